@@ -0,0 +1,255 @@
+#include "cache-simulation/checkpoint.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace replacement
+{
+
+namespace
+{
+
+// The first bytes of every checkpoint, followed by its version
+char const checkpoint_magic[8] = {'S', 'P', 'M', 'V', 'C', 'K', 'P', 'T'};
+uint32_t const checkpoint_version = 1;
+
+/*
+ * Read the header of a checkpoint, and return its pass and position.
+ */
+void load_header(
+    std::istream & i,
+    std::string const & path,
+    int32_t & pass,
+    uint64_t & position,
+    uint64_t & size,
+    uint64_t & num_processors,
+    numa_domain_type & num_numa_domains,
+    uint64_t & fingerprint)
+{
+    char magic[sizeof(checkpoint_magic)];
+    uint32_t version;
+    if (!i.read(magic, sizeof(magic)) ||
+        !std::equal(magic, magic + sizeof(magic), checkpoint_magic))
+    {
+        throw checkpoint_error(path + ": Expected a checkpoint");
+    }
+    load(i, version);
+    if (version != checkpoint_version)
+        throw checkpoint_error(path + ": Unsupported checkpoint version");
+    load(i, pass);
+    load(i, position);
+    load(i, size);
+    load(i, num_processors);
+    load(i, num_numa_domains);
+    load(i, fingerprint);
+}
+
+}
+
+checkpoint_error::checkpoint_error(std::string const & message)
+    : std::runtime_error(message)
+{
+}
+
+Checkpoint::Checkpoint(
+    std::string const & path,
+    int interval,
+    bool resume,
+    int pass)
+    : path_(path)
+    , interval_(interval)
+    , resume_(resume)
+    , pass_(pass)
+{
+}
+
+Checkpoint::~Checkpoint()
+{
+}
+
+bool Checkpoint::enabled() const
+{
+    return !path_.empty();
+}
+
+std::string const & Checkpoint::path() const
+{
+    return path_;
+}
+
+int Checkpoint::interval() const
+{
+    return interval_;
+}
+
+bool Checkpoint::resume() const
+{
+    return resume_;
+}
+
+int Checkpoint::pass() const
+{
+    return pass_;
+}
+
+Checkpoint Checkpoint::for_simulation(
+    std::string const & name) const
+{
+    if (!enabled())
+        return *this;
+    return Checkpoint(path_ + "/" + name + ".ckpt", interval_, resume_, pass_);
+}
+
+Checkpoint Checkpoint::for_pass(
+    int pass) const
+{
+    return Checkpoint(path_, interval_, resume_, pass);
+}
+
+int Checkpoint::saved_pass() const
+{
+    if (!enabled() || !resume_)
+        return -1;
+    std::ifstream i(path_, std::ios::binary);
+    if (!i)
+        return -1;
+
+    int32_t pass;
+    uint64_t position, size, num_processors, fingerprint;
+    numa_domain_type num_numa_domains;
+    load_header(
+        i, path_, pass, position, size, num_processors, num_numa_domains,
+        fingerprint);
+    return pass;
+}
+
+bool Checkpoint::due(
+    std::chrono::steady_clock::time_point & last) const
+{
+    if (!enabled() || interval_ <= 0)
+        return false;
+    auto now = std::chrono::steady_clock::now();
+    if (now - last < std::chrono::seconds(interval_))
+        return false;
+    last = now;
+    return true;
+}
+
+void Checkpoint::save(
+    uint64_t position,
+    uint64_t size,
+    uint64_t num_processors,
+    numa_domain_type num_numa_domains,
+    uint64_t fingerprint,
+    std::function<void(std::ostream &)> const & save_state) const
+{
+    if (!enabled())
+        return;
+
+    std::string tmp_path = path_ + ".tmp";
+    {
+        std::ofstream o(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!o)
+            throw checkpoint_error(tmp_path + ": Failed to open checkpoint");
+        o.write(checkpoint_magic, sizeof(checkpoint_magic));
+        replacement::save(o, checkpoint_version);
+        replacement::save(o, int32_t(pass_));
+        replacement::save(o, position);
+        replacement::save(o, size);
+        replacement::save(o, num_processors);
+        replacement::save(o, num_numa_domains);
+        replacement::save(o, fingerprint);
+        save_state(o);
+        o.flush();
+        if (!o)
+            throw checkpoint_error(tmp_path + ": Failed to write checkpoint");
+    }
+    if (std::rename(tmp_path.c_str(), path_.c_str()) != 0)
+        throw checkpoint_error(path_ + ": Failed to rename checkpoint");
+}
+
+uint64_t Checkpoint::load(
+    uint64_t size,
+    uint64_t num_processors,
+    numa_domain_type num_numa_domains,
+    uint64_t fingerprint,
+    std::function<void(std::istream &)> const & load_state) const
+{
+    if (!enabled() || !resume_)
+        return 0;
+    std::ifstream i(path_, std::ios::binary);
+    if (!i)
+        return 0;
+
+    int32_t saved_pass;
+    uint64_t position, saved_size, saved_num_processors, saved_fingerprint;
+    numa_domain_type saved_num_numa_domains;
+    load_header(
+        i, path_, saved_pass, position, saved_size,
+        saved_num_processors, saved_num_numa_domains, saved_fingerprint);
+    if (saved_pass != pass_)
+        return 0;
+    if (saved_size != size ||
+        saved_num_processors != num_processors ||
+        saved_num_numa_domains != num_numa_domains ||
+        position > size)
+    {
+        throw checkpoint_error(
+            path_ + ": Expected a checkpoint of the same simulation");
+    }
+    if (saved_fingerprint != fingerprint) {
+        throw checkpoint_error(
+            path_ + ": Expected a checkpoint of the same memory references, "
+            "but the addresses of the memory references have changed");
+    }
+    try {
+        load_state(i);
+    } catch (checkpoint_error const & e) {
+        throw checkpoint_error(path_ + ": " + e.what());
+    }
+    return position;
+}
+
+uint64_t Checkpoint::fingerprint(
+    std::vector<MemoryReferenceGenerator const *> const & ws)
+{
+    // FNV-1a hash of the addresses of the first memory references
+    uint64_t const count = 4096;
+    uint64_t h = UINT64_C(14695981039346656037);
+    std::vector<MemoryReferenceString::value_type> w;
+    for (auto const * generator : ws) {
+        w.resize(std::min(count, generator->size()));
+        generator->generate(0, w.size(), w.data());
+        for (auto const & x : w) {
+            h = (h ^ x.address()) * UINT64_C(1099511628211);
+            h = (h ^ x.numa_domain()) * UINT64_C(1099511628211);
+        }
+    }
+    return h;
+}
+
+void save(std::ostream & o, std::mt19937_64 const & rng)
+{
+    std::ostringstream s;
+    s << rng;
+    std::string state = s.str();
+    save(o, uint64_t(state.size()));
+    o.write(state.data(), state.size());
+}
+
+void load(std::istream & i, std::mt19937_64 & rng)
+{
+    uint64_t size;
+    load(i, size);
+    std::string state(size, '\0');
+    if (!i.read(&state[0], size))
+        throw checkpoint_error("Unexpected end of checkpoint");
+    std::istringstream s(state);
+    s >> rng;
+}
+
+}
@@ -0,0 +1,284 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include "cache-simulation/replacement.hpp"
+#include "util/flat-hash-map.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace replacement
+{
+
+class checkpoint_error
+    : public std::runtime_error
+{
+public:
+    checkpoint_error(std::string const & message);
+};
+
+/*
+ * Periodic checkpoints of a cache simulation, which allow a
+ * simulation that was interrupted to be resumed with identical
+ * results.
+ *
+ * Every `interval' seconds, and once the simulation is finished, the
+ * number of memory references simulated so far, the partial counts
+ * and the state of the caches and prefetchers are written to a
+ * binary file at `path'.  The file is first written under a temporary
+ * name and then renamed, so that an interrupted write leaves the
+ * previous checkpoint intact.
+ *
+ * A simulation that makes several passes over the memory references,
+ * such as a warm-up run followed by the actual run, records the pass
+ * that each checkpoint belongs to.  If `resume' is set, a simulation
+ * continues from the checkpoint, if there is one, by skipping the
+ * memory references that were already simulated.  Since the state
+ * of the caches refers to the addresses of the memory references, a
+ * fingerprint of the memory reference strings is also recorded, and a
+ * simulation can only be resumed if the memory references are the
+ * same.  The arrays of a kernel should therefore be relocated to
+ * fixed addresses (see `MemoryRelocation').
+ */
+class Checkpoint
+{
+public:
+    Checkpoint(
+        std::string const & path = std::string(),
+        int interval = 0,
+        bool resume = false,
+        int pass = 0);
+    ~Checkpoint();
+
+    bool enabled() const;
+    std::string const & path() const;
+    int interval() const;
+    bool resume() const;
+    int pass() const;
+
+    /*
+     * The checkpoint of a simulation with the given name, which is
+     * stored in the directory given by `path'.
+     */
+    Checkpoint for_simulation(
+        std::string const & name) const;
+
+    /*
+     * The checkpoint of the given pass of a simulation.
+     */
+    Checkpoint for_pass(
+        int pass) const;
+
+    /*
+     * The pass of the saved checkpoint, or -1 if there is none, or
+     * if the simulation is not to be resumed.
+     */
+    int saved_pass() const;
+
+    /*
+     * Check whether a checkpoint is due, given the time at which
+     * the previous one was taken, and, if so, update that time.
+     */
+    bool due(
+        std::chrono::steady_clock::time_point & last) const;
+
+    /*
+     * Save a checkpoint of a simulation of `size' memory references
+     * made by `num_processors' processors, of which `position' have
+     * been simulated, and whose remaining state is written by
+     * `save_state'.
+     */
+    void save(
+        uint64_t position,
+        uint64_t size,
+        uint64_t num_processors,
+        numa_domain_type num_numa_domains,
+        uint64_t fingerprint,
+        std::function<void(std::ostream &)> const & save_state) const;
+
+    /*
+     * Load a saved checkpoint of the current pass, if the simulation
+     * is to be resumed, and return the number of memory references
+     * that were already simulated, or zero if there is no such
+     * checkpoint.  A checkpoint of a simulation of a different size,
+     * or of different memory references, is an error.
+     */
+    uint64_t load(
+        uint64_t size,
+        uint64_t num_processors,
+        numa_domain_type num_numa_domains,
+        uint64_t fingerprint,
+        std::function<void(std::istream &)> const & load_state) const;
+
+    /*
+     * A fingerprint of memory reference strings, which is computed
+     * from the first memory references of each string.
+     */
+    static uint64_t fingerprint(
+        std::vector<MemoryReferenceGenerator const *> const & ws);
+
+private:
+    std::string path_;
+    int interval_;
+    bool resume_;
+    int pass_;
+};
+
+/*
+ * Binary serialisation of the state of a simulation.  Values are
+ * written in the byte order of the host, since a checkpoint is only
+ * meant to be resumed on the same kind of machine.
+ */
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type
+save(std::ostream & o, T const & x)
+{
+    o.write(reinterpret_cast<char const *>(&x), sizeof(T));
+}
+
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type
+load(std::istream & i, T & x)
+{
+    if (!i.read(reinterpret_cast<char *>(&x), sizeof(T)))
+        throw checkpoint_error("Unexpected end of checkpoint");
+}
+
+template <typename T, typename U>
+void save(std::ostream & o, std::pair<T, U> const & x)
+{
+    save(o, x.first);
+    save(o, x.second);
+}
+
+template <typename T, typename U>
+void load(std::istream & i, std::pair<T, U> & x)
+{
+    load(i, x.first);
+    load(i, x.second);
+}
+
+template <typename T>
+void save(std::ostream & o, std::vector<T> const & x)
+{
+    save(o, uint64_t(x.size()));
+    for (auto const & y : x)
+        save(o, y);
+}
+
+template <typename T>
+void load(std::istream & i, std::vector<T> & x)
+{
+    uint64_t size;
+    load(i, size);
+    x.resize(size);
+    for (auto & y : x)
+        load(i, y);
+}
+
+template <typename T>
+void save(std::ostream & o, std::deque<T> const & x)
+{
+    save(o, uint64_t(x.size()));
+    for (auto const & y : x)
+        save(o, y);
+}
+
+template <typename T>
+void load(std::istream & i, std::deque<T> & x)
+{
+    uint64_t size;
+    load(i, size);
+    x.resize(size);
+    for (auto & y : x)
+        load(i, y);
+}
+
+template <typename T>
+void save(std::ostream & o, std::set<T> const & x)
+{
+    save(o, uint64_t(x.size()));
+    for (auto const & y : x)
+        save(o, y);
+}
+
+template <typename T>
+void load(std::istream & i, std::set<T> & x)
+{
+    uint64_t size;
+    load(i, size);
+    x.clear();
+    for (uint64_t n = 0; n < size; n++) {
+        T y;
+        load(i, y);
+        x.insert(x.end(), y);
+    }
+}
+
+template <typename T>
+void save(std::ostream & o, std::unordered_set<T> const & x)
+{
+    save(o, uint64_t(x.size()));
+    for (auto const & y : x)
+        save(o, y);
+}
+
+template <typename T>
+void load(std::istream & i, std::unordered_set<T> & x)
+{
+    uint64_t size;
+    load(i, size);
+    x.clear();
+    x.reserve(size);
+    for (uint64_t n = 0; n < size; n++) {
+        T y;
+        load(i, y);
+        x.insert(y);
+    }
+}
+
+template <typename Key, typename T>
+void save(std::ostream & o, FlatHashMap<Key, T> const & x)
+{
+    save(o, uint64_t(x.size()));
+    x.for_each(
+        [&o] (Key key, T const & value) {
+            save(o, key);
+            save(o, value);
+        });
+}
+
+template <typename Key, typename T>
+void load(std::istream & i, FlatHashMap<Key, T> & x)
+{
+    uint64_t size;
+    load(i, size);
+    x.clear();
+    x.reserve(size);
+    for (uint64_t n = 0; n < size; n++) {
+        Key key;
+        T value;
+        load(i, key);
+        load(i, value);
+        x.insert(key, value);
+    }
+}
+
+void save(std::ostream & o, std::mt19937_64 const & rng);
+void load(std::istream & i, std::mt19937_64 & rng);
+
+}
+
+#endif
@@ -1,49 +1,172 @@
+#include "cache-simulation/checkpoint.hpp"
 #include "cache-simulation/replacement.hpp"
 
 #include <algorithm>
-#include <queue>
-#include <set>
+#include <limits>
+#include <vector>
 
 namespace replacement
 {
 
 using cache_reference_type = uintptr_t;
 
+static constexpr uint32_t no_slot = std::numeric_limits<uint32_t>::max();
+
 FIFO::FIFO(
     cache_size_type cache_lines,
     cache_size_type cache_line_size,
     std::vector<memory_reference_type> const & initial_state)
     : ReplacementAlgorithm(
         cache_lines,
-        cache_line_size,
-        MemoryReferenceSet(std::begin(initial_state), std::end(initial_state)))
-    , q()
+        cache_line_size)
+    , lines(cache_lines)
+    , states(cache_lines)
+    , prev(cache_lines, no_slot)
+    , next(cache_lines, no_slot)
+    , head(no_slot)
+    , tail(no_slot)
+    , num_lines(0u)
+    , free_slots()
+    , index(std::numeric_limits<memory_reference_type>::max(), cache_lines)
 {
-    for (auto & memory_reference : initial_state)
-        q.emplace(memory_reference);
+    for (auto & memory_reference : initial_state) {
+        if (num_lines >= cache_lines)
+            break;
+        if (index.find(memory_reference))
+            continue;
+        slot_type slot = num_lines++;
+        lines[slot] = memory_reference;
+        index.insert(memory_reference, slot);
+        push_back(slot);
+    }
 }
 
 FIFO::~FIFO()
 {
 }
 
+void FIFO::unlink(slot_type slot)
+{
+    if (prev[slot] != no_slot)
+        next[prev[slot]] = next[slot];
+    else
+        head = next[slot];
+    if (next[slot] != no_slot)
+        prev[next[slot]] = prev[slot];
+    else
+        tail = prev[slot];
+}
+
+void FIFO::push_back(slot_type slot)
+{
+    prev[slot] = tail;
+    next[slot] = no_slot;
+    if (tail != no_slot)
+        next[tail] = slot;
+    else
+        head = slot;
+    tail = slot;
+}
+
 cache_miss_type FIFO::allocate(
     memory_reference_type x,
     numa_domain_type numa_domain)
 {
-    cache_reference_type y = x / cache_line_size;
-    auto it = memory_references.find(y);
-    if (it != std::cend(memory_references) && y == *it)
+    return allocate_line(x / cache_line_size, numa_domain);
+}
+
+cache_miss_type FIFO::allocate_line(
+    memory_reference_type y,
+    numa_domain_type numa_domain)
+{
+    victim_line = no_victim;
+    slot_type * it = index.find(y);
+    if (it) {
+        allocated_line = &states[*it];
         return 0u;
+    }
+    if (cache_lines == 0u)
+        return 1u;
 
-    memory_references.insert(y);
-    if (memory_references.size() > cache_lines) {
-        auto z = q.front();
-        q.pop();
-        memory_references.erase(z);
+    // Use a free slot, if there is one, or else replace the cache
+    // line that was filled first.
+    slot_type slot;
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    } else if (num_lines < cache_lines) {
+        slot = num_lines++;
+    } else {
+        slot = head;
+        victim_line = lines[slot];
+        victim_state = states[slot];
+        index.erase(lines[slot]);
+        unlink(slot);
     }
-    q.emplace(y);
+    lines[slot] = y;
+    states[slot] = CacheLineState();
+    allocated_line = &states[slot];
+    index.insert(y, slot);
+    push_back(slot);
     return 1u;
 }
 
+bool FIFO::invalidate(
+    memory_reference_type x)
+{
+    cache_reference_type y = x / cache_line_size;
+    slot_type * it = index.find(y);
+    if (!it)
+        return false;
+    slot_type slot = *it;
+    unlink(slot);
+    index.erase(y);
+    free_slots.push_back(slot);
+    return true;
+}
+
+
+bool FIFO::contains(
+    memory_reference_type x) const
+{
+    return index.find(x / cache_line_size) != nullptr;
+}
+
+CacheLineState * FIFO::find_line(
+    memory_reference_type y)
+{
+    slot_type * it = index.find(y);
+    return it ? &states[*it] : nullptr;
+}
+
+void FIFO::save(
+    std::ostream & o) const
+{
+    ReplacementAlgorithm::save(o);
+    replacement::save(o, lines);
+    replacement::save(o, states);
+    replacement::save(o, prev);
+    replacement::save(o, next);
+    replacement::save(o, head);
+    replacement::save(o, tail);
+    replacement::save(o, num_lines);
+    replacement::save(o, free_slots);
+    replacement::save(o, index);
+}
+
+void FIFO::load(
+    std::istream & i)
+{
+    ReplacementAlgorithm::load(i);
+    replacement::load(i, lines);
+    replacement::load(i, states);
+    replacement::load(i, prev);
+    replacement::load(i, next);
+    replacement::load(i, head);
+    replacement::load(i, tail);
+    replacement::load(i, num_lines);
+    replacement::load(i, free_slots);
+    replacement::load(i, index);
+}
+
 }
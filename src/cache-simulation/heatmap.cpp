@@ -0,0 +1,147 @@
+#include "cache-simulation/heatmap.hpp"
+#include "cache-simulation/checkpoint.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace replacement
+{
+
+MatrixLocator::MatrixLocator()
+    : rows_(0)
+    , columns_(0)
+    , arrays()
+{
+}
+
+MatrixLocator::MatrixLocator(
+    std::size_t rows,
+    std::size_t columns,
+    std::vector<MatrixLocatorArray> const & arrays)
+    : rows_(rows)
+    , columns_(columns)
+    , arrays(arrays)
+{
+}
+
+MatrixLocator::~MatrixLocator()
+{
+}
+
+bool MatrixLocator::empty() const
+{
+    return arrays.empty();
+}
+
+std::size_t MatrixLocator::rows() const
+{
+    return rows_;
+}
+
+std::size_t MatrixLocator::columns() const
+{
+    return columns_;
+}
+
+MatrixLocator MatrixLocator::relocate(
+    MemoryRelocation const & relocation) const
+{
+    std::vector<MatrixLocatorArray> relocated_arrays(arrays);
+    for (auto & a : relocated_arrays) {
+        memory_reference_type begin = relocation.relocate(a.begin);
+        a.end = begin + (a.end - a.begin);
+        a.begin = begin;
+    }
+    return MatrixLocator(rows_, columns_, relocated_arrays);
+}
+
+Heatmap::Heatmap()
+    : rows(0)
+    , columns(0)
+    , row_bins_(0)
+    , column_bins_(0)
+    , counts()
+{
+}
+
+Heatmap::Heatmap(
+    std::size_t rows,
+    std::size_t columns,
+    std::size_t row_bins,
+    std::size_t column_bins)
+    : rows(rows)
+    , columns(columns)
+    , row_bins_(std::max<std::size_t>(1, std::min(rows, row_bins)))
+    , column_bins_(std::max<std::size_t>(1, std::min(columns, column_bins)))
+    , counts(row_bins_ * column_bins_, 0)
+{
+    if (row_bins == 0 || column_bins == 0)
+        throw std::invalid_argument("Expected a positive number of bins");
+}
+
+Heatmap::~Heatmap()
+{
+}
+
+bool Heatmap::empty() const
+{
+    return counts.empty();
+}
+
+std::size_t Heatmap::row_bins() const
+{
+    return row_bins_;
+}
+
+std::size_t Heatmap::column_bins() const
+{
+    return column_bins_;
+}
+
+std::size_t Heatmap::row_begin(
+    std::size_t row_bin) const
+{
+    // The first row that `bin' places in the given block
+    return (row_bin * rows + row_bins_ - 1) / row_bins_;
+}
+
+std::size_t Heatmap::column_begin(
+    std::size_t column_bin) const
+{
+    return (column_bin * columns + column_bins_ - 1) / column_bins_;
+}
+
+cache_miss_type Heatmap::operator()(
+    std::size_t row_bin,
+    std::size_t column_bin) const
+{
+    return counts[row_bin * column_bins_ + column_bin];
+}
+
+void Heatmap::scale(
+    double factor)
+{
+    for (auto & count : counts)
+        count = std::llround(count * factor);
+}
+
+void Heatmap::save(
+    std::ostream & o) const
+{
+    replacement::save(o, counts);
+}
+
+void Heatmap::load(
+    std::istream & i)
+{
+    std::size_t size = counts.size();
+    replacement::load(i, counts);
+    if (counts.size() != size)
+        throw checkpoint_error("Expected a checkpoint of a heatmap of the same size");
+}
+
+}
@@ -0,0 +1,229 @@
+#ifndef HEATMAP_HPP
+#define HEATMAP_HPP
+
+#include "cache-simulation/memory-region.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace replacement
+{
+
+/*
+ * The row and column of a matrix that a processor is currently
+ * working on.
+ */
+struct MatrixLocation
+{
+    int64_t row;
+    int64_t column;
+};
+
+/*
+ * An array of a kernel whose elements tell the row or the column of
+ * the matrix that a memory reference belongs to.  If `indices' is
+ * given, element `k' belongs to the row or column `indices[k]', such
+ * as for the column indices of the nonzeros of a sparse matrix.
+ * Otherwise, element `k' belongs to the row or column
+ * `(k % modulus) / stride + offset', where a modulus of zero is
+ * ignored, such as for the vectors `x' and `y'.
+ */
+struct MatrixLocatorArray
+{
+    enum Coordinate { row, column };
+
+    Coordinate coordinate;
+    memory_reference_type begin;
+    memory_reference_type end;
+    std::size_t element_size;
+    int32_t const * indices;
+    int64_t modulus;
+    int64_t stride;
+    int64_t offset;
+};
+
+/*
+ * Describe an array whose elements belong to the rows or columns
+ * given by another array of indices.
+ */
+template <typename Array, typename IndexArray>
+MatrixLocatorArray make_matrix_locator_array(
+    MatrixLocatorArray::Coordinate coordinate,
+    Array const & a,
+    IndexArray const & indices)
+{
+    memory_reference_type begin = memory_reference_type(a.data());
+    return MatrixLocatorArray{
+        coordinate, begin,
+        begin + a.size() * sizeof(typename Array::value_type),
+        sizeof(typename Array::value_type), indices.data(), 0, 1, 0};
+}
+
+/*
+ * Describe an array whose element `k' belongs to the row or column
+ * `(k % modulus) / stride + offset'.
+ */
+template <typename Array>
+MatrixLocatorArray make_matrix_locator_array(
+    MatrixLocatorArray::Coordinate coordinate,
+    Array const & a,
+    int64_t stride = 1,
+    int64_t offset = 0,
+    int64_t modulus = 0)
+{
+    memory_reference_type begin = memory_reference_type(a.data());
+    return MatrixLocatorArray{
+        coordinate, begin,
+        begin + a.size() * sizeof(typename Array::value_type),
+        sizeof(typename Array::value_type), nullptr, modulus, stride, offset};
+}
+
+/*
+ * Find the rows and columns of a matrix that the memory references of
+ * a kernel belong to.  Every memory reference to one of the arrays of
+ * the locator updates either the row or the column of the processor
+ * that made it, and the other memory references leave them unchanged.
+ * For example, a sparse matrix-vector multiplication in the CSR format
+ * updates the row when it starts a new row, and the column whenever
+ * it loads a column index or an element of `x'.
+ */
+class MatrixLocator
+{
+public:
+    MatrixLocator();
+    MatrixLocator(
+        std::size_t rows,
+        std::size_t columns,
+        std::vector<MatrixLocatorArray> const & arrays);
+    ~MatrixLocator();
+
+    /*
+     * Whether the locator describes a matrix, which is not the case
+     * for kernels without a matrix.
+     */
+    bool empty() const;
+
+    std::size_t rows() const;
+    std::size_t columns() const;
+
+    /*
+     * The same locator for memory references that were relocated by
+     * the given relocation.
+     */
+    MatrixLocator relocate(
+        MemoryRelocation const & relocation) const;
+
+    /*
+     * Update the location of a processor with its memory reference.
+     */
+    void locate(
+        memory_reference_type x,
+        MatrixLocation & location) const
+    {
+        for (auto const & a : arrays) {
+            if (x < a.begin || x >= a.end)
+                continue;
+            int64_t k = (x - a.begin) / a.element_size;
+            int64_t coordinate;
+            if (a.indices) {
+                coordinate = a.indices[k];
+            } else {
+                if (a.modulus > 0)
+                    k %= a.modulus;
+                coordinate = k / a.stride + a.offset;
+            }
+            if (a.coordinate == MatrixLocatorArray::row)
+                location.row = coordinate;
+            else
+                location.column = coordinate;
+            return;
+        }
+    }
+
+private:
+    std::size_t rows_;
+    std::size_t columns_;
+    std::vector<MatrixLocatorArray> arrays;
+};
+
+/*
+ * A two-dimensional histogram of cache misses, where the rows and
+ * columns of a matrix are divided into `row_bins' and `column_bins'
+ * blocks of nearly equal size.  Locations outside of the matrix are
+ * counted in the nearest block.
+ */
+class Heatmap
+{
+public:
+    Heatmap();
+    Heatmap(
+        std::size_t rows,
+        std::size_t columns,
+        std::size_t row_bins,
+        std::size_t column_bins);
+    ~Heatmap();
+
+    bool empty() const;
+    std::size_t row_bins() const;
+    std::size_t column_bins() const;
+
+    /*
+     * The first row of a block of rows, or, for `row_bins()', the
+     * number of rows, and likewise for columns.
+     */
+    std::size_t row_begin(
+        std::size_t row_bin) const;
+    std::size_t column_begin(
+        std::size_t column_bin) const;
+
+    void add(
+        MatrixLocation const & location,
+        cache_miss_type count = 1)
+    {
+        counts[bin(location.row, rows, row_bins_) * column_bins_ +
+               bin(location.column, columns, column_bins_)] += count;
+    }
+
+    cache_miss_type operator()(
+        std::size_t row_bin,
+        std::size_t column_bin) const;
+
+    /*
+     * Scale every count, for instance to extrapolate a sampled
+     * simulation.
+     */
+    void scale(
+        double factor);
+
+    void save(
+        std::ostream & o) const;
+    void load(
+        std::istream & i);
+
+private:
+    static std::size_t bin(
+        int64_t x,
+        std::size_t size,
+        std::size_t bins)
+    {
+        if (x <= 0)
+            return 0;
+        if (std::size_t(x) >= size)
+            return bins - 1;
+        return (std::size_t(x) * bins) / size;
+    }
+
+private:
+    std::size_t rows;
+    std::size_t columns;
+    std::size_t row_bins_;
+    std::size_t column_bins_;
+    std::vector<cache_miss_type> counts;
+};
+
+}
+
+#endif
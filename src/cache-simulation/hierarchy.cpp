@@ -0,0 +1,727 @@
+#include "cache-simulation/hierarchy.hpp"
+#include "cache-simulation/checkpoint.hpp"
+#include "cache-simulation/timing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+namespace replacement
+{
+
+CacheHierarchy::CacheHierarchy()
+    : caches()
+    , parents()
+    , children()
+    , inclusion_policies()
+    , prefetchers()
+    , prefetches()
+    , cache_misses_()
+    , write_backs_()
+    , prefetch_fills_()
+    , useful_prefetches_()
+    , attribution(nullptr)
+    , cache_misses_per_region_()
+    , locator(nullptr)
+    , empty_heatmap()
+    , locations()
+    , heatmaps_()
+    , regions(nullptr)
+    , remote_caches()
+    , invalidated_lines()
+    , invalidations_()
+    , coherence_misses_()
+    , false_sharing_()
+    , counting(true)
+    , discarded_counts()
+    , discarded_coherence_counts()
+    , discarded_cache_misses_per_region()
+    , discarded_heatmaps()
+    , served_by(-1)
+{
+}
+
+CacheHierarchy::~CacheHierarchy()
+{
+}
+
+int CacheHierarchy::add_cache(
+    ReplacementAlgorithm & cache,
+    int parent,
+    InclusionPolicy inclusion_policy,
+    Prefetcher * prefetcher)
+{
+    int index = caches.size();
+    caches.push_back(&cache);
+    parents.push_back(parent);
+    children.emplace_back();
+    inclusion_policies.push_back(inclusion_policy);
+    prefetchers.push_back(prefetcher);
+    invalidated_lines.emplace_back(ReplacementAlgorithm::no_victim);
+    if (parent >= 0)
+        children[parent].push_back(index);
+    return index;
+}
+
+int CacheHierarchy::num_caches() const
+{
+    return caches.size();
+}
+
+void CacheHierarchy::enable_coherence(
+    MemoryRegions const & memory_regions)
+{
+    regions = &memory_regions;
+}
+
+void CacheHierarchy::attribute_cache_misses(
+    MemoryRegions const & memory_regions)
+{
+    attribution = &memory_regions;
+}
+
+void CacheHierarchy::enable_heatmaps(
+    MatrixLocator const & matrix_locator,
+    Heatmap const & heatmap)
+{
+    locator = &matrix_locator;
+    empty_heatmap = heatmap;
+}
+
+void CacheHierarchy::reset(
+    std::size_t num_processors,
+    numa_domain_type num_numa_domains)
+{
+    cache_misses_.assign(
+        caches.size(),
+        std::vector<std::vector<cache_miss_type>>(
+            num_processors,
+            std::vector<cache_miss_type>(num_numa_domains, 0)));
+    write_backs_ = cache_misses_;
+    prefetch_fills_ = cache_misses_;
+    useful_prefetches_ = cache_misses_;
+    counting = true;
+    discarded_counts.assign(4, cache_misses_);
+    cache_misses_per_region_.assign(
+        caches.size(),
+        std::vector<cache_miss_type>(attribution ? attribution->size() : 0, 0));
+    discarded_cache_misses_per_region = cache_misses_per_region_;
+    locations.assign(num_processors, MatrixLocation{0, 0});
+    heatmaps_.clear();
+    if (locator)
+        heatmaps_.assign(caches.size(), empty_heatmap);
+    discarded_heatmaps = heatmaps_;
+    if (!regions)
+        return;
+
+    invalidations_.assign(
+        caches.size(), std::vector<cache_miss_type>(regions->size(), 0));
+    coherence_misses_ = invalidations_;
+    false_sharing_ = invalidations_;
+    discarded_coherence_counts.assign(3, invalidations_);
+
+    // The caches that are remote to a first-level cache are those
+    // that are neither the cache itself nor one of its ancestors.
+    // They are listed with children before their parents.
+    int num_caches = caches.size();
+    remote_caches.assign(num_caches, std::vector<int>());
+    for (int cache = 0; cache < num_caches; cache++) {
+        std::vector<bool> local(num_caches, false);
+        for (int ancestor = cache; ancestor >= 0; ancestor = parents[ancestor])
+            local[ancestor] = true;
+        for (int remote = num_caches - 1; remote >= 0; remote--) {
+            if (!local[remote])
+                remote_caches[cache].push_back(remote);
+        }
+    }
+}
+
+void CacheHierarchy::count(
+    bool counting)
+{
+    if (this->counting == counting)
+        return;
+    this->counting = counting;
+
+    // Swap the counts with those that are discarded, so that the
+    // references made while counting is stopped leave the counts
+    // unchanged.
+    std::swap(cache_misses_, discarded_counts[0]);
+    std::swap(write_backs_, discarded_counts[1]);
+    std::swap(prefetch_fills_, discarded_counts[2]);
+    std::swap(useful_prefetches_, discarded_counts[3]);
+    std::swap(cache_misses_per_region_, discarded_cache_misses_per_region);
+    std::swap(heatmaps_, discarded_heatmaps);
+    if (!regions)
+        return;
+    std::swap(invalidations_, discarded_coherence_counts[0]);
+    std::swap(coherence_misses_, discarded_coherence_counts[1]);
+    std::swap(false_sharing_, discarded_coherence_counts[2]);
+}
+
+void CacheHierarchy::extrapolate(
+    SamplingStatistics const & statistics)
+{
+    count(true);
+    for (auto * counts :
+             {&cache_misses_, &write_backs_, &prefetch_fills_, &useful_prefetches_})
+    {
+        for (auto & counts_per_cache : *counts)
+            statistics.extrapolate(counts_per_cache);
+    }
+
+    // Coherence events and the cache misses of each memory region are
+    // not attributed to processors, and they are therefore scaled by
+    // the overall fraction of references that were counted.
+    double scale = statistics.scale();
+    for (auto * counts :
+             {&cache_misses_per_region_, &invalidations_, &coherence_misses_,
+              &false_sharing_})
+    {
+        for (auto & counts_per_cache : *counts) {
+            for (auto & count : counts_per_cache)
+                count = std::llround(count * scale);
+        }
+    }
+    for (auto & heatmap : heatmaps_)
+        heatmap.scale(scale);
+}
+
+void CacheHierarchy::save(
+    std::ostream & o) const
+{
+    replacement::save(o, uint64_t(caches.size()));
+    for (std::size_t cache = 0; cache < caches.size(); cache++) {
+        caches[cache]->save(o);
+        if (prefetchers[cache])
+            prefetchers[cache]->save(o);
+    }
+    replacement::save(o, cache_misses_);
+    replacement::save(o, write_backs_);
+    replacement::save(o, prefetch_fills_);
+    replacement::save(o, useful_prefetches_);
+    replacement::save(o, cache_misses_per_region_);
+    for (auto const & heatmap : heatmaps_)
+        heatmap.save(o);
+    for (auto const & location : locations)
+        replacement::save(o, std::make_pair(location.row, location.column));
+    if (!regions)
+        return;
+    replacement::save(o, uint64_t(invalidated_lines.size()));
+    for (auto const & lines : invalidated_lines)
+        replacement::save(o, lines);
+    replacement::save(o, invalidations_);
+    replacement::save(o, coherence_misses_);
+    replacement::save(o, false_sharing_);
+}
+
+void CacheHierarchy::load(
+    std::istream & i)
+{
+    uint64_t num_caches;
+    replacement::load(i, num_caches);
+    if (num_caches != caches.size())
+        throw checkpoint_error("Expected a checkpoint of a cache hierarchy with the same caches");
+    for (std::size_t cache = 0; cache < caches.size(); cache++) {
+        caches[cache]->load(i);
+        if (prefetchers[cache])
+            prefetchers[cache]->load(i);
+    }
+    replacement::load(i, cache_misses_);
+    replacement::load(i, write_backs_);
+    replacement::load(i, prefetch_fills_);
+    replacement::load(i, useful_prefetches_);
+    replacement::load(i, cache_misses_per_region_);
+    for (auto & heatmap : heatmaps_)
+        heatmap.load(i);
+    for (auto & location : locations) {
+        std::pair<int64_t, int64_t> x;
+        replacement::load(i, x);
+        location = MatrixLocation{x.first, x.second};
+    }
+    if (!regions)
+        return;
+    uint64_t num_invalidated_lines;
+    replacement::load(i, num_invalidated_lines);
+    if (num_invalidated_lines != invalidated_lines.size())
+        throw checkpoint_error("Expected a checkpoint of a cache hierarchy with the same caches");
+    for (auto & lines : invalidated_lines)
+        replacement::load(i, lines);
+    replacement::load(i, invalidations_);
+    replacement::load(i, coherence_misses_);
+    replacement::load(i, false_sharing_);
+}
+
+std::vector<std::vector<std::vector<cache_miss_type>>> const &
+CacheHierarchy::cache_misses() const
+{
+    return cache_misses_;
+}
+
+std::vector<std::vector<std::vector<cache_miss_type>>> const &
+CacheHierarchy::write_backs() const
+{
+    return write_backs_;
+}
+
+std::vector<std::vector<std::vector<cache_miss_type>>> const &
+CacheHierarchy::prefetch_fills() const
+{
+    return prefetch_fills_;
+}
+
+std::vector<std::vector<std::vector<cache_miss_type>>> const &
+CacheHierarchy::useful_prefetches() const
+{
+    return useful_prefetches_;
+}
+
+std::vector<std::vector<cache_miss_type>> const &
+CacheHierarchy::cache_misses_per_region() const
+{
+    return cache_misses_per_region_;
+}
+
+std::vector<Heatmap> const & CacheHierarchy::heatmaps() const
+{
+    return heatmaps_;
+}
+
+std::vector<std::vector<cache_miss_type>> const &
+CacheHierarchy::invalidations() const
+{
+    return invalidations_;
+}
+
+std::vector<std::vector<cache_miss_type>> const &
+CacheHierarchy::coherence_misses() const
+{
+    return coherence_misses_;
+}
+
+std::vector<std::vector<cache_miss_type>> const &
+CacheHierarchy::false_sharing() const
+{
+    return false_sharing_;
+}
+
+int CacheHierarchy::reference(
+    int cache,
+    memory_reference_type x,
+    std::size_t p,
+    numa_domain_type numa_domain,
+    AccessType access_type)
+{
+    served_by = -1;
+    if (locator)
+        locator->locate(x, locations[p]);
+    if (regions)
+        snoop(cache, x, p, access_type);
+    if (access_type == AccessType::streaming_store) {
+        for (; cache >= 0; cache = parents[cache]) {
+            caches[cache]->access(x, numa_domain, access_type);
+            numa_domain_type write_back = caches[cache]->write_back();
+            if (write_back != ReplacementAlgorithm::no_write_back)
+                write_backs_[cache][p][write_back]++;
+        }
+        return served_by;
+    }
+    fill(cache, x, p, numa_domain, access_type, false);
+    return served_by;
+}
+
+/*
+ * Bring a cache line into a cache and, on a cache miss, request it
+ * from the parent cache.  A demand access then trains the cache's
+ * prefetcher, whose prefetches are brought into the cache in turn.
+ */
+void CacheHierarchy::fill(
+    int cache,
+    memory_reference_type x,
+    std::size_t p,
+    numa_domain_type numa_domain,
+    AccessType access_type,
+    bool prefetch)
+{
+    cache_miss_type cache_miss = prefetch
+        ? caches[cache]->prefetch(x, numa_domain)
+        : caches[cache]->access(x, numa_domain, access_type);
+    if (cache_miss && regions && !invalidated_lines[cache].empty()) {
+        memory_reference_type y = x / caches[cache]->line_size();
+        memory_reference_type * remote_store = invalidated_lines[cache].find(y);
+        if (remote_store) {
+            if (!prefetch) {
+                std::size_t region = regions->find(x);
+                coherence_misses_[cache][region]++;
+                false_sharing_[cache][region] += (*remote_store != x);
+            }
+            invalidated_lines[cache].erase(y);
+        }
+    }
+    if (cache_miss) {
+        if (prefetch)
+            prefetch_fills_[cache][p][numa_domain]++;
+        else
+            count_cache_miss(cache, x, p, numa_domain);
+        memory_reference_type victim = caches[cache]->victim();
+        numa_domain_type victim_write_back = caches[cache]->write_back();
+        if (request(parents[cache], x, p, numa_domain, prefetch))
+            caches[cache]->mark_dirty(x, numa_domain);
+        if (victim != ReplacementAlgorithm::no_victim ||
+            victim_write_back != ReplacementAlgorithm::no_write_back)
+        {
+            evict(cache, victim, p, numa_domain, victim_write_back);
+        }
+    }
+    if (prefetch)
+        return;
+    if (!cache_miss)
+        served_by = cache;
+
+    bool useful_prefetch = caches[cache]->useful_prefetch();
+    useful_prefetches_[cache][p][numa_domain] += useful_prefetch;
+    if (!prefetchers[cache])
+        return;
+
+    // Prefetches do not train any prefetchers, so the list of
+    // prefetches is not modified while it is being processed.
+    prefetches.clear();
+    prefetchers[cache]->access(x, cache_miss || useful_prefetch, prefetches);
+    for (memory_reference_type y : prefetches)
+        fill(cache, y, p, numa_domain, AccessType::load, true);
+}
+
+/*
+ * Count a cache miss, and attribute it to its memory region and to
+ * the location in the matrix of the processor that made it.
+ */
+void CacheHierarchy::count_cache_miss(
+    int cache,
+    memory_reference_type x,
+    std::size_t p,
+    numa_domain_type numa_domain)
+{
+    cache_misses_[cache][p][numa_domain]++;
+    if (attribution)
+        cache_misses_per_region_[cache][attribution->find(x)]++;
+    if (locator)
+        heatmaps_[cache].add(locations[p]);
+}
+
+/*
+ * Keep the caches that are remote to a first-level cache coherent
+ * with a memory reference made through it.
+ */
+void CacheHierarchy::snoop(
+    int cache,
+    memory_reference_type x,
+    std::size_t p,
+    AccessType access_type)
+{
+    if (access_type == AccessType::load) {
+        if (caches[cache]->contains(x))
+            return;
+        for (int remote : remote_caches[cache]) {
+            numa_domain_type dirty = caches[remote]->clean(x);
+            if (dirty != ReplacementAlgorithm::no_write_back) {
+                write_backs_[remote][p][dirty]++;
+                write_back(parents[remote], x, p, dirty);
+            }
+        }
+        return;
+    }
+
+    for (int remote : remote_caches[cache]) {
+        if (!caches[remote]->contains(x))
+            continue;
+        caches[remote]->clean(x);
+        caches[remote]->invalidate(x);
+        invalidations_[remote][regions->find(x)]++;
+        invalidated_lines[remote].insert(
+            x / caches[remote]->line_size(), x);
+    }
+}
+
+/*
+ * Handle a cache miss or a prefetch in a child of the given cache.
+ * An exclusive cache hands over the cache line to the child, whereas
+ * other caches keep a copy.  Return whether a dirty cache line was
+ * handed over.
+ */
+bool CacheHierarchy::request(
+    int cache,
+    memory_reference_type x,
+    std::size_t p,
+    numa_domain_type numa_domain,
+    bool prefetch)
+{
+    if (cache < 0)
+        return false;
+
+    if (inclusion_policies[cache] == InclusionPolicy::exclusive) {
+        numa_domain_type dirty = caches[cache]->clean(x);
+        if (caches[cache]->invalidate(x)) {
+            if (!prefetch)
+                served_by = cache;
+            return dirty != ReplacementAlgorithm::no_write_back;
+        }
+        if (prefetch)
+            prefetch_fills_[cache][p][numa_domain]++;
+        else
+            count_cache_miss(cache, x, p, numa_domain);
+        return request(parents[cache], x, p, numa_domain, prefetch);
+    }
+    fill(cache, x, p, numa_domain, AccessType::load, prefetch);
+    return false;
+}
+
+/*
+ * Handle the eviction of a cache line from a cache, which is removed
+ * from the descendants of an inclusive cache, and written to an
+ * exclusive parent cache.  If the cache line is dirty, it is written
+ * back with the given NUMA domain.  A cache without any cache lines
+ * writes back stores without evicting anything.
+ */
+void CacheHierarchy::evict(
+    int cache,
+    memory_reference_type victim,
+    std::size_t p,
+    numa_domain_type numa_domain,
+    numa_domain_type write_back_numa_domain)
+{
+    if (victim != ReplacementAlgorithm::no_victim &&
+        inclusion_policies[cache] == InclusionPolicy::inclusive)
+    {
+        numa_domain_type dirty = back_invalidate(cache, victim);
+        if (write_back_numa_domain == ReplacementAlgorithm::no_write_back)
+            write_back_numa_domain = dirty;
+    }
+
+    bool dirty = write_back_numa_domain != ReplacementAlgorithm::no_write_back;
+    if (dirty)
+        write_backs_[cache][p][write_back_numa_domain]++;
+
+    int parent = parents[cache];
+    if (victim != ReplacementAlgorithm::no_victim &&
+        parent >= 0 &&
+        inclusion_policies[parent] == InclusionPolicy::exclusive)
+    {
+        if (caches[parent]->access(
+                victim,
+                dirty ? write_back_numa_domain : numa_domain,
+                dirty ? AccessType::store : AccessType::load))
+        {
+            memory_reference_type parent_victim = caches[parent]->victim();
+            numa_domain_type parent_write_back = caches[parent]->write_back();
+            if (parent_victim != ReplacementAlgorithm::no_victim ||
+                parent_write_back != ReplacementAlgorithm::no_write_back)
+            {
+                evict(parent, parent_victim, p, numa_domain, parent_write_back);
+            }
+        }
+    } else if (dirty) {
+        write_back(parent, victim, p, write_back_numa_domain);
+    }
+}
+
+/*
+ * Write back a dirty cache line to the nearest of the given cache and
+ * its ancestors that holds the cache line, or else to memory.
+ */
+void CacheHierarchy::write_back(
+    int cache,
+    memory_reference_type x,
+    std::size_t p,
+    numa_domain_type numa_domain)
+{
+    for (; cache >= 0; cache = parents[cache]) {
+        if (caches[cache]->mark_dirty(x, numa_domain))
+            return;
+        write_backs_[cache][p][numa_domain]++;
+    }
+}
+
+/*
+ * Invalidate a cache line in the descendants of a cache, and return
+ * the NUMA domain that it must be written back to, if any of the
+ * descendants held it dirty, or else `no_write_back'.
+ */
+numa_domain_type CacheHierarchy::back_invalidate(
+    int cache,
+    memory_reference_type victim)
+{
+    numa_domain_type write_back = ReplacementAlgorithm::no_write_back;
+    for (int child : children[cache]) {
+        numa_domain_type dirty = caches[child]->clean(victim);
+        caches[child]->invalidate(victim);
+        if (dirty != ReplacementAlgorithm::no_write_back)
+            write_back = dirty;
+        dirty = back_invalidate(child, victim);
+        if (dirty != ReplacementAlgorithm::no_write_back)
+            write_back = dirty;
+    }
+    return write_back;
+}
+
+static volatile sig_atomic_t print_progress = 0;
+
+static void signal_handler(int status)
+{
+    print_progress = 1;
+}
+
+/*
+ * The total cache misses of each cache, over every processor and
+ * NUMA domain.
+ */
+static std::vector<cache_miss_type> total_cache_misses_per_cache(
+    CacheHierarchy const & hierarchy)
+{
+    auto const & cache_misses = hierarchy.cache_misses();
+    std::vector<cache_miss_type> totals(cache_misses.size(), 0);
+    for (std::size_t cache = 0; cache < cache_misses.size(); cache++) {
+        for (auto const & cache_misses_per_processor : cache_misses[cache]) {
+            for (cache_miss_type n : cache_misses_per_processor)
+                totals[cache] += n;
+        }
+    }
+    return totals;
+}
+
+std::vector<std::vector<std::vector<cache_miss_type>>> trace_cache_misses(
+    CacheHierarchy & hierarchy,
+    std::vector<int> const & first_level_caches,
+    std::vector<MemoryReferenceString> const & ws,
+    numa_domain_type num_numa_domains,
+    CacheHierarchyTraceOptions const & options)
+{
+    std::vector<MemoryReferenceStringGenerator> generators(
+        ws.cbegin(), ws.cend());
+    std::vector<MemoryReferenceGenerator const *> generator_ptrs;
+    for (auto const & generator : generators)
+        generator_ptrs.push_back(&generator);
+    return trace_cache_misses(
+        hierarchy, first_level_caches, generator_ptrs,
+        num_numa_domains, options);
+}
+
+std::vector<std::vector<std::vector<cache_miss_type>>> trace_cache_misses(
+    CacheHierarchy & hierarchy,
+    std::vector<int> const & first_level_caches,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    numa_domain_type num_numa_domains,
+    CacheHierarchyTraceOptions const & options)
+{
+    bool verbose = options.verbose;
+    int progress_interval = options.progress_interval;
+    Interleaving const & interleaving = options.interleaving;
+    TimingModel * timing = options.timing;
+    Sampling const & sampling = options.sampling;
+    SamplingStatistics * statistics = options.statistics;
+    Checkpoint const * checkpoint = options.checkpoint;
+    bool checkpointing = checkpoint && checkpoint->enabled();
+    if (checkpointing && (timing || sampling.enabled())) {
+        throw std::invalid_argument(
+            "Expected timed or sampled simulations to be run without checkpoints");
+    }
+
+    auto P = ws.size();
+    InterleavedMemoryReferenceStream stream(ws, interleaving);
+    uint64_t T = stream.size();
+
+    hierarchy.reset(P, num_numa_domains);
+    if (timing)
+        timing->reset(P);
+    SamplingStatistics local_statistics;
+    if (!statistics)
+        statistics = &local_statistics;
+    statistics->reset(P, hierarchy.num_caches());
+    SamplingWindow previous_window = SamplingWindow::skip;
+
+    // Resume from a checkpoint by skipping the memory references that
+    // were already simulated.
+    auto save_state = [&hierarchy] (std::ostream & o) { hierarchy.save(o); };
+    auto load_state = [&hierarchy] (std::istream & i) { hierarchy.load(i); };
+    uint64_t fingerprint = checkpointing ? Checkpoint::fingerprint(ws) : 0;
+    uint64_t position = checkpointing
+        ? checkpoint->load(T, P, num_numa_domains, fingerprint, load_state) : 0;
+    auto last_checkpoint = std::chrono::steady_clock::now();
+
+    if (verbose && progress_interval > 0) {
+        print_progress = 0;
+        signal(SIGALRM, signal_handler);
+        alarm(progress_interval);
+    }
+
+    std::size_t p;
+    auto const * x = position < T ? stream.next(p) : nullptr;
+    while (x && stream.position() <= position)
+        x = stream.next(p);
+    for (; x; x = stream.next(p)) {
+        if (checkpointing && (stream.position() & 0xffff) == 0 &&
+            checkpoint->due(last_checkpoint))
+        {
+            checkpoint->save(
+                stream.position() - 1, T, P, num_numa_domains, fingerprint,
+                save_state);
+        }
+
+        if (verbose && progress_interval > 0 && print_progress) {
+            uint64_t t = stream.position();
+            fprintf(stderr, "%'" PRIu64 " of %'" PRIu64 " (%4.1f %%)\n",
+                    t, T, 100.0 * (t / (double) T));
+            print_progress = 0;
+            alarm(progress_interval);
+        }
+
+        if (sampling.enabled()) {
+            SamplingWindow window = sampling.window(stream.position() - 1);
+            statistics->reference(p, window);
+            if (previous_window == SamplingWindow::detailed &&
+                window != SamplingWindow::detailed)
+            {
+                statistics->end_window(
+                    total_cache_misses_per_cache(hierarchy));
+            }
+            previous_window = window;
+            if (window == SamplingWindow::skip)
+                continue;
+            hierarchy.count(window == SamplingWindow::detailed);
+        }
+
+        int served_by = hierarchy.reference(
+            first_level_caches[p], x->address(), p, x->numa_domain(),
+            x->access_type());
+        if (timing) {
+            timing->reference(
+                p, first_level_caches[p], served_by, x->numa_domain());
+        }
+    }
+
+    if (verbose && progress_interval > 0) {
+        alarm(0);
+        signal(SIGALRM, SIG_DFL);
+        fprintf(stderr, "%'" PRIu64 " of %'" PRIu64 " (%4.1f %%)\n", T, T, 100.0);
+    }
+
+    if (checkpointing)
+        checkpoint->save(T, T, P, num_numa_domains, fingerprint, save_state);
+
+    if (sampling.enabled()) {
+        hierarchy.count(true);
+        if (previous_window == SamplingWindow::detailed)
+            statistics->end_window(total_cache_misses_per_cache(hierarchy));
+        hierarchy.extrapolate(*statistics);
+    }
+    return hierarchy.cache_misses();
+}
+
+}
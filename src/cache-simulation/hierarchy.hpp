@@ -0,0 +1,365 @@
+#ifndef HIERARCHY_HPP
+#define HIERARCHY_HPP
+
+#include "cache-simulation/heatmap.hpp"
+#include "cache-simulation/memory-region.hpp"
+#include "cache-simulation/prefetch.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <vector>
+
+namespace replacement
+{
+
+class TimingModel;
+
+/*
+ * The relationship between a cache and the caches below it, that is,
+ * its children, which are closer to the CPU.
+ *
+ * A non-inclusive cache is filled whenever one of its children misses,
+ * but it evicts cache lines without regard to its children.  An
+ * inclusive cache also invalidates the cache lines that it evicts in
+ * all of its descendants (back-invalidation), so that it always holds
+ * every cache line held by its descendants.  An exclusive cache is
+ * only filled with the cache lines that are evicted from its children
+ * (a victim cache), and a cache line is moved to the child, rather
+ * than copied, when the child misses.
+ *
+ * Dirty cache lines that are evicted from a cache are written back
+ * to the nearest ancestor that holds the cache line, or else to
+ * memory.  An exclusive cache is instead filled with the dirty cache
+ * line, and a back-invalidated dirty cache line is written back
+ * together with the evicted cache line of the inclusive cache.
+ *
+ * A cache may have a prefetcher, which observes the demand accesses
+ * that reach the cache.  Prefetched cache lines are requested from
+ * the parent like cache misses, but they are counted as prefetch
+ * fills rather than cache misses in every cache that they are filled
+ * into, and they do not train the prefetchers of those caches.
+ *
+ * Optionally, the caches are kept coherent with a MESI-style protocol,
+ * where the caches of a processor are the first-level cache that it
+ * is attached to and that cache's ancestors, and every other cache is
+ * remote to the processor.  A store invalidates the cache line in
+ * every remote cache, taking over any dirty data, and a load that
+ * misses in the first-level cache makes every remote cache that holds
+ * the cache line dirty write it back, after which it is clean
+ * (shared).  A cache miss on a cache line that was invalidated by a
+ * remote store is a coherence miss, and it is also a false-sharing
+ * miss if the remote store was to a different address than the one
+ * that missed.  Streaming stores invalidate the remote caches, too.
+ */
+enum class InclusionPolicy
+{
+    non_inclusive,
+    inclusive,
+    exclusive,
+};
+
+/*
+ * A memory hierarchy, consisting of a tree (or forest) of caches,
+ * where only the cache misses of a cache are forwarded to its parent.
+ */
+class CacheHierarchy
+{
+public:
+    CacheHierarchy();
+    ~CacheHierarchy();
+
+    /*
+     * Add a cache to the hierarchy and return its index.  The parent
+     * is the index of a cache that was added before, or -1 for a
+     * last-level cache.  The prefetcher, if any, must outlive the
+     * hierarchy.
+     */
+    int add_cache(
+        ReplacementAlgorithm & cache,
+        int parent,
+        InclusionPolicy inclusion_policy = InclusionPolicy::non_inclusive,
+        Prefetcher * prefetcher = nullptr);
+
+    int num_caches() const;
+
+    /*
+     * Keep the caches coherent, and count the invalidations,
+     * coherence misses and false-sharing misses of each cache for
+     * each of the given memory regions, which must outlive the
+     * hierarchy.
+     */
+    void enable_coherence(
+        MemoryRegions const & regions);
+
+    /*
+     * Attribute the cache misses of each cache to the given memory
+     * regions, which must outlive the hierarchy.
+     */
+    void attribute_cache_misses(
+        MemoryRegions const & regions);
+
+    /*
+     * Count the cache misses of each cache in a copy of the given
+     * empty heatmap, at the location in the matrix of the processor
+     * that made them, which is found by the given locator.  The
+     * locator must outlive the hierarchy.
+     */
+    void enable_heatmaps(
+        MatrixLocator const & locator,
+        Heatmap const & heatmap);
+
+    /*
+     * Reference a memory location from a processor attached to the
+     * given first-level cache.  Cache misses and write-backs are
+     * counted for each cache, processor and NUMA domain.  Streaming
+     * stores bypass every cache between the processor and memory.
+     *
+     * Return the cache that held the referenced cache line, or -1 if
+     * it was fetched from (or, for a streaming store, written to)
+     * memory.
+     */
+    int reference(
+        int cache,
+        memory_reference_type x,
+        std::size_t p,
+        numa_domain_type numa_domain,
+        AccessType access_type = AccessType::load);
+
+    /*
+     * Reset the counts of cache misses, write-backs and prefetches
+     * for the given number of processors and NUMA domains.
+     */
+    void reset(
+        std::size_t num_processors,
+        numa_domain_type num_numa_domains);
+
+    /*
+     * Stop or resume counting.  While counting is stopped, for
+     * instance during the warm-up windows of a sampled simulation,
+     * the caches are updated as usual, but the counts of cache
+     * misses, write-backs, prefetches and coherence events are
+     * discarded.
+     */
+    void count(
+        bool counting);
+
+    /*
+     * Extrapolate the counts of a sampled simulation to every memory
+     * reference.
+     */
+    void extrapolate(
+        SamplingStatistics const & statistics);
+
+    /*
+     * Save or restore the counts and the state of every cache and
+     * prefetcher of the hierarchy for a checkpoint.
+     */
+    void save(
+        std::ostream & o) const;
+    void load(
+        std::istream & i);
+
+    /*
+     * The cache misses for each cache, processor and NUMA domain.
+     */
+    std::vector<std::vector<std::vector<cache_miss_type>>> const &
+        cache_misses() const;
+
+    /*
+     * The write-backs from each cache to its parent or to memory, for
+     * each processor and NUMA domain.
+     */
+    std::vector<std::vector<std::vector<cache_miss_type>>> const &
+        write_backs() const;
+
+    /*
+     * The prefetch fills and useful prefetches for each cache,
+     * processor and NUMA domain.
+     */
+    std::vector<std::vector<std::vector<cache_miss_type>>> const &
+        prefetch_fills() const;
+    std::vector<std::vector<std::vector<cache_miss_type>>> const &
+        useful_prefetches() const;
+
+    /*
+     * The cache misses for each cache and memory region, if they are
+     * attributed to memory regions, and otherwise, none.
+     */
+    std::vector<std::vector<cache_miss_type>> const &
+        cache_misses_per_region() const;
+
+    /*
+     * The heatmaps of the cache misses of each cache, if they are
+     * enabled, and otherwise, none.
+     */
+    std::vector<Heatmap> const & heatmaps() const;
+
+    /*
+     * The invalidations by remote stores, coherence misses and
+     * false-sharing misses for each cache and memory region.
+     */
+    std::vector<std::vector<cache_miss_type>> const &
+        invalidations() const;
+    std::vector<std::vector<cache_miss_type>> const &
+        coherence_misses() const;
+    std::vector<std::vector<cache_miss_type>> const &
+        false_sharing() const;
+
+private:
+    void count_cache_miss(
+        int cache,
+        memory_reference_type x,
+        std::size_t p,
+        numa_domain_type numa_domain);
+    void snoop(
+        int cache,
+        memory_reference_type x,
+        std::size_t p,
+        AccessType access_type);
+    bool request(
+        int cache,
+        memory_reference_type x,
+        std::size_t p,
+        numa_domain_type numa_domain,
+        bool prefetch);
+    void fill(
+        int cache,
+        memory_reference_type x,
+        std::size_t p,
+        numa_domain_type numa_domain,
+        AccessType access_type,
+        bool prefetch);
+    void evict(
+        int cache,
+        memory_reference_type victim,
+        std::size_t p,
+        numa_domain_type numa_domain,
+        numa_domain_type write_back);
+    void write_back(
+        int cache,
+        memory_reference_type x,
+        std::size_t p,
+        numa_domain_type numa_domain);
+    numa_domain_type back_invalidate(
+        int cache,
+        memory_reference_type victim);
+
+private:
+    std::vector<ReplacementAlgorithm *> caches;
+    std::vector<int> parents;
+    std::vector<std::vector<int>> children;
+    std::vector<InclusionPolicy> inclusion_policies;
+    std::vector<Prefetcher *> prefetchers;
+    std::vector<memory_reference_type> prefetches;
+    std::vector<std::vector<std::vector<cache_miss_type>>> cache_misses_;
+    std::vector<std::vector<std::vector<cache_miss_type>>> write_backs_;
+    std::vector<std::vector<std::vector<cache_miss_type>>> prefetch_fills_;
+    std::vector<std::vector<std::vector<cache_miss_type>>> useful_prefetches_;
+    MemoryRegions const * attribution;
+    std::vector<std::vector<cache_miss_type>> cache_misses_per_region_;
+    MatrixLocator const * locator;
+    Heatmap empty_heatmap;
+    std::vector<MatrixLocation> locations;
+    std::vector<Heatmap> heatmaps_;
+    MemoryRegions const * regions;
+    std::vector<std::vector<int>> remote_caches;
+    std::vector<FlatHashMap<memory_reference_type, memory_reference_type>>
+        invalidated_lines;
+    std::vector<std::vector<cache_miss_type>> invalidations_;
+    std::vector<std::vector<cache_miss_type>> coherence_misses_;
+    std::vector<std::vector<cache_miss_type>> false_sharing_;
+
+    // The counts that are discarded while counting is stopped
+    bool counting;
+    std::vector<std::vector<std::vector<std::vector<cache_miss_type>>>>
+        discarded_counts;
+    std::vector<std::vector<std::vector<cache_miss_type>>>
+        discarded_coherence_counts;
+    std::vector<std::vector<cache_miss_type>>
+        discarded_cache_misses_per_region;
+    std::vector<Heatmap> discarded_heatmaps;
+
+    // The cache that held the cache line of the current memory
+    // reference, or -1 for memory
+    int served_by;
+};
+
+/*
+ * Options for simulating a memory hierarchy with `trace_cache_misses'.
+ */
+struct CacheHierarchyTraceOptions
+{
+    CacheHierarchyTraceOptions()
+        : verbose(false)
+        , progress_interval(0)
+        , interleaving()
+        , timing(nullptr)
+        , sampling()
+        , statistics(nullptr)
+        , checkpoint(nullptr)
+    {
+    }
+
+    /*
+     * Report the progress of the simulation to standard error, every
+     * `progress_interval' seconds if it is positive.
+     */
+    bool verbose;
+    int progress_interval;
+
+    /*
+     * The interleaving of the memory reference strings of the
+     * processors, which is round-robin by default.
+     */
+    Interleaving interleaving;
+
+    /*
+     * If given, the timing model is advanced by every memory
+     * reference.
+     */
+    TimingModel * timing;
+
+    /*
+     * If sampling is enabled, only the memory references in the
+     * detailed windows are counted, and only those in the warm-up
+     * windows are otherwise simulated.  The counts are then
+     * extrapolated, and, if given, the statistics of each cache are
+     * kept in `statistics'.
+     */
+    Sampling sampling;
+    SamplingStatistics * statistics;
+
+    /*
+     * If given and enabled, the simulation is checkpointed
+     * periodically, and resumed from a previous checkpoint, if
+     * requested.  This cannot be combined with a timing model or with
+     * sampling.
+     */
+    Checkpoint const * checkpoint;
+};
+
+/*
+ * Compute the cache misses in every cache of a memory hierarchy for
+ * the interleaved memory reference strings of multiple processors,
+ * where processor `p' is attached to the first-level cache
+ * `first_level_caches[p]', with the given options (see
+ * `CacheHierarchyTraceOptions').
+ *
+ * The result is given for each cache, processor and NUMA domain.
+ */
+std::vector<std::vector<std::vector<cache_miss_type>>> trace_cache_misses(
+    CacheHierarchy & hierarchy,
+    std::vector<int> const & first_level_caches,
+    std::vector<MemoryReferenceString> const & ws,
+    numa_domain_type num_numa_domains,
+    CacheHierarchyTraceOptions const & options = CacheHierarchyTraceOptions());
+
+std::vector<std::vector<std::vector<cache_miss_type>>> trace_cache_misses(
+    CacheHierarchy & hierarchy,
+    std::vector<int> const & first_level_caches,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    numa_domain_type num_numa_domains,
+    CacheHierarchyTraceOptions const & options = CacheHierarchyTraceOptions());
+
+}
+
+#endif
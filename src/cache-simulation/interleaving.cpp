@@ -0,0 +1,145 @@
+#include "cache-simulation/replacement.hpp"
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace replacement
+{
+
+Interleaving::Interleaving(
+    InterleavingPolicy policy,
+    std::vector<double> const & bandwidth_per_numa_domain,
+    uint64_t seed)
+    : policy_(policy)
+    , bandwidth_per_numa_domain_(bandwidth_per_numa_domain)
+    , seed_(seed)
+{
+    if (policy != InterleavingPolicy::bandwidth)
+        return;
+    if (bandwidth_per_numa_domain.empty()) {
+        throw std::invalid_argument(
+            "Expected a bandwidth for each NUMA domain");
+    }
+    for (double bandwidth : bandwidth_per_numa_domain) {
+        if (!(bandwidth > 0.0)) {
+            throw std::invalid_argument(
+                "Expected the bandwidth of each NUMA domain to be positive");
+        }
+    }
+}
+
+Interleaving::~Interleaving()
+{
+}
+
+InterleavingPolicy Interleaving::policy() const
+{
+    return policy_;
+}
+
+std::vector<double> const & Interleaving::bandwidth_per_numa_domain() const
+{
+    return bandwidth_per_numa_domain_;
+}
+
+uint64_t Interleaving::seed() const
+{
+    return seed_;
+}
+
+InterleavedMemoryReferenceStream::InterleavedMemoryReferenceStream(
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    Interleaving const & interleaving)
+    : policy(interleaving.policy())
+    , streams()
+    , active()
+    , turn(0)
+    , clocks(ws.size(), 0.0)
+    , reference_time()
+    , rng(interleaving.seed())
+    , size_(0)
+    , position_(0)
+{
+    streams.reserve(ws.size());
+    for (auto p = 0u; p < ws.size(); ++p) {
+        streams.emplace_back(*ws[p]);
+        size_ += streams[p].size();
+        if (!streams[p].empty())
+            active.push_back(p);
+    }
+    for (double bandwidth : interleaving.bandwidth_per_numa_domain())
+        reference_time.push_back(1.0 / bandwidth);
+}
+
+InterleavedMemoryReferenceStream::~InterleavedMemoryReferenceStream()
+{
+}
+
+uint64_t InterleavedMemoryReferenceStream::size() const
+{
+    return size_;
+}
+
+uint64_t InterleavedMemoryReferenceStream::position() const
+{
+    return position_;
+}
+
+MemoryReferenceString::value_type const * InterleavedMemoryReferenceStream::next(
+    std::size_t & p)
+{
+    if (active.empty())
+        return nullptr;
+
+    // Choose the processor to make the next memory reference.  Ties
+    // between the clocks of processors are broken in their order, so
+    // that equal bandwidths give a round-robin interleaving.
+    std::size_t i = 0;
+    if (policy == InterleavingPolicy::round_robin) {
+        i = turn;
+    } else if (policy == InterleavingPolicy::bandwidth) {
+        for (std::size_t j = 1; j < active.size(); j++) {
+            if (clocks[active[j]] < clocks[active[i]])
+                i = j;
+        }
+    } else {
+        i = std::uniform_int_distribution<std::size_t>(
+            0, active.size()-1)(rng);
+    }
+
+    p = active[i];
+    auto const & x = streams[p].next();
+    position_++;
+    if (policy == InterleavingPolicy::bandwidth) {
+        // NUMA domains beyond the given bandwidths share the bandwidth
+        // of the last NUMA domain.
+        numa_domain_type numa_domain = x.numa_domain();
+        clocks[p] += (std::size_t) numa_domain < reference_time.size()
+            ? reference_time[numa_domain] : reference_time.back();
+    }
+
+    if (streams[p].empty())
+        active.erase(active.begin() + i);
+    else
+        i++;
+    turn = (i < active.size()) ? i : 0;
+    return &x;
+}
+
+std::size_t InterleavedMemoryReferenceStream::next(
+    std::size_t count,
+    MemoryReferenceString::value_type * x,
+    std::size_t * p)
+{
+    std::size_t n = 0;
+    for (; n < count; n++) {
+        auto const * y = next(p[n]);
+        if (!y)
+            break;
+        x[n] = *y;
+    }
+    return n;
+}
+
+}
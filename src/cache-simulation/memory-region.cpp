@@ -0,0 +1,175 @@
+#include "cache-simulation/memory-region.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace replacement
+{
+
+MemoryRegions::MemoryRegions()
+    : MemoryRegions(std::vector<MemoryRegion>())
+{
+}
+
+MemoryRegions::MemoryRegions(
+    std::vector<MemoryRegion> const & unsorted_regions)
+    : begins()
+    , ends()
+    , indices()
+    , names()
+{
+    std::vector<std::size_t> order(unsorted_regions.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(),
+        [&unsorted_regions] (std::size_t i, std::size_t j) {
+            return unsorted_regions[i].begin < unsorted_regions[j].begin; });
+
+    // Empty regions hold no memory references, but they keep their
+    // index, so that they can still be named.
+    for (std::size_t i : order) {
+        if (unsorted_regions[i].begin < unsorted_regions[i].end) {
+            begins.push_back(unsorted_regions[i].begin);
+            ends.push_back(unsorted_regions[i].end);
+            indices.push_back(i);
+        }
+    }
+    for (auto const & region : unsorted_regions)
+        names.push_back(region.name);
+    names.push_back("other");
+}
+
+MemoryRegions::~MemoryRegions()
+{
+}
+
+std::size_t MemoryRegions::size() const
+{
+    return names.size();
+}
+
+std::string const & MemoryRegions::name(
+    std::size_t region) const
+{
+    return names[region];
+}
+
+std::size_t MemoryRegions::find(
+    memory_reference_type x) const
+{
+    // There are only a few regions, so a linear search is faster
+    // than a binary search.
+    std::size_t n = begins.size();
+    std::size_t i = 0;
+    while (i < n && begins[i] <= x)
+        i++;
+    if (i == 0 || x >= ends[i-1])
+        return names.size() - 1;
+    return indices[i-1];
+}
+
+constexpr memory_reference_type MemoryRelocation::alignment;
+constexpr memory_reference_type MemoryRelocation::base;
+
+MemoryRelocation::MemoryRelocation()
+    : MemoryRelocation(std::vector<MemoryRegion>())
+{
+}
+
+MemoryRelocation::MemoryRelocation(
+    std::vector<MemoryRegion> const & unsorted_regions)
+    : regions_(unsorted_regions)
+    , begins()
+    , ends()
+    , displacements()
+{
+    std::vector<std::size_t> order(unsorted_regions.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(),
+        [&unsorted_regions] (std::size_t i, std::size_t j) {
+            return unsorted_regions[i].begin < unsorted_regions[j].begin; });
+
+    memory_reference_type next = base;
+    for (std::size_t i : order) {
+        MemoryRegion const & region = unsorted_regions[i];
+        memory_reference_type begin =
+            next + region.begin % alignment;
+        memory_reference_type displacement = begin - region.begin;
+        regions_[i].begin = begin;
+        regions_[i].end = region.end + displacement;
+        if (region.begin < region.end) {
+            begins.push_back(region.begin);
+            ends.push_back(region.end);
+            displacements.push_back(displacement);
+        }
+        next = (regions_[i].end + alignment - 1) / alignment * alignment;
+    }
+}
+
+MemoryRelocation::~MemoryRelocation()
+{
+}
+
+bool MemoryRelocation::empty() const
+{
+    return regions_.empty();
+}
+
+std::vector<MemoryRegion> const & MemoryRelocation::regions() const
+{
+    return regions_;
+}
+
+memory_reference_type MemoryRelocation::relocate(
+    memory_reference_type x) const
+{
+    std::size_t n = begins.size();
+    std::size_t i = 0;
+    while (i < n && begins[i] <= x)
+        i++;
+    if (i == 0 || x >= ends[i-1])
+        return x;
+    return x + displacements[i-1];
+}
+
+void MemoryRelocation::relocate(
+    uint64_t count,
+    MemoryReferenceString::value_type * w) const
+{
+    for (uint64_t i = 0; i < count; i++) {
+        w[i] = MemoryReference(
+            relocate(w[i].address()), w[i].numa_domain(), w[i].access_type());
+    }
+}
+
+RelocatedMemoryReferenceGenerator::RelocatedMemoryReferenceGenerator(
+    std::unique_ptr<MemoryReferenceGenerator> generator,
+    MemoryRelocation const & relocation)
+    : generator(std::move(generator))
+    , relocation(relocation)
+{
+}
+
+RelocatedMemoryReferenceGenerator::~RelocatedMemoryReferenceGenerator()
+{
+}
+
+uint64_t RelocatedMemoryReferenceGenerator::size() const
+{
+    return generator->size();
+}
+
+void RelocatedMemoryReferenceGenerator::generate(
+    uint64_t offset,
+    uint64_t count,
+    MemoryReferenceString::value_type * w) const
+{
+    generator->generate(offset, count, w);
+    relocation.relocate(count, w);
+}
+
+}
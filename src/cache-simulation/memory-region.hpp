@@ -0,0 +1,153 @@
+#ifndef MEMORY_REGION_HPP
+#define MEMORY_REGION_HPP
+
+#include "cache-simulation/replacement.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace replacement
+{
+
+/*
+ * A named, contiguous range of memory addresses, such as one of the
+ * arrays of a kernel, that memory references may be attributed to.
+ */
+struct MemoryRegion
+{
+    std::string name;
+    memory_reference_type begin;
+    memory_reference_type end;
+};
+
+/*
+ * Describe the memory occupied by the elements of an array.
+ */
+template <typename Array>
+MemoryRegion make_memory_region(
+    std::string const & name,
+    Array const & a)
+{
+    memory_reference_type begin = memory_reference_type(a.data());
+    return MemoryRegion{
+        name, begin, begin + a.size() * sizeof(typename Array::value_type)};
+}
+
+/*
+ * A registry of non-overlapping memory regions, which finds the region
+ * that a memory reference belongs to.  Memory references outside of
+ * every region belong to an additional region, `other'.
+ */
+class MemoryRegions
+{
+public:
+    MemoryRegions();
+    MemoryRegions(
+        std::vector<MemoryRegion> const & regions);
+    ~MemoryRegions();
+
+    /*
+     * The number of regions, including `other', which is the last.
+     */
+    std::size_t size() const;
+
+    std::string const & name(
+        std::size_t region) const;
+
+    /*
+     * Find the index of the region holding the given memory reference.
+     */
+    std::size_t find(
+        memory_reference_type x) const;
+
+private:
+    // The first and last addresses of the non-empty regions, sorted
+    // by their first address, and kept in separate arrays to make
+    // lookups, which happen for every cache miss, fast.
+    std::vector<memory_reference_type> begins;
+    std::vector<memory_reference_type> ends;
+    std::vector<std::size_t> indices;
+    std::vector<std::string> names;
+};
+
+/*
+ * A relocation of the memory regions of a kernel to fixed addresses,
+ * so that its memory references no longer depend on where its arrays
+ * happened to be allocated, for example, because of address space
+ * layout randomisation.
+ *
+ * The regions are placed one after another, in the order of their
+ * addresses, starting at `base'.  Each region keeps its offset within
+ * a page of `alignment' bytes, which, unlike the pages themselves, is
+ * the same every time a kernel is run, so that the cache lines of the
+ * memory references within a region are unchanged.  Memory references
+ * outside every region are not relocated.
+ */
+class MemoryRelocation
+{
+public:
+    static constexpr memory_reference_type alignment = 4096u;
+    static constexpr memory_reference_type base =
+        memory_reference_type(1) << 50;
+
+public:
+    MemoryRelocation();
+    MemoryRelocation(
+        std::vector<MemoryRegion> const & regions);
+    ~MemoryRelocation();
+
+    bool empty() const;
+
+    /*
+     * The regions at their relocated addresses, in their original
+     * order.
+     */
+    std::vector<MemoryRegion> const & regions() const;
+
+    memory_reference_type relocate(
+        memory_reference_type x) const;
+
+    void relocate(
+        uint64_t count,
+        MemoryReferenceString::value_type * w) const;
+
+private:
+    std::vector<MemoryRegion> regions_;
+
+    // The first and last addresses of the non-empty regions, sorted
+    // by their first address, and the distance that each is moved.
+    std::vector<memory_reference_type> begins;
+    std::vector<memory_reference_type> ends;
+    std::vector<memory_reference_type> displacements;
+};
+
+/*
+ * A generator of the relocated memory references of another
+ * generator.  Both the generator and the relocation must outlive it.
+ */
+class RelocatedMemoryReferenceGenerator
+    : public MemoryReferenceGenerator
+{
+public:
+    RelocatedMemoryReferenceGenerator(
+        std::unique_ptr<MemoryReferenceGenerator> generator,
+        MemoryRelocation const & relocation);
+    ~RelocatedMemoryReferenceGenerator();
+
+    uint64_t size() const override;
+
+    void generate(
+        uint64_t offset,
+        uint64_t count,
+        MemoryReferenceString::value_type * w) const override;
+
+private:
+    std::unique_ptr<MemoryReferenceGenerator> generator;
+    MemoryRelocation const & relocation;
+};
+
+}
+
+#endif
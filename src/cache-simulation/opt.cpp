@@ -0,0 +1,187 @@
+#include "cache-simulation/checkpoint.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace replacement
+{
+
+using cache_reference_type = uintptr_t;
+
+constexpr OPT::time_type OPT::never;
+
+OPT::OPT(
+    cache_size_type cache_lines,
+    cache_size_type cache_line_size,
+    MemoryReferenceString const & w,
+    int passes)
+    : ReplacementAlgorithm(
+        cache_lines,
+        cache_line_size)
+    , passes(passes)
+    , next_use()
+    , clock(0u)
+    , lines()
+    , index(std::numeric_limits<memory_reference_type>::max(), cache_lines)
+{
+    next_use.reserve(w.size());
+    for (auto const & x : w) {
+        if (x.access_type() != AccessType::streaming_store)
+            next_use.push_back(x.address() / cache_line_size);
+    }
+    compute_next_uses();
+}
+
+OPT::OPT(
+    cache_size_type cache_lines,
+    cache_size_type cache_line_size,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    int passes,
+    Interleaving const & interleaving)
+    : ReplacementAlgorithm(
+        cache_lines,
+        cache_line_size)
+    , passes(passes)
+    , next_use()
+    , clock(0u)
+    , lines()
+    , index(std::numeric_limits<memory_reference_type>::max(), cache_lines)
+{
+    // Interleave the cache lines referenced by each processor in the
+    // same way as the simulation, except for streaming stores, which
+    // bypass the cache.
+    InterleavedMemoryReferenceStream stream(ws, interleaving);
+    next_use.reserve(stream.size());
+    std::size_t p;
+    for (auto const * x = stream.next(p); x; x = stream.next(p)) {
+        if (x->access_type() != AccessType::streaming_store)
+            next_use.push_back(x->address() / cache_line_size);
+    }
+    compute_next_uses();
+}
+
+OPT::~OPT()
+{
+}
+
+/*
+ * Replace the cache line of each memory reference by the time of the
+ * next reference to the same cache line, in a single backward pass.
+ */
+void OPT::compute_next_uses()
+{
+    time_type T = next_use.size();
+    FlatHashMap<memory_reference_type, time_type> next_reference(
+        std::numeric_limits<memory_reference_type>::max());
+    std::vector<std::pair<memory_reference_type, time_type>> last_uses;
+    for (time_type t = T; t-- > 0;) {
+        cache_reference_type y = next_use[t];
+        time_type * s = next_reference.find(y);
+        if (s) {
+            next_use[t] = *s;
+            *s = t;
+        } else {
+            next_use[t] = never;
+            next_reference.insert(y, t);
+            if (passes > 1)
+                last_uses.emplace_back(y, t);
+        }
+    }
+
+    // Unless it is the final pass, the last use of a cache line is
+    // followed by its first use in the next pass.
+    for (auto const & last_use : last_uses)
+        next_use[last_use.second] = T + *next_reference.find(last_use.first);
+}
+
+cache_miss_type OPT::allocate(
+    memory_reference_type x,
+    numa_domain_type numa_domain)
+{
+    victim_line = no_victim;
+    cache_reference_type y = x / cache_line_size;
+
+    time_type T = next_use.size();
+    time_type pass = clock / T;
+    time_type next = next_use[clock % T];
+    clock++;
+    if (next != never) {
+        if (next >= T && pass + 1 >= (time_type) passes)
+            next = never;
+        else
+            next += pass * T;
+    }
+
+    auto * it = index.find(y);
+    if (it) {
+        lines.erase(std::make_pair(it->first, y));
+        lines.emplace(next, y);
+        it->first = next;
+        allocated_line = &it->second;
+        return 0u;
+    }
+    if (cache_lines == 0u)
+        return 1u;
+
+    // Replace the cache line whose next use is farthest away.
+    if (index.size() >= cache_lines) {
+        auto victim = std::prev(lines.end());
+        victim_line = (*victim).second;
+        victim_state = index.find(victim_line)->second;
+        index.erase(victim_line);
+        lines.erase(victim);
+    }
+    lines.emplace(next, y);
+    allocated_line = &index.insert(
+        y, std::make_pair(next, CacheLineState())).second;
+    return 1u;
+}
+
+bool OPT::invalidate(
+    memory_reference_type x)
+{
+    cache_reference_type y = x / cache_line_size;
+    auto * it = index.find(y);
+    if (!it)
+        return false;
+    lines.erase(std::make_pair(it->first, y));
+    index.erase(y);
+    return true;
+}
+
+bool OPT::contains(
+    memory_reference_type x) const
+{
+    return index.find(x / cache_line_size) != nullptr;
+}
+
+CacheLineState * OPT::find_line(
+    memory_reference_type y)
+{
+    auto * it = index.find(y);
+    return it ? &it->second : nullptr;
+}
+
+void OPT::save(
+    std::ostream & o) const
+{
+    ReplacementAlgorithm::save(o);
+    replacement::save(o, clock);
+    replacement::save(o, lines);
+    replacement::save(o, index);
+}
+
+void OPT::load(
+    std::istream & i)
+{
+    ReplacementAlgorithm::load(i);
+    replacement::load(i, clock);
+    replacement::load(i, lines);
+    replacement::load(i, index);
+}
+
+}
@@ -0,0 +1,220 @@
+#include "cache-simulation/checkpoint.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <vector>
+
+namespace replacement
+{
+
+using cache_reference_type = uintptr_t;
+
+SetAssociativePLRU::SetAssociativePLRU(
+    cache_size_type cache_lines,
+    cache_size_type cache_line_size,
+    cache_size_type ways,
+    SetIndexFunction set_index_function)
+    : SetAssociative(
+        cache_lines,
+        cache_line_size,
+        ways,
+        set_index_function)
+    , leaves(1)
+    , tree_bits()
+{
+    while (leaves < ways)
+        leaves *= 2;
+    tree_bits.assign(num_sets * leaves, 0);
+}
+
+SetAssociativePLRU::~SetAssociativePLRU()
+{
+}
+
+/*
+ * Set the bits on the path from the root to a way, so that they
+ * point away from it.
+ */
+void SetAssociativePLRU::touch(
+    cache_size_type set,
+    cache_size_type way)
+{
+    uint8_t * t = &tree_bits[set * leaves];
+    cache_size_type node = 1;
+    cache_size_type first = 0;
+    for (cache_size_type size = leaves; size > 1; size /= 2) {
+        cache_size_type half = size / 2;
+        if (way < first + half) {
+            t[node] = 1;
+            node = 2 * node;
+        } else {
+            t[node] = 0;
+            node = 2 * node + 1;
+            first += half;
+        }
+    }
+}
+
+/*
+ * Follow the bits from the root to a way, skipping subtrees that
+ * contain no ways.
+ */
+cache_size_type SetAssociativePLRU::find_victim(
+    cache_size_type set) const
+{
+    uint8_t const * t = &tree_bits[set * leaves];
+    cache_size_type node = 1;
+    cache_size_type first = 0;
+    for (cache_size_type size = leaves; size > 1; size /= 2) {
+        cache_size_type half = size / 2;
+        if (t[node] && first + half < ways) {
+            node = 2 * node + 1;
+            first += half;
+        } else {
+            node = 2 * node;
+        }
+    }
+    return first;
+}
+
+cache_miss_type SetAssociativePLRU::allocate(
+    memory_reference_type x,
+    numa_domain_type numa_domain)
+{
+    return allocate_line(x / cache_line_size, numa_domain);
+}
+
+cache_miss_type SetAssociativePLRU::allocate_line(
+    memory_reference_type y,
+    numa_domain_type numa_domain)
+{
+    victim_line = no_victim;
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    if (way < ways) {
+        touch(set, way);
+        use_way(set, way);
+        return 0u;
+    }
+
+    // Unused ways are filled first.
+    way = find_invalid_way(set);
+    if (way == ways)
+        way = find_victim(set);
+    fill_way(set, way, y);
+    touch(set, way);
+    return 1u;
+}
+
+void SetAssociativePLRU::save(
+    std::ostream & o) const
+{
+    SetAssociative::save(o);
+    replacement::save(o, tree_bits);
+}
+
+void SetAssociativePLRU::load(
+    std::istream & i)
+{
+    SetAssociative::load(i);
+    replacement::load(i, tree_bits);
+}
+
+SetAssociativeNRU::SetAssociativeNRU(
+    cache_size_type cache_lines,
+    cache_size_type cache_line_size,
+    cache_size_type ways,
+    SetIndexFunction set_index_function)
+    : SetAssociative(
+        cache_lines,
+        cache_line_size,
+        ways,
+        set_index_function)
+    , referenced(cache_lines, 0)
+{
+}
+
+SetAssociativeNRU::~SetAssociativeNRU()
+{
+}
+
+/*
+ * Set the reference bit of a way, and clear the bits of the other
+ * ways if every way of the set has now been used.
+ */
+void SetAssociativeNRU::touch(
+    cache_size_type set,
+    cache_size_type way)
+{
+    uint8_t * r = &referenced[set * ways];
+    r[way] = 1;
+    for (cache_size_type w = 0; w < ways; w++) {
+        if (!r[w])
+            return;
+    }
+    for (cache_size_type w = 0; w < ways; w++)
+        r[w] = (w == way);
+}
+
+cache_miss_type SetAssociativeNRU::allocate(
+    memory_reference_type x,
+    numa_domain_type numa_domain)
+{
+    return allocate_line(x / cache_line_size, numa_domain);
+}
+
+cache_miss_type SetAssociativeNRU::allocate_line(
+    memory_reference_type y,
+    numa_domain_type numa_domain)
+{
+    victim_line = no_victim;
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    if (way < ways) {
+        touch(set, way);
+        use_way(set, way);
+        return 0u;
+    }
+
+    // Unused ways are filled first.  Otherwise, some way has a clear
+    // reference bit, since the bits are cleared as soon as every way
+    // has been used, unless there is only a single way.
+    way = find_invalid_way(set);
+    if (way == ways) {
+        uint8_t const * r = &referenced[set * ways];
+        way = 0;
+        while (way < ways - 1 && r[way])
+            way++;
+    }
+    fill_way(set, way, y);
+    touch(set, way);
+    return 1u;
+}
+
+bool SetAssociativeNRU::invalidate(
+    memory_reference_type x)
+{
+    cache_reference_type y = x / cache_line_size;
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    if (way == ways)
+        return false;
+    tags[set * ways + way] = invalid_tag;
+    referenced[set * ways + way] = 0;
+    return true;
+}
+
+void SetAssociativeNRU::save(
+    std::ostream & o) const
+{
+    SetAssociative::save(o);
+    replacement::save(o, referenced);
+}
+
+void SetAssociativeNRU::load(
+    std::istream & i)
+{
+    SetAssociative::load(i);
+    replacement::load(i, referenced);
+}
+
+}
@@ -0,0 +1,176 @@
+#include "cache-simulation/checkpoint.hpp"
+#include "cache-simulation/prefetch.hpp"
+
+#include <vector>
+
+namespace replacement
+{
+
+using cache_reference_type = uintptr_t;
+
+constexpr memory_reference_type Prefetcher::page_size;
+constexpr int StridePrefetcher::default_num_streams;
+
+Prefetcher::Prefetcher(
+    cache_size_type cache_line_size)
+    : cache_line_size(cache_line_size)
+{
+}
+
+Prefetcher::~Prefetcher()
+{
+}
+
+void Prefetcher::save(
+    std::ostream & o) const
+{
+}
+
+void Prefetcher::load(
+    std::istream & i)
+{
+}
+
+void Prefetcher::prefetch_line(
+    memory_reference_type y,
+    int64_t offset,
+    std::vector<memory_reference_type> & prefetches) const
+{
+    cache_reference_type z = y + offset;
+    if ((z * cache_line_size) / page_size != (y * cache_line_size) / page_size)
+        return;
+    prefetches.push_back(z * cache_line_size);
+}
+
+NextLinePrefetcher::NextLinePrefetcher(
+    cache_size_type cache_line_size,
+    int degree)
+    : Prefetcher(cache_line_size)
+    , degree(degree)
+{
+}
+
+NextLinePrefetcher::~NextLinePrefetcher()
+{
+}
+
+void NextLinePrefetcher::access(
+    memory_reference_type x,
+    bool trigger,
+    std::vector<memory_reference_type> & prefetches)
+{
+    if (!trigger)
+        return;
+    cache_reference_type y = x / cache_line_size;
+    for (int i = 1; i <= degree; i++)
+        prefetch_line(y, i, prefetches);
+}
+
+AdjacentLinePrefetcher::AdjacentLinePrefetcher(
+    cache_size_type cache_line_size)
+    : Prefetcher(cache_line_size)
+{
+}
+
+AdjacentLinePrefetcher::~AdjacentLinePrefetcher()
+{
+}
+
+void AdjacentLinePrefetcher::access(
+    memory_reference_type x,
+    bool trigger,
+    std::vector<memory_reference_type> & prefetches)
+{
+    if (!trigger)
+        return;
+    cache_reference_type y = x / cache_line_size;
+    prefetch_line(y, (y % 2 == 0) ? 1 : -1, prefetches);
+}
+
+StridePrefetcher::StridePrefetcher(
+    cache_size_type cache_line_size,
+    int degree,
+    int distance,
+    int num_streams)
+    : Prefetcher(cache_line_size)
+    , degree(degree)
+    , distance(distance)
+    , streams(num_streams, Stream{~memory_reference_type(0), 0, 0, false, 0})
+    , clock(0)
+{
+}
+
+StridePrefetcher::~StridePrefetcher()
+{
+}
+
+void StridePrefetcher::access(
+    memory_reference_type x,
+    bool trigger,
+    std::vector<memory_reference_type> & prefetches)
+{
+    cache_reference_type y = x / cache_line_size;
+    memory_reference_type page = x / page_size;
+    clock++;
+
+    // Find the stream of the accessed page, or else replace the
+    // least recently used stream.
+    Stream * stream = &streams[0];
+    for (auto & s : streams) {
+        if (s.page == page) {
+            stream = &s;
+            break;
+        }
+        if (s.last_access < stream->last_access)
+            stream = &s;
+    }
+    if (stream->page != page) {
+        *stream = Stream{page, y, 0, false, clock};
+        return;
+    }
+    stream->last_access = clock;
+
+    int64_t stride = int64_t(y) - int64_t(stream->last_line);
+    if (stride == 0)
+        return;
+    stream->confirmed = (stride == stream->stride);
+    stream->stride = stride;
+    stream->last_line = y;
+    if (!stream->confirmed)
+        return;
+    for (int i = 0; i < degree; i++)
+        prefetch_line(y, stride * (distance + i), prefetches);
+}
+
+void StridePrefetcher::save(
+    std::ostream & o) const
+{
+    replacement::save(o, uint64_t(streams.size()));
+    for (Stream const & stream : streams) {
+        replacement::save(o, stream.page);
+        replacement::save(o, stream.last_line);
+        replacement::save(o, stream.stride);
+        replacement::save(o, stream.confirmed);
+        replacement::save(o, stream.last_access);
+    }
+    replacement::save(o, clock);
+}
+
+void StridePrefetcher::load(
+    std::istream & i)
+{
+    uint64_t num_streams;
+    replacement::load(i, num_streams);
+    if (num_streams != streams.size())
+        throw checkpoint_error("Expected a checkpoint of a prefetcher with the same number of streams");
+    for (Stream & stream : streams) {
+        replacement::load(i, stream.page);
+        replacement::load(i, stream.last_line);
+        replacement::load(i, stream.stride);
+        replacement::load(i, stream.confirmed);
+        replacement::load(i, stream.last_access);
+    }
+    replacement::load(i, clock);
+}
+
+}
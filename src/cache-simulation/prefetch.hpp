@@ -0,0 +1,159 @@
+#ifndef PREFETCH_HPP
+#define PREFETCH_HPP
+
+#include "cache-simulation/replacement.hpp"
+
+#include <iosfwd>
+#include <vector>
+
+namespace replacement
+{
+
+/*
+ * Models of hardware prefetchers, which observe the demand accesses
+ * to a cache and choose cache lines to fill into the cache ahead of
+ * their use.
+ *
+ * Like the prefetchers of real processors, which only see physical
+ * addresses, a prefetcher never crosses a page boundary.  As a
+ * consequence, a prefetched cache line belongs to the same NUMA
+ * domain as the access that triggered it.
+ */
+class Prefetcher
+{
+public:
+    static constexpr memory_reference_type page_size = 4096;
+
+public:
+    Prefetcher(
+        cache_size_type cache_line_size);
+    virtual ~Prefetcher();
+
+    /*
+     * Observe a demand access to the given memory reference, and
+     * append the addresses of the cache lines to prefetch.  The
+     * access is a trigger if it missed in the cache, or if it was
+     * the first use of a prefetched cache line.
+     */
+    virtual void access(
+        memory_reference_type x,
+        bool trigger,
+        std::vector<memory_reference_type> & prefetches) = 0;
+
+    /*
+     * Save or restore the state of the prefetcher for a checkpoint.
+     * Prefetchers without state need not extend these.
+     */
+    virtual void save(
+        std::ostream & o) const;
+    virtual void load(
+        std::istream & i);
+
+protected:
+    /*
+     * Append the cache line `y + offset' to the prefetches, unless it
+     * lies in a different page than the cache line `y'.
+     */
+    void prefetch_line(
+        memory_reference_type y,
+        int64_t offset,
+        std::vector<memory_reference_type> & prefetches) const;
+
+protected:
+    cache_size_type cache_line_size;
+};
+
+/*
+ * A next-line prefetcher, which fetches the `degree' cache lines
+ * following a triggering access.
+ */
+class NextLinePrefetcher
+    : public Prefetcher
+{
+public:
+    NextLinePrefetcher(
+        cache_size_type cache_line_size,
+        int degree = 1);
+    ~NextLinePrefetcher();
+
+    void access(
+        memory_reference_type x,
+        bool trigger,
+        std::vector<memory_reference_type> & prefetches) override;
+
+private:
+    int degree;
+};
+
+/*
+ * An adjacent-line prefetcher, which completes the aligned pair of
+ * cache lines that a triggering access belongs to, like the spatial
+ * prefetcher of Intel processors.
+ */
+class AdjacentLinePrefetcher
+    : public Prefetcher
+{
+public:
+    AdjacentLinePrefetcher(
+        cache_size_type cache_line_size);
+    ~AdjacentLinePrefetcher();
+
+    void access(
+        memory_reference_type x,
+        bool trigger,
+        std::vector<memory_reference_type> & prefetches) override;
+};
+
+/*
+ * A stride prefetcher, which tracks a number of streams of accesses,
+ * one per page, like the L2 streamer of Intel processors.  Once two
+ * consecutive accesses to different cache lines of a stream are
+ * separated by the same stride, the prefetcher fetches `degree' cache
+ * lines, starting `distance' strides ahead of the current access.
+ * Every demand access trains the prefetcher, and the least recently
+ * used stream is replaced when a new page is accessed.
+ */
+class StridePrefetcher
+    : public Prefetcher
+{
+public:
+    static constexpr int default_num_streams = 32;
+
+public:
+    StridePrefetcher(
+        cache_size_type cache_line_size,
+        int degree = 1,
+        int distance = 1,
+        int num_streams = default_num_streams);
+    ~StridePrefetcher();
+
+    void access(
+        memory_reference_type x,
+        bool trigger,
+        std::vector<memory_reference_type> & prefetches) override;
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+private:
+    struct Stream
+    {
+        memory_reference_type page;
+        memory_reference_type last_line;
+        int64_t stride;
+        bool confirmed;
+        uint64_t last_access;
+    };
+
+private:
+    int degree;
+    int distance;
+    std::vector<Stream> streams;
+    uint64_t clock;
+};
+
+}
+
+#endif
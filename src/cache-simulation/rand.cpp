@@ -1,7 +1,9 @@
+#include "cache-simulation/checkpoint.hpp"
 #include "cache-simulation/replacement.hpp"
 
-#include <algorithm>
-#include <set>
+#include <limits>
+#include <random>
+#include <vector>
 
 namespace replacement
 {
@@ -11,12 +13,25 @@ using cache_reference_type = uintptr_t;
 RAND::RAND(
     cache_size_type cache_lines,
     cache_size_type cache_line_size,
-    MemoryReferenceSet const & memory_references)
+    MemoryReferenceSet const & initial_state,
+    uint64_t seed)
     : ReplacementAlgorithm(
         cache_lines,
-        cache_line_size,
-        memory_references)
+        cache_line_size)
+    , lines()
+    , states()
+    , index(std::numeric_limits<memory_reference_type>::max(), cache_lines)
+    , rng(seed)
 {
+    lines.reserve(cache_lines);
+    states.reserve(cache_lines);
+    for (auto & memory_reference : initial_state) {
+        if (lines.size() >= cache_lines)
+            break;
+        index.insert(memory_reference, lines.size());
+        lines.push_back(memory_reference);
+        states.emplace_back();
+    }
 }
 
 RAND::~RAND()
@@ -27,15 +42,98 @@ cache_miss_type RAND::allocate(
     memory_reference_type x,
     numa_domain_type numa_domain)
 {
-    cache_reference_type y = x / cache_line_size;
-    auto it = std::find(std::cbegin(memory_references),
-                        std::cend(memory_references), y);
-    if (it != std::cend(memory_references))
+    return allocate_line(x / cache_line_size, numa_domain);
+}
+
+cache_miss_type RAND::allocate_line(
+    memory_reference_type y,
+    numa_domain_type numa_domain)
+{
+    victim_line = no_victim;
+    slot_type * it = index.find(y);
+    if (it) {
+        allocated_line = &states[*it];
         return 0u;
-    if (memory_references.size() == cache_lines)
-        memory_references.erase(std::begin(memory_references));
-    memory_references.insert(y);
+    }
+    if (cache_lines == 0u)
+        return 1u;
+
+    // Fill the cache before replacing a cache line chosen uniformly
+    // at random.
+    if (lines.size() < cache_lines) {
+        index.insert(y, lines.size());
+        lines.push_back(y);
+        states.emplace_back();
+        allocated_line = &states.back();
+        return 1u;
+    }
+
+    slot_type slot = std::uniform_int_distribution<cache_size_type>(
+        0, cache_lines-1)(rng);
+    victim_line = lines[slot];
+    victim_state = states[slot];
+    index.erase(lines[slot]);
+    lines[slot] = y;
+    states[slot] = CacheLineState();
+    allocated_line = &states[slot];
+    index.insert(y, slot);
     return 1u;
 }
 
+bool RAND::invalidate(
+    memory_reference_type x)
+{
+    cache_reference_type y = x / cache_line_size;
+    slot_type * it = index.find(y);
+    if (!it)
+        return false;
+
+    // Move the last cache line into the vacated slot to keep the
+    // slots dense.
+    slot_type slot = *it;
+    index.erase(y);
+    if (slot + 1u < lines.size()) {
+        lines[slot] = lines.back();
+        states[slot] = states.back();
+        *index.find(lines[slot]) = slot;
+    }
+    lines.pop_back();
+    states.pop_back();
+    return true;
+}
+
+
+bool RAND::contains(
+    memory_reference_type x) const
+{
+    return index.find(x / cache_line_size) != nullptr;
+}
+
+CacheLineState * RAND::find_line(
+    memory_reference_type y)
+{
+    slot_type * it = index.find(y);
+    return it ? &states[*it] : nullptr;
+}
+
+void RAND::save(
+    std::ostream & o) const
+{
+    ReplacementAlgorithm::save(o);
+    replacement::save(o, lines);
+    replacement::save(o, states);
+    replacement::save(o, index);
+    replacement::save(o, rng);
+}
+
+void RAND::load(
+    std::istream & i)
+{
+    ReplacementAlgorithm::load(i);
+    replacement::load(i, lines);
+    replacement::load(i, states);
+    replacement::load(i, index);
+    replacement::load(i, rng);
+}
+
 }
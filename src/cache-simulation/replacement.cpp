@@ -1,10 +1,20 @@
+#include "cache-simulation/checkpoint.hpp"
+#include "cache-simulation/heatmap.hpp"
+#include "cache-simulation/memory-region.hpp"
 #include "cache-simulation/replacement.hpp"
+#include "cache-simulation/prefetch.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iterator>
 #include <numeric>
 #include <iostream>
 #include <ostream>
+#include <stdexcept>
+#include <typeinfo>
 #include <utility>
+#include <vector>
 
 #include <inttypes.h>
 #include <signal.h>
@@ -15,18 +25,214 @@
 namespace replacement
 {
 
+constexpr memory_reference_type ReplacementAlgorithm::no_victim;
+constexpr numa_domain_type ReplacementAlgorithm::no_write_back;
+
+void save(
+    std::ostream & o,
+    CacheLineState const & state)
+{
+    save(o, state.dirty);
+    save(o, state.prefetched);
+}
+
+void load(
+    std::istream & i,
+    CacheLineState & state)
+{
+    load(i, state.dirty);
+    load(i, state.prefetched);
+}
+
+cache_miss_type ReplacementAlgorithm::access(
+    memory_reference_type x,
+    numa_domain_type numa_domain,
+    AccessType access_type)
+{
+    write_back_ = no_write_back;
+    useful_prefetch_ = false;
+    allocated_line = nullptr;
+    memory_reference_type y = x / cache_line_size;
+    if (access_type == AccessType::streaming_store) {
+        victim_line = no_victim;
+        invalidate(x);
+        if (y != streaming_store_line)
+            write_back_ = numa_domain;
+        streaming_store_line = y;
+        return 0u;
+    }
+
+    cache_miss_type cache_misses = allocate(x, numa_domain);
+    return complete_access(y, numa_domain, access_type, cache_misses);
+}
+
+/*
+ * Write back any evicted cache line, and update the state of the
+ * cache line that was used by a load or store.
+ */
+cache_miss_type ReplacementAlgorithm::complete_access(
+    memory_reference_type y,
+    numa_domain_type numa_domain,
+    AccessType access_type,
+    cache_miss_type cache_misses)
+{
+    evict_victim();
+
+    // Without any cache lines, stores are written through at once.
+    if (!allocated_line) {
+        if (access_type == AccessType::store)
+            write_back_ = numa_domain;
+        return cache_misses;
+    }
+
+    // A prefetched cache line is useful if it is still in the cache
+    // when it is first used.  Otherwise, it was evicted or
+    // invalidated, and its state was reset when it was filled again.
+    useful_prefetch_ = allocated_line->prefetched;
+    allocated_line->prefetched = false;
+    if (access_type == AccessType::store)
+        allocated_line->dirty = numa_domain;
+    return cache_misses;
+}
+
+cache_miss_type ReplacementAlgorithm::prefetch(
+    memory_reference_type x,
+    numa_domain_type numa_domain)
+{
+    write_back_ = no_write_back;
+    victim_line = no_victim;
+    if (cache_lines == 0u || contains(x))
+        return 0u;
+    allocate(x, numa_domain);
+    evict_victim();
+    allocated_line->prefetched = true;
+    return 1u;
+}
+
+/*
+ * Write back the cache line evicted by the most recent allocation, if
+ * it was dirty.
+ */
+void ReplacementAlgorithm::evict_victim()
+{
+    if (victim_line != no_victim && victim_state.dirty != no_write_back)
+        write_back_ = victim_state.dirty;
+}
+
+bool ReplacementAlgorithm::mark_dirty(
+    memory_reference_type x,
+    numa_domain_type numa_domain)
+{
+    CacheLineState * state = find_line(x / cache_line_size);
+    if (!state)
+        return false;
+    state->dirty = numa_domain;
+    return true;
+}
+
+numa_domain_type ReplacementAlgorithm::clean(
+    memory_reference_type x)
+{
+    CacheLineState * state = find_line(x / cache_line_size);
+    if (!state)
+        return no_write_back;
+    numa_domain_type write_back = state->dirty;
+    state->dirty = no_write_back;
+    return write_back;
+}
+
+void ReplacementAlgorithm::save(
+    std::ostream & o) const
+{
+    replacement::save(o, cache_lines);
+    replacement::save(o, cache_line_size);
+    replacement::save(o, victim_line);
+    replacement::save(o, victim_state);
+    replacement::save(o, write_back_);
+    replacement::save(o, streaming_store_line);
+    replacement::save(o, useful_prefetch_);
+}
+
+void ReplacementAlgorithm::load(
+    std::istream & i)
+{
+    cache_size_type saved_cache_lines, saved_cache_line_size;
+    replacement::load(i, saved_cache_lines);
+    replacement::load(i, saved_cache_line_size);
+    if (saved_cache_lines != cache_lines ||
+        saved_cache_line_size != cache_line_size)
+    {
+        throw checkpoint_error("Expected a checkpoint of a cache of the same size");
+    }
+    replacement::load(i, victim_line);
+    replacement::load(i, victim_state);
+    replacement::load(i, write_back_);
+    replacement::load(i, streaming_store_line);
+    replacement::load(i, useful_prefetch_);
+    allocated_line = nullptr;
+}
+
+MemoryReferenceStringGenerator::MemoryReferenceStringGenerator(
+    MemoryReferenceString const & w)
+    : w(&w)
+{
+}
+
+MemoryReferenceStringGenerator::~MemoryReferenceStringGenerator()
+{
+}
+
+uint64_t MemoryReferenceStringGenerator::size() const
+{
+    return w->size();
+}
+
+void MemoryReferenceStringGenerator::generate(
+    uint64_t offset,
+    uint64_t count,
+    MemoryReferenceString::value_type * v) const
+{
+    std::copy(w->cbegin() + offset, w->cbegin() + offset + count, v);
+}
+
+constexpr std::size_t MemoryReferenceStream::default_chunk_size;
+
+MemoryReferenceStream::MemoryReferenceStream(
+    MemoryReferenceGenerator const & generator,
+    std::size_t chunk_size)
+    : generator(&generator)
+    , size_(generator.size())
+    , position(0u)
+    , chunk(std::min<uint64_t>(chunk_size, size_))
+    , chunk_size(0u)
+    , chunk_position(0u)
+{
+}
+
+MemoryReferenceStream::~MemoryReferenceStream()
+{
+}
+
+void MemoryReferenceStream::read_chunk()
+{
+    chunk_size = std::min<uint64_t>(chunk.size(), size_ - position);
+    generator->generate(position, chunk_size, chunk.data());
+    chunk_position = 0u;
+}
+
 std::vector<cache_miss_type> trace_cache_misses(
     ReplacementAlgorithm & A,
     MemoryReferenceString const & w,
     numa_domain_type num_numa_domains,
-    bool verbose)
+    bool verbose,
+    int progress_interval)
 {
     std::vector<cache_miss_type> cache_misses(num_numa_domains, 0);
     for (auto const & x : w) {
-        memory_reference_type const & memory_reference = x.first;
-        numa_domain_type const & numa_domain = x.second;
+        memory_reference_type memory_reference = x.address();
+        numa_domain_type numa_domain = x.numa_domain();
         cache_misses[numa_domain] +=
-            A.allocate(memory_reference, numa_domain);
+            A.access(memory_reference, numa_domain, x.access_type());
     }
     return cache_misses;
 }
@@ -45,60 +251,380 @@ std::vector<std::vector<cache_miss_type>> trace_cache_misses(
     bool verbose,
     int progress_interval)
 {
-    auto P = ws.size();
+    std::vector<MemoryReferenceStringGenerator> generators(
+        ws.cbegin(), ws.cend());
+    std::vector<MemoryReferenceGenerator const *> generator_ptrs;
+    for (auto const & generator : generators)
+        generator_ptrs.push_back(&generator);
+    return trace_cache_misses(
+        A, generator_ptrs, num_numa_domains, verbose, progress_interval);
+}
+
+std::vector<std::vector<cache_miss_type>> trace_cache_misses(
+    ReplacementAlgorithm & A,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    numa_domain_type num_numa_domains,
+    bool verbose,
+    int progress_interval)
+{
+    CacheTrafficOptions options;
+    options.verbose = verbose;
+    options.progress_interval = progress_interval;
+    return trace_cache_traffic(A, ws, num_numa_domains, options).cache_misses;
+}
+
+static void report_progress(
+    uint64_t t,
+    uint64_t T,
+    int progress_interval)
+{
+    fprintf(stderr, "%'" PRIu64 " of %'" PRIu64 " (%4.1f %%)\n",
+            t, T, 100.0 * (t / (double) T));
+    print_progress = 0;
+    alarm(progress_interval);
+}
+
+namespace
+{
+
+// The number of memory references read from the interleaved stream
+// at a time by batched simulations
+constexpr std::size_t batch_size = 4096u;
+
+/*
+ * Simulate the remaining memory references of an interleaved stream
+ * with a cache whose replacement algorithm and cache line size are
+ * known at compile time.  Thus, loads and stores are simulated without
+ * any virtual calls, and their cache lines are found with a shift
+ * rather than a division.  Streaming stores are rare, and they still
+ * take the virtual path.
+ */
+template <typename Policy, unsigned int line_size_bits>
+void trace_cache_traffic_batched(
+    Policy & A,
+    InterleavedMemoryReferenceStream & stream,
+    CacheTraffic & traffic,
+    bool progress,
+    int progress_interval)
+{
+    std::vector<MemoryReferenceString::value_type> xs(batch_size);
+    std::vector<std::size_t> ps(batch_size);
+    uint64_t T = stream.size();
+    std::size_t n;
+    while ((n = stream.next(batch_size, xs.data(), ps.data())) > 0) {
+        if (progress && print_progress)
+            report_progress(stream.position(), T, progress_interval);
+
+        for (std::size_t i = 0; i < n; i++) {
+            std::size_t p = ps[i];
+            memory_reference_type memory_reference = xs[i].address();
+            numa_domain_type numa_domain = xs[i].numa_domain();
+            AccessType access_type = xs[i].access_type();
+            cache_miss_type cache_miss =
+                (access_type == AccessType::streaming_store)
+                ? A.access(memory_reference, numa_domain, access_type)
+                : A.template access_line<Policy>(
+                    memory_reference >> line_size_bits, numa_domain, access_type);
+            traffic.cache_misses[p][numa_domain] += cache_miss;
+            numa_domain_type write_back = A.write_back();
+            if (write_back != ReplacementAlgorithm::no_write_back)
+                traffic.write_backs[p][write_back]++;
+        }
+    }
+}
 
-    // Get the the length of each CPU's reference string and the
-    // longest reference string.
-    std::vector<memory_reference_type> T(P, 0u);
-    uint64_t T_max = 0;
-    for (auto p = 0u; p < P; ++p) {
-        T[p] = ws[p].size();
-        if (T_max < T[p])
-            T_max = T[p];
+template <typename Policy>
+bool trace_cache_traffic_batched(
+    ReplacementAlgorithm & A,
+    InterleavedMemoryReferenceStream & stream,
+    CacheTraffic & traffic,
+    bool progress,
+    int progress_interval)
+{
+    if (typeid(A) != typeid(Policy))
+        return false;
+    Policy & a = static_cast<Policy &>(A);
+    switch (A.line_size()) {
+    case 32u:
+        trace_cache_traffic_batched<Policy, 5>(
+            a, stream, traffic, progress, progress_interval);
+        return true;
+    case 64u:
+        trace_cache_traffic_batched<Policy, 6>(
+            a, stream, traffic, progress, progress_interval);
+        return true;
+    case 128u:
+        trace_cache_traffic_batched<Policy, 7>(
+            a, stream, traffic, progress, progress_interval);
+        return true;
+    default:
+        return false;
     }
+}
+
+/*
+ * Choose the batched simulation for the replacement algorithm and
+ * cache line size of a cache, and return whether there is one (see
+ * `supports_batched_simulation').
+ */
+bool trace_cache_traffic_batched(
+    ReplacementAlgorithm & A,
+    InterleavedMemoryReferenceStream & stream,
+    CacheTraffic & traffic,
+    bool progress,
+    int progress_interval)
+{
+    return
+        trace_cache_traffic_batched<LRU>(A, stream, traffic, progress, progress_interval) ||
+        trace_cache_traffic_batched<FIFO>(A, stream, traffic, progress, progress_interval) ||
+        trace_cache_traffic_batched<RAND>(A, stream, traffic, progress, progress_interval) ||
+        trace_cache_traffic_batched<SetAssociativeLRU>(A, stream, traffic, progress, progress_interval) ||
+        trace_cache_traffic_batched<SetAssociativeFIFO>(A, stream, traffic, progress, progress_interval) ||
+        trace_cache_traffic_batched<SetAssociativeRAND>(A, stream, traffic, progress, progress_interval) ||
+        trace_cache_traffic_batched<SetAssociativePLRU>(A, stream, traffic, progress, progress_interval) ||
+        trace_cache_traffic_batched<SetAssociativeNRU>(A, stream, traffic, progress, progress_interval) ||
+        trace_cache_traffic_batched<SetAssociativeRRIP>(A, stream, traffic, progress, progress_interval);
+}
+
+}
+
+bool supports_batched_simulation(
+    ReplacementAlgorithm const & A)
+{
+    std::type_info const & type = typeid(A);
+    bool batched_policy =
+        type == typeid(LRU) ||
+        type == typeid(FIFO) ||
+        type == typeid(RAND) ||
+        type == typeid(SetAssociativeLRU) ||
+        type == typeid(SetAssociativeFIFO) ||
+        type == typeid(SetAssociativeRAND) ||
+        type == typeid(SetAssociativePLRU) ||
+        type == typeid(SetAssociativeNRU) ||
+        type == typeid(SetAssociativeRRIP);
+    cache_size_type line_size = A.line_size();
+    return batched_policy &&
+        (line_size == 32u || line_size == 64u || line_size == 128u);
+}
+
+CacheTraffic trace_cache_traffic(
+    ReplacementAlgorithm & A,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    numa_domain_type num_numa_domains,
+    CacheTrafficOptions const & options)
+{
+    bool verbose = options.verbose;
+    int progress_interval = options.progress_interval;
+    Prefetcher * prefetcher = options.prefetcher;
+    Interleaving const & interleaving = options.interleaving;
+    Sampling const & sampling = options.sampling;
+    Checkpoint const * checkpoint = options.checkpoint;
+    MemoryRegions const * regions = options.regions;
+    MatrixLocator const * locator = options.locator;
+    Heatmap * heatmap = options.heatmap;
+    bool checkpointing = checkpoint && checkpoint->enabled();
+    if (checkpointing && sampling.enabled()) {
+        throw std::invalid_argument(
+            "Expected sampled simulations to be run without checkpoints");
+    }
+
+    auto P = ws.size();
+    InterleavedMemoryReferenceStream stream(ws, interleaving);
+    uint64_t T = stream.size();
 
     // Compute the number of replacements for an interleaved
-    // reference string.
-    std::vector<std::vector<cache_miss_type>> cache_misses(
+    // reference string.  With sampling, the warm-up windows are
+    // counted separately, and their counts are discarded.
+    std::vector<std::vector<cache_miss_type>> counts(
         P, std::vector<cache_miss_type>(num_numa_domains, 0));
+    CacheTraffic traffic{counts, counts, counts, counts};
+    CacheTraffic warmup_traffic{counts, counts, counts, counts};
+    if (regions) {
+        traffic.cache_misses_per_region.assign(regions->size(), 0);
+        warmup_traffic.cache_misses_per_region.assign(regions->size(), 0);
+    }
+    if (!locator)
+        heatmap = nullptr;
+    std::vector<MatrixLocation> locations(P, MatrixLocation{0, 0});
+    Heatmap warmup_heatmap;
+    if (heatmap)
+        warmup_heatmap = *heatmap;
+    std::vector<memory_reference_type> prefetches;
+    SamplingStatistics statistics;
+    statistics.reset(P, 1);
+    cache_miss_type detailed_cache_misses = 0;
+    SamplingWindow previous_window = SamplingWindow::skip;
 
-    if (verbose && progress_interval > 0) {
+    // A checkpoint holds the counts and the state of the cache and
+    // the prefetcher.  A simulation is resumed by skipping the memory
+    // references that were already simulated, which also brings a
+    // random interleaving into the same state.
+    auto save_state = [&] (std::ostream & o) {
+        save(o, traffic.cache_misses);
+        save(o, traffic.write_backs);
+        save(o, traffic.prefetch_fills);
+        save(o, traffic.useful_prefetches);
+        save(o, traffic.cache_misses_per_region);
+        if (heatmap) {
+            heatmap->save(o);
+            for (auto const & location : locations)
+                save(o, std::make_pair(location.row, location.column));
+        }
+        A.save(o);
+        if (prefetcher)
+            prefetcher->save(o);
+    };
+    auto load_state = [&] (std::istream & i) {
+        load(i, traffic.cache_misses);
+        load(i, traffic.write_backs);
+        load(i, traffic.prefetch_fills);
+        load(i, traffic.useful_prefetches);
+        load(i, traffic.cache_misses_per_region);
+        if (heatmap) {
+            heatmap->load(i);
+            for (auto & location : locations) {
+                std::pair<int64_t, int64_t> x;
+                load(i, x);
+                location = MatrixLocation{x.first, x.second};
+            }
+        }
+        A.load(i);
+        if (prefetcher)
+            prefetcher->load(i);
+    };
+    uint64_t fingerprint = checkpointing ? Checkpoint::fingerprint(ws) : 0;
+    uint64_t position = checkpointing
+        ? checkpoint->load(T, P, num_numa_domains, fingerprint, load_state) : 0;
+    auto last_checkpoint = std::chrono::steady_clock::now();
+
+    bool progress = verbose && progress_interval > 0;
+    if (progress) {
         print_progress = 0;
         signal(SIGALRM, signal_handler);
         alarm(progress_interval);
     }
 
-    for (uint64_t t = 0; t < T_max; ++t) {
-        if (verbose && progress_interval > 0 && print_progress) {
-            fprintf(stderr, "%'" PRIu64 " of %'" PRIu64 " (%4.1f %%)\n",
-                    t, T_max, T_max > 0 ? 100.0 * (t / (double) T_max) : 0.0);
-            print_progress = 0;
-            alarm(progress_interval);
+    // Without a prefetcher, sampling, checkpoints, attribution or
+    // heatmaps, the memory references are simulated in batches, if
+    // the cache supports it, and otherwise, one at a time.
+    char const * unbatched_reason =
+        !options.batched ? "batched simulation is disabled"
+        : prefetcher ? "the cache has a prefetcher"
+        : sampling.enabled() ? "the simulation is sampled"
+        : checkpointing ? "the simulation is checkpointed"
+        : regions ? "cache misses are attributed to memory regions"
+        : heatmap ? "cache misses are counted in a heatmap"
+        : !supports_batched_simulation(A)
+        ? "the replacement algorithm or cache line size is not supported"
+        : nullptr;
+    if (verbose) {
+        if (unbatched_reason) {
+            fprintf(stderr, "Simulating memory references one at a time, "
+                    "since %s\n", unbatched_reason);
+        } else {
+            fprintf(stderr, "Simulating memory references in batches\n");
+        }
+    }
+    bool batched =
+        !unbatched_reason &&
+        trace_cache_traffic_batched(
+            A, stream, traffic, progress, progress_interval);
+
+    std::size_t p;
+    auto const * x = (!batched && position < T) ? stream.next(p) : nullptr;
+    while (x && stream.position() <= position)
+        x = stream.next(p);
+    for (; x; x = stream.next(p)) {
+        if (checkpointing && (stream.position() & 0xffff) == 0 &&
+            checkpoint->due(last_checkpoint))
+        {
+            checkpoint->save(
+                stream.position() - 1, T, P, num_numa_domains, fingerprint,
+                save_state);
         }
 
-        for (auto p = 0u; p < P; ++p) {
-            if (t < T[p]) {
-                memory_reference_type const & memory_reference = ws[p][t].first;
-                numa_domain_type const & numa_domain = ws[p][t].second;
-                cache_misses[p][numa_domain] +=
-                    A.allocate(memory_reference, numa_domain);
+        if (progress && print_progress)
+            report_progress(stream.position(), T, progress_interval);
+
+        SamplingWindow window = sampling.window(stream.position() - 1);
+        if (sampling.enabled()) {
+            statistics.reference(p, window);
+            if (previous_window == SamplingWindow::detailed &&
+                window != SamplingWindow::detailed)
+            {
+                statistics.end_window({detailed_cache_misses});
             }
+            previous_window = window;
+            if (window == SamplingWindow::skip)
+                continue;
+        }
+        CacheTraffic & c = (window == SamplingWindow::detailed)
+            ? traffic : warmup_traffic;
+
+        memory_reference_type memory_reference = x->address();
+        numa_domain_type numa_domain = x->numa_domain();
+        cache_miss_type cache_miss =
+            A.access(memory_reference, numa_domain, x->access_type());
+        c.cache_misses[p][numa_domain] += cache_miss;
+        if (regions && cache_miss)
+            c.cache_misses_per_region[regions->find(memory_reference)]++;
+        if (heatmap) {
+            locator->locate(memory_reference, locations[p]);
+            if (cache_miss) {
+                (window == SamplingWindow::detailed ? *heatmap : warmup_heatmap)
+                    .add(locations[p]);
+            }
+        }
+        if (window == SamplingWindow::detailed)
+            detailed_cache_misses += cache_miss;
+        numa_domain_type write_back = A.write_back();
+        if (write_back != ReplacementAlgorithm::no_write_back)
+            c.write_backs[p][write_back]++;
+        if (!prefetcher || x->access_type() == AccessType::streaming_store)
+            continue;
+
+        bool useful_prefetch = A.useful_prefetch();
+        c.useful_prefetches[p][numa_domain] += useful_prefetch;
+        prefetches.clear();
+        prefetcher->access(
+            memory_reference, cache_miss || useful_prefetch, prefetches);
+        for (memory_reference_type y : prefetches) {
+            c.prefetch_fills[p][numa_domain] += A.prefetch(y, numa_domain);
+            write_back = A.write_back();
+            if (write_back != ReplacementAlgorithm::no_write_back)
+                c.write_backs[p][write_back]++;
         }
     }
 
-    if (verbose && progress_interval > 0) {
+    if (progress) {
         alarm(0);
         signal(SIGALRM, SIG_DFL);
-        fprintf(stderr, "%'" PRIu64 " of %'" PRIu64 " (%4.1f %%)\n", T_max, T_max, 100.0);
+        fprintf(stderr, "%'" PRIu64 " of %'" PRIu64 " (%4.1f %%)\n", T, T, 100.0);
     }
-    return cache_misses;
+    if (checkpointing)
+        checkpoint->save(T, T, P, num_numa_domains, fingerprint, save_state);
+
+    if (sampling.enabled()) {
+        if (previous_window == SamplingWindow::detailed)
+            statistics.end_window({detailed_cache_misses});
+        statistics.extrapolate(traffic.cache_misses);
+        statistics.extrapolate(traffic.write_backs);
+        statistics.extrapolate(traffic.prefetch_fills);
+        statistics.extrapolate(traffic.useful_prefetches);
+        for (auto & count : traffic.cache_misses_per_region)
+            count = std::llround(count * statistics.scale());
+        if (heatmap)
+            heatmap->scale(statistics.scale());
+        traffic.sampling = statistics.estimate(0);
+    }
+    return traffic;
 }
 
 std::ostream & operator<<(
     std::ostream & o,
-    std::pair<memory_reference_type, numa_domain_type> const & x)
+    MemoryReference const & x)
 {
-    return o << '(' << x.first << ',' << x.second << ')';
+    return o << '(' << x.address() << ',' << x.numa_domain() << ')';
 }
 
 std::ostream & operator<<(
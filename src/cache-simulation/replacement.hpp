@@ -10,12 +10,18 @@
  * pp. 80--93. DOI=http://dx.doi.org/10.1145/321623.321632.
  */
 
-#include "util/circular-buffer.hpp"
+#include "util/flat-hash-map.hpp"
+#include "util/memory-reference.hpp"
 
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <iosfwd>
-#include <queue>
+#include <limits>
+#include <random>
+#include <set>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace replacement
@@ -26,35 +32,536 @@ using numa_domain_type = int;
 using cache_size_type = uint64_t;
 using cache_miss_type = uint64_t;
 
-using MemoryReferenceString =
-    std::vector<std::pair<memory_reference_type, numa_domain_type>>;
+/*
+ * Memory references are packed into 64 bits, with the address in the
+ * lower 54 bits, followed by the access type and the NUMA domain.
+ */
+using MemoryReference = ::MemoryReference;
+using AccessType = ::AccessType;
+using MemoryReferenceString = std::vector<MemoryReference>;
 using MemoryReferenceSet = std::unordered_set<memory_reference_type>;
 
+/*
+ * A memory reference string that is generated on demand, so that
+ * only a part of it needs to be stored at any one time.  Any
+ * contiguous part of the string may be generated independently of
+ * the rest of the string.
+ */
+class MemoryReferenceGenerator
+{
+public:
+    virtual ~MemoryReferenceGenerator()
+    {
+    }
+
+    /*
+     * The length of the memory reference string.
+     */
+    virtual uint64_t size() const = 0;
+
+    /*
+     * Generate the `count' memory references starting at the given
+     * offset in the memory reference string.
+     */
+    virtual void generate(
+        uint64_t offset,
+        uint64_t count,
+        MemoryReferenceString::value_type * w) const = 0;
+};
+
+/*
+ * A generator for a memory reference string that is already stored
+ * in its entirety.  The memory reference string is not copied, and
+ * must outlive the generator.
+ */
+class MemoryReferenceStringGenerator
+    : public MemoryReferenceGenerator
+{
+public:
+    MemoryReferenceStringGenerator(
+        MemoryReferenceString const & w);
+    ~MemoryReferenceStringGenerator();
+
+    uint64_t size() const override;
+
+    void generate(
+        uint64_t offset,
+        uint64_t count,
+        MemoryReferenceString::value_type * w) const override;
+
+private:
+    MemoryReferenceString const * w;
+};
+
+/*
+ * Read a generated memory reference string from beginning to end,
+ * one chunk at a time.
+ */
+class MemoryReferenceStream
+{
+public:
+    static constexpr std::size_t default_chunk_size = 1u << 16;
+
+public:
+    MemoryReferenceStream(
+        MemoryReferenceGenerator const & generator,
+        std::size_t chunk_size = default_chunk_size);
+    ~MemoryReferenceStream();
+
+    uint64_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return position == size_;
+    }
+
+    /*
+     * Read the next memory reference, which must not be done once
+     * the end of the stream has been reached.
+     */
+    MemoryReferenceString::value_type const & next()
+    {
+        if (chunk_position == chunk_size)
+            read_chunk();
+        position++;
+        return chunk[chunk_position++];
+    }
+
+private:
+    void read_chunk();
+
+private:
+    MemoryReferenceGenerator const * generator;
+    uint64_t size_;
+    uint64_t position;
+    std::vector<MemoryReferenceString::value_type> chunk;
+    std::size_t chunk_size;
+    std::size_t chunk_position;
+};
+
+/*
+ * Ways of interleaving the memory reference strings of multiple
+ * processors that share a cache.
+ *
+ * With round-robin interleaving, the processors take turns making
+ * one memory reference each, as if they all ran at the same speed.
+ * With bandwidth interleaving, each processor instead advances its
+ * own clock by the reciprocal of the bandwidth of the NUMA domain of
+ * each memory reference that it makes, and the processor with the
+ * earliest clock makes the next memory reference.  Thus, processors
+ * that access slower (for example, remote) memory fall behind.  With
+ * random interleaving, every memory reference is made by a processor
+ * chosen uniformly at random among those with memory references left,
+ * using a seeded random number generator.
+ *
+ * For the same memory reference strings, the same interleaving always
+ * gives the same order of memory references.
+ */
+enum class InterleavingPolicy
+{
+    round_robin,
+    bandwidth,
+    random,
+};
+
+class Interleaving
+{
+public:
+    Interleaving(
+        InterleavingPolicy policy = InterleavingPolicy::round_robin,
+        std::vector<double> const & bandwidth_per_numa_domain = std::vector<double>(),
+        uint64_t seed = 0);
+    ~Interleaving();
+
+    InterleavingPolicy policy() const;
+    std::vector<double> const & bandwidth_per_numa_domain() const;
+    uint64_t seed() const;
+
+private:
+    InterleavingPolicy policy_;
+    std::vector<double> bandwidth_per_numa_domain_;
+    uint64_t seed_;
+};
+
+/*
+ * Read the memory reference strings of multiple processors as a
+ * single, interleaved stream.
+ */
+class InterleavedMemoryReferenceStream
+{
+public:
+    InterleavedMemoryReferenceStream(
+        std::vector<MemoryReferenceGenerator const *> const & ws,
+        Interleaving const & interleaving = Interleaving());
+    ~InterleavedMemoryReferenceStream();
+
+    /*
+     * The total number of memory references of every processor, and
+     * the number of memory references read so far.
+     */
+    uint64_t size() const;
+    uint64_t position() const;
+
+    /*
+     * Read the next memory reference and set `p' to the processor
+     * that made it, or return `nullptr' once every memory reference
+     * has been read.
+     */
+    MemoryReferenceString::value_type const * next(
+        std::size_t & p);
+
+    /*
+     * Read up to `count' memory references into `x', and the
+     * processors that made them into `p', and return the number of
+     * memory references read, which is zero once every memory
+     * reference has been read.
+     */
+    std::size_t next(
+        std::size_t count,
+        MemoryReferenceString::value_type * x,
+        std::size_t * p);
+
+private:
+    InterleavingPolicy policy;
+    std::vector<MemoryReferenceStream> streams;
+
+    // The processors with memory references left, in order
+    std::vector<std::size_t> active;
+
+    // The position within `active' of the next processor to make
+    // a memory reference with round-robin interleaving
+    std::size_t turn;
+
+    // The clock of each processor, and the time taken by a memory
+    // reference to each NUMA domain, for bandwidth interleaving
+    std::vector<double> clocks;
+    std::vector<double> reference_time;
+
+    std::mt19937_64 rng;
+    uint64_t size_;
+    uint64_t position_;
+};
+
+/*
+ * Sampled simulation, where only periodic windows of the interleaved
+ * memory references are simulated in detail.  Every `period' memory
+ * references, the memory references are first skipped, that is, not
+ * simulated at all, after which the caches are warmed up with the
+ * next `warmup_window' memory references, and, finally, the cache
+ * misses of the last `detailed_window' memory references are counted.
+ * The cache misses are then extrapolated to every memory reference.
+ *
+ * A period of zero disables sampling, so that every memory reference
+ * is counted.  The estimates are meant to be within a relative error
+ * of `target_error' at 95% confidence, unless it is zero.
+ */
+enum class SamplingWindow
+{
+    skip,
+    warmup,
+    detailed,
+};
+
+class Sampling
+{
+public:
+    Sampling(
+        uint64_t period = 0,
+        uint64_t warmup_window = 0,
+        uint64_t detailed_window = 0,
+        double target_error = 0.0);
+    ~Sampling();
+
+    bool enabled() const;
+    uint64_t period() const;
+    uint64_t warmup_window() const;
+    uint64_t detailed_window() const;
+    double target_error() const;
+
+    /*
+     * The window that the memory reference at the given position of
+     * the interleaved memory references belongs to.
+     */
+    SamplingWindow window(
+        uint64_t t) const;
+
+private:
+    uint64_t period_;
+    uint64_t warmup_window_;
+    uint64_t detailed_window_;
+    double target_error_;
+};
+
+/*
+ * An estimate of the total cache misses of a cache from sampled
+ * simulation, based on the given number of detailed windows, and the
+ * half-width of its 95% confidence interval.
+ */
+struct SamplingEstimate
+{
+    uint64_t windows = 0;
+    double cache_misses = 0.0;
+    double confidence_interval = 0.0;
+
+    /*
+     * The half-width of the confidence interval relative to the
+     * estimated cache misses, or zero if there are none.
+     */
+    double relative_error() const;
+
+    /*
+     * Whether the relative error is within the target error of the
+     * given sampling, which is always the case without a target.
+     */
+    bool meets_target(
+        Sampling const & sampling) const;
+};
+
+/*
+ * Statistics of sampled simulation of one or more caches, which are
+ * used to extrapolate the cache misses of the detailed windows.
+ */
+class SamplingStatistics
+{
+public:
+    SamplingStatistics();
+    ~SamplingStatistics();
+
+    void reset(
+        std::size_t num_processors,
+        std::size_t num_caches);
+
+    /*
+     * Count a memory reference of processor `p' in the given window.
+     */
+    void reference(
+        std::size_t p,
+        SamplingWindow window);
+
+    /*
+     * End a detailed window, given the cache misses of each cache
+     * that have been counted so far.
+     */
+    void end_window(
+        std::vector<cache_miss_type> const & cache_misses);
+
+    /*
+     * The ratio of all memory references to those in detailed
+     * windows for processor `p', or for every processor together.
+     */
+    double scale(
+        std::size_t p) const;
+    double scale() const;
+
+    /*
+     * Extrapolate counts for each processor and NUMA domain.
+     */
+    void extrapolate(
+        std::vector<std::vector<cache_miss_type>> & counts) const;
+
+    SamplingEstimate estimate(
+        std::size_t cache) const;
+
+private:
+    std::vector<uint64_t> references;
+    std::vector<uint64_t> detailed_references;
+    std::vector<cache_miss_type> counted_cache_misses;
+    std::vector<std::vector<cache_miss_type>> window_cache_misses;
+};
+
+/*
+ * The state of a cache line residing in a cache, which each
+ * replacement algorithm keeps alongside the cache line itself.  A
+ * dirty cache line holds the NUMA domain of the memory that it is
+ * written back to, and a clean cache line holds -1.  A prefetched
+ * cache line is marked until it is first used.
+ */
+struct CacheLineState
+{
+    int16_t dirty = -1;
+    bool prefetched = false;
+};
+
+void save(
+    std::ostream & o,
+    CacheLineState const & state);
+void load(
+    std::istream & i,
+    CacheLineState & state);
+
 /*
  * Replacement algorithms.
  */
 class ReplacementAlgorithm
 {
+public:
+    // The victim reported when no cache line was evicted
+    static constexpr memory_reference_type no_victim =
+        std::numeric_limits<memory_reference_type>::max();
+
+    // The write-back reported when nothing was written back
+    static constexpr numa_domain_type no_write_back = -1;
+
 public:
     ReplacementAlgorithm(
         cache_size_type cache_lines,
-        cache_size_type cache_line_size,
-        MemoryReferenceSet const & _memory_references)
+        cache_size_type cache_line_size)
         : cache_lines(cache_lines)
         , cache_line_size(cache_line_size)
-        , memory_references(_memory_references)
+        , victim_line(no_victim)
+        , victim_state()
+        , allocated_line(nullptr)
+        , write_back_(no_write_back)
+        , streaming_store_line(no_victim)
+        , useful_prefetch_(false)
     {
-        memory_references.reserve(cache_lines);
     }
 
     virtual ~ReplacementAlgorithm()
     {
     }
 
+    /*
+     * Allocate the cache line holding the given memory reference, and
+     * return the number of cache misses.  Replacement algorithms that
+     * support batched simulation (see `trace_cache_traffic') also
+     * provide a non-virtual `allocate_line', which takes the cache
+     * line instead of the memory reference.
+     */
     virtual cache_miss_type allocate(
         memory_reference_type x,
         numa_domain_type numa_domain) = 0;
 
+    /*
+     * Remove the cache line holding the given memory reference, if
+     * it resides in the cache, and return whether it did.
+     */
+    virtual bool invalidate(
+        memory_reference_type x) = 0;
+
+    /*
+     * Check whether the cache line holding the given memory
+     * reference resides in the cache.
+     */
+    virtual bool contains(
+        memory_reference_type x) const = 0;
+
+    /*
+     * Make a memory access of the given type, and return the number
+     * of cache misses.  Loads and stores allocate the referenced
+     * cache line, and a store leaves it dirty.  A streaming store
+     * instead invalidates the cache line and is written directly to
+     * memory, where consecutive streaming stores to the same cache
+     * line are combined into a single write.
+     */
+    cache_miss_type access(
+        memory_reference_type x,
+        numa_domain_type numa_domain,
+        AccessType access_type);
+
+    /*
+     * Load or store the given cache line, like `access', but without
+     * virtual calls, by allocating the cache line with the
+     * `allocate_line' of the given replacement algorithm, which must
+     * be the dynamic type of the cache.  Streaming stores are not
+     * supported.
+     */
+    template <typename Policy>
+    cache_miss_type access_line(
+        memory_reference_type y,
+        numa_domain_type numa_domain,
+        AccessType access_type)
+    {
+        write_back_ = no_write_back;
+        useful_prefetch_ = false;
+        allocated_line = nullptr;
+        cache_miss_type cache_misses =
+            static_cast<Policy &>(*this).allocate_line(y, numa_domain);
+        return complete_access(y, numa_domain, access_type, cache_misses);
+    }
+
+    /*
+     * Fill the cache line holding the given memory reference into
+     * the cache ahead of its use, and return the number of cache
+     * lines filled.  Nothing happens if the cache line already
+     * resides in the cache.
+     */
+    cache_miss_type prefetch(
+        memory_reference_type x,
+        numa_domain_type numa_domain);
+
+    /*
+     * Whether the most recent call to `access' was the first use of
+     * a prefetched cache line.
+     */
+    bool useful_prefetch() const
+    {
+        return useful_prefetch_;
+    }
+
+    /*
+     * The NUMA domain of the memory that was written to by the most
+     * recent call to `access' or `prefetch', either because a dirty
+     * cache line was evicted or because of a streaming store, or
+     * `no_write_back' if nothing was written.
+     */
+    numa_domain_type write_back() const
+    {
+        return write_back_;
+    }
+
+    /*
+     * Mark the cache line holding the given memory reference as
+     * dirty, if it resides in the cache, and return whether it did.
+     */
+    bool mark_dirty(
+        memory_reference_type x,
+        numa_domain_type numa_domain);
+
+    /*
+     * Mark the cache line holding the given memory reference as
+     * clean.  If it was dirty, return the NUMA domain that it would
+     * have been written back to, or else `no_write_back'.
+     */
+    numa_domain_type clean(
+        memory_reference_type x);
+
+    /*
+     * The address of the cache line that was evicted by the most
+     * recent call to `allocate', or `no_victim' if no cache line was
+     * evicted.
+     */
+    memory_reference_type victim() const
+    {
+        return victim_line == no_victim
+            ? no_victim : victim_line * cache_line_size;
+    }
+
+    cache_size_type line_size() const
+    {
+        return cache_line_size;
+    }
+
+    /*
+     * Save or restore the state of the cache for a checkpoint.
+     * Replacement algorithms with additional state extend these.
+     */
+    virtual void save(
+        std::ostream & o) const;
+    virtual void load(
+        std::istream & i);
+
+protected:
+    /*
+     * Find the state of the given cache line, or return null if it
+     * does not reside in the cache.
+     */
+    virtual CacheLineState * find_line(
+        memory_reference_type y) = 0;
+
 protected:
     // The number of cache lines that fit in the cache
     cache_size_type cache_lines;
@@ -62,12 +569,40 @@ protected:
     // The size of each cache line (in bytes)
     cache_size_type cache_line_size;
 
-    // The subset cache lines residing in the cache
-    MemoryReferenceSet memory_references;
+    // The cache line evicted by the most recent allocation, if any,
+    // and the state that it was in
+    memory_reference_type victim_line;
+    CacheLineState victim_state;
+
+    // The state of the cache line used by the most recent
+    // allocation, which remains valid until the cache is modified
+    // again, or null if the cache has no cache lines
+    CacheLineState * allocated_line;
+
+private:
+    void evict_victim();
+
+    cache_miss_type complete_access(
+        memory_reference_type y,
+        numa_domain_type numa_domain,
+        AccessType access_type,
+        cache_miss_type cache_misses);
+
+private:
+    // The NUMA domain written to by the most recent access, if any
+    numa_domain_type write_back_;
+
+    // The cache line written by the most recent streaming store
+    memory_reference_type streaming_store_line;
+
+    // Whether the most recent access used a prefetched cache line
+    bool useful_prefetch_;
 };
 
 /*
- * A random replacement policy.
+ * A random replacement policy, which evicts a cache line chosen
+ * uniformly at random once the cache is full.  The random number
+ * generator is seeded, so that the cache misses are reproducible.
  */
 class RAND
     : public ReplacementAlgorithm
@@ -76,16 +611,56 @@ public:
     RAND(
         cache_size_type cache_lines,
         cache_size_type cache_line_size,
-        MemoryReferenceSet const & memory_references = MemoryReferenceSet());
+        MemoryReferenceSet const & memory_references = MemoryReferenceSet(),
+        uint64_t seed = 0);
     ~RAND();
 
     cache_miss_type allocate(
         memory_reference_type x,
         numa_domain_type numa_domain) override;
+    cache_miss_type allocate_line(
+        memory_reference_type y,
+        numa_domain_type numa_domain);
+
+    bool invalidate(
+        memory_reference_type x) override;
+
+    bool contains(
+        memory_reference_type x) const override;
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+protected:
+    CacheLineState * find_line(
+        memory_reference_type y) override;
+
+private:
+    typedef uint32_t slot_type;
+
+private:
+    // The cache lines residing in the cache, stored densely, so that
+    // a victim can be chosen in constant time
+    std::vector<memory_reference_type> lines;
+
+    // The state of the cache line in each slot
+    std::vector<CacheLineState> states;
+
+    // The slot of each cache line residing in the cache
+    FlatHashMap<memory_reference_type, slot_type> index;
+
+    std::mt19937_64 rng;
 };
 
 /*
  * A first-in-first-out replacement policy.
+ *
+ * Like LRU, the cache lines are kept in a doubly-linked list threaded
+ * through a fixed array of slots, but ordered from the first to the
+ * most recently filled, so that both replacements and invalidations
+ * take constant time.
  */
 class FIFO
     : public ReplacementAlgorithm
@@ -100,13 +675,62 @@ public:
     cache_miss_type allocate(
         memory_reference_type x,
         numa_domain_type numa_domain) override;
+    cache_miss_type allocate_line(
+        memory_reference_type y,
+        numa_domain_type numa_domain);
+
+    bool invalidate(
+        memory_reference_type x) override;
+
+    bool contains(
+        memory_reference_type x) const override;
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+protected:
+    CacheLineState * find_line(
+        memory_reference_type y) override;
+
+private:
+    typedef uint32_t slot_type;
+
+    void unlink(slot_type slot);
+    void push_back(slot_type slot);
 
 private:
-    std::queue<memory_reference_type> q;
+    // The cache line held by each slot, and its state
+    std::vector<memory_reference_type> lines;
+    std::vector<CacheLineState> states;
+
+    // Links to the previous (filled earlier) and next (filled later)
+    // slots
+    std::vector<slot_type> prev;
+    std::vector<slot_type> next;
+
+    // The first and most recently filled slots
+    slot_type head;
+    slot_type tail;
+
+    // The number of slots that have been used
+    cache_size_type num_lines;
+
+    // Slots that were freed by invalidating their cache lines
+    std::vector<slot_type> free_slots;
+
+    // The slot of each cache line residing in the cache
+    FlatHashMap<memory_reference_type, slot_type> index;
 };
 
 /*
  * A least-recently used replacement policy.
+ *
+ * The cache lines are kept in a doubly-linked list, ordered from the
+ * least to the most recently used, which is threaded through a fixed
+ * array of slots.  A hash index maps each cache line to its slot, so
+ * that both hits and replacements take constant time.
  */
 class LRU
     : public ReplacementAlgorithm
@@ -121,9 +745,554 @@ public:
     cache_miss_type allocate(
         memory_reference_type x,
         numa_domain_type numa_domain) override;
+    cache_miss_type allocate_line(
+        memory_reference_type y,
+        numa_domain_type numa_domain);
+
+    bool invalidate(
+        memory_reference_type x) override;
+
+    bool contains(
+        memory_reference_type x) const override;
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+protected:
+    CacheLineState * find_line(
+        memory_reference_type y) override;
 
 private:
-    CircularBuffer<memory_reference_type> q;
+    typedef uint32_t slot_type;
+
+    void unlink(slot_type slot);
+    void push_back(slot_type slot);
+
+private:
+    // The cache line held by each slot, and its state
+    std::vector<memory_reference_type> lines;
+    std::vector<CacheLineState> states;
+
+    // Links to the previous (less recently used) and next (more
+    // recently used) slots
+    std::vector<slot_type> prev;
+    std::vector<slot_type> next;
+
+    // The least and most recently used slots
+    slot_type head;
+    slot_type tail;
+
+    // The number of slots that have been used
+    cache_size_type num_lines;
+
+    // Slots that were freed by invalidating their cache lines
+    std::vector<slot_type> free_slots;
+
+    // The slot of each cache line residing in the cache
+    FlatHashMap<memory_reference_type, slot_type> index;
+};
+
+/*
+ * Belady's optimal replacement policy (MIN or OPT), which evicts the
+ * cache line whose next use lies farthest in the future.  This gives
+ * the fewest cache misses of any replacement policy for a fully
+ * associative cache, and is therefore a lower bound for the cache
+ * misses of realistic policies.
+ *
+ * The time of the next use of every memory reference is computed in
+ * advance for the memory reference strings of the given processors,
+ * interleaved in the given way, and the strings must afterwards be
+ * processed with the same interleaving exactly `passes' times, where
+ * the first passes warm up the cache.  Streaming stores bypass the
+ * cache, and so they are left out.  This requires 8 bytes for each
+ * memory reference.  The cache lines residing in the
+ * cache are ordered by their next use, so that each reference takes
+ * logarithmic time.
+ */
+class OPT
+    : public ReplacementAlgorithm
+{
+public:
+    OPT(
+        cache_size_type cache_lines,
+        cache_size_type cache_line_size,
+        MemoryReferenceString const & w,
+        int passes = 1);
+    OPT(
+        cache_size_type cache_lines,
+        cache_size_type cache_line_size,
+        std::vector<MemoryReferenceGenerator const *> const & ws,
+        int passes = 1,
+        Interleaving const & interleaving = Interleaving());
+    ~OPT();
+
+    cache_miss_type allocate(
+        memory_reference_type x,
+        numa_domain_type numa_domain) override;
+
+    bool invalidate(
+        memory_reference_type x) override;
+
+    bool contains(
+        memory_reference_type x) const override;
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+protected:
+    CacheLineState * find_line(
+        memory_reference_type y) override;
+
+private:
+    typedef uint64_t time_type;
+    static constexpr time_type never =
+        std::numeric_limits<time_type>::max();
+
+    void compute_next_uses();
+
+private:
+    // The number of times that the memory reference strings are
+    // processed
+    int passes;
+
+    // The time of the next reference to the same cache line, for
+    // each memory reference of the interleaved strings.  A time of
+    // at least `next_use.size()' refers to the following pass.
+    std::vector<time_type> next_use;
+
+    // The number of memory references processed so far
+    time_type clock;
+
+    // The cache lines residing in the cache, ordered by the time of
+    // their next use
+    std::set<std::pair<time_type, memory_reference_type>> lines;
+
+    // The time of the next use and the state of each cache line
+    // residing in the cache
+    FlatHashMap<memory_reference_type, std::pair<time_type, CacheLineState>> index;
+};
+
+/*
+ * Functions for mapping cache lines to sets in a set-associative
+ * cache.  The modulo function uses the lowest-order bits of the cache
+ * line number, whereas the XOR function also folds in the
+ * higher-order bits, similar to the hashed indexing used by some
+ * last-level caches.
+ */
+enum class SetIndexFunction
+{
+    modulo,
+    xor_fold,
+};
+
+/*
+ * A set-associative cache, where each cache line may only reside in
+ * one of the `ways' slots of the set given by its set index.
+ *
+ * The tags of each set are stored contiguously, so that looking up a
+ * cache line amounts to a short, branch-free comparison of all the
+ * tags in a set.  Derived classes implement the replacement policy
+ * that is used within each set.
+ */
+class SetAssociative
+    : public ReplacementAlgorithm
+{
+public:
+    SetAssociative(
+        cache_size_type cache_lines,
+        cache_size_type cache_line_size,
+        cache_size_type ways,
+        SetIndexFunction set_index_function);
+    ~SetAssociative();
+
+    bool invalidate(
+        memory_reference_type x) override;
+
+    bool contains(
+        memory_reference_type x) const override;
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+protected:
+    CacheLineState * find_line(
+        memory_reference_type y) override;
+
+    cache_size_type set_index(memory_reference_type y) const
+    {
+        if (set_index_function == SetIndexFunction::xor_fold)
+            y = y ^ (y >> set_bits) ^ (y >> (2 * set_bits));
+        return sets_mask ? (y & sets_mask) : (y % num_sets);
+    }
+
+    /*
+     * Find the way of a set that holds the given cache line, or
+     * return `ways' if the cache line is not in the set.
+     */
+    cache_size_type find_way(
+        cache_size_type set,
+        memory_reference_type y) const
+    {
+        memory_reference_type const * t = &tags[set * ways];
+        cache_size_type way = ways;
+        for (cache_size_type w = 0; w < ways; w++)
+            way = (t[w] == y) ? w : way;
+        return way;
+    }
+
+    /*
+     * Find the first unused way in a set, or return `ways' if the
+     * set is full.
+     */
+    cache_size_type find_invalid_way(
+        cache_size_type set) const
+    {
+        memory_reference_type const * t = &tags[set * ways];
+        cache_size_type way = ways;
+        for (cache_size_type w = ways; w-- > 0;)
+            way = (t[w] == invalid_tag) ? w : way;
+        return way;
+    }
+
+    /*
+     * Use the cache line held in the given way of a set.
+     */
+    void use_way(
+        cache_size_type set,
+        cache_size_type way)
+    {
+        allocated_line = &line_states[set * ways + way];
+    }
+
+    /*
+     * Fill the given way of a set with a cache line, and evict the
+     * cache line that it held, if any.
+     */
+    void fill_way(
+        cache_size_type set,
+        cache_size_type way,
+        memory_reference_type y)
+    {
+        cache_size_type i = set * ways + way;
+        if (tags[i] != invalid_tag) {
+            victim_line = tags[i];
+            victim_state = line_states[i];
+        }
+        tags[i] = y;
+        line_states[i] = CacheLineState();
+        allocated_line = &line_states[i];
+    }
+
+protected:
+    static constexpr memory_reference_type invalid_tag =
+        ~memory_reference_type(0);
+
+    // The number of ways in each set
+    cache_size_type ways;
+
+    // The number of sets
+    cache_size_type num_sets;
+
+    // The number of bits needed to represent a set index
+    unsigned int set_bits;
+
+    // A mask for computing set indices, if the number of sets is a
+    // power of two greater than one, or zero otherwise
+    cache_size_type sets_mask;
+
+    // The function used to map cache lines to sets
+    SetIndexFunction set_index_function;
+
+    // The cache line held in each way of each set, and its state
+    std::vector<memory_reference_type> tags;
+    std::vector<CacheLineState> line_states;
+};
+
+/*
+ * A set-associative cache with least-recently used replacement
+ * within each set.
+ */
+class SetAssociativeLRU
+    : public SetAssociative
+{
+public:
+    SetAssociativeLRU(
+        cache_size_type cache_lines,
+        cache_size_type cache_line_size,
+        cache_size_type ways,
+        SetIndexFunction set_index_function = SetIndexFunction::modulo);
+    ~SetAssociativeLRU();
+
+    cache_miss_type allocate(
+        memory_reference_type x,
+        numa_domain_type numa_domain) override;
+    cache_miss_type allocate_line(
+        memory_reference_type y,
+        numa_domain_type numa_domain);
+
+    bool invalidate(
+        memory_reference_type x) override;
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+private:
+    // The time of the most recent use of each way of each set
+    std::vector<uint64_t> last_use;
+    uint64_t clock;
+};
+
+/*
+ * A set-associative cache with first-in-first-out replacement
+ * within each set.
+ */
+class SetAssociativeFIFO
+    : public SetAssociative
+{
+public:
+    SetAssociativeFIFO(
+        cache_size_type cache_lines,
+        cache_size_type cache_line_size,
+        cache_size_type ways,
+        SetIndexFunction set_index_function = SetIndexFunction::modulo);
+    ~SetAssociativeFIFO();
+
+    cache_miss_type allocate(
+        memory_reference_type x,
+        numa_domain_type numa_domain) override;
+    cache_miss_type allocate_line(
+        memory_reference_type y,
+        numa_domain_type numa_domain);
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+private:
+    // The next way to be replaced in each set
+    std::vector<cache_size_type> next_way;
+};
+
+/*
+ * A set-associative cache with random replacement within each set.
+ */
+class SetAssociativeRAND
+    : public SetAssociative
+{
+public:
+    SetAssociativeRAND(
+        cache_size_type cache_lines,
+        cache_size_type cache_line_size,
+        cache_size_type ways,
+        SetIndexFunction set_index_function = SetIndexFunction::modulo,
+        uint64_t seed = 0);
+    ~SetAssociativeRAND();
+
+    cache_miss_type allocate(
+        memory_reference_type x,
+        numa_domain_type numa_domain) override;
+    cache_miss_type allocate_line(
+        memory_reference_type y,
+        numa_domain_type numa_domain);
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+private:
+    std::mt19937_64 rng;
+};
+
+/*
+ * A set-associative cache with tree-based pseudo-LRU replacement, as
+ * used in the caches of many CPUs.  Each set has a binary tree of
+ * bits, whose leaves are the ways of the set.  A reference to a way
+ * sets the bits on the path from the root to point away from it, and
+ * the victim is found by following the bits from the root.
+ *
+ * If the number of ways is not a power of two, the tree is built for
+ * the next power of two, and subtrees without any ways are skipped.
+ */
+class SetAssociativePLRU
+    : public SetAssociative
+{
+public:
+    SetAssociativePLRU(
+        cache_size_type cache_lines,
+        cache_size_type cache_line_size,
+        cache_size_type ways,
+        SetIndexFunction set_index_function = SetIndexFunction::modulo);
+    ~SetAssociativePLRU();
+
+    cache_miss_type allocate(
+        memory_reference_type x,
+        numa_domain_type numa_domain) override;
+    cache_miss_type allocate_line(
+        memory_reference_type y,
+        numa_domain_type numa_domain);
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+private:
+    void touch(cache_size_type set, cache_size_type way);
+    cache_size_type find_victim(cache_size_type set) const;
+
+private:
+    // The number of leaves of each tree, which is the number of
+    // ways rounded up to a power of two
+    cache_size_type leaves;
+
+    // The bits of the tree of each set, where node `i' has the
+    // children `2i' and `2i+1', and the root is node 1.  A bit is
+    // set if the victim is to be found in the right subtree.
+    std::vector<uint8_t> tree_bits;
+};
+
+/*
+ * A set-associative cache with not-recently-used (NRU) replacement
+ * within each set.  Each way has a reference bit that is set when
+ * the way is used.  Once every way of a set has been used, the bits
+ * of the other ways are cleared.  The victim is the first way whose
+ * bit is clear.
+ */
+class SetAssociativeNRU
+    : public SetAssociative
+{
+public:
+    SetAssociativeNRU(
+        cache_size_type cache_lines,
+        cache_size_type cache_line_size,
+        cache_size_type ways,
+        SetIndexFunction set_index_function = SetIndexFunction::modulo);
+    ~SetAssociativeNRU();
+
+    cache_miss_type allocate(
+        memory_reference_type x,
+        numa_domain_type numa_domain) override;
+    cache_miss_type allocate_line(
+        memory_reference_type y,
+        numa_domain_type numa_domain);
+
+    bool invalidate(
+        memory_reference_type x) override;
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+private:
+    void touch(cache_size_type set, cache_size_type way);
+
+private:
+    // The reference bit of each way of each set
+    std::vector<uint8_t> referenced;
+};
+
+/*
+ * The insertion policies of re-reference interval prediction (RRIP).
+ *
+ * Static RRIP (SRRIP) inserts new cache lines with a long
+ * re-reference interval, so that lines that are referenced again
+ * are protected from a scan of lines that are used only once.
+ * Bimodal RRIP (BRRIP) inserts most cache lines with a distant
+ * re-reference interval, which preserves part of a working set that
+ * does not fit in the cache.  Dynamic RRIP (DRRIP) uses set dueling
+ * between a few leader sets of each kind to choose the insertion
+ * policy of the remaining sets.
+ */
+enum class RRIPInsertionPolicy
+{
+    static_rrip,
+    bimodal_rrip,
+    dynamic_rrip,
+};
+
+/*
+ * A set-associative cache with re-reference interval prediction
+ * (RRIP) replacement within each set, as described by Jaleel et al.,
+ * "High Performance Cache Replacement Using Re-Reference Interval
+ * Prediction (RRIP)", ISCA 2010.
+ *
+ * Each way has a 2-bit re-reference prediction value (RRPV), which
+ * is reset to zero when the way is used again.  The victim is the
+ * first way whose RRPV is the largest possible value.  If there is
+ * no such way, the RRPVs of the set are incremented until there is.
+ */
+class SetAssociativeRRIP
+    : public SetAssociative
+{
+public:
+    SetAssociativeRRIP(
+        cache_size_type cache_lines,
+        cache_size_type cache_line_size,
+        cache_size_type ways,
+        RRIPInsertionPolicy insertion_policy,
+        SetIndexFunction set_index_function = SetIndexFunction::modulo);
+    ~SetAssociativeRRIP();
+
+    cache_miss_type allocate(
+        memory_reference_type x,
+        numa_domain_type numa_domain) override;
+    cache_miss_type allocate_line(
+        memory_reference_type y,
+        numa_domain_type numa_domain);
+
+    bool invalidate(
+        memory_reference_type x) override;
+
+    void save(
+        std::ostream & o) const override;
+    void load(
+        std::istream & i) override;
+
+public:
+    static constexpr uint8_t max_rrpv = 3;
+
+    // One in this many cache lines is inserted with a long, rather
+    // than distant, re-reference interval by BRRIP
+    static constexpr unsigned int bimodal_throttle = 32;
+
+    // The number of leader sets for each insertion policy of DRRIP
+    static constexpr cache_size_type dueling_leader_sets = 32;
+
+    // The number of bits of the policy selection counter of DRRIP
+    static constexpr int policy_selector_bits = 10;
+
+private:
+    uint8_t insertion_rrpv(cache_size_type set);
+
+private:
+    RRIPInsertionPolicy insertion_policy;
+
+    // The re-reference prediction value of each way of each set
+    std::vector<uint8_t> rrpv;
+
+    // The number of insertions made by BRRIP, used to insert every
+    // `bimodal_throttle'-th cache line with a long interval
+    unsigned int bimodal_count;
+
+    // The distance between consecutive SRRIP leader sets of DRRIP,
+    // each of which is followed by a BRRIP leader set
+    cache_size_type leader_set_spacing;
+
+    // The policy selection counter of DRRIP, which is incremented by
+    // misses in the SRRIP leader sets and decremented by misses in
+    // the BRRIP leader sets
+    unsigned int policy_selector;
 };
 
 /*
@@ -134,8 +1303,8 @@ std::vector<cache_miss_type> trace_cache_misses(
     ReplacementAlgorithm & A,
     MemoryReferenceString const & w,
     numa_domain_type num_numa_domains,
-    bool verbose,
-    int progress_interval);
+    bool verbose = false,
+    int progress_interval = 0);
 
 /*
  * Compute the cost (number of replacements) of processing memory
@@ -144,14 +1313,165 @@ std::vector<cache_miss_type> trace_cache_misses(
  * In this case, it is assumed that the memory reference strings of the
  * different CPUs are perfectly interleaved.  In reality, scheduling
  * may be unfair and memory access latencies vary, causing some CPUs
- * to be delayed more than others.
+ * to be delayed more than others.  Other interleavings are available
+ * through `trace_cache_traffic' below.
  */
 std::vector<std::vector<cache_miss_type>> trace_cache_misses(
     ReplacementAlgorithm & A,
     std::vector<MemoryReferenceString> const & ws,
     numa_domain_type num_numa_domains,
-    bool verbose,
-    int progress_interval);
+    bool verbose = false,
+    int progress_interval = 0);
+
+/*
+ * Compute the cost (number of replacements) of processing generated
+ * memory reference strings for multiple processors with a shared
+ * cache, as above.
+ */
+std::vector<std::vector<cache_miss_type>> trace_cache_misses(
+    ReplacementAlgorithm & A,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    numa_domain_type num_numa_domains,
+    bool verbose = false,
+    int progress_interval = 0);
+
+/*
+ * The (demand) cache misses, write-backs, prefetch fills and useful
+ * prefetches of each processor for each NUMA domain.  A write-back is
+ * attributed to the processor whose memory reference caused it, and
+ * to the NUMA domain of the memory that is written to.  A useful
+ * prefetch is a prefetched cache line that is used before it is
+ * evicted.
+ *
+ * If memory regions are given, the cache misses are also attributed
+ * to the memory region of the missing memory reference, summed over
+ * every processor and NUMA domain, and otherwise, they are empty.
+ * For caches that are kept coherent, the invalidations, coherence
+ * misses and false-sharing misses are also given for each memory
+ * region, and otherwise, they are empty.
+ *
+ * With sampled simulation, the counts are extrapolated, and the
+ * estimate of the total cache misses is also given.
+ */
+struct CacheTraffic
+{
+    std::vector<std::vector<cache_miss_type>> cache_misses;
+    std::vector<std::vector<cache_miss_type>> write_backs;
+    std::vector<std::vector<cache_miss_type>> prefetch_fills;
+    std::vector<std::vector<cache_miss_type>> useful_prefetches;
+    std::vector<cache_miss_type> cache_misses_per_region;
+    std::vector<cache_miss_type> invalidations;
+    std::vector<cache_miss_type> coherence_misses;
+    std::vector<cache_miss_type> false_sharing;
+    SamplingEstimate sampling;
+};
+
+class Checkpoint;
+class Heatmap;
+class MatrixLocator;
+class MemoryRegions;
+class Prefetcher;
+
+/*
+ * Options for simulating a cache with `trace_cache_traffic'.
+ */
+struct CacheTrafficOptions
+{
+    CacheTrafficOptions()
+        : verbose(false)
+        , progress_interval(0)
+        , prefetcher(nullptr)
+        , interleaving()
+        , sampling()
+        , checkpoint(nullptr)
+        , regions(nullptr)
+        , locator(nullptr)
+        , heatmap(nullptr)
+        , batched(true)
+    {
+    }
+
+    /*
+     * Report the progress of the simulation to standard error, every
+     * `progress_interval' seconds if it is positive.
+     */
+    bool verbose;
+    int progress_interval;
+
+    /*
+     * If given, the prefetcher observes the loads and stores, and its
+     * prefetches are filled into the cache.
+     */
+    Prefetcher * prefetcher;
+
+    /*
+     * The interleaving of the memory reference strings of the
+     * processors, which is round-robin by default.
+     */
+    Interleaving interleaving;
+
+    /*
+     * If enabled, only the memory references in the detailed windows
+     * are counted.
+     */
+    Sampling sampling;
+
+    /*
+     * If given and enabled, the simulation is checkpointed
+     * periodically, and resumed from a previous checkpoint, if
+     * requested.
+     */
+    Checkpoint const * checkpoint;
+
+    /*
+     * If given, the cache misses are attributed to the memory regions.
+     */
+    MemoryRegions const * regions;
+
+    /*
+     * If both are given, the cache misses are also counted in the
+     * heatmap at the location in the matrix of the processor that
+     * made them.
+     */
+    MatrixLocator const * locator;
+    Heatmap * heatmap;
+
+    /*
+     * Simulate the cache in batches of memory references, if possible
+     * (see `trace_cache_traffic'), or else, always one memory
+     * reference at a time.
+     */
+    bool batched;
+};
+
+/*
+ * Whether the memory references of a cache can be simulated in
+ * batches, without virtual calls, which is the case for every
+ * replacement algorithm except optimal replacement, and for cache
+ * lines of 32, 64 or 128 bytes.
+ */
+bool supports_batched_simulation(
+    ReplacementAlgorithm const & A);
+
+/*
+ * Compute the cache misses and write-backs of processing generated
+ * memory reference strings for multiple processors with a shared
+ * cache, as above, but with the given options (see
+ * `CacheTrafficOptions').
+ *
+ * The memory references are simulated in batches, without virtual
+ * calls (see `access_line'), only if the cache supports it (see
+ * `supports_batched_simulation') and there is no prefetcher,
+ * sampling, enabled checkpoint, memory regions or heatmap.
+ * Otherwise, they are simulated one at a time through the virtual
+ * `access', which gives the same results, only more slowly.  If
+ * `verbose' is set, the choice is reported to standard error.
+ */
+CacheTraffic trace_cache_traffic(
+    ReplacementAlgorithm & A,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    numa_domain_type num_numa_domains,
+    CacheTrafficOptions const & options = CacheTrafficOptions());
 
 std::ostream & operator<<(
     std::ostream & o,
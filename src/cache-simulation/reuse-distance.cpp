@@ -0,0 +1,348 @@
+#include "cache-simulation/reuse-distance.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+namespace replacement
+{
+
+constexpr reuse_distance_type ReuseDistance::infinite;
+
+static constexpr memory_reference_type no_line =
+    std::numeric_limits<memory_reference_type>::max();
+
+static constexpr uint64_t min_clock_capacity = 4096u;
+
+ReuseDistance::ReuseDistance(
+    cache_size_type cache_line_size)
+    : cache_line_size(cache_line_size)
+    , tree(min_clock_capacity + 1u, 0u)
+    , line_at(min_clock_capacity, no_line)
+    , last_use(no_line)
+    , clock(0u)
+    , num_lines(0u)
+{
+}
+
+ReuseDistance::~ReuseDistance()
+{
+}
+
+void ReuseDistance::mark(uint64_t time, int delta)
+{
+    for (uint64_t i = time + 1u; i < tree.size(); i += i & (~i + 1u))
+        tree[i] += delta;
+}
+
+ReuseDistance::count_type ReuseDistance::count(uint64_t time) const
+{
+    count_type n = 0u;
+    for (uint64_t i = time + 1u; i > 0u; i -= i & (~i + 1u))
+        n += tree[i];
+    return n;
+}
+
+void ReuseDistance::compact()
+{
+    uint64_t capacity = std::max(min_clock_capacity, 2u * num_lines);
+    std::vector<memory_reference_type> new_line_at(capacity, no_line);
+    uint64_t time = 0u;
+    for (auto y : line_at) {
+        if (y == no_line)
+            continue;
+        last_use.insert(y, time);
+        new_line_at[time] = y;
+        time++;
+    }
+    line_at.swap(new_line_at);
+
+    // Build the tree in linear time, with a mark at each of the
+    // renumbered times
+    tree.assign(capacity + 1u, 0u);
+    for (uint64_t i = 1u; i <= time; i++)
+        tree[i] = 1u;
+    for (uint64_t i = 1u; i <= capacity; i++) {
+        uint64_t j = i + (i & (~i + 1u));
+        if (j <= capacity)
+            tree[j] += tree[i];
+    }
+    clock = time;
+}
+
+reuse_distance_type ReuseDistance::reference(
+    memory_reference_type x)
+{
+    if (clock >= line_at.size())
+        compact();
+
+    memory_reference_type y = x / cache_line_size;
+    reuse_distance_type d;
+    uint64_t * t = last_use.find(y);
+    if (t) {
+        d = num_lines - count(*t);
+        mark(*t, -1);
+        line_at[*t] = no_line;
+        *t = clock;
+    } else {
+        d = infinite;
+        last_use.insert(y, clock);
+        num_lines++;
+    }
+    mark(clock, 1);
+    line_at[clock] = y;
+    clock++;
+    return d;
+}
+
+std::size_t reuse_distance_bin(reuse_distance_type d)
+{
+    if (d < 4u)
+        return d;
+    unsigned int k = 63u - __builtin_clzll(d);
+    return 4u * (k - 1u) + ((d >> (k - 2u)) & 3u);
+}
+
+reuse_distance_type reuse_distance_bin_lower_bound(std::size_t bin)
+{
+    if (bin < 4u)
+        return bin;
+    unsigned int k = bin / 4u + 1u;
+    return reuse_distance_type(4u + bin % 4u) << (k - 2u);
+}
+
+ReuseDistanceHistogram::ReuseDistanceHistogram()
+    : cache_line_size_(0u)
+    , num_numa_domains_(0)
+    , exact_cache_lines_()
+    , exact_cache_misses()
+    , histogram()
+    , cold_misses_()
+{
+}
+
+ReuseDistanceHistogram::ReuseDistanceHistogram(
+    cache_size_type cache_line_size,
+    std::size_t num_processors,
+    numa_domain_type num_numa_domains,
+    std::vector<cache_size_type> const & exact_cache_lines)
+    : cache_line_size_(cache_line_size)
+    , num_numa_domains_(num_numa_domains)
+    , exact_cache_lines_(exact_cache_lines)
+    , exact_cache_misses()
+    , histogram(
+        num_processors,
+        std::vector<std::vector<cache_miss_type>>(num_numa_domains))
+    , cold_misses_(
+        num_processors,
+        std::vector<cache_miss_type>(num_numa_domains, 0u))
+{
+    std::sort(exact_cache_lines_.begin(), exact_cache_lines_.end());
+    exact_cache_lines_.erase(
+        std::unique(exact_cache_lines_.begin(), exact_cache_lines_.end()),
+        exact_cache_lines_.end());
+    exact_cache_misses.assign(exact_cache_lines_.size(), cold_misses_);
+}
+
+ReuseDistanceHistogram::~ReuseDistanceHistogram()
+{
+}
+
+cache_size_type ReuseDistanceHistogram::cache_line_size() const
+{
+    return cache_line_size_;
+}
+
+std::size_t ReuseDistanceHistogram::num_processors() const
+{
+    return histogram.size();
+}
+
+numa_domain_type ReuseDistanceHistogram::num_numa_domains() const
+{
+    return num_numa_domains_;
+}
+
+std::vector<cache_size_type> const &
+ReuseDistanceHistogram::exact_cache_lines() const
+{
+    return exact_cache_lines_;
+}
+
+std::size_t ReuseDistanceHistogram::num_bins() const
+{
+    std::size_t n = 0u;
+    for (auto const & h : histogram) {
+        for (auto const & bins : h)
+            n = std::max(n, bins.size());
+    }
+    return n;
+}
+
+void ReuseDistanceHistogram::add(
+    std::size_t p,
+    numa_domain_type numa_domain,
+    reuse_distance_type d)
+{
+    if (d == ReuseDistance::infinite) {
+        cold_misses_[p][numa_domain]++;
+        return;
+    }
+
+    for (std::size_t k = 0;
+         k < exact_cache_lines_.size() && d >= exact_cache_lines_[k];
+         k++)
+    {
+        exact_cache_misses[k][p][numa_domain]++;
+    }
+
+    std::vector<cache_miss_type> & bins = histogram[p][numa_domain];
+    std::size_t bin = reuse_distance_bin(d);
+    if (bin >= bins.size())
+        bins.resize(bin + 1u, 0u);
+    bins[bin]++;
+}
+
+cache_miss_type ReuseDistanceHistogram::count(
+    std::size_t p,
+    numa_domain_type numa_domain,
+    std::size_t bin) const
+{
+    std::vector<cache_miss_type> const & bins = histogram[p][numa_domain];
+    return bin < bins.size() ? bins[bin] : 0u;
+}
+
+cache_miss_type ReuseDistanceHistogram::cold_misses(
+    std::size_t p,
+    numa_domain_type numa_domain) const
+{
+    return cold_misses_[p][numa_domain];
+}
+
+bool ReuseDistanceHistogram::exact(
+    cache_size_type cache_lines) const
+{
+    return reuse_distance_bin_lower_bound(
+            reuse_distance_bin(cache_lines)) == cache_lines ||
+        std::binary_search(
+            exact_cache_lines_.cbegin(), exact_cache_lines_.cend(),
+            cache_lines);
+}
+
+std::vector<std::vector<cache_miss_type>> ReuseDistanceHistogram::cache_misses(
+    cache_size_type cache_lines) const
+{
+    std::vector<std::vector<cache_miss_type>> cache_misses(cold_misses_);
+    auto it = std::lower_bound(
+        exact_cache_lines_.cbegin(), exact_cache_lines_.cend(),
+        cache_lines);
+    if (it != exact_cache_lines_.cend() && *it == cache_lines) {
+        auto const & exact = exact_cache_misses[it - exact_cache_lines_.cbegin()];
+        for (std::size_t p = 0; p < histogram.size(); p++) {
+            for (numa_domain_type i = 0; i < num_numa_domains_; i++)
+                cache_misses[p][i] += exact[p][i];
+        }
+        return cache_misses;
+    }
+
+    for (std::size_t p = 0; p < histogram.size(); p++) {
+        for (numa_domain_type i = 0; i < num_numa_domains_; i++) {
+            std::vector<cache_miss_type> const & bins = histogram[p][i];
+            for (std::size_t bin = 0; bin < bins.size(); bin++) {
+                if (reuse_distance_bin_lower_bound(bin) >= cache_lines)
+                    cache_misses[p][i] += bins[bin];
+            }
+        }
+    }
+    return cache_misses;
+}
+
+static volatile sig_atomic_t print_progress = 0;
+
+static void signal_handler(int status)
+{
+    print_progress = 1;
+}
+
+ReuseDistanceHistogram trace_reuse_distances(
+    cache_size_type cache_line_size,
+    std::vector<MemoryReferenceString> const & ws,
+    numa_domain_type num_numa_domains,
+    bool warmup,
+    bool verbose,
+    int progress_interval,
+    std::vector<cache_size_type> const & exact_cache_lines)
+{
+    std::vector<MemoryReferenceStringGenerator> generators(
+        ws.cbegin(), ws.cend());
+    std::vector<MemoryReferenceGenerator const *> generator_ptrs;
+    for (auto const & generator : generators)
+        generator_ptrs.push_back(&generator);
+    return trace_reuse_distances(
+        cache_line_size, generator_ptrs, num_numa_domains,
+        warmup, verbose, progress_interval, Interleaving(),
+        exact_cache_lines);
+}
+
+ReuseDistanceHistogram trace_reuse_distances(
+    cache_size_type cache_line_size,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    numa_domain_type num_numa_domains,
+    bool warmup,
+    bool verbose,
+    int progress_interval,
+    Interleaving const & interleaving,
+    std::vector<cache_size_type> const & exact_cache_lines)
+{
+    auto P = ws.size();
+
+    uint64_t T = 0;
+    for (auto p = 0u; p < P; ++p)
+        T += ws[p]->size();
+
+    ReuseDistance reuse_distance(cache_line_size);
+    ReuseDistanceHistogram histogram(
+        cache_line_size, P, num_numa_domains, exact_cache_lines);
+
+    if (verbose && progress_interval > 0) {
+        print_progress = 0;
+        signal(SIGALRM, signal_handler);
+        alarm(progress_interval);
+    }
+
+    uint64_t num_passes = warmup ? 2u : 1u;
+    for (uint64_t pass = 0; pass < num_passes; ++pass) {
+        bool record = (pass + 1u == num_passes);
+        InterleavedMemoryReferenceStream stream(ws, interleaving);
+        std::size_t p;
+        for (auto const * x = stream.next(p); x; x = stream.next(p)) {
+            if (verbose && progress_interval > 0 && print_progress) {
+                uint64_t s = pass * T + stream.position();
+                uint64_t S = num_passes * T;
+                fprintf(stderr, "%'" PRIu64 " of %'" PRIu64 " (%4.1f %%)\n",
+                        s, S, 100.0 * (s / (double) S));
+                print_progress = 0;
+                alarm(progress_interval);
+            }
+
+            reuse_distance_type d = reuse_distance.reference(x->address());
+            if (record)
+                histogram.add(p, x->numa_domain(), d);
+        }
+    }
+
+    if (verbose && progress_interval > 0) {
+        alarm(0);
+        signal(SIGALRM, SIG_DFL);
+        uint64_t S = num_passes * T;
+        fprintf(stderr, "%'" PRIu64 " of %'" PRIu64 " (%4.1f %%)\n", S, S, 100.0);
+    }
+    return histogram;
+}
+
+}
@@ -0,0 +1,215 @@
+#ifndef REUSE_DISTANCE_HPP
+#define REUSE_DISTANCE_HPP
+
+/*
+ * Reuse distance (stack distance) analysis, based on the paper:
+ *
+ * R. L. Mattson, J. Gecsei, D. R. Slutz, and I. L. Traiger (1970):
+ * Evaluation techniques for storage hierarchies, in IBM Systems
+ * Journal, vol. 9, no. 2, pp. 78--117. DOI=10.1147/sj.92.0078.
+ *
+ * The reuse distance of a memory reference is the number of distinct
+ * cache lines that were referenced since the previous reference to
+ * the same cache line.  A fully associative cache with least-recently
+ * used replacement that holds C cache lines incurs a cache miss
+ * exactly for those references whose reuse distance is at least C,
+ * and for the first reference to each cache line.  A single pass
+ * over a memory reference string therefore yields the number of
+ * cache misses for every cache size.
+ */
+
+#include "cache-simulation/replacement.hpp"
+#include "util/flat-hash-map.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace replacement
+{
+
+using reuse_distance_type = uint64_t;
+
+/*
+ * Compute reuse distances in O(log n) time per memory reference.
+ *
+ * A Fenwick tree over time marks the most recent use of every cache
+ * line, so that the reuse distance of a cache line is the number of
+ * marks that follow its previous use.  Whenever the clock runs out of
+ * room, the marks are renumbered in order of their time of use, which
+ * keeps the tree proportional to the number of distinct cache lines.
+ */
+class ReuseDistance
+{
+public:
+    // The reuse distance of the first reference to a cache line
+    static constexpr reuse_distance_type infinite =
+        std::numeric_limits<reuse_distance_type>::max();
+
+public:
+    ReuseDistance(cache_size_type cache_line_size);
+    ~ReuseDistance();
+
+    reuse_distance_type reference(memory_reference_type x);
+
+private:
+    typedef uint32_t count_type;
+
+    void mark(uint64_t time, int delta);
+    count_type count(uint64_t time) const;
+    void compact();
+
+private:
+    // The size of each cache line (in bytes)
+    cache_size_type cache_line_size;
+
+    // A Fenwick tree over time, counting the most recent uses of
+    // cache lines
+    std::vector<count_type> tree;
+
+    // The cache line whose most recent use happened at a given time,
+    // or `no_line' if there is none
+    std::vector<memory_reference_type> line_at;
+
+    // The time of the most recent use of each cache line
+    FlatHashMap<memory_reference_type, uint64_t> last_use;
+
+    // The current time
+    uint64_t clock;
+
+    // The number of distinct cache lines referenced so far
+    uint64_t num_lines;
+};
+
+/*
+ * Reuse distances are counted in bins, where the first four bins
+ * hold the distances 0, 1, 2 and 3, and every subsequent power of two
+ * is split into four bins of equal width.
+ */
+std::size_t reuse_distance_bin(reuse_distance_type d);
+reuse_distance_type reuse_distance_bin_lower_bound(std::size_t bin);
+
+/*
+ * A histogram of the reuse distances of memory references made by
+ * one or more processors, together with the number of first
+ * references to each cache line, which have infinite reuse distance.
+ *
+ * Since reuse distances are binned, the cache misses are only known
+ * exactly for cache sizes at the boundaries of bins.  In addition,
+ * the cache misses are counted exactly for each of the given numbers
+ * of cache lines, such as those of the caches that are simulated.
+ */
+class ReuseDistanceHistogram
+{
+public:
+    ReuseDistanceHistogram();
+    ReuseDistanceHistogram(
+        cache_size_type cache_line_size,
+        std::size_t num_processors,
+        numa_domain_type num_numa_domains,
+        std::vector<cache_size_type> const & exact_cache_lines =
+            std::vector<cache_size_type>());
+    ~ReuseDistanceHistogram();
+
+    cache_size_type cache_line_size() const;
+    std::size_t num_processors() const;
+    numa_domain_type num_numa_domains() const;
+
+    /*
+     * The numbers of cache lines, in increasing order, for which
+     * cache misses are counted exactly, in addition to those at the
+     * boundaries of bins.
+     */
+    std::vector<cache_size_type> const & exact_cache_lines() const;
+
+    /*
+     * The number of bins, which is one more than the largest bin in
+     * use by any processor and NUMA domain.
+     */
+    std::size_t num_bins() const;
+
+    void add(
+        std::size_t p,
+        numa_domain_type numa_domain,
+        reuse_distance_type d);
+
+    cache_miss_type count(
+        std::size_t p,
+        numa_domain_type numa_domain,
+        std::size_t bin) const;
+
+    cache_miss_type cold_misses(
+        std::size_t p,
+        numa_domain_type numa_domain) const;
+
+    /*
+     * Whether the cache misses are exact for a cache that holds the
+     * given number of cache lines, that is, whether it is the lower
+     * bound of a bin or one of `exact_cache_lines()'.
+     */
+    bool exact(
+        cache_size_type cache_lines) const;
+
+    /*
+     * The number of cache misses for each processor and NUMA domain
+     * in a fully associative cache with least-recently used
+     * replacement that holds the given number of cache lines.
+     *
+     * Unless the result is exact, the memory references in the bin
+     * that contains the number of cache lines are all counted as
+     * hits, and the result is a lower bound on the cache misses.
+     */
+    std::vector<std::vector<cache_miss_type>> cache_misses(
+        cache_size_type cache_lines) const;
+
+private:
+    cache_size_type cache_line_size_;
+    numa_domain_type num_numa_domains_;
+
+    // The numbers of cache lines with exact cache misses, and the
+    // cache misses, other than cold misses, for each of them,
+    // processor and NUMA domain
+    std::vector<cache_size_type> exact_cache_lines_;
+    std::vector<std::vector<std::vector<cache_miss_type>>> exact_cache_misses;
+
+    // The histogram for each processor and NUMA domain
+    std::vector<std::vector<std::vector<cache_miss_type>>> histogram;
+
+    // The first references for each processor and NUMA domain
+    std::vector<std::vector<cache_miss_type>> cold_misses_;
+};
+
+/*
+ * Compute a histogram of the reuse distances of memory reference
+ * strings for multiple processors with a shared cache, where the
+ * memory reference strings are perfectly interleaved, as in
+ * `trace_cache_misses', unless another interleaving is given.
+ *
+ * If `warmup' is set, the memory reference strings are processed
+ * twice, and only the second pass is counted.  Cache misses are
+ * counted exactly for caches with `exact_cache_lines' cache lines.
+ */
+ReuseDistanceHistogram trace_reuse_distances(
+    cache_size_type cache_line_size,
+    std::vector<MemoryReferenceString> const & ws,
+    numa_domain_type num_numa_domains,
+    bool warmup = false,
+    bool verbose = false,
+    int progress_interval = 0,
+    std::vector<cache_size_type> const & exact_cache_lines =
+        std::vector<cache_size_type>());
+
+ReuseDistanceHistogram trace_reuse_distances(
+    cache_size_type cache_line_size,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    numa_domain_type num_numa_domains,
+    bool warmup = false,
+    bool verbose = false,
+    int progress_interval = 0,
+    Interleaving const & interleaving = Interleaving(),
+    std::vector<cache_size_type> const & exact_cache_lines =
+        std::vector<cache_size_type>());
+
+}
+
+#endif
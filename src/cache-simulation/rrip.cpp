@@ -0,0 +1,146 @@
+#include "cache-simulation/checkpoint.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace replacement
+{
+
+using cache_reference_type = uintptr_t;
+
+constexpr uint8_t SetAssociativeRRIP::max_rrpv;
+constexpr unsigned int SetAssociativeRRIP::bimodal_throttle;
+constexpr cache_size_type SetAssociativeRRIP::dueling_leader_sets;
+constexpr int SetAssociativeRRIP::policy_selector_bits;
+
+SetAssociativeRRIP::SetAssociativeRRIP(
+    cache_size_type cache_lines,
+    cache_size_type cache_line_size,
+    cache_size_type ways,
+    RRIPInsertionPolicy insertion_policy,
+    SetIndexFunction set_index_function)
+    : SetAssociative(
+        cache_lines,
+        cache_line_size,
+        ways,
+        set_index_function)
+    , insertion_policy(insertion_policy)
+    , rrpv(cache_lines, max_rrpv)
+    , bimodal_count(0)
+    , leader_set_spacing(
+        std::max<cache_size_type>(num_sets / dueling_leader_sets, 4))
+    , policy_selector(1u << (policy_selector_bits - 1))
+{
+}
+
+SetAssociativeRRIP::~SetAssociativeRRIP()
+{
+}
+
+/*
+ * Choose the RRPV of a cache line that is inserted into a set after
+ * a cache miss.  For DRRIP, a miss in a leader set also updates the
+ * policy selector.
+ */
+uint8_t SetAssociativeRRIP::insertion_rrpv(
+    cache_size_type set)
+{
+    RRIPInsertionPolicy policy = insertion_policy;
+    if (policy == RRIPInsertionPolicy::dynamic_rrip) {
+        unsigned int const policy_selector_max =
+            (1u << policy_selector_bits) - 1u;
+        unsigned int const policy_selector_threshold =
+            1u << (policy_selector_bits - 1);
+        cache_size_type leader = set % leader_set_spacing;
+        if (leader == 0) {
+            policy = RRIPInsertionPolicy::static_rrip;
+            if (policy_selector < policy_selector_max)
+                policy_selector++;
+        } else if (leader == 1) {
+            policy = RRIPInsertionPolicy::bimodal_rrip;
+            if (policy_selector > 0)
+                policy_selector--;
+        } else {
+            policy = (policy_selector > policy_selector_threshold)
+                ? RRIPInsertionPolicy::bimodal_rrip
+                : RRIPInsertionPolicy::static_rrip;
+        }
+    }
+
+    if (policy == RRIPInsertionPolicy::bimodal_rrip) {
+        if (++bimodal_count < bimodal_throttle)
+            return max_rrpv;
+        bimodal_count = 0;
+    }
+    return max_rrpv - 1;
+}
+
+cache_miss_type SetAssociativeRRIP::allocate(
+    memory_reference_type x,
+    numa_domain_type numa_domain)
+{
+    return allocate_line(x / cache_line_size, numa_domain);
+}
+
+cache_miss_type SetAssociativeRRIP::allocate_line(
+    memory_reference_type y,
+    numa_domain_type numa_domain)
+{
+    victim_line = no_victim;
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    uint8_t * r = &rrpv[set * ways];
+    if (way < ways) {
+        r[way] = 0;
+        use_way(set, way);
+        return 0u;
+    }
+
+    // Unused ways are filled first.  Otherwise, the first way with
+    // a distant re-reference interval is replaced, after ageing the
+    // set until there is such a way.
+    way = find_invalid_way(set);
+    if (way == ways) {
+        uint8_t oldest = *std::max_element(r, r + ways);
+        for (cache_size_type w = 0; w < ways; w++)
+            r[w] += max_rrpv - oldest;
+        way = std::find(r, r + ways, max_rrpv) - r;
+    }
+    fill_way(set, way, y);
+    r[way] = insertion_rrpv(set);
+    return 1u;
+}
+
+bool SetAssociativeRRIP::invalidate(
+    memory_reference_type x)
+{
+    cache_reference_type y = x / cache_line_size;
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    if (way == ways)
+        return false;
+    tags[set * ways + way] = invalid_tag;
+    rrpv[set * ways + way] = max_rrpv;
+    return true;
+}
+
+void SetAssociativeRRIP::save(
+    std::ostream & o) const
+{
+    SetAssociative::save(o);
+    replacement::save(o, rrpv);
+    replacement::save(o, bimodal_count);
+    replacement::save(o, policy_selector);
+}
+
+void SetAssociativeRRIP::load(
+    std::istream & i)
+{
+    SetAssociative::load(i);
+    replacement::load(i, rrpv);
+    replacement::load(i, bimodal_count);
+    replacement::load(i, policy_selector);
+}
+
+}
@@ -0,0 +1,180 @@
+#include "cache-simulation/replacement.hpp"
+
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace replacement
+{
+
+Sampling::Sampling(
+    uint64_t period,
+    uint64_t warmup_window,
+    uint64_t detailed_window,
+    double target_error)
+    : period_(period)
+    , warmup_window_(warmup_window)
+    , detailed_window_(detailed_window)
+    , target_error_(target_error)
+{
+    if (period > 0 &&
+        (detailed_window == 0 || warmup_window + detailed_window > period))
+    {
+        throw std::invalid_argument(
+            "Expected a detailed window, and that the warm-up and "
+            "detailed windows fit within the sampling period");
+    }
+    if (target_error < 0.0) {
+        throw std::invalid_argument(
+            "Expected a non-negative target error");
+    }
+}
+
+Sampling::~Sampling()
+{
+}
+
+bool Sampling::enabled() const
+{
+    return period_ > 0;
+}
+
+uint64_t Sampling::period() const
+{
+    return period_;
+}
+
+uint64_t Sampling::warmup_window() const
+{
+    return warmup_window_;
+}
+
+uint64_t Sampling::detailed_window() const
+{
+    return detailed_window_;
+}
+
+double Sampling::target_error() const
+{
+    return target_error_;
+}
+
+SamplingWindow Sampling::window(
+    uint64_t t) const
+{
+    if (period_ == 0)
+        return SamplingWindow::detailed;
+    uint64_t phase = t % period_;
+    if (phase + detailed_window_ >= period_)
+        return SamplingWindow::detailed;
+    if (phase + detailed_window_ + warmup_window_ >= period_)
+        return SamplingWindow::warmup;
+    return SamplingWindow::skip;
+}
+
+SamplingStatistics::SamplingStatistics()
+    : references()
+    , detailed_references()
+    , counted_cache_misses()
+    , window_cache_misses()
+{
+}
+
+SamplingStatistics::~SamplingStatistics()
+{
+}
+
+void SamplingStatistics::reset(
+    std::size_t num_processors,
+    std::size_t num_caches)
+{
+    references.assign(num_processors, 0);
+    detailed_references.assign(num_processors, 0);
+    counted_cache_misses.assign(num_caches, 0);
+    window_cache_misses.assign(num_caches, std::vector<cache_miss_type>());
+}
+
+void SamplingStatistics::reference(
+    std::size_t p,
+    SamplingWindow window)
+{
+    references[p]++;
+    detailed_references[p] += (window == SamplingWindow::detailed);
+}
+
+void SamplingStatistics::end_window(
+    std::vector<cache_miss_type> const & cache_misses)
+{
+    for (std::size_t i = 0; i < cache_misses.size(); i++) {
+        window_cache_misses[i].push_back(
+            cache_misses[i] - counted_cache_misses[i]);
+        counted_cache_misses[i] = cache_misses[i];
+    }
+}
+
+double SamplingStatistics::scale(
+    std::size_t p) const
+{
+    if (detailed_references[p] == 0)
+        return 0.0;
+    return references[p] / (double) detailed_references[p];
+}
+
+double SamplingStatistics::scale() const
+{
+    uint64_t n = std::accumulate(
+        references.cbegin(), references.cend(), uint64_t(0));
+    uint64_t m = std::accumulate(
+        detailed_references.cbegin(), detailed_references.cend(), uint64_t(0));
+    return m > 0 ? n / (double) m : 0.0;
+}
+
+void SamplingStatistics::extrapolate(
+    std::vector<std::vector<cache_miss_type>> & counts) const
+{
+    for (std::size_t p = 0; p < counts.size(); p++) {
+        double s = scale(p);
+        for (auto & count : counts[p])
+            count = std::llround(count * s);
+    }
+}
+
+double SamplingEstimate::relative_error() const
+{
+    return cache_misses > 0.0 ? confidence_interval / cache_misses : 0.0;
+}
+
+bool SamplingEstimate::meets_target(
+    Sampling const & sampling) const
+{
+    return sampling.target_error() <= 0.0 ||
+        relative_error() <= sampling.target_error();
+}
+
+/*
+ * The detailed windows are treated as a random sample of windows, so
+ * that the variance of their sum is the number of windows times the
+ * sample variance of the cache misses of a window.  With fewer than
+ * two windows, the variance is unknown, and the confidence interval
+ * is taken to be as wide as the estimate itself.
+ */
+SamplingEstimate SamplingStatistics::estimate(
+    std::size_t cache) const
+{
+    auto const & x = window_cache_misses[cache];
+    uint64_t n = x.size();
+    double sum = std::accumulate(x.cbegin(), x.cend(), 0.0);
+    double cache_misses = scale() * sum;
+    if (n < 2)
+        return SamplingEstimate{n, cache_misses, cache_misses};
+
+    double mean = sum / n;
+    double variance = 0.0;
+    for (cache_miss_type y : x)
+        variance += (y - mean) * (y - mean) / (n - 1);
+    double confidence_interval = 1.96 * scale() * std::sqrt(n * variance);
+    return SamplingEstimate{n, cache_misses, confidence_interval};
+}
+
+}
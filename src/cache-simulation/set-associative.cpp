@@ -0,0 +1,296 @@
+#include "cache-simulation/checkpoint.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace replacement
+{
+
+using cache_reference_type = uintptr_t;
+
+constexpr memory_reference_type SetAssociative::invalid_tag;
+
+SetAssociative::SetAssociative(
+    cache_size_type cache_lines,
+    cache_size_type cache_line_size,
+    cache_size_type ways,
+    SetIndexFunction set_index_function)
+    : ReplacementAlgorithm(
+        cache_lines,
+        cache_line_size)
+    , ways(ways)
+    , num_sets(ways > 0 ? cache_lines / ways : 0)
+    , set_bits(0)
+    , sets_mask(0)
+    , set_index_function(set_index_function)
+    , tags(cache_lines, invalid_tag)
+    , line_states(cache_lines)
+{
+    if (ways == 0 || cache_lines % ways != 0) {
+        std::stringstream s;
+        s << "Expected the number of cache lines (" << cache_lines << ") "
+          << "to be a multiple of the associativity (" << ways << ")";
+        throw std::invalid_argument(s.str());
+    }
+
+    while ((cache_size_type(1) << set_bits) < num_sets)
+        set_bits++;
+    if (num_sets > 1 && (num_sets & (num_sets - 1)) == 0)
+        sets_mask = num_sets - 1;
+}
+
+SetAssociative::~SetAssociative()
+{
+}
+
+bool SetAssociative::invalidate(
+    memory_reference_type x)
+{
+    cache_reference_type y = x / cache_line_size;
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    if (way == ways)
+        return false;
+    tags[set * ways + way] = invalid_tag;
+    return true;
+}
+
+bool SetAssociative::contains(
+    memory_reference_type x) const
+{
+    cache_reference_type y = x / cache_line_size;
+    return find_way(set_index(y), y) < ways;
+}
+
+CacheLineState * SetAssociative::find_line(
+    memory_reference_type y)
+{
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    return way < ways ? &line_states[set * ways + way] : nullptr;
+}
+
+void SetAssociative::save(
+    std::ostream & o) const
+{
+    ReplacementAlgorithm::save(o);
+    replacement::save(o, tags);
+    replacement::save(o, line_states);
+}
+
+void SetAssociative::load(
+    std::istream & i)
+{
+    ReplacementAlgorithm::load(i);
+    replacement::load(i, tags);
+    replacement::load(i, line_states);
+}
+
+SetAssociativeLRU::SetAssociativeLRU(
+    cache_size_type cache_lines,
+    cache_size_type cache_line_size,
+    cache_size_type ways,
+    SetIndexFunction set_index_function)
+    : SetAssociative(
+        cache_lines,
+        cache_line_size,
+        ways,
+        set_index_function)
+    , last_use(cache_lines, 0)
+    , clock(0)
+{
+}
+
+SetAssociativeLRU::~SetAssociativeLRU()
+{
+}
+
+cache_miss_type SetAssociativeLRU::allocate(
+    memory_reference_type x,
+    numa_domain_type numa_domain)
+{
+    return allocate_line(x / cache_line_size, numa_domain);
+}
+
+cache_miss_type SetAssociativeLRU::allocate_line(
+    memory_reference_type y,
+    numa_domain_type numa_domain)
+{
+    victim_line = no_victim;
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    clock++;
+    if (way < ways) {
+        last_use[set * ways + way] = clock;
+        use_way(set, way);
+        return 0u;
+    }
+
+    // Replace the least recently used way.  Unused ways have never
+    // been used, and are therefore replaced first.
+    uint64_t const * t = &last_use[set * ways];
+    way = 0;
+    for (cache_size_type w = 1; w < ways; w++)
+        way = (t[w] < t[way]) ? w : way;
+    fill_way(set, way, y);
+    last_use[set * ways + way] = clock;
+    return 1u;
+}
+
+bool SetAssociativeLRU::invalidate(
+    memory_reference_type x)
+{
+    cache_reference_type y = x / cache_line_size;
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    if (way == ways)
+        return false;
+    tags[set * ways + way] = invalid_tag;
+    last_use[set * ways + way] = 0;
+    return true;
+}
+
+void SetAssociativeLRU::save(
+    std::ostream & o) const
+{
+    SetAssociative::save(o);
+    replacement::save(o, last_use);
+    replacement::save(o, clock);
+}
+
+void SetAssociativeLRU::load(
+    std::istream & i)
+{
+    SetAssociative::load(i);
+    replacement::load(i, last_use);
+    replacement::load(i, clock);
+}
+
+SetAssociativeFIFO::SetAssociativeFIFO(
+    cache_size_type cache_lines,
+    cache_size_type cache_line_size,
+    cache_size_type ways,
+    SetIndexFunction set_index_function)
+    : SetAssociative(
+        cache_lines,
+        cache_line_size,
+        ways,
+        set_index_function)
+    , next_way(num_sets, 0)
+{
+}
+
+SetAssociativeFIFO::~SetAssociativeFIFO()
+{
+}
+
+cache_miss_type SetAssociativeFIFO::allocate(
+    memory_reference_type x,
+    numa_domain_type numa_domain)
+{
+    return allocate_line(x / cache_line_size, numa_domain);
+}
+
+cache_miss_type SetAssociativeFIFO::allocate_line(
+    memory_reference_type y,
+    numa_domain_type numa_domain)
+{
+    victim_line = no_victim;
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    if (way < ways) {
+        use_way(set, way);
+        return 0u;
+    }
+
+    // Unused ways are filled first.  Otherwise, ways are replaced in
+    // a round-robin order, so that the oldest cache line in a set is
+    // replaced, unless some of its ways were invalidated.
+    way = find_invalid_way(set);
+    if (way == ways) {
+        way = next_way[set];
+        next_way[set] = (way + 1 < ways) ? way + 1 : 0;
+    }
+    fill_way(set, way, y);
+    return 1u;
+}
+
+void SetAssociativeFIFO::save(
+    std::ostream & o) const
+{
+    SetAssociative::save(o);
+    replacement::save(o, next_way);
+}
+
+void SetAssociativeFIFO::load(
+    std::istream & i)
+{
+    SetAssociative::load(i);
+    replacement::load(i, next_way);
+}
+
+SetAssociativeRAND::SetAssociativeRAND(
+    cache_size_type cache_lines,
+    cache_size_type cache_line_size,
+    cache_size_type ways,
+    SetIndexFunction set_index_function,
+    uint64_t seed)
+    : SetAssociative(
+        cache_lines,
+        cache_line_size,
+        ways,
+        set_index_function)
+    , rng(seed)
+{
+}
+
+SetAssociativeRAND::~SetAssociativeRAND()
+{
+}
+
+cache_miss_type SetAssociativeRAND::allocate(
+    memory_reference_type x,
+    numa_domain_type numa_domain)
+{
+    return allocate_line(x / cache_line_size, numa_domain);
+}
+
+cache_miss_type SetAssociativeRAND::allocate_line(
+    memory_reference_type y,
+    numa_domain_type numa_domain)
+{
+    victim_line = no_victim;
+    cache_size_type set = set_index(y);
+    cache_size_type way = find_way(set, y);
+    if (way < ways) {
+        use_way(set, way);
+        return 0u;
+    }
+
+    way = find_invalid_way(set);
+    if (way == ways)
+        way = std::uniform_int_distribution<cache_size_type>(0, ways-1)(rng);
+    fill_way(set, way, y);
+    return 1u;
+}
+
+void SetAssociativeRAND::save(
+    std::ostream & o) const
+{
+    SetAssociative::save(o);
+    replacement::save(o, rng);
+}
+
+void SetAssociativeRAND::load(
+    std::istream & i)
+{
+    SetAssociative::load(i);
+    replacement::load(i, rng);
+}
+
+}
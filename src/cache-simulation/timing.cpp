@@ -0,0 +1,144 @@
+#include "cache-simulation/timing.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace replacement
+{
+
+TimingModel::TimingModel(
+    std::vector<double> const & cache_latency,
+    std::vector<double> const & cache_bandwidth,
+    std::vector<double> const & memory_latency,
+    std::vector<double> const & memory_bandwidth,
+    cache_size_type cache_line_size,
+    int max_outstanding_misses)
+    : cache_latency(cache_latency)
+    , cache_bandwidth(cache_bandwidth)
+    , memory_latency(memory_latency)
+    , memory_bandwidth(memory_bandwidth)
+    , cache_line_size(cache_line_size)
+    , max_outstanding_misses(std::max(1, max_outstanding_misses))
+    , clocks()
+    , outstanding()
+    , finish()
+    , cache_lines_per_cache()
+    , cache_lines_per_numa_domain()
+    , served_per_cache()
+    , served_per_numa_domain()
+{
+}
+
+TimingModel::~TimingModel()
+{
+}
+
+void TimingModel::reset(
+    std::size_t num_processors)
+{
+    clocks.assign(num_processors, 0.0);
+    outstanding.assign(num_processors, {});
+    finish.assign(num_processors, 0.0);
+    cache_lines_per_cache.assign(cache_latency.size(), 0);
+    cache_lines_per_numa_domain.assign(memory_latency.size(), 0);
+    served_per_cache.assign(
+        cache_latency.size(), std::vector<bool>(num_processors, false));
+    served_per_numa_domain.assign(
+        memory_latency.size(), std::vector<bool>(num_processors, false));
+}
+
+void TimingModel::serve(
+    std::size_t p,
+    std::vector<cache_miss_type> & cache_lines,
+    std::vector<std::vector<bool>> & served,
+    std::size_t resource,
+    cache_miss_type n)
+{
+    if (resource >= cache_lines.size())
+        return;
+    cache_lines[resource] += n;
+    served[resource][p] = true;
+}
+
+void TimingModel::reference(
+    std::size_t p,
+    int first_level_cache,
+    int served_by,
+    numa_domain_type numa_domain)
+{
+    double issue = cache_latency[first_level_cache];
+    if (served_by == first_level_cache) {
+        clocks[p] += issue;
+        return;
+    }
+
+    // Wait for an outstanding cache miss to complete, if there are
+    // already too many of them.
+    auto & misses = outstanding[p];
+    if ((int) misses.size() >= max_outstanding_misses) {
+        clocks[p] = std::max(clocks[p], misses.top());
+        misses.pop();
+    }
+
+    double latency;
+    if (served_by >= 0) {
+        latency = cache_latency[served_by];
+        serve(p, cache_lines_per_cache, served_per_cache, served_by, 1);
+    } else {
+        // NUMA domains beyond the given latencies share the latency
+        // of the last NUMA domain.
+        latency = (std::size_t) numa_domain < memory_latency.size()
+            ? memory_latency[numa_domain]
+            : memory_latency.empty() ? 0.0 : memory_latency.back();
+        serve(p, cache_lines_per_numa_domain, served_per_numa_domain,
+              numa_domain, 1);
+    }
+    double completion = clocks[p] + latency;
+    misses.push(completion);
+    finish[p] = std::max(finish[p], completion);
+    clocks[p] += issue;
+}
+
+void TimingModel::transfer(
+    std::size_t p,
+    numa_domain_type numa_domain,
+    cache_miss_type cache_lines)
+{
+    if (cache_lines > 0) {
+        serve(p, cache_lines_per_numa_domain, served_per_numa_domain,
+              numa_domain, cache_lines);
+    }
+}
+
+std::vector<double> TimingModel::time() const
+{
+    std::size_t num_processors = clocks.size();
+    std::vector<double> t(num_processors);
+    for (std::size_t p = 0; p < num_processors; p++)
+        t[p] = std::max(clocks[p], finish[p]);
+
+    // Every processor that was served by a cache or a NUMA domain
+    // finishes no earlier than it takes to transfer all the cache
+    // lines that it served at its bandwidth.
+    for (std::size_t i = 0; i < cache_lines_per_cache.size(); i++) {
+        if (i >= cache_bandwidth.size() || cache_bandwidth[i] <= 0.0)
+            continue;
+        double busy = cache_lines_per_cache[i] * cache_line_size / cache_bandwidth[i];
+        for (std::size_t p = 0; p < num_processors; p++) {
+            if (served_per_cache[i][p])
+                t[p] = std::max(t[p], busy);
+        }
+    }
+    for (std::size_t i = 0; i < cache_lines_per_numa_domain.size(); i++) {
+        if (i >= memory_bandwidth.size() || memory_bandwidth[i] <= 0.0)
+            continue;
+        double busy = cache_lines_per_numa_domain[i] * cache_line_size / memory_bandwidth[i];
+        for (std::size_t p = 0; p < num_processors; p++) {
+            if (served_per_numa_domain[i][p])
+                t[p] = std::max(t[p], busy);
+        }
+    }
+    return t;
+}
+
+}
@@ -0,0 +1,115 @@
+#ifndef TIMING_HPP
+#define TIMING_HPP
+
+#include "cache-simulation/replacement.hpp"
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace replacement
+{
+
+/*
+ * A cycle-approximate timing model of processors that make memory
+ * references through a cache hierarchy, which predicts the time taken
+ * by each processor (in nanoseconds, or whatever unit the latencies
+ * are given in).
+ *
+ * Every processor has its own clock.  A memory reference that hits
+ * in the processor's first-level cache advances the clock by the
+ * latency of that cache.  Otherwise, the memory reference is a cache
+ * miss that is served by a cache further from the processor, or by
+ * memory, and it completes after the latency of the cache or the
+ * NUMA domain that served it.  Cache misses do not stall the
+ * processor, except that at most `max_outstanding_misses' of them may
+ * be in flight at once, after which the processor waits for the
+ * earliest one to complete.  The memory references of a processor are
+ * otherwise assumed to be independent of each other.
+ *
+ * Bandwidth is modelled in aggregate, so that the result does not
+ * depend on the order in which the memory references of different
+ * processors are interleaved: a cache or a NUMA domain with a
+ * bandwidth of B bytes per unit of time that serves N cache lines is
+ * busy for at least N times the cache line size divided by B, and
+ * every processor that it served finishes no earlier than that.  A
+ * bandwidth of zero is unlimited.
+ */
+class TimingModel
+{
+public:
+    TimingModel(
+        std::vector<double> const & cache_latency,
+        std::vector<double> const & cache_bandwidth,
+        std::vector<double> const & memory_latency,
+        std::vector<double> const & memory_bandwidth,
+        cache_size_type cache_line_size,
+        int max_outstanding_misses);
+    ~TimingModel();
+
+    /*
+     * Reset the clocks of the given number of processors.
+     */
+    void reset(
+        std::size_t num_processors);
+
+    /*
+     * Advance the clock of processor `p', which is attached to the
+     * given first-level cache, by a memory reference that was served
+     * by the cache `served_by', or by memory if `served_by' is -1.
+     */
+    void reference(
+        std::size_t p,
+        int first_level_cache,
+        int served_by,
+        numa_domain_type numa_domain);
+
+    /*
+     * Charge additional cache lines that are transferred between
+     * memory and the caches on behalf of processor `p', such as
+     * write-backs and prefetches, against the memory bandwidth.
+     */
+    void transfer(
+        std::size_t p,
+        numa_domain_type numa_domain,
+        cache_miss_type cache_lines);
+
+    /*
+     * The predicted time taken by each processor.
+     */
+    std::vector<double> time() const;
+
+private:
+    void serve(
+        std::size_t p,
+        std::vector<cache_miss_type> & cache_lines,
+        std::vector<std::vector<bool>> & served,
+        std::size_t resource,
+        cache_miss_type n);
+
+private:
+    std::vector<double> cache_latency;
+    std::vector<double> cache_bandwidth;
+    std::vector<double> memory_latency;
+    std::vector<double> memory_bandwidth;
+    cache_size_type cache_line_size;
+    int max_outstanding_misses;
+
+    // The clock of each processor, the completion times of its
+    // outstanding cache misses, and the latest completion time
+    std::vector<double> clocks;
+    std::vector<std::priority_queue<
+        double, std::vector<double>, std::greater<double>>> outstanding;
+    std::vector<double> finish;
+
+    // The cache lines served by each cache and each NUMA domain, and
+    // the processors that they were served to
+    std::vector<cache_miss_type> cache_lines_per_cache;
+    std::vector<cache_miss_type> cache_lines_per_numa_domain;
+    std::vector<std::vector<bool>> served_per_cache;
+    std::vector<std::vector<bool>> served_per_numa_domain;
+};
+
+}
+
+#endif
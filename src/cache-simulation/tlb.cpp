@@ -0,0 +1,40 @@
+#include "cache-simulation/tlb.hpp"
+
+#include <vector>
+
+namespace replacement
+{
+
+TLB::TLB(
+    cache_size_type entries,
+    cache_size_type page_size,
+    cache_size_type associativity)
+    : SetAssociativeLRU(
+        entries,
+        page_size,
+        associativity > 0 ? associativity : entries)
+{
+}
+
+TLB::~TLB()
+{
+}
+
+std::vector<std::vector<std::vector<cache_miss_type>>> trace_tlb_misses(
+    CacheHierarchy & hierarchy,
+    std::vector<int> const & first_level_tlbs,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    numa_domain_type num_numa_domains,
+    Interleaving const & interleaving)
+{
+    InterleavedMemoryReferenceStream stream(ws, interleaving);
+    hierarchy.reset(ws.size(), num_numa_domains);
+    std::size_t p;
+    for (auto const * x = stream.next(p); x; x = stream.next(p)) {
+        hierarchy.reference(
+            first_level_tlbs[p], x->address(), p, x->numa_domain());
+    }
+    return hierarchy.cache_misses();
+}
+
+}
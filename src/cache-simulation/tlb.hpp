@@ -0,0 +1,50 @@
+#ifndef TLB_HPP
+#define TLB_HPP
+
+#include "cache-simulation/hierarchy.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <vector>
+
+namespace replacement
+{
+
+/*
+ * A translation lookaside buffer (TLB), which caches the translations
+ * of virtual pages.  A TLB behaves like a cache whose cache lines are
+ * pages, and it is modelled as a set-associative cache with LRU
+ * replacement, where an associativity of zero gives a fully
+ * associative TLB.
+ *
+ * Hierarchies of TLBs, such as a first-level data TLB backed by a
+ * second-level TLB (STLB), are simulated with `CacheHierarchy', where
+ * a miss in a last-level TLB corresponds to a page walk.
+ */
+class TLB
+    : public SetAssociativeLRU
+{
+public:
+    TLB(cache_size_type entries,
+        cache_size_type page_size,
+        cache_size_type associativity = 0);
+    ~TLB();
+};
+
+/*
+ * Compute the TLB misses in every TLB of a TLB hierarchy for the
+ * interleaved memory reference strings of multiple processors, where
+ * processor `p' is attached to the first-level TLB `first_level_tlbs[p]'.
+ * Every memory reference is translated, including streaming stores.
+ *
+ * The result is given for each TLB, processor and NUMA domain.
+ */
+std::vector<std::vector<std::vector<cache_miss_type>>> trace_tlb_misses(
+    CacheHierarchy & hierarchy,
+    std::vector<int> const & first_level_tlbs,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    numa_domain_type num_numa_domains,
+    Interleaving const & interleaving = Interleaving());
+
+}
+
+#endif
@@ -0,0 +1,504 @@
+#include "cache-simulation/trace-file.hpp"
+#include "cache-simulation/checkpoint.hpp"
+
+#include "util/zlibstream.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace replacement
+{
+
+namespace
+{
+
+// The first bytes of every trace file, followed by its version
+char const trace_file_magic[8] = {'S', 'P', 'M', 'V', 'T', 'R', 'C', 'E'};
+uint32_t const trace_file_version = 1;
+
+// Flags in the header of a trace file
+uint32_t const trace_file_compressed = 1u;
+
+void encode_varint(
+    std::string & s,
+    uint64_t x)
+{
+    while (x >= 0x80) {
+        s.push_back(char((x & 0x7f) | 0x80));
+        x >>= 7;
+    }
+    s.push_back(char(x));
+}
+
+/*
+ * Encode a block of memory references.  Addresses are encoded as
+ * zigzag-encoded differences from the previous address, shifted left
+ * by one bit to flag the memory references whose NUMA domain or
+ * access type differ from the previous memory reference.
+ */
+std::string encode_block(
+    MemoryReference const * w,
+    std::size_t count)
+{
+    std::string s;
+    s.reserve(2 * count);
+    uint64_t previous_address = 0;
+    uint64_t previous_attributes = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        uint64_t address = w[i].address();
+        uint64_t attributes =
+            (uint64_t(w[i].numa_domain()) << 2) | uint64_t(w[i].access_type());
+        int64_t delta = int64_t(address - previous_address);
+        uint64_t zigzag = (uint64_t(delta) << 1) ^ uint64_t(delta >> 63);
+        bool changed = attributes != previous_attributes;
+        encode_varint(s, (zigzag << 1) | uint64_t(changed));
+        if (changed)
+            encode_varint(s, attributes);
+        previous_address = address;
+        previous_attributes = attributes;
+    }
+    return s;
+}
+
+uint64_t decode_varint(
+    unsigned char const *& p,
+    unsigned char const * end)
+{
+    uint64_t x = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end)
+            throw trace_file_error("Unexpected end of memory reference block");
+        unsigned char c = *p++;
+        x |= uint64_t(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return x;
+    }
+    throw trace_file_error("Invalid variable-length integer");
+}
+
+void decode_block(
+    unsigned char const * p,
+    unsigned char const * end,
+    MemoryReference * w,
+    std::size_t count)
+{
+    uint64_t address = 0;
+    uint64_t attributes = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        uint64_t x = decode_varint(p, end);
+        uint64_t zigzag = x >> 1;
+        address += uint64_t((zigzag >> 1) ^ -(zigzag & 1));
+        if (x & 1)
+            attributes = decode_varint(p, end);
+        w[i] = MemoryReference(
+            address,
+            numa_domain_type(attributes >> 2),
+            AccessType(attributes & 0x3));
+    }
+    if (p != end)
+        throw trace_file_error("Unexpected data at the end of memory reference block");
+}
+
+/*
+ * A read-only stream buffer for data that is already in memory.
+ */
+class memorybuf
+    : public std::streambuf
+{
+public:
+    memorybuf(char const * p, std::size_t size)
+    {
+        char * q = const_cast<char *>(p);
+        this->setg(q, q, q + size);
+    }
+};
+
+/*
+ * Write values to a stream, while keeping track of the number of
+ * bytes that are written, which determines the offsets of the blocks.
+ */
+class TraceFileWriter
+{
+public:
+    TraceFileWriter(std::ostream & o)
+        : o(o)
+        , offset(0)
+    {
+    }
+
+    template <typename T>
+    void write(T const & x)
+    {
+        save(o, x);
+        offset += sizeof(T);
+    }
+
+    void write(std::string const & s)
+    {
+        write(uint64_t(s.size()));
+        o.write(s.data(), s.size());
+        offset += s.size();
+    }
+
+    std::ostream & o;
+    uint64_t offset;
+};
+
+/*
+ * Read values from a trace file that is mapped into memory.
+ */
+class TraceFileReader
+{
+public:
+    TraceFileReader(
+        unsigned char const * data,
+        std::size_t size,
+        std::size_t offset)
+        : data(data)
+        , size(size)
+        , offset(offset)
+    {
+        if (offset > size)
+            throw trace_file_error("Unexpected end of trace file");
+    }
+
+    template <typename T>
+    T read()
+    {
+        T x;
+        if (size - offset < sizeof(T))
+            throw trace_file_error("Unexpected end of trace file");
+        std::memcpy(&x, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return x;
+    }
+
+    std::string read_string()
+    {
+        uint64_t length = read<uint64_t>();
+        if (size - offset < length)
+            throw trace_file_error("Unexpected end of trace file");
+        std::string s(reinterpret_cast<char const *>(data + offset), length);
+        offset += length;
+        return s;
+    }
+
+    unsigned char const * data;
+    std::size_t size;
+    std::size_t offset;
+};
+
+}
+
+trace_file_error::trace_file_error(std::string const & message)
+    : std::runtime_error(message)
+{
+}
+
+void write_trace_file(
+    std::ostream & o,
+    std::string const & kernel_name,
+    std::string const & kernel_description,
+    std::vector<MemoryRegion> const & regions,
+    int num_numa_domains,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    bool compress)
+{
+    TraceFileWriter writer(o);
+    o.write(trace_file_magic, sizeof(trace_file_magic));
+    writer.offset += sizeof(trace_file_magic);
+    writer.write(trace_file_version);
+    writer.write(uint32_t(compress ? trace_file_compressed : 0u));
+    writer.write(uint64_t(trace_file_block_size));
+    writer.write(uint32_t(ws.size()));
+    writer.write(uint32_t(num_numa_domains));
+    writer.write(kernel_name);
+    writer.write(kernel_description);
+    writer.write(uint64_t(regions.size()));
+    for (auto const & region : regions) {
+        writer.write(region.name);
+        writer.write(uint64_t(region.begin));
+        writer.write(uint64_t(region.end));
+    }
+
+    // Write the blocks of each memory reference string, followed by
+    // an index of the blocks and, finally, the offset of the index.
+    std::vector<uint64_t> sizes(ws.size());
+    std::vector<std::vector<uint64_t>> index(ws.size());
+    MemoryReferenceString w(trace_file_block_size);
+    for (std::size_t thread = 0; thread < ws.size(); thread++) {
+        sizes[thread] = ws[thread]->size();
+        for (uint64_t i = 0; i < sizes[thread]; i += trace_file_block_size) {
+            std::size_t count = std::min<uint64_t>(
+                trace_file_block_size, sizes[thread] - i);
+            ws[thread]->generate(i, count, w.data());
+            std::string block = encode_block(w.data(), count);
+            uint64_t decompressed_size = block.size();
+            if (compress) {
+                std::stringbuf buf;
+                zlib::ozlibstream z(&buf);
+                z.write(block.data(), block.size());
+                z.finish();
+                block = buf.str();
+            }
+            index[thread].push_back(writer.offset);
+            index[thread].push_back(block.size());
+            index[thread].push_back(decompressed_size);
+            o.write(block.data(), block.size());
+            writer.offset += block.size();
+        }
+    }
+
+    uint64_t index_offset = writer.offset;
+    for (std::size_t thread = 0; thread < ws.size(); thread++) {
+        writer.write(sizes[thread]);
+        for (auto x : index[thread])
+            writer.write(x);
+    }
+    writer.write(index_offset);
+}
+
+TraceFile::TraceFile(
+    std::string const & path)
+    : path_(path)
+    , data(nullptr)
+    , data_size(0)
+    , compressed_(false)
+    , num_numa_domains_(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw trace_file_error(path + ": " + std::strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        int err = errno;
+        close(fd);
+        throw trace_file_error(path + ": " + std::strerror(err));
+    }
+    data_size = st.st_size;
+    if (data_size > 0) {
+        void * p = mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            int err = errno;
+            close(fd);
+            throw trace_file_error(path + ": " + std::strerror(err));
+        }
+        data = static_cast<unsigned char const *>(p);
+    }
+    close(fd);
+
+    try {
+        if (data_size < sizeof(trace_file_magic) ||
+            !std::equal(trace_file_magic, trace_file_magic + sizeof(trace_file_magic),
+                        reinterpret_cast<char const *>(data)))
+        {
+            throw trace_file_error("Expected a trace file");
+        }
+        TraceFileReader header(data, data_size, sizeof(trace_file_magic));
+        if (header.read<uint32_t>() != trace_file_version)
+            throw trace_file_error("Unsupported trace file version");
+        compressed_ = header.read<uint32_t>() & trace_file_compressed;
+        if (header.read<uint64_t>() != trace_file_block_size)
+            throw trace_file_error("Unsupported block size");
+        uint32_t num_threads = header.read<uint32_t>();
+        num_numa_domains_ = header.read<uint32_t>();
+        kernel_name_ = header.read_string();
+        kernel_description_ = header.read_string();
+        uint64_t num_regions = header.read<uint64_t>();
+        for (uint64_t i = 0; i < num_regions; i++) {
+            std::string name = header.read_string();
+            memory_reference_type begin = header.read<uint64_t>();
+            memory_reference_type end = header.read<uint64_t>();
+            regions.push_back(MemoryRegion{name, begin, end});
+        }
+        uint64_t blocks_begin = header.offset;
+
+        if (data_size < blocks_begin + sizeof(uint64_t))
+            throw trace_file_error("Unexpected end of trace file");
+        uint64_t index_offset = TraceFileReader(
+            data, data_size, data_size - sizeof(uint64_t)).read<uint64_t>();
+        if (index_offset < blocks_begin || index_offset > data_size - sizeof(uint64_t))
+            throw trace_file_error("Invalid trace file index");
+        TraceFileReader index(data, data_size - sizeof(uint64_t), index_offset);
+        sizes.resize(num_threads);
+        blocks.resize(num_threads);
+        for (uint32_t thread = 0; thread < num_threads; thread++) {
+            sizes[thread] = index.read<uint64_t>();
+            uint64_t num_blocks =
+                (sizes[thread] + trace_file_block_size - 1) / trace_file_block_size;
+            for (uint64_t i = 0; i < num_blocks; i++) {
+                Block block;
+                block.offset = index.read<uint64_t>();
+                block.size = index.read<uint64_t>();
+                block.decompressed_size = index.read<uint64_t>();
+                if (block.offset < blocks_begin ||
+                    block.offset > index_offset ||
+                    block.size > index_offset - block.offset)
+                {
+                    throw trace_file_error("Invalid trace file index");
+                }
+                blocks[thread].push_back(block);
+            }
+        }
+        if (index.offset != index.size)
+            throw trace_file_error("Invalid trace file index");
+    } catch (trace_file_error const & e) {
+        if (data)
+            munmap(const_cast<unsigned char *>(data), data_size);
+        throw trace_file_error(path + ": " + e.what());
+    }
+}
+
+TraceFile::~TraceFile()
+{
+    if (data)
+        munmap(const_cast<unsigned char *>(data), data_size);
+}
+
+std::string const & TraceFile::path() const
+{
+    return path_;
+}
+
+std::string const & TraceFile::kernel_name() const
+{
+    return kernel_name_;
+}
+
+std::string const & TraceFile::kernel_description() const
+{
+    return kernel_description_;
+}
+
+std::vector<MemoryRegion> const & TraceFile::memory_regions() const
+{
+    return regions;
+}
+
+int TraceFile::num_numa_domains() const
+{
+    return num_numa_domains_;
+}
+
+int TraceFile::num_threads() const
+{
+    return sizes.size();
+}
+
+bool TraceFile::compressed() const
+{
+    return compressed_;
+}
+
+/*
+ * A generator that decodes the memory reference string of a thread
+ * from a trace file.  Memory references are usually generated in
+ * order, so the most recently decoded block is kept.
+ *
+ * Although `generate' is const, it updates the decoded block, and so
+ * a generator must not be used by more than one simulation at a
+ * time.  Instead, each simulation obtains its own generator from
+ * `TraceFile::generator', and only the trace file itself is shared.
+ */
+class TraceFileGenerator
+    : public MemoryReferenceGenerator
+{
+public:
+    TraceFileGenerator(
+        TraceFile const & trace_file,
+        int thread)
+        : trace_file(trace_file)
+        , thread(thread)
+        , block(trace_file_block_size)
+        , current_block(-1)
+    {
+    }
+
+    uint64_t size() const override
+    {
+        return trace_file.sizes[thread];
+    }
+
+    void generate(
+        uint64_t offset,
+        uint64_t count,
+        MemoryReferenceString::value_type * w) const override
+    {
+        while (count > 0) {
+            uint64_t i = offset / trace_file_block_size;
+            uint64_t j = offset % trace_file_block_size;
+            decode(i);
+            uint64_t n = std::min<uint64_t>(
+                count, block_count(i) - j);
+            std::copy(block.begin() + j, block.begin() + j + n, w);
+            offset += n;
+            count -= n;
+            w += n;
+        }
+    }
+
+private:
+    uint64_t block_count(uint64_t i) const
+    {
+        return std::min<uint64_t>(
+            trace_file_block_size,
+            trace_file.sizes[thread] - i * trace_file_block_size);
+    }
+
+    void decode(uint64_t i) const
+    {
+        if (int64_t(i) == current_block)
+            return;
+        TraceFile::Block const & b = trace_file.blocks[thread][i];
+        unsigned char const * p = trace_file.data + b.offset;
+        try {
+            if (trace_file.compressed()) {
+                memorybuf buf(reinterpret_cast<char const *>(p), b.size);
+                zlib::izlibstream z(&buf);
+                decompressed.resize(b.decompressed_size);
+                if (!z.read(&decompressed[0], b.decompressed_size))
+                    throw trace_file_error("Unexpected end of compressed memory reference block");
+                p = reinterpret_cast<unsigned char const *>(decompressed.data());
+                decode_block(p, p + b.decompressed_size, block.data(), block_count(i));
+            } else {
+                decode_block(p, p + b.size, block.data(), block_count(i));
+            }
+        } catch (trace_file_error const & e) {
+            current_block = -1;
+            throw trace_file_error(trace_file.path() + ": " + e.what());
+        } catch (zlib::zlibstream_error const & e) {
+            current_block = -1;
+            throw trace_file_error(trace_file.path() + ": " + e.what());
+        }
+        current_block = i;
+    }
+
+private:
+    TraceFile const & trace_file;
+    int thread;
+    mutable MemoryReferenceString block;
+    mutable std::string decompressed;
+    mutable int64_t current_block;
+};
+
+std::unique_ptr<MemoryReferenceGenerator> TraceFile::generator(
+    int thread) const
+{
+    return std::unique_ptr<MemoryReferenceGenerator>(
+        new TraceFileGenerator(*this, thread));
+}
+
+}
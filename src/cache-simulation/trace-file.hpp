@@ -0,0 +1,117 @@
+#ifndef TRACE_FILE_HPP
+#define TRACE_FILE_HPP
+
+#include "cache-simulation/memory-region.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace replacement
+{
+
+class trace_file_error
+    : public std::runtime_error
+{
+public:
+    trace_file_error(std::string const & message);
+};
+
+/*
+ * A binary file with the memory reference strings of every thread of
+ * a kernel, which allows the cache simulations to be repeated without
+ * generating the memory references again.
+ *
+ * Each memory reference string is divided into blocks of
+ * `trace_file_block_size' memory references, which are encoded
+ * independently of each other, so that any part of a memory reference
+ * string can be decoded without decoding the preceding blocks.  Within
+ * a block, a memory reference is encoded as the difference between
+ * its address and the address of the previous memory reference,
+ * followed by its NUMA domain and access type only if these differ
+ * from those of the previous memory reference.  Both are written as
+ * variable-length integers, and blocks may also be compressed with
+ * zlib.
+ *
+ * The file also records the name and the description of the kernel,
+ * as well as its memory regions.  Values are written in the byte order
+ * of the host.
+ */
+std::size_t const trace_file_block_size = std::size_t(1) << 16;
+
+/*
+ * Write the memory reference strings given by `ws', one for each
+ * thread, to a trace file.
+ */
+void write_trace_file(
+    std::ostream & o,
+    std::string const & kernel_name,
+    std::string const & kernel_description,
+    std::vector<MemoryRegion> const & regions,
+    int num_numa_domains,
+    std::vector<MemoryReferenceGenerator const *> const & ws,
+    bool compress);
+
+/*
+ * A trace file that is mapped into memory, and whose memory reference
+ * strings are decoded on demand.
+ */
+class TraceFile
+{
+public:
+    TraceFile(
+        std::string const & path);
+    ~TraceFile();
+
+    TraceFile(TraceFile const &) = delete;
+    TraceFile & operator=(TraceFile const &) = delete;
+
+    std::string const & path() const;
+    std::string const & kernel_name() const;
+    std::string const & kernel_description() const;
+    std::vector<MemoryRegion> const & memory_regions() const;
+    int num_numa_domains() const;
+    int num_threads() const;
+    bool compressed() const;
+
+    /*
+     * The memory reference string of a thread.  The generator refers
+     * to the trace file, which must outlive it.  A generator keeps
+     * the block that it decoded most recently, and must therefore not
+     * be shared between simulations that run concurrently.
+     */
+    std::unique_ptr<MemoryReferenceGenerator> generator(
+        int thread) const;
+
+private:
+    friend class TraceFileGenerator;
+
+    // The location of an encoded block in the file, and its size
+    // once it is decompressed.
+    struct Block
+    {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t decompressed_size;
+    };
+
+    std::string path_;
+    unsigned char const * data;
+    std::size_t data_size;
+    bool compressed_;
+    std::string kernel_name_;
+    std::string kernel_description_;
+    std::vector<MemoryRegion> regions;
+    int num_numa_domains_;
+    std::vector<uint64_t> sizes;
+    std::vector<std::vector<Block>> blocks;
+};
+
+}
+
+#endif
@@ -1,21 +1,35 @@
 #include "cache-trace.hpp"
 #include "trace-config.hpp"
+#include "cache-simulation/hierarchy.hpp"
+#include "cache-simulation/memory-region.hpp"
+#include "cache-simulation/timing.hpp"
+#include "cache-simulation/tlb.hpp"
+#include "cache-simulation/trace-file.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <exception>
 #include <map>
 #include <iostream>
+#include <utility>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
 CacheTrace::CacheTrace(
     TraceConfig const & trace_config,
     Kernel const & kernel,
-    bool warmup,
-    std::map<std::string, std::vector<std::vector<cache_miss_type>>> const & cache_misses)
+    CacheTraceOptions const & options,
+    CacheTraceResults const & results)
     : trace_config_(trace_config)
     , kernel_(kernel)
-    , warmup_(warmup)
-    , cache_misses_(cache_misses)
+    , options_(options)
+    , results_(results)
 {
 }
 
@@ -33,15 +47,135 @@ Kernel const & CacheTrace::kernel() const
     return kernel_;
 }
 
+CacheTraceOptions const & CacheTrace::options() const
+{
+    return options_;
+}
+
 bool CacheTrace::warmup() const
 {
-    return warmup_;
+    return options_.warmup;
+}
+
+CacheHierarchyMode CacheTrace::hierarchy_mode() const
+{
+    return options_.hierarchy_mode;
+}
+
+std::string cache_hierarchy_mode_name(
+    CacheHierarchyMode hierarchy_mode)
+{
+    switch (hierarchy_mode) {
+    case CacheHierarchyMode::independent: return "independent";
+    case CacheHierarchyMode::non_inclusive: return "non-inclusive";
+    case CacheHierarchyMode::inclusive: return "inclusive";
+    case CacheHierarchyMode::exclusive: return "exclusive";
+    }
+    return "unknown";
+}
+
+replacement::InterleavingPolicy CacheTrace::interleaving_policy() const
+{
+    return options_.interleaving_policy;
+}
+
+std::string interleaving_policy_name(
+    replacement::InterleavingPolicy interleaving_policy)
+{
+    switch (interleaving_policy) {
+    case replacement::InterleavingPolicy::round_robin: return "round-robin";
+    case replacement::InterleavingPolicy::bandwidth: return "bandwidth";
+    case replacement::InterleavingPolicy::random: return "random";
+    }
+    return "unknown";
 }
 
 std::map<std::string, std::vector<std::vector<cache_miss_type>>> const &
 CacheTrace::cache_misses() const
 {
-    return cache_misses_;
+    return results_.cache_misses;
+}
+
+std::map<std::string, std::vector<std::vector<cache_miss_type>>> const &
+CacheTrace::write_backs() const
+{
+    return results_.write_backs;
+}
+
+std::map<std::string, std::vector<std::vector<cache_miss_type>>> const &
+CacheTrace::prefetch_fills() const
+{
+    return results_.prefetch_fills;
+}
+
+std::map<std::string, std::vector<std::vector<cache_miss_type>>> const &
+CacheTrace::useful_prefetches() const
+{
+    return results_.useful_prefetches;
+}
+
+std::map<std::string, std::map<std::string, cache_miss_type>> const &
+CacheTrace::cache_misses_per_array() const
+{
+    return results_.cache_misses_per_array;
+}
+
+std::map<std::string, std::vector<std::vector<double>>> const &
+CacheTrace::cache_misses_mean() const
+{
+    return results_.cache_misses_mean;
+}
+
+std::map<std::string, std::vector<std::vector<double>>> const &
+CacheTrace::cache_misses_variance() const
+{
+    return results_.cache_misses_variance;
+}
+
+std::map<std::string, std::vector<std::vector<cache_miss_type>>> const &
+CacheTrace::opt_cache_misses() const
+{
+    return results_.opt_cache_misses;
+}
+
+std::map<std::string, std::vector<std::vector<cache_miss_type>>> const &
+CacheTrace::tlb_misses() const
+{
+    return results_.tlb_misses;
+}
+
+std::map<std::string, CoherenceEvents> const &
+CacheTrace::coherence() const
+{
+    return results_.coherence;
+}
+
+std::vector<double> const & CacheTrace::execution_time() const
+{
+    return results_.execution_time;
+}
+
+replacement::Sampling const & CacheTrace::sampling() const
+{
+    return options_.sampling;
+}
+
+std::map<std::string, replacement::SamplingEstimate> const &
+CacheTrace::sampling_estimates() const
+{
+    return results_.sampling_estimates;
+}
+
+std::map<std::string, replacement::ReuseDistanceHistogram> const &
+CacheTrace::reuse_distances() const
+{
+    return results_.reuse_distances;
+}
+
+std::map<std::string, replacement::Heatmap> const &
+CacheTrace::heatmaps() const
+{
+    return results_.heatmaps;
 }
 
 bool cache_has_ancestor(
@@ -89,13 +223,286 @@ std::vector<int> active_threads(
     return threads;
 }
 
-std::vector<std::vector<cache_miss_type>> trace_cache_misses_per_cache(
+/*
+ * Create a cache model with the size, associativity and replacement
+ * policy of the given cache.  Random replacement uses the given seed.
+ */
+std::unique_ptr<replacement::ReplacementAlgorithm> make_replacement_algorithm(
+    Cache const & cache,
+    uint64_t seed)
+{
+    replacement::cache_size_type num_cache_lines =
+        (cache.size + (cache.line_size-1)) / cache.line_size;
+
+    // Pseudo-LRU, NRU and RRIP replacement are only implemented for
+    // set-associative caches, and the trace configuration requires
+    // an associativity for them.
+    bool set_associative_policy =
+        cache.replacement_policy == "plru" ||
+        cache.replacement_policy == "nru" ||
+        cache.replacement_policy == "srrip" ||
+        cache.replacement_policy == "brrip" ||
+        cache.replacement_policy == "drrip";
+    replacement::cache_size_type ways =
+        cache.associativity > 0 ? cache.associativity : num_cache_lines;
+
+    if (!set_associative_policy &&
+        (cache.associativity == 0 ||
+         (replacement::cache_size_type) cache.associativity == num_cache_lines))
+    {
+        if (cache.replacement_policy == "fifo") {
+            return std::make_unique<replacement::FIFO>(
+                num_cache_lines, cache.line_size);
+        } else if (cache.replacement_policy == "rand") {
+            return std::make_unique<replacement::RAND>(
+                num_cache_lines, cache.line_size,
+                replacement::MemoryReferenceSet(), seed);
+        }
+        return std::make_unique<replacement::LRU>(
+            num_cache_lines, cache.line_size);
+    }
+
+    replacement::SetIndexFunction set_index_function =
+        (cache.set_index == "xor")
+        ? replacement::SetIndexFunction::xor_fold
+        : replacement::SetIndexFunction::modulo;
+    if (cache.replacement_policy == "fifo") {
+        return std::make_unique<replacement::SetAssociativeFIFO>(
+            num_cache_lines, cache.line_size,
+            ways, set_index_function);
+    } else if (cache.replacement_policy == "rand") {
+        return std::make_unique<replacement::SetAssociativeRAND>(
+            num_cache_lines, cache.line_size,
+            ways, set_index_function, seed);
+    } else if (cache.replacement_policy == "plru") {
+        return std::make_unique<replacement::SetAssociativePLRU>(
+            num_cache_lines, cache.line_size,
+            ways, set_index_function);
+    } else if (cache.replacement_policy == "nru") {
+        return std::make_unique<replacement::SetAssociativeNRU>(
+            num_cache_lines, cache.line_size,
+            ways, set_index_function);
+    } else if (cache.replacement_policy == "srrip") {
+        return std::make_unique<replacement::SetAssociativeRRIP>(
+            num_cache_lines, cache.line_size, ways,
+            replacement::RRIPInsertionPolicy::static_rrip,
+            set_index_function);
+    } else if (cache.replacement_policy == "brrip") {
+        return std::make_unique<replacement::SetAssociativeRRIP>(
+            num_cache_lines, cache.line_size, ways,
+            replacement::RRIPInsertionPolicy::bimodal_rrip,
+            set_index_function);
+    } else if (cache.replacement_policy == "drrip") {
+        return std::make_unique<replacement::SetAssociativeRRIP>(
+            num_cache_lines, cache.line_size, ways,
+            replacement::RRIPInsertionPolicy::dynamic_rrip,
+            set_index_function);
+    }
+    return std::make_unique<replacement::SetAssociativeLRU>(
+        num_cache_lines, cache.line_size,
+        ways, set_index_function);
+}
+
+/*
+ * Create a model of the hardware prefetcher of the given cache, or
+ * return null if the cache has no prefetcher.
+ */
+std::unique_ptr<replacement::Prefetcher> make_prefetcher(
+    Cache const & cache)
+{
+    if (cache.prefetcher == "next-line") {
+        return std::make_unique<replacement::NextLinePrefetcher>(
+            cache.line_size, cache.prefetch_degree);
+    } else if (cache.prefetcher == "adjacent-line") {
+        return std::make_unique<replacement::AdjacentLinePrefetcher>(
+            cache.line_size);
+    } else if (cache.prefetcher == "stride") {
+        return std::make_unique<replacement::StridePrefetcher>(
+            cache.line_size, cache.prefetch_degree, cache.prefetch_distance);
+    }
+    return nullptr;
+}
+
+/*
+ * A short description of a cache model for progress messages,
+ * such as "8-way set-associative lru".
+ */
+std::string replacement_algorithm_description(
+    Cache const & cache)
+{
+    std::stringstream s;
+    if (cache.associativity == 0)
+        s << "fully associative ";
+    else
+        s << cache.associativity << "-way set-associative ";
+    s << cache.replacement_policy;
+    return s.str();
+}
+
+/*
+ * The memory reference strings of a kernel's threads, which are
+ * generated once and shared by every simulation that needs them, as
+ * long as they fit within a memory budget.  The memory reference
+ * strings of the remaining threads are generated again, one chunk at
+ * a time, by each simulation.
+ *
+ * If `relocate' is set, the arrays of the kernel are moved to fixed
+ * addresses, so that the memory references are the same every time
+ * the kernel is run, as is needed to resume from a checkpoint.
+ */
+class ReferenceStrings
+{
+public:
+    ReferenceStrings(
+        TraceConfig const & trace_config,
+        Kernel const & kernel,
+        std::vector<int> const & num_uses,
+        std::size_t memory_budget,
+        bool relocate,
+        int sim_threads,
+        bool verbose);
+
+    std::unique_ptr<replacement::MemoryReferenceGenerator> generator(
+        int thread) const;
+
+    /*
+     * The arrays of the kernel, at the addresses of the memory
+     * references.
+     */
+    std::vector<replacement::MemoryRegion> memory_regions() const;
+
+    /*
+     * The locator of the kernel's matrix for the memory references.
+     */
+    replacement::MatrixLocator matrix_locator(
+        replacement::MatrixLocator const & locator) const;
+
+private:
+    TraceConfig const & trace_config;
+    Kernel const & kernel;
+    bool relocate;
+    replacement::MemoryRelocation relocation;
+    std::vector<bool> stored;
+    std::vector<replacement::MemoryReferenceString> strings;
+};
+
+ReferenceStrings::ReferenceStrings(
+    TraceConfig const & trace_config,
+    Kernel const & kernel,
+    std::vector<int> const & num_uses,
+    std::size_t memory_budget,
+    bool relocate,
+    int sim_threads,
+    bool verbose)
+    : trace_config(trace_config)
+    , kernel(kernel)
+    , relocate(relocate)
+    , relocation()
+    , stored(num_uses.size(), false)
+    , strings(num_uses.size())
+{
+    int num_threads = num_uses.size();
+    if (relocate) {
+        relocation = replacement::MemoryRelocation(kernel.memory_regions());
+        if (relocation.empty()) {
+            throw kernel_error(
+                "Expected a kernel whose arrays are known, "
+                "since its memory references cannot be checkpointed otherwise");
+        }
+    }
+
+    // Only store the memory reference strings that are used more
+    // than once, and only as many as fit within the memory budget.
+    std::vector<std::unique_ptr<replacement::MemoryReferenceGenerator>>
+        generators(num_threads);
+    std::size_t memory = 0;
+    for (int thread = 0; thread < num_threads; thread++) {
+        if (num_uses[thread] < 2)
+            continue;
+        generators[thread] = kernel.memory_reference_generator(
+            trace_config, thread, num_threads);
+        std::size_t size = generators[thread]->size() *
+            sizeof(replacement::MemoryReferenceString::value_type);
+        if (memory + size <= memory_budget) {
+            stored[thread] = true;
+            memory += size;
+        }
+    }
+
+    #pragma omp parallel for schedule(dynamic) num_threads(sim_threads)
+    for (int thread = 0; thread < num_threads; thread++) {
+        if (!stored[thread])
+            continue;
+        #pragma omp critical
+        if (verbose) {
+            std::cerr << "Tracing memory accesses of kernel " << kernel.name()
+                      << " (thread " << thread << ")" << std::endl;
+        }
+        strings[thread].resize(generators[thread]->size());
+        generators[thread]->generate(
+            0, strings[thread].size(), strings[thread].data());
+        if (relocate)
+            relocation.relocate(strings[thread].size(), strings[thread].data());
+    }
+}
+
+std::unique_ptr<replacement::MemoryReferenceGenerator>
+ReferenceStrings::generator(int thread) const
+{
+    if (stored[thread]) {
+        return std::make_unique<replacement::MemoryReferenceStringGenerator>(
+            strings[thread]);
+    }
+    std::unique_ptr<replacement::MemoryReferenceGenerator> generator =
+        kernel.memory_reference_generator(
+            trace_config, thread, trace_config.thread_affinities().size());
+    if (relocate) {
+        return std::make_unique<replacement::RelocatedMemoryReferenceGenerator>(
+            std::move(generator), relocation);
+    }
+    return generator;
+}
+
+std::vector<replacement::MemoryRegion> ReferenceStrings::memory_regions() const
+{
+    return relocate ? relocation.regions() : kernel.memory_regions();
+}
+
+replacement::MatrixLocator ReferenceStrings::matrix_locator(
+    replacement::MatrixLocator const & locator) const
+{
+    return relocate ? locator.relocate(relocation) : locator;
+}
+
+/*
+ * Simulate a cache with the memory references of every thread that
+ * shares it, and return its cache misses, write-backs and prefetches.
+ * If `opt' is set, the cache is instead simulated as a fully
+ * associative cache of the same size with optimal replacement and
+ * without a prefetcher, since optimal replacement relies on knowing
+ * every future memory reference in advance, and the simulation is
+ * neither sampled nor attributed to the arrays of the kernel.
+ * Otherwise, the cache misses are attributed to the arrays of the
+ * kernel if `per_array' is set.  If `heatmaps' is given, the cache
+ * misses are also counted in a copy of `heatmap' for the cache, at
+ * the locations in the matrix that are found by `locator'.
+ *
+ * With a warm-up run, the warm-up run and the actual run are
+ * checkpointed as the first and second pass, and the warm-up run is
+ * skipped when resuming from a checkpoint of the actual run.
+ */
+replacement::CacheTraffic trace_cache_misses_per_cache(
     TraceConfig const & trace_config,
     Kernel const & kernel,
+    ReferenceStrings const & reference_strings,
     Cache const & cache,
-    bool warmup,
-    bool verbose,
-    int progress_interval)
+    CacheTraceOptions const & options,
+    bool opt,
+    replacement::MatrixLocator const & locator,
+    replacement::Heatmap const & heatmap,
+    std::map<std::string, replacement::Heatmap> * heatmaps,
+    replacement::Interleaving const & interleaving,
+    replacement::Checkpoint const & checkpoint)
 {
     auto const & thread_affinities = trace_config.thread_affinities();
     int num_threads = thread_affinities.size();
@@ -106,84 +513,1028 @@ std::vector<std::vector<cache_miss_type>> trace_cache_misses_per_cache(
         trace_config, cache);
     int num_active_threads = threads.size();
     if (num_active_threads <= 0) {
-        return std::vector<std::vector<cache_miss_type>>();
+        return replacement::CacheTraffic();
     }
 
-    // Obtain the memory reference strings for each thread
-    std::vector<replacement::MemoryReferenceString>
+    // Obtain the memory reference strings for each thread, which
+    // are generated in chunks during the simulation
+    std::vector<std::unique_ptr<replacement::MemoryReferenceGenerator>>
+        generators(num_active_threads);
+    std::vector<replacement::MemoryReferenceGenerator const *>
         memory_reference_strings(num_active_threads);
     for (int n = 0; n < num_active_threads; n++) {
-        if (verbose) {
+        if (options.verbose) {
             std::cerr << "Tracing memory accesses of kernel " << kernel.name()
                       << " for cache " << cache.name
                       << " (thread " << threads[n] << ")" << std::endl;
         }
 
-        memory_reference_strings[n] =
-            kernel.memory_reference_string(
-                trace_config, threads[n], num_threads);
+        generators[n] = reference_strings.generator(threads[n]);
+        memory_reference_strings[n] = generators[n].get();
     }
 
-    int num_cache_lines = (cache.size + (cache.line_size-1)) / cache.line_size;
-    replacement::LRU replacement_algorithm(num_cache_lines, cache.line_size);
-    if (warmup) {
-        if (verbose) {
-            std::cerr << "Simulating LRU cache replacement "
+    std::unique_ptr<replacement::ReplacementAlgorithm> replacement_algorithm;
+    std::unique_ptr<replacement::Prefetcher> prefetcher;
+    std::string description;
+    if (opt) {
+        if (options.verbose) {
+            std::cerr << "Computing next uses of memory references "
+                      << "for cache " << cache.name << std::endl;
+        }
+
+        replacement::cache_size_type num_cache_lines =
+            (cache.size + (cache.line_size-1)) / cache.line_size;
+        replacement_algorithm = std::make_unique<replacement::OPT>(
+            num_cache_lines, cache.line_size,
+            memory_reference_strings, options.warmup ? 2 : 1, interleaving);
+        description = "fully associative opt";
+    } else {
+        replacement_algorithm = make_replacement_algorithm(cache, options.seed);
+        prefetcher = make_prefetcher(cache);
+        description = replacement_algorithm_description(cache);
+    }
+
+    replacement::Sampling sampling = opt
+        ? replacement::Sampling() : options.sampling;
+    replacement::Checkpoint warmup_checkpoint = checkpoint.for_pass(0);
+    replacement::Checkpoint run_checkpoint = checkpoint.for_pass(1);
+    if (options.warmup && run_checkpoint.saved_pass() < 1) {
+        if (options.verbose) {
+            std::cerr << "Simulating " << description
+                      << " cache replacement "
                       << "for cache " << cache.name << " (warmup run)" << std::endl;
         }
 
-        replacement::trace_cache_misses(
-            replacement_algorithm,
+        replacement::CacheTrafficOptions warmup_options;
+        warmup_options.verbose = options.verbose;
+        warmup_options.progress_interval = options.progress_interval;
+        warmup_options.prefetcher = prefetcher.get();
+        warmup_options.interleaving = interleaving;
+        warmup_options.sampling = sampling;
+        warmup_options.checkpoint = &warmup_checkpoint;
+        replacement::trace_cache_traffic(
+            *replacement_algorithm,
             memory_reference_strings,
             num_numa_domains,
-            verbose,
-            progress_interval);
+            warmup_options);
     }
 
-    if (verbose) {
-        std::cerr << "Simulating LRU cache replacement "
+    if (options.verbose) {
+        std::cerr << "Simulating " << description
+                  << " cache replacement "
                   << "for cache " << cache.name << std::endl;
     }
 
-    std::vector<std::vector<cache_miss_type>> active_threads_cache_misses =
-        replacement::trace_cache_misses(
-            replacement_algorithm,
+    replacement::MemoryRegions regions(reference_strings.memory_regions());
+    replacement::Heatmap cache_heatmap(heatmap);
+    replacement::CacheTrafficOptions run_options;
+    run_options.verbose = options.verbose;
+    run_options.progress_interval = options.progress_interval;
+    run_options.prefetcher = prefetcher.get();
+    run_options.interleaving = interleaving;
+    run_options.sampling = sampling;
+    run_options.checkpoint = &run_checkpoint;
+    run_options.regions = (options.per_array && !opt) ? &regions : nullptr;
+    run_options.locator = heatmaps ? &locator : nullptr;
+    run_options.heatmap = heatmaps ? &cache_heatmap : nullptr;
+    replacement::CacheTraffic active_threads_traffic =
+        replacement::trace_cache_traffic(
+            *replacement_algorithm,
             memory_reference_strings,
             num_numa_domains,
-            verbose,
-            progress_interval);
+            run_options);
+    if (heatmaps)
+        heatmaps->emplace(cache.name, cache_heatmap);
 
-    std::vector<std::vector<cache_miss_type>> cache_misses(
+    replacement::CacheTraffic traffic;
+    traffic.cache_misses.assign(
         num_threads, std::vector<cache_miss_type>(num_numa_domains, 0));
-    for (int i = 0; i < num_active_threads; i++)
-        cache_misses[threads[i]] = active_threads_cache_misses[i];
-    return cache_misses;
+    traffic.write_backs = traffic.cache_misses;
+    traffic.prefetch_fills = traffic.cache_misses;
+    traffic.useful_prefetches = traffic.cache_misses;
+    for (int i = 0; i < num_active_threads; i++) {
+        traffic.cache_misses[threads[i]] = active_threads_traffic.cache_misses[i];
+        traffic.write_backs[threads[i]] = active_threads_traffic.write_backs[i];
+        traffic.prefetch_fills[threads[i]] = active_threads_traffic.prefetch_fills[i];
+        traffic.useful_prefetches[threads[i]] =
+            active_threads_traffic.useful_prefetches[i];
+    }
+    traffic.cache_misses_per_region =
+        active_threads_traffic.cache_misses_per_region;
+    traffic.sampling = active_threads_traffic.sampling;
+    return traffic;
 }
 
-CacheTrace trace_cache_misses(
+/*
+ * Compute a histogram of the reuse distances of the interleaved
+ * memory references made by the threads that share the given cache,
+ * with exact cache misses for caches of `exact_cache_lines' lines.
+ */
+replacement::ReuseDistanceHistogram trace_reuse_distances_per_cache(
     TraceConfig const & trace_config,
     Kernel const & kernel,
+    ReferenceStrings const & reference_strings,
+    Cache const & cache,
+    std::vector<replacement::cache_size_type> const & exact_cache_lines,
     bool warmup,
+    replacement::Interleaving const & interleaving,
     bool verbose,
     int progress_interval)
 {
-    std::map<std::string, std::vector<std::vector<cache_miss_type>>> cache_misses;
+    auto const & thread_affinities = trace_config.thread_affinities();
+    int num_threads = thread_affinities.size();
+    replacement::numa_domain_type num_numa_domains = trace_config.num_numa_domains();
+
+    std::vector<int> threads = active_threads(
+        trace_config, cache);
+    if (threads.empty())
+        return replacement::ReuseDistanceHistogram();
+
+    // Threads that do not share the cache are given empty memory
+    // reference strings, which do not affect the interleaving.
+    replacement::MemoryReferenceString empty_memory_reference_string;
+    replacement::MemoryReferenceStringGenerator empty_generator(
+        empty_memory_reference_string);
+    std::vector<std::unique_ptr<replacement::MemoryReferenceGenerator>>
+        generators(num_threads);
+    std::vector<replacement::MemoryReferenceGenerator const *>
+        memory_reference_strings(num_threads, &empty_generator);
+    for (int thread : threads) {
+        if (verbose) {
+            std::cerr << "Tracing memory accesses of kernel " << kernel.name()
+                      << " for cache " << cache.name
+                      << " (thread " << thread << ")" << std::endl;
+        }
+
+        generators[thread] = reference_strings.generator(thread);
+        memory_reference_strings[thread] = generators[thread].get();
+    }
+
+    if (verbose) {
+        std::cerr << "Computing reuse distances "
+                  << "for cache " << cache.name
+                  << (warmup ? " (with warmup run)" : "") << std::endl;
+    }
+
+    return replacement::trace_reuse_distances(
+        cache.line_size,
+        memory_reference_strings,
+        num_numa_domains,
+        warmup,
+        verbose,
+        progress_interval,
+        interleaving,
+        exact_cache_lines);
+}
+
+/*
+ * Simulate all the caches below a last-level cache together, so that
+ * only the cache misses of a cache are forwarded to its parent.  If
+ * `execution_time' is given, it is set to the time taken by each
+ * thread according to the timing model.  If `per_array' is set, the
+ * cache misses of each cache are also attributed to the arrays of the
+ * kernel.  If `heatmaps' is given, the cache misses of each cache are
+ * also counted in a copy of `heatmap', as above.
+ */
+std::map<std::string, replacement::CacheTraffic>
+trace_cache_misses_per_hierarchy(
+    TraceConfig const & trace_config,
+    Kernel const & kernel,
+    ReferenceStrings const & reference_strings,
+    Cache const & last_level_cache,
+    CacheTraceOptions const & options,
+    replacement::MatrixLocator const & locator,
+    replacement::Heatmap const & heatmap,
+    std::map<std::string, replacement::Heatmap> * heatmaps,
+    replacement::Interleaving const & interleaving,
+    replacement::Checkpoint const & checkpoint,
+    std::vector<double> * execution_time)
+{
+    auto const & caches = trace_config.caches();
+    auto const & thread_affinities = trace_config.thread_affinities();
+    int num_threads = thread_affinities.size();
+    replacement::numa_domain_type num_numa_domains = trace_config.num_numa_domains();
+
+    // Find the caches below the last-level cache, with every cache
+    // placed after its parent.
+    std::vector<Cache const *> hierarchy_caches{&last_level_cache};
+    std::map<std::string, int> cache_index{{last_level_cache.name, 0}};
+    for (std::size_t i = 0; i < hierarchy_caches.size(); i++) {
+        for (auto it = caches.cbegin(); it != caches.cend(); ++it) {
+            Cache const & cache = (*it).second;
+            if (cache.parent == hierarchy_caches[i]->name &&
+                cache_index.find(cache.name) == cache_index.end())
+            {
+                cache_index.emplace(cache.name, hierarchy_caches.size());
+                hierarchy_caches.push_back(&cache);
+            }
+        }
+    }
+    int num_hierarchy_caches = hierarchy_caches.size();
+
+    // Only the last-level cache uses the given inclusion policy,
+    // whereas the caches above it are non-inclusive.
+    replacement::InclusionPolicy last_level_inclusion_policy =
+        replacement::InclusionPolicy::non_inclusive;
+    if (options.hierarchy_mode == CacheHierarchyMode::inclusive)
+        last_level_inclusion_policy = replacement::InclusionPolicy::inclusive;
+    else if (options.hierarchy_mode == CacheHierarchyMode::exclusive)
+        last_level_inclusion_policy = replacement::InclusionPolicy::exclusive;
+
+    std::vector<std::unique_ptr<replacement::ReplacementAlgorithm>>
+        replacement_algorithms(num_hierarchy_caches);
+    std::vector<std::unique_ptr<replacement::Prefetcher>>
+        prefetchers(num_hierarchy_caches);
+    replacement::MemoryRegions regions(reference_strings.memory_regions());
+    replacement::CacheHierarchy hierarchy;
+    if (options.coherence)
+        hierarchy.enable_coherence(regions);
+    if (options.per_array)
+        hierarchy.attribute_cache_misses(regions);
+    if (heatmaps)
+        hierarchy.enable_heatmaps(locator, heatmap);
+    for (int i = 0; i < num_hierarchy_caches; i++) {
+        Cache const & cache = *hierarchy_caches[i];
+        replacement_algorithms[i] = make_replacement_algorithm(cache, options.seed);
+        prefetchers[i] = make_prefetcher(cache);
+        hierarchy.add_cache(
+            *replacement_algorithms[i],
+            i > 0 ? cache_index.at(cache.parent) : -1,
+            i > 0 ? replacement::InclusionPolicy::non_inclusive
+            : last_level_inclusion_policy,
+            prefetchers[i].get());
+    }
+
+    std::vector<double> cache_latency(num_hierarchy_caches);
+    std::vector<double> cache_bandwidth(num_hierarchy_caches);
+    for (int i = 0; i < num_hierarchy_caches; i++) {
+        cache_latency[i] = hierarchy_caches[i]->latency;
+        cache_bandwidth[i] = hierarchy_caches[i]->bandwidth;
+    }
+    replacement::TimingModel timing(
+        cache_latency, cache_bandwidth,
+        trace_config.latency_per_numa_domain(),
+        trace_config.bandwidth_per_numa_domain(),
+        last_level_cache.line_size,
+        trace_config.max_outstanding_misses());
+    if (execution_time)
+        execution_time->assign(num_threads, 0.0);
+    replacement::SamplingStatistics statistics;
+
+    std::vector<std::vector<std::vector<cache_miss_type>>> hierarchy_cache_misses;
+    std::vector<std::vector<std::vector<cache_miss_type>>> hierarchy_write_backs;
+    std::vector<std::vector<std::vector<cache_miss_type>>> hierarchy_prefetch_fills;
+    std::vector<std::vector<std::vector<cache_miss_type>>> hierarchy_useful_prefetches;
+    std::vector<int> threads = active_threads(
+        trace_config, last_level_cache);
+    int num_active_threads = threads.size();
+    if (num_active_threads > 0) {
+        std::vector<std::unique_ptr<replacement::MemoryReferenceGenerator>>
+            generators(num_active_threads);
+        std::vector<replacement::MemoryReferenceGenerator const *>
+            memory_reference_strings(num_active_threads);
+        std::vector<int> first_level_caches(num_active_threads);
+        for (int n = 0; n < num_active_threads; n++) {
+            if (options.verbose) {
+                std::cerr << "Tracing memory accesses of kernel " << kernel.name()
+                          << " for cache hierarchy " << last_level_cache.name
+                          << " (thread " << threads[n] << ")" << std::endl;
+            }
+
+            generators[n] = reference_strings.generator(threads[n]);
+            memory_reference_strings[n] = generators[n].get();
+            first_level_caches[n] =
+                cache_index.at(thread_affinities[threads[n]].cache);
+        }
+
+        replacement::Checkpoint warmup_checkpoint = checkpoint.for_pass(0);
+        replacement::Checkpoint run_checkpoint = checkpoint.for_pass(1);
+        if (options.warmup && run_checkpoint.saved_pass() < 1) {
+            if (options.verbose) {
+                std::cerr << "Simulating " << cache_hierarchy_mode_name(options.hierarchy_mode)
+                          << " cache hierarchy " << last_level_cache.name
+                          << " (warmup run)" << std::endl;
+            }
+
+            replacement::CacheHierarchyTraceOptions warmup_options;
+            warmup_options.verbose = options.verbose;
+            warmup_options.progress_interval = options.progress_interval;
+            warmup_options.interleaving = interleaving;
+            warmup_options.sampling = options.sampling;
+            warmup_options.checkpoint = &warmup_checkpoint;
+            replacement::trace_cache_misses(
+                hierarchy,
+                first_level_caches,
+                memory_reference_strings,
+                num_numa_domains,
+                warmup_options);
+        }
+
+        if (options.verbose) {
+            std::cerr << "Simulating " << cache_hierarchy_mode_name(options.hierarchy_mode)
+                      << " cache hierarchy " << last_level_cache.name << std::endl;
+        }
+
+        replacement::CacheHierarchyTraceOptions run_options;
+        run_options.verbose = options.verbose;
+        run_options.progress_interval = options.progress_interval;
+        run_options.interleaving = interleaving;
+        run_options.timing = execution_time ? &timing : nullptr;
+        run_options.sampling = options.sampling;
+        run_options.statistics = &statistics;
+        run_options.checkpoint = &run_checkpoint;
+        hierarchy_cache_misses = replacement::trace_cache_misses(
+            hierarchy,
+            first_level_caches,
+            memory_reference_strings,
+            num_numa_domains,
+            run_options);
+        hierarchy_write_backs = hierarchy.write_backs();
+        hierarchy_prefetch_fills = hierarchy.prefetch_fills();
+        hierarchy_useful_prefetches = hierarchy.useful_prefetches();
+
+        // The write-backs and prefetches of the last-level cache
+        // also take up memory bandwidth.
+        if (execution_time) {
+            for (int n = 0; n < num_active_threads; n++) {
+                for (replacement::numa_domain_type i = 0; i < num_numa_domains; i++) {
+                    timing.transfer(
+                        n, i,
+                        hierarchy_write_backs[0][n][i] +
+                        hierarchy_prefetch_fills[0][n][i]);
+                }
+            }
+            std::vector<double> time = timing.time();
+            for (int n = 0; n < num_active_threads; n++)
+                (*execution_time)[threads[n]] = time[n];
+        }
+    }
+
+    std::map<std::string, replacement::CacheTraffic> traffic;
+    for (int i = 0; i < num_hierarchy_caches; i++) {
+        Cache const & cache = *hierarchy_caches[i];
+        replacement::CacheTraffic traffic_per_thread;
+        if (!active_threads(trace_config, cache).empty()) {
+            traffic_per_thread.cache_misses.assign(
+                num_threads, std::vector<cache_miss_type>(num_numa_domains, 0));
+            traffic_per_thread.write_backs = traffic_per_thread.cache_misses;
+            traffic_per_thread.prefetch_fills = traffic_per_thread.cache_misses;
+            traffic_per_thread.useful_prefetches = traffic_per_thread.cache_misses;
+            for (int n = 0; n < num_active_threads; n++) {
+                traffic_per_thread.cache_misses[threads[n]] =
+                    hierarchy_cache_misses[i][n];
+                traffic_per_thread.write_backs[threads[n]] =
+                    hierarchy_write_backs[i][n];
+                traffic_per_thread.prefetch_fills[threads[n]] =
+                    hierarchy_prefetch_fills[i][n];
+                traffic_per_thread.useful_prefetches[threads[n]] =
+                    hierarchy_useful_prefetches[i][n];
+            }
+            if (options.per_array) {
+                traffic_per_thread.cache_misses_per_region =
+                    hierarchy.cache_misses_per_region()[i];
+            }
+            if (options.coherence) {
+                traffic_per_thread.invalidations = hierarchy.invalidations()[i];
+                traffic_per_thread.coherence_misses = hierarchy.coherence_misses()[i];
+                traffic_per_thread.false_sharing = hierarchy.false_sharing()[i];
+            }
+            if (options.sampling.enabled())
+                traffic_per_thread.sampling = statistics.estimate(i);
+            if (heatmaps)
+                heatmaps->emplace(cache.name, hierarchy.heatmaps()[i]);
+        }
+        traffic.emplace(cache.name, traffic_per_thread);
+    }
+    return traffic;
+}
+
+/*
+ * Find the last-level TLB of the TLB hierarchy that a TLB belongs to.
+ */
+TLB const & last_level_tlb(
+    TraceConfig const & trace_config,
+    TLB const & tlb)
+{
+    if (tlb.parent.empty())
+        return tlb;
+    return last_level_tlb(trace_config, trace_config.tlbs().at(tlb.parent));
+}
+
+/*
+ * Simulate all the TLBs below a last-level TLB together, with the
+ * memory references of every thread attached to one of them.
+ */
+std::map<std::string, std::vector<std::vector<cache_miss_type>>>
+trace_tlb_misses_per_hierarchy(
+    TraceConfig const & trace_config,
+    Kernel const & kernel,
+    ReferenceStrings const & reference_strings,
+    TLB const & last_level,
+    bool warmup,
+    replacement::Interleaving const & interleaving,
+    bool verbose)
+{
+    auto const & tlbs = trace_config.tlbs();
+    auto const & thread_affinities = trace_config.thread_affinities();
+    int num_threads = thread_affinities.size();
+    replacement::numa_domain_type num_numa_domains = trace_config.num_numa_domains();
+
+    // Find the TLBs below the last-level TLB, with every TLB placed
+    // after its parent.
+    std::vector<TLB const *> hierarchy_tlbs{&last_level};
+    std::map<std::string, int> tlb_index{{last_level.name, 0}};
+    for (std::size_t i = 0; i < hierarchy_tlbs.size(); i++) {
+        for (auto it = tlbs.cbegin(); it != tlbs.cend(); ++it) {
+            TLB const & tlb = (*it).second;
+            if (tlb.parent == hierarchy_tlbs[i]->name &&
+                tlb_index.find(tlb.name) == tlb_index.end())
+            {
+                tlb_index.emplace(tlb.name, hierarchy_tlbs.size());
+                hierarchy_tlbs.push_back(&tlb);
+            }
+        }
+    }
+    int num_hierarchy_tlbs = hierarchy_tlbs.size();
+
+    std::vector<std::unique_ptr<replacement::TLB>> tlb_models(num_hierarchy_tlbs);
+    replacement::CacheHierarchy hierarchy;
+    for (int i = 0; i < num_hierarchy_tlbs; i++) {
+        TLB const & tlb = *hierarchy_tlbs[i];
+        tlb_models[i] = std::make_unique<replacement::TLB>(
+            tlb.entries, tlb.page_size, tlb.associativity);
+        hierarchy.add_cache(
+            *tlb_models[i], i > 0 ? tlb_index.at(tlb.parent) : -1);
+    }
+
+    std::vector<int> threads;
+    for (int thread = 0; thread < num_threads; thread++) {
+        auto it = tlb_index.find(thread_affinities[thread].tlb);
+        if (it != tlb_index.end())
+            threads.push_back(thread);
+    }
+    int num_active_threads = threads.size();
+
+    std::vector<std::unique_ptr<replacement::MemoryReferenceGenerator>>
+        generators(num_active_threads);
+    std::vector<replacement::MemoryReferenceGenerator const *>
+        memory_reference_strings(num_active_threads);
+    std::vector<int> first_level_tlbs(num_active_threads);
+    for (int n = 0; n < num_active_threads; n++) {
+        generators[n] = reference_strings.generator(threads[n]);
+        memory_reference_strings[n] = generators[n].get();
+        first_level_tlbs[n] = tlb_index.at(thread_affinities[threads[n]].tlb);
+    }
+
+    if (verbose) {
+        std::cerr << "Simulating TLB hierarchy " << last_level.name
+                  << (warmup ? " (with warmup run)" : "") << std::endl;
+    }
 
+    if (warmup) {
+        replacement::trace_tlb_misses(
+            hierarchy, first_level_tlbs,
+            memory_reference_strings, num_numa_domains, interleaving);
+    }
+    std::vector<std::vector<std::vector<cache_miss_type>>> hierarchy_tlb_misses =
+        replacement::trace_tlb_misses(
+            hierarchy, first_level_tlbs,
+            memory_reference_strings, num_numa_domains, interleaving);
+
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> tlb_misses;
+    for (int i = 0; i < num_hierarchy_tlbs; i++) {
+        std::vector<std::vector<cache_miss_type>> tlb_misses_per_thread(
+            num_threads, std::vector<cache_miss_type>(num_numa_domains, 0));
+        for (int n = 0; n < num_active_threads; n++)
+            tlb_misses_per_thread[threads[n]] = hierarchy_tlb_misses[i][n];
+        tlb_misses.emplace(hierarchy_tlbs[i]->name, tlb_misses_per_thread);
+    }
+    return tlb_misses;
+}
+
+/*
+ * The name of a cache simulation, which is used for its checkpoints.
+ */
+std::string simulation_name(
+    std::string const & kind,
+    Cache const & cache,
+    int sample)
+{
+    std::string name = kind + "-" + cache.name;
+    if (sample > 0)
+        name += "-" + std::to_string(sample);
+    return name;
+}
+
+CacheTrace trace_cache_misses(
+    TraceConfig const & trace_config,
+    Kernel const & kernel,
+    CacheTraceOptions options)
+{
     auto const & caches = trace_config.caches();
+    std::vector<Cache const *> cache_list;
+    for (auto it = caches.cbegin(); it != caches.cend(); ++it)
+        cache_list.push_back(&(*it).second);
+    int num_caches = cache_list.size();
+
+    // Each cache is simulated on its own, or else together with the
+    // other caches below the same last-level cache.
+    std::vector<Cache const *> cache_simulations;
+    for (int i = 0; i < num_caches; i++) {
+        Cache const & cache = *cache_list[i];
+        if (options.hierarchy_mode == CacheHierarchyMode::independent ||
+            cache.parent.empty() ||
+            caches.find(cache.parent) == caches.end())
+        {
+            cache_simulations.push_back(&cache);
+        }
+    }
+    int num_cache_simulations = cache_simulations.size();
+
+    // Caches that are shared by the same threads and have the same
+    // cache line size see the same reuse distances, regardless of
+    // their size, so the reuse distances are only computed once for
+    // each such group of caches.  The cache misses are counted
+    // exactly for the size of every cache in the group.
+    std::vector<Cache const *> reuse_distance_caches;
+    std::vector<std::vector<replacement::cache_size_type>> reuse_distance_cache_lines;
+    std::vector<int> reuse_distance_group(num_caches, -1);
+    if (options.reuse_distance) {
+        std::map<std::pair<cache_size_type, std::vector<int>>, int> groups;
+        for (int i = 0; i < num_caches; i++) {
+            Cache const & cache = *cache_list[i];
+            auto key = std::make_pair(
+                cache.line_size, active_threads(trace_config, cache));
+            auto group = groups.emplace(key, reuse_distance_caches.size());
+            if (group.second) {
+                reuse_distance_caches.push_back(&cache);
+                reuse_distance_cache_lines.emplace_back();
+            }
+            reuse_distance_group[i] = (*group.first).second;
+            reuse_distance_cache_lines[reuse_distance_group[i]].push_back(
+                (cache.size + (cache.line_size-1)) / cache.line_size);
+        }
+    }
+
+    // Optimal replacement is simulated separately for every cache.
+    int num_opt_simulations = options.opt ? num_caches : 0;
+
+    // Each hierarchy of TLBs with threads attached to it is simulated
+    // on its own.
+    auto const & tlbs = trace_config.tlbs();
+    std::vector<TLB const *> tlb_simulations;
+    for (auto it = tlbs.cbegin(); it != tlbs.cend(); ++it) {
+        TLB const & tlb = (*it).second;
+        if (!tlb.parent.empty())
+            continue;
+        for (auto const & thread_affinity : trace_config.thread_affinities()) {
+            if (!thread_affinity.tlb.empty() &&
+                last_level_tlb(trace_config, tlbs.at(thread_affinity.tlb)).name == tlb.name)
+            {
+                tlb_simulations.push_back(&tlb);
+                break;
+            }
+        }
+    }
+    int num_tlb_simulations = tlb_simulations.size();
+    int num_reuse_distance_simulations = reuse_distance_caches.size();
+
+    // Bandwidth interleaving needs the bandwidth of every NUMA domain.
+    if (options.interleaving_policy == replacement::InterleavingPolicy::bandwidth) {
+        auto const & bandwidths = trace_config.bandwidth_per_numa_domain();
+        if ((int) bandwidths.size() < trace_config.num_numa_domains()) {
+            throw trace_config_error(
+                "Expected \"bandwidth_per_numa_domain\" to give the bandwidth "
+                "of every NUMA domain for bandwidth interleaving");
+        }
+        for (double bandwidth : bandwidths) {
+            if (bandwidth <= 0.0) {
+                throw trace_config_error(
+                    "Expected \"bandwidth_per_numa_domain\" to be positive "
+                    "for bandwidth interleaving");
+            }
+        }
+    }
+
+    // The timing model needs the latency of every cache and NUMA
+    // domain.
+    if (options.timing) {
+        if ((int) trace_config.latency_per_numa_domain().size() <
+            trace_config.num_numa_domains())
+        {
+            throw trace_config_error(
+                "Expected \"latency_per_numa_domain\" to give the latency "
+                "of every NUMA domain for the timing model");
+        }
+        for (Cache const * cache : cache_list) {
+            if (cache->latency <= 0.0) {
+                throw trace_config_error(
+                    cache->name + ": Expected \"latency\" "
+                    "to be positive for the timing model");
+            }
+        }
+    }
+
+    // Heatmaps need to know which rows and columns of the matrix the
+    // memory references of the kernel belong to.
+    bool heatmap = options.heatmap_row_bins > 0 && options.heatmap_column_bins > 0;
+    replacement::MatrixLocator locator;
+    replacement::Heatmap empty_heatmap;
+    if (heatmap) {
+        locator = kernel.matrix_locator();
+        if (locator.empty())
+            throw kernel_error("Expected a kernel with a matrix for heatmaps");
+        empty_heatmap = replacement::Heatmap(
+            locator.rows(), locator.columns(),
+            options.heatmap_row_bins, options.heatmap_column_bins);
+    }
+
+    // With random interleaving, the cache simulations are repeated
+    // for an ensemble of interleavings, each with its own seed.  The
+    // first sample is reported as the cache misses, and the others
+    // are only used for their mean and variance.  Optimal
+    // replacement, reuse distances and TLBs use the first sample.
+    if (options.interleaving_samples < 1)
+        options.interleaving_samples = 1;
+    std::vector<replacement::Interleaving> interleavings;
+    for (int sample = 0; sample < options.interleaving_samples; sample++) {
+        interleavings.emplace_back(
+            options.interleaving_policy,
+            trace_config.bandwidth_per_numa_domain(),
+            options.seed + sample);
+    }
+    int num_cache_samples = num_cache_simulations * options.interleaving_samples;
+    int num_simulations = num_cache_samples + num_opt_simulations +
+        num_reuse_distance_simulations + num_tlb_simulations;
+
+    // The simulations are independent, and so they are carried out
+    // concurrently.  Progress is reported with a single alarm, which
+    // cannot be shared by concurrent simulations.
+    if (options.sim_threads <= 0) {
+#ifdef USE_OPENMP
+        options.sim_threads = omp_get_max_threads();
+#else
+        options.sim_threads = 1;
+#endif
+    }
+    options.sim_threads = std::max(1, std::min(options.sim_threads, num_simulations));
+    if (options.sim_threads > 1)
+        options.progress_interval = 0;
+
+    // Count the number of times that each thread's memory reference
+    // string is traversed, so that the strings that are traversed
+    // more than once are only generated once.  Optimal replacement
+    // traverses the strings once more to find the next uses.
+    int num_threads = trace_config.thread_affinities().size();
+    std::vector<int> num_uses(num_threads, 0);
+    for (int i = 0; i < num_simulations - num_tlb_simulations; i++) {
+        int j = i - num_cache_samples;
+        Cache const & cache = (i < num_cache_samples)
+            ? *cache_simulations[i % num_cache_simulations]
+            : (j < num_opt_simulations)
+            ? *cache_list[j]
+            : *reuse_distance_caches[j - num_opt_simulations];
+        for (int thread : active_threads(trace_config, cache)) {
+            num_uses[thread] += options.warmup ? 2 : 1;
+            if (i >= num_cache_samples && j < num_opt_simulations)
+                num_uses[thread]++;
+        }
+    }
+    for (int thread = 0; thread < num_threads; thread++) {
+        if (!trace_config.thread_affinities()[thread].tlb.empty())
+            num_uses[thread] += options.warmup ? 2 : 1;
+    }
+    ReferenceStrings reference_strings(
+        trace_config, kernel, num_uses, options.reference_memory,
+        options.checkpoint.enabled(), options.sim_threads, options.verbose);
+    if (heatmap)
+        locator = reference_strings.matrix_locator(locator);
+
+    std::vector<std::map<std::string, replacement::CacheTraffic>>
+        traffic_per_simulation(num_cache_samples);
+    std::vector<std::vector<double>>
+        execution_time_per_simulation(num_cache_simulations);
+    std::vector<std::map<std::string, replacement::Heatmap>>
+        heatmaps_per_simulation(num_cache_simulations);
+    std::vector<replacement::CacheTraffic>
+        opt_traffic_per_cache(num_opt_simulations);
+    std::vector<replacement::ReuseDistanceHistogram>
+        reuse_distances_per_group(reuse_distance_caches.size());
+    std::vector<std::map<std::string, std::vector<std::vector<cache_miss_type>>>>
+        tlb_misses_per_simulation(num_tlb_simulations);
+    std::vector<std::exception_ptr> errors(num_simulations);
+
+    #pragma omp parallel for schedule(dynamic) num_threads(options.sim_threads)
+    for (int i = 0; i < num_simulations; i++) {
+        try {
+            if (i < num_cache_samples &&
+                options.hierarchy_mode == CacheHierarchyMode::independent)
+            {
+                Cache const & cache = *cache_simulations[i % num_cache_simulations];
+                traffic_per_simulation[i].emplace(
+                    cache.name,
+                    trace_cache_misses_per_cache(
+                        trace_config, kernel, reference_strings, cache,
+                        options, false, locator, empty_heatmap,
+                        (heatmap && i < num_cache_simulations)
+                        ? &heatmaps_per_simulation[i] : nullptr,
+                        interleavings[i / num_cache_simulations],
+                        options.checkpoint.for_simulation(
+                            simulation_name("cache", cache, i / num_cache_simulations))));
+            } else if (i < num_cache_samples) {
+                Cache const & cache = *cache_simulations[i % num_cache_simulations];
+                traffic_per_simulation[i] =
+                    trace_cache_misses_per_hierarchy(
+                        trace_config, kernel, reference_strings, cache,
+                        options, locator, empty_heatmap,
+                        (heatmap && i < num_cache_simulations)
+                        ? &heatmaps_per_simulation[i] : nullptr,
+                        interleavings[i / num_cache_simulations],
+                        options.checkpoint.for_simulation(
+                            simulation_name("hierarchy", cache, i / num_cache_simulations)),
+                        (options.timing && i < num_cache_simulations)
+                        ? &execution_time_per_simulation[i] : nullptr);
+            } else if (i < num_cache_samples + num_opt_simulations) {
+                int j = i - num_cache_samples;
+                opt_traffic_per_cache[j] =
+                    trace_cache_misses_per_cache(
+                        trace_config, kernel, reference_strings, *cache_list[j],
+                        options, true, locator, empty_heatmap, nullptr,
+                        interleavings[0],
+                        options.checkpoint.for_simulation(
+                            simulation_name("opt", *cache_list[j], 0)));
+            } else if (i < num_cache_samples + num_opt_simulations +
+                       num_reuse_distance_simulations)
+            {
+                int group = i - num_cache_samples - num_opt_simulations;
+                reuse_distances_per_group[group] =
+                    trace_reuse_distances_per_cache(
+                        trace_config, kernel, reference_strings,
+                        *reuse_distance_caches[group],
+                        reuse_distance_cache_lines[group],
+                        options.warmup, interleavings[0], options.verbose,
+                        options.progress_interval);
+            } else {
+                int j = i - num_cache_samples - num_opt_simulations -
+                    num_reuse_distance_simulations;
+                tlb_misses_per_simulation[j] =
+                    trace_tlb_misses_per_hierarchy(
+                        trace_config, kernel, reference_strings,
+                        *tlb_simulations[j], options.warmup, interleavings[0],
+                        options.verbose);
+            }
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    }
+
+    for (auto const & error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    // Prefetches are only reported if some cache has a prefetcher.
+    bool prefetch = false;
     for (auto it = caches.cbegin(); it != caches.cend(); ++it) {
-        std::string name = (*it).first;
-        Cache const & cache = (*it).second;
+        if (!(*it).second.prefetcher.empty())
+            prefetch = true;
+    }
+
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> cache_misses;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> write_backs;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> prefetch_fills;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> useful_prefetches;
+    std::map<std::string, std::map<std::string, cache_miss_type>> cache_misses_per_array;
+    std::map<std::string, CoherenceEvents> coherence_events;
+    std::map<std::string, replacement::SamplingEstimate> sampling_estimates;
+    std::map<std::string, int> cache_simulation;
+    replacement::MemoryRegions regions(kernel.memory_regions());
+    for (int i = 0; i < num_cache_simulations; i++) {
+        for (auto const & cache_traffic : traffic_per_simulation[i]) {
+            cache_simulation.emplace(cache_traffic.first, i);
+            cache_misses.emplace(
+                cache_traffic.first, cache_traffic.second.cache_misses);
+            write_backs.emplace(
+                cache_traffic.first, cache_traffic.second.write_backs);
+            if (options.sampling.enabled()) {
+                sampling_estimates.emplace(
+                    cache_traffic.first, cache_traffic.second.sampling);
+            }
+            if (prefetch) {
+                prefetch_fills.emplace(
+                    cache_traffic.first, cache_traffic.second.prefetch_fills);
+                useful_prefetches.emplace(
+                    cache_traffic.first, cache_traffic.second.useful_prefetches);
+            }
+            if (!cache_traffic.second.cache_misses_per_region.empty()) {
+                auto & counts = cache_misses_per_array[cache_traffic.first];
+                for (std::size_t region = 0; region < regions.size(); region++) {
+                    counts[regions.name(region)] =
+                        cache_traffic.second.cache_misses_per_region[region];
+                }
+            }
+            if (!cache_traffic.second.invalidations.empty()) {
+                CoherenceEvents & events = coherence_events[cache_traffic.first];
+                for (std::size_t region = 0; region < regions.size(); region++) {
+                    std::string const & name = regions.name(region);
+                    events.invalidations[name] =
+                        cache_traffic.second.invalidations[region];
+                    events.coherence_misses[name] =
+                        cache_traffic.second.coherence_misses[region];
+                    events.false_sharing[name] =
+                        cache_traffic.second.false_sharing[region];
+                }
+            }
+        }
+    }
 
-        std::vector<std::vector<cache_miss_type>>
-            num_cache_misses_per_thread_per_numa_domain =
-            trace_cache_misses_per_cache(
-                trace_config, kernel, cache, warmup, verbose, progress_interval);
-        cache_misses.emplace(
-            cache.name,
-            num_cache_misses_per_thread_per_numa_domain);
+    // The mean and sample variance of the cache misses of each cache,
+    // thread and NUMA domain over the ensemble of interleavings.
+    std::map<std::string, std::vector<std::vector<double>>> cache_misses_mean;
+    std::map<std::string, std::vector<std::vector<double>>> cache_misses_variance;
+    if (options.interleaving_samples > 1) {
+        for (auto const & cache_miss : cache_misses) {
+            std::string const & name = cache_miss.first;
+            std::vector<std::vector<double>> mean(cache_miss.second.size());
+            for (std::size_t thread = 0; thread < mean.size(); thread++)
+                mean[thread].assign(cache_miss.second[thread].size(), 0.0);
+            std::vector<std::vector<double>> variance(mean);
+            for (int sample = 0; sample < options.interleaving_samples; sample++) {
+                auto const & sample_cache_misses = traffic_per_simulation[
+                    sample * num_cache_simulations + cache_simulation.at(name)]
+                    .at(name).cache_misses;
+                for (std::size_t thread = 0; thread < mean.size(); thread++) {
+                    for (std::size_t i = 0; i < mean[thread].size(); i++)
+                        mean[thread][i] += sample_cache_misses[thread][i];
+                }
+            }
+            for (std::size_t thread = 0; thread < mean.size(); thread++) {
+                for (std::size_t i = 0; i < mean[thread].size(); i++)
+                    mean[thread][i] /= options.interleaving_samples;
+            }
+            for (int sample = 0; sample < options.interleaving_samples; sample++) {
+                auto const & sample_cache_misses = traffic_per_simulation[
+                    sample * num_cache_simulations + cache_simulation.at(name)]
+                    .at(name).cache_misses;
+                for (std::size_t thread = 0; thread < mean.size(); thread++) {
+                    for (std::size_t i = 0; i < mean[thread].size(); i++) {
+                        double d = sample_cache_misses[thread][i] - mean[thread][i];
+                        variance[thread][i] += d * d / (options.interleaving_samples - 1);
+                    }
+                }
+            }
+            cache_misses_mean.emplace(name, mean);
+            cache_misses_variance.emplace(name, variance);
+        }
+    }
+
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> opt_cache_misses;
+    for (int i = 0; i < num_opt_simulations; i++) {
+        opt_cache_misses.emplace(
+            cache_list[i]->name, opt_traffic_per_cache[i].cache_misses);
+    }
+
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> tlb_misses;
+    for (auto const & simulation_tlb_misses : tlb_misses_per_simulation) {
+        tlb_misses.insert(
+            simulation_tlb_misses.cbegin(),
+            simulation_tlb_misses.cend());
+    }
+
+    // Every thread is simulated by the hierarchy of its first-level
+    // cache, and the kernel takes as long as the slowest thread.
+    std::vector<double> execution_time;
+    if (options.timing) {
+        execution_time.assign(trace_config.thread_affinities().size(), 0.0);
+        for (auto const & simulation_time : execution_time_per_simulation) {
+            for (std::size_t thread = 0; thread < simulation_time.size(); thread++) {
+                execution_time[thread] =
+                    std::max(execution_time[thread], simulation_time[thread]);
+            }
+        }
+    }
+
+    std::map<std::string, replacement::Heatmap> heatmaps;
+    for (auto const & simulation_heatmaps : heatmaps_per_simulation) {
+        heatmaps.insert(
+            simulation_heatmaps.cbegin(),
+            simulation_heatmaps.cend());
+    }
+
+    std::map<std::string, replacement::ReuseDistanceHistogram> reuse_distances;
+    if (options.reuse_distance) {
+        for (int i = 0; i < num_caches; i++) {
+            reuse_distances.emplace(
+                cache_list[i]->name,
+                reuse_distances_per_group[reuse_distance_group[i]]);
+        }
+    }
+
+    CacheTraceResults results;
+    results.cache_misses = std::move(cache_misses);
+    results.write_backs = std::move(write_backs);
+    results.prefetch_fills = std::move(prefetch_fills);
+    results.useful_prefetches = std::move(useful_prefetches);
+    results.cache_misses_per_array = std::move(cache_misses_per_array);
+    results.cache_misses_mean = std::move(cache_misses_mean);
+    results.cache_misses_variance = std::move(cache_misses_variance);
+    results.opt_cache_misses = std::move(opt_cache_misses);
+    results.tlb_misses = std::move(tlb_misses);
+    results.coherence = std::move(coherence_events);
+    results.execution_time = std::move(execution_time);
+    results.sampling_estimates = std::move(sampling_estimates);
+    results.reuse_distances = std::move(reuse_distances);
+    results.heatmaps = std::move(heatmaps);
+    return CacheTrace(trace_config, kernel, options, results);
+}
+
+CacheTrace estimate_cache_misses(
+    TraceConfig const & trace_config,
+    Kernel const & kernel,
+    bool verbose)
+{
+    auto const & caches = trace_config.caches();
+    auto const & thread_affinities = trace_config.thread_affinities();
+    int num_threads = thread_affinities.size();
+    int num_numa_domains = trace_config.num_numa_domains();
+
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> cache_misses;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> write_backs;
+    std::map<std::string, std::vector<int>> threads_per_cache;
+    for (auto const & cache : caches) {
+        cache_misses[cache.first] = std::vector<std::vector<cache_miss_type>>(
+            num_threads, std::vector<cache_miss_type>(num_numa_domains, 0));
+        write_backs[cache.first] = cache_misses[cache.first];
+        threads_per_cache[cache.first] = active_threads(trace_config, cache.second);
+    }
+
+    for (int thread = 0; thread < num_threads; thread++) {
+        if (verbose) {
+            std::cerr << "Estimating cache misses of kernel " << kernel.name()
+                      << " (thread " << thread << ")" << std::endl;
+        }
+
+        // Find the caches that the thread uses, and its part of each.
+        std::vector<std::string> names;
+        std::vector<std::size_t> cache_sizes;
+        std::vector<std::size_t> line_sizes;
+        for (auto const & cache : caches) {
+            auto const & threads = threads_per_cache[cache.first];
+            if (std::find(threads.begin(), threads.end(), thread) == threads.end())
+                continue;
+            names.push_back(cache.first);
+            cache_sizes.push_back(cache.second.size / threads.size());
+            line_sizes.push_back(cache.second.line_size);
+        }
+        if (names.empty())
+            continue;
+
+        std::vector<std::vector<cache_miss_type>> thread_cache_misses(
+            names.size(), std::vector<cache_miss_type>(num_numa_domains, 0));
+        std::vector<std::vector<cache_miss_type>> thread_write_backs(
+            thread_cache_misses);
+        kernel.estimate_cache_misses(
+            trace_config, thread, num_threads, cache_sizes, line_sizes,
+            thread_cache_misses, thread_write_backs);
+        for (std::size_t c = 0; c < names.size(); c++) {
+            cache_misses[names[c]][thread] = thread_cache_misses[c];
+            write_backs[names[c]][thread] = thread_write_backs[c];
+        }
     }
 
-    return CacheTrace(trace_config, kernel, warmup, cache_misses);
+    CacheTraceResults results;
+    results.cache_misses = cache_misses;
+    results.write_backs = write_backs;
+    return CacheTrace(trace_config, kernel, CacheTraceOptions(), results);
+}
+
+void record_trace(
+    std::ostream & o,
+    TraceConfig const & trace_config,
+    Kernel const & kernel,
+    bool compress,
+    bool verbose)
+{
+    if (verbose) {
+        std::cerr << "Recording memory accesses of kernel "
+                  << kernel.name() << std::endl;
+    }
+
+    int num_threads = trace_config.thread_affinities().size();
+    std::vector<std::unique_ptr<replacement::MemoryReferenceGenerator>>
+        generators(num_threads);
+    std::vector<replacement::MemoryReferenceGenerator const *> ws(num_threads);
+    for (int thread = 0; thread < num_threads; thread++) {
+        generators[thread] = kernel.memory_reference_generator(
+            trace_config, thread, num_threads);
+        ws[thread] = generators[thread].get();
+    }
+
+    std::stringstream description;
+    kernel.print(description);
+    replacement::write_trace_file(
+        o, kernel.name(), description.str(), kernel.memory_regions(),
+        trace_config.num_numa_domains(), ws, compress);
 }
 
 std::ostream & operator<<(
@@ -240,17 +1591,368 @@ std::ostream & operator<<(
 
 std::ostream & operator<<(
     std::ostream & o,
-    CacheTrace const & cache_trace)
+    std::vector<std::vector<double>> const & values)
+{
+    o << '[';
+    for (std::size_t i = 0; i < values.size(); i++) {
+        o << (i > 0 ? ", [" : "[");
+        for (std::size_t j = 0; j < values[i].size(); j++)
+            o << (j > 0 ? ", " : "") << values[i][j];
+        o << ']';
+    }
+    return o << ']';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    std::map<std::string, std::vector<std::vector<double>>> const & values)
+{
+    if (values.empty())
+        return o << "{}";
+
+    o << '{' << '\n';
+    auto it = values.cbegin();
+    auto end = --values.cend();
+    for (; it != end; ++it) {
+        o << '"' << (*it).first << '"' << ": "
+          << (*it).second << ",\n";
+    }
+    o << '"' << (*it).first << '"' << ": "
+      << (*it).second << '\n';
+    return o << '}';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    std::vector<std::vector<std::vector<cache_miss_type>>> const & cache_misses)
+{
+    if (cache_misses.empty())
+        return o << "[]";
+
+    o << '[';
+    auto it = cache_misses.cbegin();
+    auto end = --cache_misses.cend();
+    for (; it != end; ++it)
+        o << *it << ',' << ' ';
+    return o << *it << ']';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    replacement::ReuseDistanceHistogram const & histogram)
+{
+    std::size_t num_threads = histogram.num_processors();
+    replacement::numa_domain_type num_numa_domains =
+        histogram.num_numa_domains();
+    std::size_t num_bins = histogram.num_bins();
+
+    // The lower bound of each bin, and the cache sizes at the upper
+    // end of each bin, for which the LRU cache misses are exact.
+    std::vector<cache_miss_type> reuse_distances(num_bins);
+    std::vector<cache_miss_type> cache_sizes(num_bins);
+    for (std::size_t bin = 0; bin < num_bins; bin++) {
+        reuse_distances[bin] = replacement::reuse_distance_bin_lower_bound(bin);
+        cache_sizes[bin] = histogram.cache_line_size() *
+            replacement::reuse_distance_bin_lower_bound(bin+1);
+    }
+
+    std::vector<std::vector<std::vector<cache_miss_type>>> counts(
+        num_threads,
+        std::vector<std::vector<cache_miss_type>>(
+            num_numa_domains, std::vector<cache_miss_type>(num_bins)));
+    std::vector<std::vector<std::vector<cache_miss_type>>> lru_cache_misses(
+        counts);
+    for (std::size_t bin = 0; bin < num_bins; bin++) {
+        std::vector<std::vector<cache_miss_type>> cache_misses =
+            histogram.cache_misses(
+                replacement::reuse_distance_bin_lower_bound(bin+1));
+        for (std::size_t p = 0; p < num_threads; p++) {
+            for (replacement::numa_domain_type i = 0; i < num_numa_domains; i++) {
+                counts[p][i][bin] = histogram.count(p, i, bin);
+                lru_cache_misses[p][i][bin] = cache_misses[p][i];
+            }
+        }
+    }
+
+    std::vector<std::vector<cache_miss_type>> cold_misses(
+        num_threads, std::vector<cache_miss_type>(num_numa_domains));
+    for (std::size_t p = 0; p < num_threads; p++) {
+        for (replacement::numa_domain_type i = 0; i < num_numa_domains; i++)
+            cold_misses[p][i] = histogram.cold_misses(p, i);
+    }
+
+    // The sizes of the caches that share the reuse distances, which
+    // need not lie at the boundaries of bins, and their exact LRU
+    // cache misses.
+    std::vector<replacement::cache_size_type> const & exact_cache_lines =
+        histogram.exact_cache_lines();
+    std::vector<cache_miss_type> exact_cache_sizes(exact_cache_lines.size());
+    std::vector<std::vector<std::vector<cache_miss_type>>> exact_lru_cache_misses(
+        num_threads,
+        std::vector<std::vector<cache_miss_type>>(
+            num_numa_domains,
+            std::vector<cache_miss_type>(exact_cache_lines.size())));
+    for (std::size_t k = 0; k < exact_cache_lines.size(); k++) {
+        exact_cache_sizes[k] = histogram.cache_line_size() * exact_cache_lines[k];
+        std::vector<std::vector<cache_miss_type>> cache_misses =
+            histogram.cache_misses(exact_cache_lines[k]);
+        for (std::size_t p = 0; p < num_threads; p++) {
+            for (replacement::numa_domain_type i = 0; i < num_numa_domains; i++)
+                exact_lru_cache_misses[p][i][k] = cache_misses[p][i];
+        }
+    }
+
+    return o << '{' << '\n'
+             << '"' << "line_size" << '"' << ": "
+             << histogram.cache_line_size() << ',' << '\n'
+             << '"' << "reuse_distances" << '"' << ": "
+             << reuse_distances << ',' << '\n'
+             << '"' << "histogram" << '"' << ": "
+             << counts << ',' << '\n'
+             << '"' << "cold_misses" << '"' << ": "
+             << cold_misses << ',' << '\n'
+             << '"' << "cache_sizes" << '"' << ": "
+             << cache_sizes << ',' << '\n'
+             << '"' << "lru_cache_misses" << '"' << ": "
+             << lru_cache_misses << ',' << '\n'
+             << '"' << "exact_cache_sizes" << '"' << ": "
+             << exact_cache_sizes << ',' << '\n'
+             << '"' << "exact_lru_cache_misses" << '"' << ": "
+             << exact_lru_cache_misses << '\n'
+             << '}';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    std::map<std::string, replacement::ReuseDistanceHistogram> const & reuse_distances)
+{
+    if (reuse_distances.empty())
+        return o << "{}";
+
+    o << '{' << '\n';
+    auto it = reuse_distances.cbegin();
+    auto end = --reuse_distances.cend();
+    for (; it != end; ++it) {
+        o << '"' << (*it).first << '"' << ": "
+          << (*it).second << ",\n";
+    }
+    o << '"' << (*it).first << '"' << ": "
+      << (*it).second << '\n';
+    return o << '}';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    std::map<std::string, cache_miss_type> const & counts)
+{
+    if (counts.empty())
+        return o << "{}";
+
+    o << '{';
+    auto it = counts.cbegin();
+    auto end = --counts.cend();
+    for (; it != end; ++it)
+        o << '"' << (*it).first << '"' << ": " << (*it).second << ',' << ' ';
+    return o << '"' << (*it).first << '"' << ": " << (*it).second << '}';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    std::map<std::string, std::map<std::string, cache_miss_type>> const & counts)
+{
+    if (counts.empty())
+        return o << "{}";
+
+    o << '{' << '\n';
+    auto it = counts.cbegin();
+    auto end = --counts.cend();
+    for (; it != end; ++it) {
+        o << '"' << (*it).first << '"' << ": "
+          << (*it).second << ",\n";
+    }
+    o << '"' << (*it).first << '"' << ": "
+      << (*it).second << '\n';
+    return o << '}';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    CoherenceEvents const & events)
 {
     return o << '{' << '\n'
-             << '"' << "trace_config" << '"' << ": "
-             << cache_trace.trace_config() << ',' << '\n'
-             << '"' << "kernel" << '"' << ": "
-             << cache_trace.kernel() << ',' << '\n'
-             << '"' << "warmup" << '"' << ": "
-             << (cache_trace.warmup()
-                 ? std::string("true") : std::string("false")) << ',' << '\n'
-             << '"' << "cache_misses" << '"' << ": "
-             << cache_trace.cache_misses()
-             << '\n' << '}';
+             << '"' << "invalidations" << '"' << ": "
+             << events.invalidations << ',' << '\n'
+             << '"' << "coherence_misses" << '"' << ": "
+             << events.coherence_misses << ',' << '\n'
+             << '"' << "false_sharing" << '"' << ": "
+             << events.false_sharing << '\n'
+             << '}';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    std::map<std::string, CoherenceEvents> const & coherence)
+{
+    if (coherence.empty())
+        return o << "{}";
+
+    o << '{' << '\n';
+    auto it = coherence.cbegin();
+    auto end = --coherence.cend();
+    for (; it != end; ++it) {
+        o << '"' << (*it).first << '"' << ": "
+          << (*it).second << ",\n";
+    }
+    o << '"' << (*it).first << '"' << ": "
+      << (*it).second << '\n';
+    return o << '}';
+}
+
+/*
+ * Print the sampling estimates of every cache, and whether each one
+ * meets the target error of the sampling.
+ */
+std::ostream & print_sampling_estimates(
+    std::ostream & o,
+    std::map<std::string, replacement::SamplingEstimate> const & estimates,
+    replacement::Sampling const & sampling)
+{
+    if (estimates.empty())
+        return o << "{}";
+
+    o << '{' << '\n';
+    for (auto it = estimates.cbegin(); it != estimates.cend(); ++it) {
+        auto const & estimate = (*it).second;
+        o << (it != estimates.cbegin() ? ",\n" : "")
+          << '"' << (*it).first << '"' << ": " << '{'
+          << '"' << "windows" << '"' << ": "
+          << estimate.windows << ',' << ' '
+          << '"' << "cache_misses" << '"' << ": "
+          << estimate.cache_misses << ',' << ' '
+          << '"' << "confidence_interval" << '"' << ": " << '['
+          << estimate.cache_misses - estimate.confidence_interval << ',' << ' '
+          << estimate.cache_misses + estimate.confidence_interval << ']' << ',' << ' '
+          << '"' << "relative_error" << '"' << ": "
+          << estimate.relative_error() << ',' << ' '
+          << '"' << "target_error_met" << '"' << ": "
+          << (estimate.meets_target(sampling)
+              ? std::string("true") : std::string("false")) << '}';
+    }
+    return o << '\n' << '}';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    CacheTrace const & cache_trace)
+{
+    o << '{' << '\n'
+      << '"' << "trace_config" << '"' << ": "
+      << cache_trace.trace_config() << ',' << '\n'
+      << '"' << "kernel" << '"' << ": "
+      << cache_trace.kernel() << ',' << '\n'
+      << '"' << "warmup" << '"' << ": "
+      << (cache_trace.warmup()
+          ? std::string("true") : std::string("false")) << ',' << '\n'
+      << '"' << "hierarchy" << '"' << ": "
+      << '"' << cache_hierarchy_mode_name(cache_trace.hierarchy_mode()) << '"'
+      << ',' << '\n'
+      << '"' << "interleaving" << '"' << ": "
+      << '"' << interleaving_policy_name(cache_trace.interleaving_policy()) << '"'
+      << ',' << '\n'
+      << '"' << "cache_misses" << '"' << ": "
+      << cache_trace.cache_misses() << ',' << '\n'
+      << '"' << "write_backs" << '"' << ": "
+      << cache_trace.write_backs();
+    if (!cache_trace.prefetch_fills().empty()) {
+        o << ',' << '\n'
+          << '"' << "prefetch_fills" << '"' << ": "
+          << cache_trace.prefetch_fills() << ',' << '\n'
+          << '"' << "useful_prefetches" << '"' << ": "
+          << cache_trace.useful_prefetches();
+    }
+    if (!cache_trace.cache_misses_per_array().empty()) {
+        o << ',' << '\n'
+          << '"' << "cache_misses_per_array" << '"' << ": "
+          << cache_trace.cache_misses_per_array();
+    }
+    if (!cache_trace.cache_misses_mean().empty()) {
+        o << ',' << '\n'
+          << '"' << "cache_misses_mean" << '"' << ": "
+          << cache_trace.cache_misses_mean() << ',' << '\n'
+          << '"' << "cache_misses_variance" << '"' << ": "
+          << cache_trace.cache_misses_variance();
+    }
+    if (cache_trace.sampling().enabled()) {
+        auto const & sampling = cache_trace.sampling();
+        o << ',' << '\n'
+          << '"' << "sampling" << '"' << ": " << '{' << '\n'
+          << '"' << "period" << '"' << ": "
+          << sampling.period() << ',' << '\n'
+          << '"' << "warmup_window" << '"' << ": "
+          << sampling.warmup_window() << ',' << '\n'
+          << '"' << "detailed_window" << '"' << ": "
+          << sampling.detailed_window() << ',' << '\n'
+          << '"' << "target_error" << '"' << ": ";
+        if (sampling.target_error() > 0.0)
+            o << sampling.target_error();
+        else
+            o << "null";
+        o << ',' << '\n'
+          << '"' << "caches" << '"' << ": ";
+        print_sampling_estimates(o, cache_trace.sampling_estimates(), sampling)
+            << '\n' << '}';
+    }
+    if (!cache_trace.opt_cache_misses().empty()) {
+        o << ',' << '\n'
+          << '"' << "opt_cache_misses" << '"' << ": "
+          << cache_trace.opt_cache_misses();
+    }
+    if (!cache_trace.tlb_misses().empty()) {
+        o << ',' << '\n'
+          << '"' << "tlb_misses" << '"' << ": "
+          << cache_trace.tlb_misses();
+    }
+    if (!cache_trace.coherence().empty()) {
+        o << ',' << '\n'
+          << '"' << "coherence" << '"' << ": "
+          << cache_trace.coherence();
+    }
+    if (!cache_trace.execution_time().empty()) {
+        auto const & execution_time = cache_trace.execution_time();
+        o << ',' << '\n'
+          << '"' << "predicted_execution_time" << '"' << ": " << '{' << '\n'
+          << '"' << "threads" << '"' << ": " << '[';
+        for (std::size_t thread = 0; thread < execution_time.size(); thread++)
+            o << (thread > 0 ? ", " : "") << execution_time[thread];
+        o << ']' << ',' << '\n'
+          << '"' << "total" << '"' << ": "
+          << *std::max_element(execution_time.cbegin(), execution_time.cend())
+          << '\n' << '}';
+    }
+    if (!cache_trace.reuse_distances().empty()) {
+        o << ',' << '\n'
+          << '"' << "reuse_distance" << '"' << ": "
+          << cache_trace.reuse_distances();
+    }
+    return o << '\n' << '}';
+}
+
+void write_heatmaps(
+    std::ostream & o,
+    CacheTrace const & cache_trace)
+{
+    o << "cache,row_begin,row_end,column_begin,column_end,cache_misses" << '\n';
+    for (auto const & cache_heatmap : cache_trace.heatmaps()) {
+        replacement::Heatmap const & heatmap = cache_heatmap.second;
+        for (std::size_t i = 0; i < heatmap.row_bins(); i++) {
+            for (std::size_t j = 0; j < heatmap.column_bins(); j++) {
+                if (heatmap(i, j) == 0)
+                    continue;
+                o << cache_heatmap.first << ','
+                  << heatmap.row_begin(i) << ',' << heatmap.row_begin(i+1) << ','
+                  << heatmap.column_begin(j) << ',' << heatmap.column_begin(j+1) << ','
+                  << heatmap(i, j) << '\n';
+            }
+        }
+    }
 }
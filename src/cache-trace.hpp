@@ -2,45 +2,340 @@
 #define CACHE_TRACE_HPP
 
 #include "trace-config.hpp"
+#include "cache-simulation/checkpoint.hpp"
+#include "cache-simulation/heatmap.hpp"
 #include "cache-simulation/replacement.hpp"
+#include "cache-simulation/reuse-distance.hpp"
 #include "kernels/kernel.hpp"
 
+#include <cstddef>
 #include <iosfwd>
 #include <map>
 #include <string>
+#include <vector>
 
 using cache_miss_type = replacement::cache_miss_type;
 
+/*
+ * Ways of simulating the caches of a memory hierarchy.  By default,
+ * each cache is simulated independently, using the memory references
+ * of every thread that shares the cache.  Otherwise, all the caches
+ * below a last-level cache are simulated together, so that only the
+ * cache misses of a cache are forwarded to its parent, and the
+ * last-level cache is either non-inclusive, inclusive or exclusive.
+ */
+enum class CacheHierarchyMode
+{
+    independent,
+    non_inclusive,
+    inclusive,
+    exclusive,
+};
+
+std::string cache_hierarchy_mode_name(
+    CacheHierarchyMode hierarchy_mode);
+
+std::string interleaving_policy_name(
+    replacement::InterleavingPolicy interleaving_policy);
+
+/*
+ * The coherence events of a cache for each array of a kernel.
+ */
+struct CoherenceEvents
+{
+    std::map<std::string, cache_miss_type> invalidations;
+    std::map<std::string, cache_miss_type> coherence_misses;
+    std::map<std::string, cache_miss_type> false_sharing;
+};
+
+/*
+ * Options for simulating the caches of a trace configuration (see
+ * `trace_cache_misses').
+ */
+struct CacheTraceOptions
+{
+    CacheTraceOptions()
+        : warmup(false)
+        , hierarchy_mode(CacheHierarchyMode::independent)
+        , opt(false)
+        , reuse_distance(false)
+        , coherence(false)
+        , per_array(false)
+        , heatmap_row_bins(0)
+        , heatmap_column_bins(0)
+        , timing(false)
+        , interleaving_policy(replacement::InterleavingPolicy::round_robin)
+        , interleaving_samples(1)
+        , sampling()
+        , checkpoint()
+        , sim_threads(0)
+        , reference_memory(std::size_t(1) << 30)
+        , seed(0)
+        , verbose(false)
+        , progress_interval(0)
+    {
+    }
+
+    /*
+     * Run the kernel once to warm up the caches before counting its
+     * cache misses.
+     */
+    bool warmup;
+
+    /*
+     * Simulate each cache independently, or every cache hierarchy
+     * together.
+     */
+    CacheHierarchyMode hierarchy_mode;
+
+    /*
+     * Also simulate every cache as a fully associative cache with
+     * Belady's optimal replacement, which gives a lower bound on the
+     * cache misses of any replacement policy.
+     */
+    bool opt;
+
+    /*
+     * Also compute the reuse distances seen by every cache, and the
+     * cache misses of LRU caches of the configured sizes.
+     */
+    bool reuse_distance;
+
+    /*
+     * Keep the caches of each cache hierarchy coherent, and attribute
+     * their coherence events to the arrays of the kernel.  This
+     * requires a hierarchy mode other than `independent'.
+     */
+    bool coherence;
+
+    /*
+     * Attribute the cache misses of each cache to the arrays of the
+     * kernel, summed over threads and NUMA domains.  Optimal
+     * replacement is not attributed.
+     */
+    bool per_array;
+
+    /*
+     * If both are positive, the cache misses of each cache are also
+     * counted in a heatmap with that many blocks of rows and columns
+     * of the matrix of the kernel, which must have a matrix.  Like
+     * the cache misses, the heatmaps are taken from the first
+     * interleaving, and optimal replacement has none.
+     */
+    std::size_t heatmap_row_bins;
+    std::size_t heatmap_column_bins;
+
+    /*
+     * Predict the execution time of each thread by a timing model of
+     * each cache hierarchy, which uses the latencies and bandwidths
+     * of the caches and NUMA domains of the trace configuration.
+     * This also requires a hierarchy mode other than `independent'.
+     */
+    bool timing;
+
+    /*
+     * The memory reference strings of threads that share a cache are
+     * interleaved according to `interleaving_policy', where bandwidth
+     * interleaving uses the bandwidth of each NUMA domain given by
+     * the trace configuration, and random interleaving is seeded with
+     * `seed'.  If `interleaving_samples' is greater than one, the
+     * cache simulations are repeated with that many interleavings,
+     * seeded with `seed', `seed+1', and so on, and the mean and
+     * variance of the cache misses are reported along with the cache
+     * misses of the first interleaving.
+     */
+    replacement::InterleavingPolicy interleaving_policy;
+    int interleaving_samples;
+
+    /*
+     * If enabled, the cache simulations only count the memory
+     * references in periodic detailed windows, each of which is
+     * preceded by a warm-up window, and the rest are skipped.  The
+     * counts are then extrapolated, and reported along with an
+     * estimate of the cache misses of each cache and its confidence
+     * interval.  Optimal replacement, reuse distances and TLBs are
+     * not sampled.
+     */
+    replacement::Sampling sampling;
+
+    /*
+     * If enabled, the cache simulations are checkpointed periodically
+     * to files in the directory given by its path, one for each
+     * simulation, and, if requested, resumed from those files.  A
+     * simulation is resumed correctly only if it is given the same
+     * options as before.  Reuse distances and TLBs are not
+     * checkpointed.
+     */
+    replacement::Checkpoint checkpoint;
+
+    /*
+     * The number of simulations carried out concurrently, or zero to
+     * use every available thread.
+     */
+    int sim_threads;
+
+    /*
+     * The memory reference strings of threads that are needed by more
+     * than one simulation are generated only once, and shared, as
+     * long as they fit within this many bytes.
+     */
+    std::size_t reference_memory;
+
+    /*
+     * The seed of caches with random replacement and of random
+     * interleavings.
+     */
+    uint64_t seed;
+
+    /*
+     * Report the progress of the simulations to standard error, every
+     * `progress_interval' seconds if it is positive.  The progress of
+     * concurrent simulations is not reported.
+     */
+    bool verbose;
+    int progress_interval;
+};
+
+/*
+ * The results of simulating the caches of a trace configuration (see
+ * `trace_cache_misses'), each for the caches, or the TLBs, that they
+ * were computed for.  The counts are given for each thread and NUMA
+ * domain, and the results that were not requested are empty.
+ */
+struct CacheTraceResults
+{
+    // The (demand) cache misses, write-backs, prefetch fills and
+    // useful prefetches of each cache
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> cache_misses;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> write_backs;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> prefetch_fills;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> useful_prefetches;
+
+    // The cache misses of each cache attributed to the arrays of the
+    // kernel
+    std::map<std::string, std::map<std::string, cache_miss_type>> cache_misses_per_array;
+
+    // The mean and variance of the cache misses of each cache over
+    // random interleavings
+    std::map<std::string, std::vector<std::vector<double>>> cache_misses_mean;
+    std::map<std::string, std::vector<std::vector<double>>> cache_misses_variance;
+
+    // The cache misses of each cache with optimal replacement
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> opt_cache_misses;
+
+    // The misses of each TLB
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> tlb_misses;
+
+    // The coherence events of each cache
+    std::map<std::string, CoherenceEvents> coherence;
+
+    // The predicted execution time of each thread
+    std::vector<double> execution_time;
+
+    // The estimated cache misses of each cache with sampling
+    std::map<std::string, replacement::SamplingEstimate> sampling_estimates;
+
+    // The reuse distances seen by each cache
+    std::map<std::string, replacement::ReuseDistanceHistogram> reuse_distances;
+
+    // The heatmap of the cache misses of each cache
+    std::map<std::string, replacement::Heatmap> heatmaps;
+};
+
 class CacheTrace
 {
 public:
     CacheTrace(TraceConfig const & trace_config,
                Kernel const & kernel,
-               bool warmup,
-               std::map<std::string, std::vector<std::vector<cache_miss_type>>> const & cache_misses);
+               CacheTraceOptions const & options,
+               CacheTraceResults const & results);
     ~CacheTrace();
 
     TraceConfig const & trace_config() const;
     Kernel const & kernel() const;
+    CacheTraceOptions const & options() const;
     bool warmup() const;
+    CacheHierarchyMode hierarchy_mode() const;
+    replacement::InterleavingPolicy interleaving_policy() const;
+    replacement::Sampling const & sampling() const;
     std::map<std::string, std::vector<std::vector<cache_miss_type>>> const & cache_misses() const;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> const & write_backs() const;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> const & prefetch_fills() const;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> const & useful_prefetches() const;
+    std::map<std::string, std::map<std::string, cache_miss_type>> const & cache_misses_per_array() const;
+    std::map<std::string, std::vector<std::vector<double>>> const & cache_misses_mean() const;
+    std::map<std::string, std::vector<std::vector<double>>> const & cache_misses_variance() const;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> const & opt_cache_misses() const;
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>> const & tlb_misses() const;
+    std::map<std::string, CoherenceEvents> const & coherence() const;
+    std::vector<double> const & execution_time() const;
+    std::map<std::string, replacement::SamplingEstimate> const & sampling_estimates() const;
+    std::map<std::string, replacement::ReuseDistanceHistogram> const & reuse_distances() const;
+    std::map<std::string, replacement::Heatmap> const & heatmaps() const;
 
 private:
     TraceConfig const & trace_config_;
     Kernel const & kernel_;
-    bool warmup_;
-    std::map<std::string, std::vector<std::vector<cache_miss_type>>> const cache_misses_;
+    CacheTraceOptions const options_;
+    CacheTraceResults const results_;
 };
 
+/*
+ * The threads whose memory references reach the given cache, that
+ * is, those whose first-level cache is the cache or one of its
+ * descendants.
+ */
+std::vector<int> active_threads(
+    TraceConfig const & trace_config,
+    Cache const & cache);
+
+/*
+ * Simulate the caches of the given trace configuration for a kernel
+ * with the given options (see `CacheTraceOptions').  The TLBs of the
+ * trace configuration, if any, are simulated with the same memory
+ * reference strings.
+ */
 CacheTrace trace_cache_misses(
     TraceConfig const & trace_config,
     Kernel const & kernel,
-    bool warmup,
-    bool verbose,
-    int progress_interval);
+    CacheTraceOptions options);
+
+/*
+ * Estimate the cache misses and write-backs of every cache of the
+ * trace configuration from the structure of the matrix of the kernel
+ * (see `Kernel::estimate_cache_misses'), instead of simulating the
+ * caches.  Each cache is estimated independently, and the threads
+ * that share a cache are each given an equal part of it.  This takes
+ * time proportional to the number of nonzeros, and the estimates are
+ * reported in the same form as the simulated cache misses.
+ */
+CacheTrace estimate_cache_misses(
+    TraceConfig const & trace_config,
+    Kernel const & kernel,
+    bool verbose);
+
+/*
+ * Record the memory reference strings of every thread of a kernel in
+ * a trace file, optionally compressed, so that the cache simulations
+ * may later be repeated without the kernel (see `TraceFile').
+ */
+void record_trace(
+    std::ostream & o,
+    TraceConfig const & trace_config,
+    Kernel const & kernel,
+    bool compress,
+    bool verbose);
 
 std::ostream & operator<<(
     std::ostream & o,
     CacheTrace const & cache_trace);
 
+/*
+ * Write the heatmaps of a cache trace as comma-separated values, with
+ * one line for every block of rows and columns with cache misses.
+ */
+void write_heatmaps(
+    std::ostream & o,
+    CacheTrace const & cache_trace);
+
 #endif
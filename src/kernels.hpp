@@ -8,5 +8,6 @@
 #include "kernels/ell-spmv.hpp"
 #include "kernels/mkl-csr-spmv.hpp"
 #include "kernels/hybrid-spmv.hpp"
+#include "kernels/trace-replay.hpp"
 
 #endif
@@ -8,9 +8,64 @@
 #include "matrix/matrix-market.hpp"
 
 #include <algorithm>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <vector>
+
+namespace
+{
+
+class coo_spmv_atomic_memory_reference_generator
+    : public replacement::MemoryReferenceGenerator
+{
+public:
+    coo_spmv_atomic_memory_reference_generator(
+        coo_matrix::Matrix const & A,
+        coo_matrix::value_array_type const & x,
+        coo_matrix::value_array_type const & y,
+        int thread,
+        int num_threads,
+        std::vector<int> const & numa_domains,
+        int page_size)
+        : A(A)
+        , x(x)
+        , y(y)
+        , thread(thread)
+        , num_threads(num_threads)
+        , numa_domains(numa_domains)
+        , page_size(page_size)
+    {
+    }
+
+    uint64_t size() const override
+    {
+        return A.spmv_atomic_memory_reference_string_size(thread, num_threads);
+    }
+
+    void generate(
+        uint64_t offset,
+        uint64_t count,
+        replacement::MemoryReferenceString::value_type * w) const override
+    {
+        A.spmv_atomic_memory_reference_substring(
+            x, y, thread, num_threads,
+            numa_domains.data(), page_size,
+            offset, count, w);
+    }
+
+private:
+    coo_matrix::Matrix const & A;
+    coo_matrix::value_array_type const & x;
+    coo_matrix::value_array_type const & y;
+    int thread;
+    int num_threads;
+    std::vector<int> numa_domains;
+    int page_size;
+};
+
+}
 
 coo_spmv_atomic_kernel::coo_spmv_atomic_kernel(
     std::string const & matrix_path)
@@ -90,6 +145,51 @@ replacement::MemoryReferenceString coo_spmv_atomic_kernel::memory_reference_stri
         page_size);
 }
 
+std::unique_ptr<replacement::MemoryReferenceGenerator>
+coo_spmv_atomic_kernel::memory_reference_generator(
+    TraceConfig const & trace_config,
+    int thread,
+    int num_threads) const
+{
+    auto const & thread_affinities = trace_config.thread_affinities();
+#ifdef HAVE_LIBNUMA
+    int page_size = numa_pagesize();
+#else
+    int page_size = 4096;
+#endif
+
+    std::vector<int> numa_domain_affinity(thread_affinities.size(), 0);
+    for (size_t i = 0; i < thread_affinities.size(); i++) {
+        numa_domain_affinity[i] = thread_affinities[i].numa_domain;
+    }
+
+    return std::unique_ptr<replacement::MemoryReferenceGenerator>(
+        new coo_spmv_atomic_memory_reference_generator(
+            A, x, y, thread, num_threads,
+            numa_domain_affinity, page_size));
+}
+
+std::vector<replacement::MemoryRegion> coo_spmv_atomic_kernel::memory_regions() const
+{
+    return std::vector<replacement::MemoryRegion>{
+        replacement::make_memory_region("row_index", A.row_index),
+        replacement::make_memory_region("column_index", A.column_index),
+        replacement::make_memory_region("value", A.value),
+        replacement::make_memory_region("x", x),
+        replacement::make_memory_region("y", y)};
+}
+
+replacement::MatrixLocator coo_spmv_atomic_kernel::matrix_locator() const
+{
+    return replacement::MatrixLocator(
+        A.rows, A.columns,
+        std::vector<replacement::MatrixLocatorArray>{
+            replacement::make_matrix_locator_array(replacement::MatrixLocatorArray::row, A.row_index, A.row_index),
+            replacement::make_matrix_locator_array(replacement::MatrixLocatorArray::column, A.column_index, A.column_index),
+            replacement::make_matrix_locator_array(replacement::MatrixLocatorArray::column, x),
+            replacement::make_matrix_locator_array(replacement::MatrixLocatorArray::row, y)});
+}
+
 std::string coo_spmv_atomic_kernel::name() const
 {
     return "coo-spmv-atomic";
@@ -7,7 +7,9 @@
 #include "matrix/coo-matrix.hpp"
 
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <vector>
 
 class coo_spmv_atomic_kernel : public Kernel
 {
@@ -26,6 +28,15 @@ public:
         int thread,
         int num_threads) const override;
 
+    std::unique_ptr<replacement::MemoryReferenceGenerator>
+        memory_reference_generator(
+            TraceConfig const & trace_config,
+            int thread,
+            int num_threads) const override;
+
+    std::vector<replacement::MemoryRegion> memory_regions() const override;
+    replacement::MatrixLocator matrix_locator() const override;
+
     std::string name() const override;
     std::ostream & print(
         std::ostream & o) const override;
@@ -7,7 +7,9 @@
 #include "matrix/csr-matrix.hpp"
 
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <vector>
 
 class csr_spmv_kernel : public Kernel
 {
@@ -26,6 +28,24 @@ public:
         int thread,
         int num_threads) const override;
 
+    std::unique_ptr<replacement::MemoryReferenceGenerator>
+        memory_reference_generator(
+            TraceConfig const & trace_config,
+            int thread,
+            int num_threads) const override;
+
+    std::vector<replacement::MemoryRegion> memory_regions() const override;
+    replacement::MatrixLocator matrix_locator() const override;
+
+    void estimate_cache_misses(
+        TraceConfig const & trace_config,
+        int thread,
+        int num_threads,
+        std::vector<std::size_t> const & cache_sizes,
+        std::vector<std::size_t> const & line_sizes,
+        std::vector<std::vector<replacement::cache_miss_type>> & cache_misses,
+        std::vector<std::vector<replacement::cache_miss_type>> & write_backs) const override;
+
     std::string name() const override;
 
     std::ostream & print(
@@ -8,9 +8,64 @@
 #include "matrix/matrix-market.hpp"
 
 #include <algorithm>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <vector>
+
+namespace
+{
+
+class ell_spmv_memory_reference_generator
+    : public replacement::MemoryReferenceGenerator
+{
+public:
+    ell_spmv_memory_reference_generator(
+        ell_matrix::Matrix const & A,
+        ell_matrix::value_array_type const & x,
+        ell_matrix::value_array_type const & y,
+        int thread,
+        int num_threads,
+        std::vector<int> const & numa_domains,
+        int page_size)
+        : A(A)
+        , x(x)
+        , y(y)
+        , thread(thread)
+        , num_threads(num_threads)
+        , numa_domains(numa_domains)
+        , page_size(page_size)
+    {
+    }
+
+    uint64_t size() const override
+    {
+        return A.spmv_memory_reference_string_size(thread, num_threads);
+    }
+
+    void generate(
+        uint64_t offset,
+        uint64_t count,
+        replacement::MemoryReferenceString::value_type * w) const override
+    {
+        A.spmv_memory_reference_substring(
+            x, y, thread, num_threads,
+            numa_domains.data(), page_size,
+            offset, count, w);
+    }
+
+private:
+    ell_matrix::Matrix const & A;
+    ell_matrix::value_array_type const & x;
+    ell_matrix::value_array_type const & y;
+    int thread;
+    int num_threads;
+    std::vector<int> numa_domains;
+    int page_size;
+};
+
+}
 
 ell_spmv_kernel::ell_spmv_kernel(
     std::string const & matrix_path)
@@ -88,6 +143,53 @@ replacement::MemoryReferenceString ell_spmv_kernel::memory_reference_string(
         page_size);
 }
 
+std::unique_ptr<replacement::MemoryReferenceGenerator>
+ell_spmv_kernel::memory_reference_generator(
+    TraceConfig const & trace_config,
+    int thread,
+    int num_threads) const
+{
+    auto const & thread_affinities = trace_config.thread_affinities();
+#ifdef HAVE_LIBNUMA
+    int page_size = numa_pagesize();
+#else
+    int page_size = 4096;
+#endif
+
+    std::vector<int> numa_domain_affinity(thread_affinities.size(), 0);
+    for (size_t i = 0; i < thread_affinities.size(); i++) {
+        numa_domain_affinity[i] = thread_affinities[i].numa_domain;
+    }
+
+    return std::unique_ptr<replacement::MemoryReferenceGenerator>(
+        new ell_spmv_memory_reference_generator(
+            A, x, y, thread, num_threads,
+            numa_domain_affinity, page_size));
+}
+
+std::vector<replacement::MemoryRegion> ell_spmv_kernel::memory_regions() const
+{
+    return std::vector<replacement::MemoryRegion>{
+        replacement::make_memory_region("column_index", A.column_index),
+        replacement::make_memory_region("value", A.value),
+        replacement::make_memory_region("x", x),
+        replacement::make_memory_region("y", y)};
+}
+
+replacement::MatrixLocator ell_spmv_kernel::matrix_locator() const
+{
+    // The entries of each row are stored contiguously, and the row is
+    // found from the position of each value.
+    return replacement::MatrixLocator(
+        A.rows, A.columns,
+        std::vector<replacement::MatrixLocatorArray>{
+            replacement::make_matrix_locator_array(replacement::MatrixLocatorArray::column, A.column_index, A.column_index),
+            replacement::make_matrix_locator_array(
+                replacement::MatrixLocatorArray::row, A.value, std::max<int64_t>(1, A.row_length)),
+            replacement::make_matrix_locator_array(replacement::MatrixLocatorArray::column, x),
+            replacement::make_matrix_locator_array(replacement::MatrixLocatorArray::row, y)});
+}
+
 std::string ell_spmv_kernel::name() const
 {
     return "ell-spmv";
@@ -8,9 +8,67 @@
 #include "matrix/matrix-market.hpp"
 
 #include <algorithm>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <vector>
+
+namespace
+{
+
+class hybrid_spmv_memory_reference_generator
+    : public replacement::MemoryReferenceGenerator
+{
+public:
+    hybrid_spmv_memory_reference_generator(
+        hybrid_matrix::Matrix const & A,
+        hybrid_matrix::value_array_type const & x,
+        hybrid_matrix::value_array_type const & y,
+        hybrid_matrix::value_array_type const & workspace,
+        int thread,
+        int num_threads,
+        std::vector<int> const & numa_domains,
+        int page_size)
+        : A(A)
+        , x(x)
+        , y(y)
+        , workspace(workspace)
+        , thread(thread)
+        , num_threads(num_threads)
+        , numa_domains(numa_domains)
+        , page_size(page_size)
+    {
+    }
+
+    uint64_t size() const override
+    {
+        return A.spmv_memory_reference_string_size(thread, num_threads);
+    }
+
+    void generate(
+        uint64_t offset,
+        uint64_t count,
+        replacement::MemoryReferenceString::value_type * w) const override
+    {
+        A.spmv_memory_reference_substring(
+            x, y, workspace, thread, num_threads,
+            numa_domains.data(), page_size,
+            offset, count, w);
+    }
+
+private:
+    hybrid_matrix::Matrix const & A;
+    hybrid_matrix::value_array_type const & x;
+    hybrid_matrix::value_array_type const & y;
+    hybrid_matrix::value_array_type const & workspace;
+    int thread;
+    int num_threads;
+    std::vector<int> numa_domains;
+    int page_size;
+};
+
+}
 
 hybrid_spmv_kernel::hybrid_spmv_kernel(
     std::string const & matrix_path)
@@ -105,6 +163,63 @@ replacement::MemoryReferenceString hybrid_spmv_kernel::memory_reference_string(
         page_size);
 }
 
+std::unique_ptr<replacement::MemoryReferenceGenerator>
+hybrid_spmv_kernel::memory_reference_generator(
+    TraceConfig const & trace_config,
+    int thread,
+    int num_threads) const
+{
+    auto const & thread_affinities = trace_config.thread_affinities();
+#ifdef HAVE_LIBNUMA
+    int page_size = numa_pagesize();
+#else
+    int page_size = 4096;
+#endif
+
+    std::vector<int> numa_domain_affinity(thread_affinities.size(), 0);
+    for (size_t i = 0; i < thread_affinities.size(); i++) {
+        numa_domain_affinity[i] = thread_affinities[i].numa_domain;
+    }
+
+    return std::unique_ptr<replacement::MemoryReferenceGenerator>(
+        new hybrid_spmv_memory_reference_generator(
+            A, x, y, workspace, thread, num_threads,
+            numa_domain_affinity, page_size));
+}
+
+std::vector<replacement::MemoryRegion> hybrid_spmv_kernel::memory_regions() const
+{
+    return std::vector<replacement::MemoryRegion>{
+        replacement::make_memory_region("ell_column_index", A.ell_column_index),
+        replacement::make_memory_region("ell_value", A.ell_value),
+        replacement::make_memory_region("coo_row_index", A.coo_row_index),
+        replacement::make_memory_region("coo_column_index", A.coo_column_index),
+        replacement::make_memory_region("coo_value", A.coo_value),
+        replacement::make_memory_region("x", x),
+        replacement::make_memory_region("y", y),
+        replacement::make_memory_region("workspace", workspace)};
+}
+
+replacement::MatrixLocator hybrid_spmv_kernel::matrix_locator() const
+{
+    // The row of an entry of the ELL part is found from the position
+    // of its value, as for the ELL kernel.
+    return replacement::MatrixLocator(
+        A.rows, A.columns,
+        std::vector<replacement::MatrixLocatorArray>{
+            replacement::make_matrix_locator_array(
+                replacement::MatrixLocatorArray::column, A.ell_column_index, A.ell_column_index),
+            replacement::make_matrix_locator_array(
+                replacement::MatrixLocatorArray::row, A.ell_value, std::max<int64_t>(1, A.ell_row_length)),
+            replacement::make_matrix_locator_array(
+                replacement::MatrixLocatorArray::row, A.coo_row_index, A.coo_row_index),
+            replacement::make_matrix_locator_array(
+                replacement::MatrixLocatorArray::column, A.coo_column_index, A.coo_column_index),
+            replacement::make_matrix_locator_array(replacement::MatrixLocatorArray::column, x),
+            replacement::make_matrix_locator_array(replacement::MatrixLocatorArray::row, y),
+            replacement::make_matrix_locator_array(replacement::MatrixLocatorArray::row, workspace, 1, 0, A.rows)});
+}
+
 std::string hybrid_spmv_kernel::name() const
 {
     return "hybrid-spmv";
@@ -1,14 +1,84 @@
 #include "kernel.hpp"
 
+#include <memory>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 kernel_error::kernel_error(std::string const & s) throw()
     : std::runtime_error(s)
 {
 }
 
+namespace
+{
+
+class stored_memory_reference_generator
+    : public replacement::MemoryReferenceGenerator
+{
+public:
+    stored_memory_reference_generator(
+        replacement::MemoryReferenceString && w)
+        : w(std::move(w))
+        , generator(this->w)
+    {
+    }
+
+    uint64_t size() const override
+    {
+        return generator.size();
+    }
+
+    void generate(
+        uint64_t offset,
+        uint64_t count,
+        replacement::MemoryReferenceString::value_type * v) const override
+    {
+        generator.generate(offset, count, v);
+    }
+
+private:
+    replacement::MemoryReferenceString w;
+    replacement::MemoryReferenceStringGenerator generator;
+};
+
+}
+
+std::unique_ptr<replacement::MemoryReferenceGenerator>
+Kernel::memory_reference_generator(
+    TraceConfig const & trace_config,
+    int thread,
+    int num_threads) const
+{
+    return std::unique_ptr<replacement::MemoryReferenceGenerator>(
+        new stored_memory_reference_generator(
+            memory_reference_string(trace_config, thread, num_threads)));
+}
+
+std::vector<replacement::MemoryRegion> Kernel::memory_regions() const
+{
+    return std::vector<replacement::MemoryRegion>();
+}
+
+replacement::MatrixLocator Kernel::matrix_locator() const
+{
+    return replacement::MatrixLocator();
+}
+
+void Kernel::estimate_cache_misses(
+    TraceConfig const & trace_config,
+    int thread,
+    int num_threads,
+    std::vector<std::size_t> const & cache_sizes,
+    std::vector<std::size_t> const & line_sizes,
+    std::vector<std::vector<replacement::cache_miss_type>> & cache_misses,
+    std::vector<std::vector<replacement::cache_miss_type>> & write_backs) const
+{
+    throw kernel_error("Cache misses can only be estimated for the CSR kernel");
+}
+
 std::ostream & operator<<(
     std::ostream & o,
     Kernel const & kernel)
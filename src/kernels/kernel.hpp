@@ -2,11 +2,16 @@
 #define KERNEL_HPP
 
 #include "trace-config.hpp"
+#include "cache-simulation/heatmap.hpp"
+#include "cache-simulation/memory-region.hpp"
 #include "cache-simulation/replacement.hpp"
 
+#include <cstddef>
 #include <iosfwd>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 class kernel_error
     : public std::runtime_error
@@ -34,6 +39,47 @@ public:
         int thread,
         int num_threads) const = 0;
 
+    /*
+     * Generate the memory reference string of a thread in chunks of
+     * bounded size, rather than all at once.  By default, the entire
+     * memory reference string is stored in the generator.
+     */
+    virtual std::unique_ptr<replacement::MemoryReferenceGenerator>
+        memory_reference_generator(
+            TraceConfig const & trace_config,
+            int thread,
+            int num_threads) const;
+
+    /*
+     * The arrays accessed by the kernel, which the memory references
+     * may be attributed to.  By default, no arrays are named.
+     */
+    virtual std::vector<replacement::MemoryRegion> memory_regions() const;
+
+    /*
+     * Find the rows and columns of the matrix that the memory
+     * references of the kernel belong to.  By default, the kernel has
+     * no matrix, and the locator is empty.
+     */
+    virtual replacement::MatrixLocator matrix_locator() const;
+
+    /*
+     * Estimate the cache misses and write-backs of a thread from the
+     * structure of the matrix, without generating its memory
+     * references, for caches with the given capacities and cache line
+     * sizes.  The estimates are added to `cache_misses' and
+     * `write_backs', which hold the counts of each cache for every
+     * NUMA domain.  By default, the kernel cannot be estimated.
+     */
+    virtual void estimate_cache_misses(
+        TraceConfig const & trace_config,
+        int thread,
+        int num_threads,
+        std::vector<std::size_t> const & cache_sizes,
+        std::vector<std::size_t> const & line_sizes,
+        std::vector<std::vector<replacement::cache_miss_type>> & cache_misses,
+        std::vector<std::vector<replacement::cache_miss_type>> & write_backs) const;
+
     virtual std::string name() const = 0;
 
     virtual std::ostream & print(
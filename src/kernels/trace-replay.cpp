@@ -0,0 +1,107 @@
+#include "trace-replay.hpp"
+#include "kernel.hpp"
+#include "trace-config.hpp"
+
+#include "cache-simulation/replacement.hpp"
+#include "cache-simulation/trace-file.hpp"
+
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+trace_replay_kernel::trace_replay_kernel(
+    std::string const & trace_path)
+    : Kernel()
+    , trace_path(trace_path)
+{
+}
+
+trace_replay_kernel::~trace_replay_kernel()
+{
+}
+
+void trace_replay_kernel::init(
+    TraceConfig const & trace_config,
+    std::ostream & o,
+    bool verbose)
+{
+    if (verbose)
+        o << "Reading memory references from " << trace_path << std::endl;
+
+    try {
+        trace_file = std::make_unique<replacement::TraceFile>(trace_path);
+    } catch (replacement::trace_file_error & e) {
+        throw kernel_error(e.what());
+    }
+
+    // The NUMA domains of the memory references were determined by
+    // the threads of the trace configuration that the trace was
+    // recorded with.
+    int num_threads = trace_config.thread_affinities().size();
+    if (trace_file->num_threads() != num_threads) {
+        std::stringstream s;
+        s << trace_path << ": "
+          << "Expected a trace of " << num_threads << " threads, "
+          << "but the trace has " << trace_file->num_threads() << " threads";
+        throw kernel_error(s.str());
+    }
+    if (trace_file->num_numa_domains() != trace_config.num_numa_domains()) {
+        std::stringstream s;
+        s << trace_path << ": "
+          << "Expected a trace of " << trace_config.num_numa_domains() << " NUMA domains, "
+          << "but the trace has " << trace_file->num_numa_domains() << " NUMA domains";
+        throw kernel_error(s.str());
+    }
+}
+
+void trace_replay_kernel::prepare(
+        TraceConfig const & trace_config)
+{
+    throw kernel_error(trace_path + ": Cannot run a kernel replayed from a trace");
+}
+
+void trace_replay_kernel::run(TraceConfig const & trace_config)
+{
+    throw kernel_error(trace_path + ": Cannot run a kernel replayed from a trace");
+}
+
+replacement::MemoryReferenceString trace_replay_kernel::memory_reference_string(
+    TraceConfig const & trace_config,
+    int thread,
+    int num_threads) const
+{
+    auto generator = trace_file->generator(thread);
+    replacement::MemoryReferenceString w(generator->size());
+    generator->generate(0, w.size(), w.data());
+    return w;
+}
+
+std::unique_ptr<replacement::MemoryReferenceGenerator>
+trace_replay_kernel::memory_reference_generator(
+    TraceConfig const & trace_config,
+    int thread,
+    int num_threads) const
+{
+    return trace_file->generator(thread);
+}
+
+std::vector<replacement::MemoryRegion> trace_replay_kernel::memory_regions() const
+{
+    return trace_file->memory_regions();
+}
+
+std::string trace_replay_kernel::name() const
+{
+    return "trace-replay";
+}
+
+std::ostream & trace_replay_kernel::print(
+    std::ostream & o) const
+{
+    // Describe the kernel that was recorded, so that the results are
+    // the same as those of the original kernel.
+    return o << trace_file->kernel_description();
+}
@@ -0,0 +1,55 @@
+#ifndef TRACE_REPLAY_HPP
+#define TRACE_REPLAY_HPP
+
+#include "kernel.hpp"
+#include "trace-config.hpp"
+#include "cache-simulation/replacement.hpp"
+#include "cache-simulation/trace-file.hpp"
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * A kernel whose memory references are replayed from a trace file that
+ * was recorded earlier, rather than generated from a matrix.  Since
+ * the kernel itself is not available, it can be traced, but it cannot
+ * be run or profiled.
+ */
+class trace_replay_kernel : public Kernel
+{
+public:
+    trace_replay_kernel(std::string const & trace_path);
+    ~trace_replay_kernel();
+
+    void init(TraceConfig const & trace_config,
+              std::ostream & o,
+              bool verbose) override;
+    void prepare(TraceConfig const & trace_config) override;
+    void run(TraceConfig const & trace_config) override;
+
+    replacement::MemoryReferenceString memory_reference_string(
+        TraceConfig const & trace_config,
+        int thread,
+        int num_threads) const override;
+
+    std::unique_ptr<replacement::MemoryReferenceGenerator>
+        memory_reference_generator(
+            TraceConfig const & trace_config,
+            int thread,
+            int num_threads) const override;
+
+    std::vector<replacement::MemoryRegion> memory_regions() const override;
+
+    std::string name() const override;
+
+    std::ostream & print(
+        std::ostream & o) const override;
+
+private:
+    std::string trace_path;
+    std::unique_ptr<replacement::TraceFile> trace_file;
+};
+
+#endif
@@ -4,9 +4,67 @@
 #include "cache-simulation/replacement.hpp"
 
 #include <algorithm>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <vector>
+
+namespace
+{
+
+class triad_memory_reference_generator
+    : public replacement::MemoryReferenceGenerator
+{
+public:
+    triad_memory_reference_generator(
+        triad::value_array_type const & a,
+        triad::value_array_type const & b,
+        triad::value_array_type const & c,
+        triad::size_type start_entry,
+        triad::size_type num_entries,
+        int numa_domain)
+        : a(a)
+        , b(b)
+        , c(c)
+        , start_entry(start_entry)
+        , num_entries(num_entries)
+        , numa_domain(numa_domain)
+    {
+    }
+
+    uint64_t size() const override
+    {
+        return 3 * uint64_t(num_entries);
+    }
+
+    void generate(
+        uint64_t offset,
+        uint64_t count,
+        replacement::MemoryReferenceString::value_type * w) const override
+    {
+        for (uint64_t t = offset, l = 0; l < count; ++t, ++l) {
+            triad::size_type k = start_entry + t / 3;
+            if (t % 3 == 0)
+                w[l] = replacement::MemoryReference(uintptr_t(&b[k]), numa_domain);
+            else if (t % 3 == 1)
+                w[l] = replacement::MemoryReference(uintptr_t(&c[k]), numa_domain);
+            else
+                w[l] = replacement::MemoryReference(
+                    uintptr_t(&a[k]), numa_domain, AccessType::store);
+        }
+    }
+
+private:
+    triad::value_array_type const & a;
+    triad::value_array_type const & b;
+    triad::value_array_type const & c;
+    triad::size_type start_entry;
+    triad::size_type num_entries;
+    int numa_domain;
+};
+
+}
 
 triad_kernel::triad_kernel(
     triad::size_type num_entries)
@@ -58,6 +116,19 @@ replacement::MemoryReferenceString triad_kernel::memory_reference_string(
     TraceConfig const & trace_config,
     int thread,
     int num_threads) const
+{
+    auto generator = memory_reference_generator(
+        trace_config, thread, num_threads);
+    auto w = replacement::MemoryReferenceString(generator->size());
+    generator->generate(0, w.size(), w.data());
+    return w;
+}
+
+std::unique_ptr<replacement::MemoryReferenceGenerator>
+triad_kernel::memory_reference_generator(
+    TraceConfig const & trace_config,
+    int thread,
+    int num_threads) const
 {
     auto const & thread_affinities = trace_config.thread_affinities();
 
@@ -70,13 +141,18 @@ replacement::MemoryReferenceString triad_kernel::memory_reference_string(
     triad::size_type thread_start_entry = std::min(num_entries, thread * entries_per_thread);
     triad::size_type thread_end_entry = std::min(num_entries, (thread + 1) * entries_per_thread);
     triad::size_type thread_num_entries = thread_end_entry - thread_start_entry;
-    auto w = std::vector<std::pair<uintptr_t, int>>(3 * thread_num_entries);
-    for (triad::size_type k = thread_start_entry, l = 0; k < thread_end_entry; ++k, l += 3) {
-        w[l+0] = std::make_pair(uintptr_t(&b[k]), numa_domain_affinity[thread]);
-        w[l+1] = std::make_pair(uintptr_t(&c[k]), numa_domain_affinity[thread]);
-        w[l+2] = std::make_pair(uintptr_t(&a[k]), numa_domain_affinity[thread]);
-    }
-    return w;
+    return std::unique_ptr<replacement::MemoryReferenceGenerator>(
+        new triad_memory_reference_generator(
+            a, b, c, thread_start_entry, thread_num_entries,
+            numa_domain_affinity[thread]));
+}
+
+std::vector<replacement::MemoryRegion> triad_kernel::memory_regions() const
+{
+    return std::vector<replacement::MemoryRegion>{
+        replacement::make_memory_region("a", a),
+        replacement::make_memory_region("b", b),
+        replacement::make_memory_region("c", c)};
 }
 
 std::string triad_kernel::name() const
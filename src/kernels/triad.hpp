@@ -7,7 +7,9 @@
 #include "util/aligned-allocator.hpp"
 
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace triad
 {
@@ -35,6 +37,14 @@ public:
         int thread,
         int num_threads) const override;
 
+    std::unique_ptr<replacement::MemoryReferenceGenerator>
+        memory_reference_generator(
+            TraceConfig const & trace_config,
+            int thread,
+            int num_threads) const override;
+
+    std::vector<replacement::MemoryRegion> memory_regions() const override;
+
     std::string name() const override;
     std::ostream & print(
         std::ostream & o) const override;
@@ -1,6 +1,7 @@
 #include "cache-trace.hpp"
 #include "profile-kernel.hpp"
 #include "trace-config.hpp"
+#include "validation.hpp"
 #include "kernels.hpp"
 #include "util/json-ostreambuf.hpp"
 #include "util/perf-events.hpp"
@@ -8,11 +9,13 @@
 #include <argp.h>
 
 #include <locale.h>
+#include <sys/stat.h>
 
 #include <algorithm>
 #include <cctype>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -34,6 +37,7 @@ enum kernel_type
     kernel_ell,
     kernel_mkl_csr,
     kernel_hybrid,
+    kernel_trace_replay,
 };
 
 struct arguments
@@ -44,7 +48,33 @@ struct arguments
         , matrix_path()
         , trace_config()
         , profile(0)
+        , estimate(false)
+        , validate(0)
         , warmup(false)
+        , hierarchy_mode(CacheHierarchyMode::independent)
+        , opt(false)
+        , reuse_distance(false)
+        , coherence(false)
+        , per_array(false)
+        , heatmap()
+        , heatmap_row_bins(64)
+        , heatmap_column_bins(64)
+        , record_trace()
+        , compress_trace(false)
+        , replay_trace()
+        , timing(false)
+        , interleaving_policy(replacement::InterleavingPolicy::round_robin)
+        , interleaving_samples(1)
+        , sample_period(0)
+        , sample_warmup(100000)
+        , sample_window(10000)
+        , sample_error(0.05)
+        , checkpoint()
+        , checkpoint_interval(600)
+        , resume(false)
+        , sim_threads(0)
+        , reference_memory(std::size_t(1) << 30)
+        , seed(0)
         , flush_caches(false)
         , list_perf_events(false)
         , verbose(false)
@@ -57,7 +87,33 @@ struct arguments
     std::string matrix_path;
     std::string trace_config;
     int profile;
+    bool estimate;
+    int validate;
     bool warmup;
+    CacheHierarchyMode hierarchy_mode;
+    bool opt;
+    bool reuse_distance;
+    bool coherence;
+    bool per_array;
+    std::string heatmap;
+    std::size_t heatmap_row_bins;
+    std::size_t heatmap_column_bins;
+    std::string record_trace;
+    bool compress_trace;
+    std::string replay_trace;
+    bool timing;
+    replacement::InterleavingPolicy interleaving_policy;
+    int interleaving_samples;
+    uint64_t sample_period;
+    uint64_t sample_warmup;
+    uint64_t sample_window;
+    double sample_error;
+    std::string checkpoint;
+    int checkpoint_interval;
+    bool resume;
+    int sim_threads;
+    std::size_t reference_memory;
+    uint64_t seed;
     bool flush_caches;
     bool list_perf_events;
     bool verbose;
@@ -74,7 +130,32 @@ enum class short_options
     /* Sparse matrix-vector multplication kernels. */
     non_printable_characters = 128,
     list_perf_events,
+    estimate,
+    validate,
     warmup,
+    hierarchy,
+    opt,
+    reuse_distance,
+    coherence,
+    per_array,
+    heatmap,
+    heatmap_bins,
+    record_trace,
+    compress_trace,
+    replay_trace,
+    timing,
+    interleaving,
+    interleaving_samples,
+    sample_period,
+    sample_warmup,
+    sample_window,
+    sample_error,
+    checkpoint,
+    checkpoint_interval,
+    resume,
+    sim_threads,
+    reference_memory,
+    seed,
     flush_caches,
     triad,
     spmv_format,
@@ -103,10 +184,205 @@ error_t parse_option(int key, char * arg, argp_state * state)
         }
         break;
 
+    case int(short_options::estimate):
+        args.estimate = true;
+        break;
+
+    case int(short_options::validate):
+        try {
+            args.validate = std::stoi(arg);
+        } catch (std::out_of_range const & e) {
+            argp_error(state, "validate: %s", strerror(errno));
+        } catch (std::invalid_argument const & e) {
+            argp_error(state, "Expected 'validate' to be an integer");
+        }
+        if (args.validate <= 0)
+            argp_error(state, "Expected 'validate' to be a positive integer");
+        break;
+
     case int(short_options::warmup):
         args.warmup = true;
         break;
 
+    case int(short_options::hierarchy):
+        if (strcmp(arg, "independent") == 0) args.hierarchy_mode = CacheHierarchyMode::independent;
+        else if (strcmp(arg, "non-inclusive") == 0) args.hierarchy_mode = CacheHierarchyMode::non_inclusive;
+        else if (strcmp(arg, "inclusive") == 0) args.hierarchy_mode = CacheHierarchyMode::inclusive;
+        else if (strcmp(arg, "exclusive") == 0) args.hierarchy_mode = CacheHierarchyMode::exclusive;
+        else argp_error(state, "hierarchy: invalid argument");
+        break;
+
+    case int(short_options::opt):
+        args.opt = true;
+        break;
+
+    case int(short_options::reuse_distance):
+        args.reuse_distance = true;
+        break;
+
+    case int(short_options::coherence):
+        args.coherence = true;
+        break;
+
+    case int(short_options::per_array):
+        args.per_array = true;
+        break;
+
+    case int(short_options::heatmap):
+        args.heatmap = arg;
+        break;
+
+    case int(short_options::heatmap_bins):
+        {
+            std::string bins(arg);
+            std::size_t comma = bins.find(',');
+            try {
+                args.heatmap_row_bins = std::stoul(bins.substr(0, comma));
+                args.heatmap_column_bins = comma == std::string::npos
+                    ? args.heatmap_row_bins
+                    : std::stoul(bins.substr(comma + 1));
+            } catch (std::out_of_range const & e) {
+                argp_error(state, "heatmap-bins: %s", strerror(errno));
+            } catch (std::invalid_argument const & e) {
+                argp_error(state, "Expected 'heatmap-bins' to be an integer or a pair of integers");
+            }
+            if (args.heatmap_row_bins == 0 || args.heatmap_column_bins == 0)
+                argp_error(state, "Expected 'heatmap-bins' to be positive");
+            break;
+        }
+
+    case int(short_options::record_trace):
+        args.record_trace = arg;
+        break;
+
+    case int(short_options::compress_trace):
+        args.compress_trace = true;
+        break;
+
+    case int(short_options::replay_trace):
+        args.kernel_type = kernel_trace_replay;
+        args.replay_trace = arg;
+        break;
+
+    case int(short_options::timing):
+        args.timing = true;
+        break;
+
+    case int(short_options::interleaving):
+        if (strcmp(arg, "round-robin") == 0) args.interleaving_policy = replacement::InterleavingPolicy::round_robin;
+        else if (strcmp(arg, "bandwidth") == 0) args.interleaving_policy = replacement::InterleavingPolicy::bandwidth;
+        else if (strcmp(arg, "random") == 0) args.interleaving_policy = replacement::InterleavingPolicy::random;
+        else argp_error(state, "interleaving: invalid argument");
+        break;
+
+    case int(short_options::interleaving_samples):
+        try {
+            args.interleaving_samples = std::stoi(arg);
+        } catch (std::out_of_range const & e) {
+            argp_error(state, "interleaving-samples: %s", strerror(errno));
+        } catch (std::invalid_argument const & e) {
+            argp_error(state, "Expected 'interleaving-samples' to be an integer");
+        }
+        if (args.interleaving_samples <= 0)
+            argp_error(state, "Expected 'interleaving-samples' to be a positive integer");
+        break;
+
+    case int(short_options::sample_period):
+        try {
+            args.sample_period = std::stoull(arg);
+        } catch (std::out_of_range const & e) {
+            argp_error(state, "sample-period: %s", strerror(errno));
+        } catch (std::invalid_argument const & e) {
+            argp_error(state, "Expected 'sample-period' to be an integer");
+        }
+        break;
+
+    case int(short_options::sample_warmup):
+        try {
+            args.sample_warmup = std::stoull(arg);
+        } catch (std::out_of_range const & e) {
+            argp_error(state, "sample-warmup: %s", strerror(errno));
+        } catch (std::invalid_argument const & e) {
+            argp_error(state, "Expected 'sample-warmup' to be an integer");
+        }
+        break;
+
+    case int(short_options::sample_window):
+        try {
+            args.sample_window = std::stoull(arg);
+        } catch (std::out_of_range const & e) {
+            argp_error(state, "sample-window: %s", strerror(errno));
+        } catch (std::invalid_argument const & e) {
+            argp_error(state, "Expected 'sample-window' to be an integer");
+        }
+        if (args.sample_window == 0)
+            argp_error(state, "Expected 'sample-window' to be a positive integer");
+        break;
+
+    case int(short_options::sample_error):
+        try {
+            args.sample_error = std::stod(arg);
+        } catch (std::out_of_range const & e) {
+            argp_error(state, "sample-error: %s", strerror(errno));
+        } catch (std::invalid_argument const & e) {
+            argp_error(state, "Expected 'sample-error' to be a number");
+        }
+        if (args.sample_error <= 0.0)
+            argp_error(state, "Expected 'sample-error' to be positive");
+        break;
+
+    case int(short_options::sim_threads):
+        try {
+            args.sim_threads = std::stoi(arg);
+        } catch (std::out_of_range const & e) {
+            argp_error(state, "sim-threads: %s", strerror(errno));
+        } catch (std::invalid_argument const & e) {
+            argp_error(state, "Expected 'sim-threads' to be an integer");
+        }
+        if (args.sim_threads <= 0)
+            argp_error(state, "Expected 'sim-threads' to be a positive integer");
+        break;
+
+    case int(short_options::reference_memory):
+        try {
+            args.reference_memory = std::size_t(std::stoul(arg)) << 20;
+        } catch (std::out_of_range const & e) {
+            argp_error(state, "reference-memory: %s", strerror(errno));
+        } catch (std::invalid_argument const & e) {
+            argp_error(state, "Expected 'reference-memory' to be an integer");
+        }
+        break;
+
+    case int(short_options::checkpoint):
+        args.checkpoint = arg;
+        break;
+
+    case int(short_options::checkpoint_interval):
+        try {
+            args.checkpoint_interval = std::stoi(arg);
+        } catch (std::out_of_range const & e) {
+            argp_error(state, "checkpoint-interval: %s", strerror(errno));
+        } catch (std::invalid_argument const & e) {
+            argp_error(state, "Expected 'checkpoint-interval' to be an integer");
+        }
+        if (args.checkpoint_interval <= 0)
+            argp_error(state, "Expected 'checkpoint-interval' to be a positive integer");
+        break;
+
+    case int(short_options::resume):
+        args.resume = true;
+        break;
+
+    case int(short_options::seed):
+        try {
+            args.seed = std::stoull(arg);
+        } catch (std::out_of_range const & e) {
+            argp_error(state, "seed: %s", strerror(errno));
+        } catch (std::invalid_argument const & e) {
+            argp_error(state, "Expected 'seed' to be an integer");
+        }
+        break;
+
     case int(short_options::flush_caches):
         args.flush_caches = true;
         break;
@@ -151,6 +427,34 @@ error_t parse_option(int key, char * arg, argp_state * state)
             break;
         if (args.trace_config.empty())
             argp_error(state, "Please specify --trace-config");
+        if (args.coherence && args.hierarchy_mode == CacheHierarchyMode::independent)
+            argp_error(state, "Please specify --hierarchy together with --coherence");
+        if (args.timing && args.hierarchy_mode == CacheHierarchyMode::independent)
+            argp_error(state, "Please specify --hierarchy together with --timing");
+        if (args.interleaving_samples > 1 &&
+            args.interleaving_policy != replacement::InterleavingPolicy::random)
+        {
+            argp_error(state, "Please specify --interleaving=random together with --interleaving-samples");
+        }
+        if (args.sample_period > 0 &&
+            args.sample_period < args.sample_warmup + args.sample_window)
+        {
+            argp_error(state, "Expected 'sample-period' to be at least 'sample-warmup' plus 'sample-window'");
+        }
+        if (args.sample_period > 0 && args.timing)
+            argp_error(state, "Please do not specify --sample-period together with --timing");
+        if (args.resume && args.checkpoint.empty())
+            argp_error(state, "Please specify --checkpoint together with --resume");
+        if (!args.checkpoint.empty() && (args.timing || args.sample_period > 0))
+            argp_error(state, "Please do not specify --checkpoint together with --timing or --sample-period");
+        if (args.compress_trace && args.record_trace.empty())
+            argp_error(state, "Please specify --record-trace together with --compress-trace");
+        if (args.estimate && args.profile > 0)
+            argp_error(state, "Please do not specify --estimate together with --profile");
+        if (args.validate > 0 && args.profile > 0)
+            argp_error(state, "Please do not specify --validate together with --profile");
+        if (!args.replay_trace.empty() && (args.profile > 0 || args.validate > 0))
+            argp_error(state, "Please do not specify --replay-trace together with --profile or --validate");
         break;
 
     default:
@@ -159,6 +463,68 @@ error_t parse_option(int key, char * arg, argp_state * state)
     return 0;
 }
 
+/*
+ * The options of the cache simulations given on the command line.
+ */
+CacheTraceOptions cache_trace_options(
+    arguments const & args)
+{
+    CacheTraceOptions options;
+    options.warmup = args.warmup;
+    options.hierarchy_mode = args.hierarchy_mode;
+    options.opt = args.opt;
+    options.reuse_distance = args.reuse_distance;
+    options.coherence = args.coherence;
+    options.per_array = args.per_array;
+    options.heatmap_row_bins = args.heatmap.empty() ? 0 : args.heatmap_row_bins;
+    options.heatmap_column_bins = args.heatmap.empty() ? 0 : args.heatmap_column_bins;
+    options.timing = args.timing;
+    options.interleaving_policy = args.interleaving_policy;
+    options.interleaving_samples = args.interleaving_samples;
+    options.sampling = replacement::Sampling(
+        args.sample_period, args.sample_warmup, args.sample_window,
+        args.sample_error);
+    options.checkpoint = replacement::Checkpoint(
+        args.checkpoint, args.checkpoint_interval, args.resume);
+    options.sim_threads = args.sim_threads;
+    options.reference_memory = args.reference_memory;
+    options.seed = args.seed;
+    options.verbose = args.verbose;
+    options.progress_interval = args.progress_interval;
+    return options;
+}
+
+/*
+ * Print a cache trace, or, with --validate, compare it with the cache
+ * misses measured in profiling runs of the kernel.  Without --warmup,
+ * the caches are flushed before each profiling run, to match the cold
+ * caches of the simulation.
+ */
+void print_cache_trace(
+    arguments const & args,
+    TraceConfig const & trace_config,
+    Kernel & kernel,
+    CacheTrace const & cache_trace)
+{
+    if (args.validate > 0) {
+        perf::libpfm_context libpfm_context;
+        Profiling profiling = profile_cache_misses(
+            trace_config,
+            kernel,
+            args.warmup,
+            args.flush_caches || !args.warmup,
+            args.validate,
+            libpfm_context,
+            std::cerr,
+            args.verbose);
+        auto o = json_ostreambuf(std::cout);
+        std::cout << Validation(cache_trace, profiling) << '\n';
+    } else {
+        auto o = json_ostreambuf(std::cout);
+        std::cout << cache_trace << '\n';
+    }
+}
+
 int main(int argc, char ** argv)
 {
     setlocale(LC_ALL, "");
@@ -170,8 +536,60 @@ int main(int argc, char ** argv)
          "Read cache parameters from a configuration file in JSON format."},
         {"profile", int(short_options::profile), "N", 0,
          "Measure cache misses using hardware performance counters", 0},
+        {"estimate", int(short_options::estimate), nullptr, 0,
+         "Estimate cache misses from the structure of the matrix, instead of simulating the caches (CSR only)", 0},
+        {"validate", int(short_options::validate), "N", 0,
+         "Compare the simulated cache misses with those measured by the \"cache_miss_event\" of each cache in N profiling runs", 0},
         {"warmup", int(short_options::warmup), nullptr, 0,
          "Warm up the cache before tracing or profiling", 0},
+        {"hierarchy", int(short_options::hierarchy), "MODE", 0,
+         "Simulate caches independently, or as a hierarchy with a non-inclusive, inclusive or exclusive last-level cache. "
+         "Choose one of: independent (default), non-inclusive, inclusive and exclusive", 0},
+        {"opt", int(short_options::opt), nullptr, 0,
+         "Also simulate each cache with optimal (Belady) replacement, as a lower bound on its cache misses", 0},
+        {"reuse-distance", int(short_options::reuse_distance), nullptr, 0,
+         "Compute reuse distance histograms and LRU cache misses for all cache sizes", 0},
+        {"coherence", int(short_options::coherence), nullptr, 0,
+         "Keep the caches of each cache hierarchy coherent, and count invalidations, coherence misses and false sharing", 0},
+        {"per-array", int(short_options::per_array), nullptr, 0,
+         "Attribute the cache misses of each cache to the arrays of the kernel", 0},
+        {"heatmap", int(short_options::heatmap), "PATH", 0,
+         "Write the cache misses of each cache per block of rows and columns of the matrix to a file in CSV format", 0},
+        {"heatmap-bins", int(short_options::heatmap_bins), "ROWS[,COLUMNS]", 0,
+         "Divide the rows and columns of the matrix into this many blocks for --heatmap (default: 64,64)", 0},
+        {"record-trace", int(short_options::record_trace), "PATH", 0,
+         "Record the memory references of every thread of the kernel to a binary trace file, and exit, unless --estimate, --profile or --validate is also given", 0},
+        {"compress-trace", int(short_options::compress_trace), nullptr, 0,
+         "Compress the trace file written by --record-trace with zlib", 0},
+        {"replay-trace", int(short_options::replay_trace), "PATH", 0,
+         "Replay the memory references of a trace file written by --record-trace, instead of running a kernel", 0},
+        {"timing", int(short_options::timing), nullptr, 0,
+         "Predict the execution time of each thread from the latencies and bandwidths of the caches and NUMA domains", 0},
+        {"interleaving", int(short_options::interleaving), "MODE", 0,
+         "Interleave the memory references of threads that share a cache in turn, in proportion to the bandwidth of the NUMA domains they access, or at random. "
+         "Choose one of: round-robin (default), bandwidth and random", 0},
+        {"interleaving-samples", int(short_options::interleaving_samples), "N", 0,
+         "Repeat the cache simulations with N random interleavings, and report the mean and variance of the cache misses (default: 1)", 0},
+        {"sample-period", int(short_options::sample_period), "N", 0,
+         "Sample the cache simulations by only counting a detailed window at the end of every N memory references, and extrapolating the counts (default: 0, which disables sampling)", 0},
+        {"sample-warmup", int(short_options::sample_warmup), "N", 0,
+         "Simulate N memory references before each detailed window without counting them (default: 100000)", 0},
+        {"sample-window", int(short_options::sample_window), "N", 0,
+         "Count N memory references in each detailed window (default: 10000)", 0},
+        {"sample-error", int(short_options::sample_error), "E", 0,
+         "Warn if the relative error of the sampled cache misses at 95 % confidence exceeds E, and flag those caches in the output (default: 0.05)", 0},
+        {"sim-threads", int(short_options::sim_threads), "N", 0,
+         "Simulate up to N caches concurrently (default: number of available CPUs)", 0},
+        {"reference-memory", int(short_options::reference_memory), "MIB", 0,
+         "Share memory reference strings between simulations, using up to MIB mebibytes (default: 1024)", 0},
+        {"checkpoint", int(short_options::checkpoint), "DIR", 0,
+         "Periodically save checkpoints of the cache simulations to the directory DIR", 0},
+        {"checkpoint-interval", int(short_options::checkpoint_interval), "SECONDS", 0,
+         "Save a checkpoint of each cache simulation every SECONDS seconds (default: 600)", 0},
+        {"resume", int(short_options::resume), nullptr, 0,
+         "Resume the cache simulations from the checkpoints in the directory given by --checkpoint", 0},
+        {"seed", int(short_options::seed), "N", 0,
+         "Seed the random number generators of caches with random replacement and of random interleavings (default: 0)", 0},
         {"flush-caches", int(short_options::flush_caches),  nullptr, 0,
          "Flush caches between each profiling run", 0},
         {"list-perf-events", int(short_options::list_perf_events), nullptr, 0,
@@ -229,6 +647,16 @@ int main(int argc, char ** argv)
     case kernel_hybrid:
         kernel = std::make_unique<hybrid_spmv_kernel>(args.matrix_path);
         break;
+    case kernel_trace_replay:
+        kernel = std::make_unique<trace_replay_kernel>(args.replay_trace);
+        break;
+    }
+
+    if (!args.checkpoint.empty() &&
+        mkdir(args.checkpoint.c_str(), 0777) != 0 && errno != EEXIST)
+    {
+        std::cerr << args.checkpoint << ": " << strerror(errno) << '\n';
+        return EXIT_FAILURE;
     }
 
     try {
@@ -236,12 +664,58 @@ int main(int argc, char ** argv)
 
         kernel->init(trace_config, std::cerr, args.verbose);
 
-        if (args.profile == 0) {
+        if (!args.record_trace.empty()) {
+            std::ofstream f(args.record_trace, std::ios::binary);
+            record_trace(f, trace_config, *(kernel.get()),
+                         args.compress_trace, args.verbose);
+            if (!f) {
+                std::cerr << args.record_trace << ": " << strerror(errno) << '\n';
+                return EXIT_FAILURE;
+            }
+
+            // A trace is usually recorded once, to be simulated
+            // elsewhere, so only continue if asked to.
+            if (!args.estimate && args.profile == 0 && args.validate == 0)
+                return EXIT_SUCCESS;
+        }
+
+        if (args.estimate) {
+            CacheTrace cache_trace = estimate_cache_misses(
+                trace_config, *(kernel.get()), args.verbose);
+            print_cache_trace(args, trace_config, *(kernel.get()), cache_trace);
+        }
+        else if (args.profile == 0) {
             CacheTrace cache_trace = trace_cache_misses(
-                trace_config, *(kernel.get()), args.warmup,
-                args.verbose, args.progress_interval);
-            auto o = json_ostreambuf(std::cout);
-            std::cout << cache_trace << '\n';
+                trace_config, *(kernel.get()), cache_trace_options(args));
+
+            // Suggest a shorter sampling period, and thus more
+            // detailed windows, for caches whose cache misses are not
+            // estimated to within the requested error.  The error
+            // decreases with the square root of the number of windows.
+            for (auto const & estimate : cache_trace.sampling_estimates()) {
+                if (estimate.second.meets_target(cache_trace.sampling()))
+                    continue;
+                double error = estimate.second.relative_error();
+                uint64_t period = args.sample_period *
+                    (args.sample_error / error) * (args.sample_error / error);
+                std::cerr << estimate.first << ": "
+                          << "The relative error of the sampled cache misses ("
+                          << error << ") exceeds " << args.sample_error
+                          << ", consider a sampling period of at most "
+                          << std::max(period, args.sample_warmup + args.sample_window)
+                          << '\n';
+            }
+
+            if (!args.heatmap.empty()) {
+                std::ofstream f(args.heatmap);
+                write_heatmaps(f, cache_trace);
+                if (!f) {
+                    std::cerr << args.heatmap << ": " << strerror(errno) << '\n';
+                    return EXIT_FAILURE;
+                }
+            }
+
+            print_cache_trace(args, trace_config, *(kernel.get()), cache_trace);
         }
         else {
             perf::libpfm_context libpfm_context;
@@ -261,6 +735,12 @@ int main(int argc, char ** argv)
     } catch (trace_config_error const & e) {
         std::cerr << args.trace_config << ": " << e.what() << '\n';
         return EXIT_FAILURE;
+    } catch (replacement::checkpoint_error const & e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    } catch (replacement::trace_file_error const & e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
     } catch (kernel_error const & e) {
         std::cerr << kernel->name() << ": " << e.what() << '\n';
         return EXIT_FAILURE;
@@ -78,7 +78,23 @@ std::size_t Matrix::index_padding_size() const
         + sizeof(decltype(row_index)::value_type) * num_padding_entries();
 }
 
-std::vector<std::pair<uintptr_t, int>>
+std::size_t Matrix::spmv_memory_reference_string_size(
+    int thread,
+    int num_threads) const
+{
+    index_type num_entries_per_thread = (num_entries + num_threads - 1) / num_threads;
+    index_type thread_start_entry = std::min(num_entries, thread * num_entries_per_thread);
+    index_type thread_end_entry = std::min(num_entries, (thread + 1) * num_entries_per_thread);
+    std::size_t thread_num_entries = thread_end_entry - thread_start_entry;
+
+    index_type rows_per_thread = (rows + num_threads - 1) / num_threads;
+    index_type start_row = std::min(rows, thread * rows_per_thread);
+    index_type end_row = std::min(rows, (thread + 1) * rows_per_thread);
+    std::size_t thread_num_rows = end_row - start_row;
+    return 5 * thread_num_entries + 2 * thread_num_rows * num_threads;
+}
+
+std::vector<MemoryReference>
 Matrix::spmv_memory_reference_string(
     value_array_type const & x,
     value_array_type const & y,
@@ -87,60 +103,109 @@ Matrix::spmv_memory_reference_string(
     int num_threads,
     int const * numa_domains,
     int page_size) const
+{
+    std::size_t num_references =
+        spmv_memory_reference_string_size(thread, num_threads);
+    std::vector<MemoryReference> w(num_references);
+    spmv_memory_reference_substring(
+        x, y, workspace, thread, num_threads, numa_domains, page_size,
+        0, num_references, w.data());
+    return w;
+}
+
+void Matrix::spmv_memory_reference_substring(
+    value_array_type const & x,
+    value_array_type const & y,
+    value_array_type const & workspace,
+    int thread,
+    int num_threads,
+    int const * numa_domains,
+    int page_size,
+    std::size_t offset,
+    std::size_t count,
+    MemoryReference * w) const
 {
     index_type num_entries_per_thread = (num_entries + num_threads - 1) / num_threads;
     index_type thread_start_entry = std::min(num_entries, thread * num_entries_per_thread);
     index_type thread_end_entry = std::min(num_entries, (thread + 1) * num_entries_per_thread);
-    index_type thread_num_entries = thread_end_entry - thread_start_entry;
+    std::size_t thread_num_entries = thread_end_entry - thread_start_entry;
 
     index_type rows_per_thread = (rows + num_threads - 1) / num_threads;
     index_type start_row = std::min(rows, thread * rows_per_thread);
     index_type end_row = std::min(rows, (thread + 1) * rows_per_thread);
     index_type thread_num_rows = end_row - start_row;
 
-    std::vector<std::pair<uintptr_t, int>> w(
-        5 * thread_num_entries + 2 * thread_num_rows * num_threads,
-        std::make_pair(0,0));
-    size_t l = 0;
-    for (size_type k = thread_start_entry; k < thread_end_entry; ++k, l += 5) {
-        index_type i = row_index[k];
-        index_type j = column_index[k];
-        w[l+0] = std::make_pair(
-            uintptr_t(&row_index[k]),
-            numa_domains[thread]);
-        w[l+1] = std::make_pair(
-            uintptr_t(&column_index[k]),
-            numa_domains[thread]);
-        w[l+2] = std::make_pair(
-            uintptr_t(&value[k]),
-            numa_domains[thread]);
-        int column_thread = thread_of_index<value_type>(
-            x.data(), columns, j, num_threads, page_size);
-        w[l+3] = std::make_pair(
-            uintptr_t(&x[j]),
-            numa_domains[column_thread]);
-        w[l+4] = std::make_pair(
-            uintptr_t(&workspace[thread*rows+i]),
-            numa_domains[thread]);
-    }
-
-    for (index_type i = start_row; i < end_row; i++) {
-        for (size_type j = 0; j < num_threads; j++, l += 2) {
-            int t0 = thread_of_index<value_type>(
-                workspace.data(), num_threads*thread_num_rows, j*rows+i,
-                num_threads, page_size);
-            w[l+0] =  std::make_pair(
-                uintptr_t(&workspace[j*rows+i]),
-                numa_domains[t0]);
-            w[l+1] =  std::make_pair(
-                uintptr_t(&y[i]),
-                numa_domains[thread]);
+    // Five references for each nonzero, followed by two references
+    // for each row and thread to reduce the per-thread workspaces.
+    for (std::size_t t = offset, l = 0; l < count; ++t, ++l) {
+        if (t < 5 * thread_num_entries) {
+            size_type k = thread_start_entry + t / 5;
+            index_type i = row_index[k];
+            index_type j = column_index[k];
+            switch (t % 5) {
+            case 0:
+                w[l] = MemoryReference(
+                    uintptr_t(&row_index[k]),
+                    numa_domains[thread]);
+                break;
+            case 1:
+                w[l] = MemoryReference(
+                    uintptr_t(&column_index[k]),
+                    numa_domains[thread]);
+                break;
+            case 2:
+                w[l] = MemoryReference(
+                    uintptr_t(&value[k]),
+                    numa_domains[thread]);
+                break;
+            case 3: {
+                int column_thread = thread_of_index<value_type>(
+                    x.data(), columns, j, num_threads, page_size);
+                w[l] = MemoryReference(
+                    uintptr_t(&x[j]),
+                    numa_domains[column_thread]);
+                break;
+            }
+            case 4:
+                w[l] = MemoryReference(
+                    uintptr_t(&workspace[thread*rows+i]),
+                    numa_domains[thread],
+                    AccessType::store);
+                break;
+            }
+        } else {
+            std::size_t u = t - 5 * thread_num_entries;
+            index_type i = start_row + (u / 2) / num_threads;
+            size_type j = (u / 2) % num_threads;
+            if (u % 2 == 0) {
+                int t0 = thread_of_index<value_type>(
+                    workspace.data(), num_threads*thread_num_rows, j*rows+i,
+                    num_threads, page_size);
+                w[l] = MemoryReference(
+                    uintptr_t(&workspace[j*rows+i]),
+                    numa_domains[t0]);
+            } else {
+                w[l] = MemoryReference(
+                    uintptr_t(&y[i]),
+                    numa_domains[thread],
+                    AccessType::store);
+            }
         }
     }
-    return w;
 }
 
-std::vector<std::pair<uintptr_t, int>>
+std::size_t Matrix::spmv_atomic_memory_reference_string_size(
+    int thread,
+    int num_threads) const
+{
+    index_type num_entries_per_thread = (num_entries + num_threads - 1) / num_threads;
+    index_type thread_start_entry = std::min(num_entries, thread * num_entries_per_thread);
+    index_type thread_end_entry = std::min(num_entries, (thread + 1) * num_entries_per_thread);
+    std::size_t thread_num_entries = thread_end_entry - thread_start_entry;
+    return 5 * thread_num_entries;
+}
+
+std::vector<MemoryReference>
 Matrix::spmv_atomic_memory_reference_string(
     value_array_type const & x,
     value_array_type const & y,
@@ -148,40 +213,69 @@ Matrix::spmv_atomic_memory_reference_string(
     int num_threads,
     int const * numa_domains,
     int page_size) const
+{
+    std::size_t num_references =
+        spmv_atomic_memory_reference_string_size(thread, num_threads);
+    std::vector<MemoryReference> w(num_references);
+    spmv_atomic_memory_reference_substring(
+        x, y, thread, num_threads, numa_domains, page_size,
+        0, num_references, w.data());
+    return w;
+}
+
+void Matrix::spmv_atomic_memory_reference_substring(
+    value_array_type const & x,
+    value_array_type const & y,
+    int thread,
+    int num_threads,
+    int const * numa_domains,
+    int page_size,
+    std::size_t offset,
+    std::size_t count,
+    MemoryReference * w) const
 {
     index_type num_entries_per_thread = (num_entries + num_threads - 1) / num_threads;
     index_type thread_start_entry = std::min(num_entries, thread * num_entries_per_thread);
-    index_type thread_end_entry = std::min(num_entries, (thread + 1) * num_entries_per_thread);
-    index_type thread_num_entries = thread_end_entry - thread_start_entry;
 
-    std::vector<std::pair<uintptr_t, int>> w(
-        5 * thread_num_entries, std::make_pair(0,0));
-    for (size_type k = thread_start_entry, l = 0;
-         k < thread_end_entry; ++k, l += 5)
-    {
+    for (std::size_t t = offset, l = 0; l < count; ++t, ++l) {
+        size_type k = thread_start_entry + t / 5;
         index_type i = row_index[k];
         index_type j = column_index[k];
-        w[l+0] = std::make_pair(
-            uintptr_t(&row_index[k]),
-            numa_domains[thread]);
-        w[l+1] = std::make_pair(
-            uintptr_t(&column_index[k]),
-            numa_domains[thread]);
-        w[l+2] = std::make_pair(
-            uintptr_t(&value[k]),
-            numa_domains[thread]);
-        int column_thread = thread_of_index<value_type>(
-            x.data(), columns, j, num_threads, page_size);
-        w[l+3] = std::make_pair(
-            uintptr_t(&x[j]),
-            numa_domains[column_thread]);
-        int row_thread = thread_of_index<value_type>(
-            y.data(), rows, i, num_threads, page_size);
-        w[l+4] = std::make_pair(
-            uintptr_t(&y[i]),
-            numa_domains[row_thread]);
+        switch (t % 5) {
+        case 0:
+            w[l] = MemoryReference(
+                uintptr_t(&row_index[k]),
+                numa_domains[thread]);
+            break;
+        case 1:
+            w[l] = MemoryReference(
+                uintptr_t(&column_index[k]),
+                numa_domains[thread]);
+            break;
+        case 2:
+            w[l] = MemoryReference(
+                uintptr_t(&value[k]),
+                numa_domains[thread]);
+            break;
+        case 3: {
+            int column_thread = thread_of_index<value_type>(
+                x.data(), columns, j, num_threads, page_size);
+            w[l] = MemoryReference(
+                uintptr_t(&x[j]),
+                numa_domains[column_thread]);
+            break;
+        }
+        case 4: {
+            int row_thread = thread_of_index<value_type>(
+                y.data(), rows, i, num_threads, page_size);
+            w[l] = MemoryReference(
+                uintptr_t(&y[i]),
+                numa_domains[row_thread],
+                AccessType::store);
+            break;
+        }
+        }
     }
-    return w;
 }
 
 bool operator==(Matrix const & a, Matrix const & b)
@@ -2,6 +2,7 @@
 #define COORDINATE_MATRIX_HPP
 
 #include "util/aligned-allocator.hpp"
+#include "util/memory-reference.hpp"
 
 #include <cstdint>
 #include <iosfwd>
@@ -43,7 +44,11 @@ public:
     std::size_t value_padding_size() const;
     std::size_t index_padding_size() const;
 
-    std::vector<std::pair<uintptr_t, int>> spmv_memory_reference_string(
+    std::size_t spmv_memory_reference_string_size(
+        int thread,
+        int num_threads) const;
+
+    std::vector<MemoryReference> spmv_memory_reference_string(
         value_array_type const & x,
         value_array_type const & y,
         value_array_type const & workspace,
@@ -52,7 +57,28 @@ public:
         int const * numa_domains,
         int page_size) const;
 
-    std::vector<std::pair<uintptr_t, int>> spmv_atomic_memory_reference_string(
+    /*
+     * Generate `count' references of the memory reference string of
+     * the given thread, starting at `offset', without generating the
+     * preceding part of the string.
+     */
+    void spmv_memory_reference_substring(
+        value_array_type const & x,
+        value_array_type const & y,
+        value_array_type const & workspace,
+        int thread,
+        int num_threads,
+        int const * numa_domains,
+        int page_size,
+        std::size_t offset,
+        std::size_t count,
+        MemoryReference * w) const;
+
+    std::size_t spmv_atomic_memory_reference_string_size(
+        int thread,
+        int num_threads) const;
+
+    std::vector<MemoryReference> spmv_atomic_memory_reference_string(
         value_array_type const & x,
         value_array_type const & y,
         int thread,
@@ -60,6 +86,17 @@ public:
         int const * numa_domains,
         int page_size) const;
 
+    void spmv_atomic_memory_reference_substring(
+        value_array_type const & x,
+        value_array_type const & y,
+        int thread,
+        int num_threads,
+        int const * numa_domains,
+        int page_size,
+        std::size_t offset,
+        std::size_t count,
+        MemoryReference * w) const;
+
 public:
     index_type rows;
     index_type columns;
@@ -2,6 +2,10 @@
 #include "matrix-market.hpp"
 #include "matrix-error.hpp"
 
+#include "util/flat-hash-map.hpp"
+
+#include <algorithm>
+#include <cstdint>
 #include <iterator>
 #include <ostream>
 #include <stdexcept>
@@ -94,7 +98,16 @@ size_type Matrix::spmv_nonzeros_per_thread(int thread, int num_threads) const
     return nonzeros;
 }
 
-std::vector<std::pair<uintptr_t, int>>
+std::size_t Matrix::spmv_memory_reference_string_size(
+    int thread,
+    int num_threads) const
+{
+    std::size_t rows = spmv_rows_per_thread(thread, num_threads);
+    std::size_t nonzeros = spmv_nonzeros_per_thread(thread, num_threads);
+    return 3 * nonzeros + 2 * rows + 1;
+}
+
+std::vector<MemoryReference>
 Matrix::spmv_memory_reference_string(
     value_array_type const & x,
     value_array_type const & y,
@@ -102,44 +115,234 @@ Matrix::spmv_memory_reference_string(
     int num_threads,
     int const * numa_domains,
     int page_size) const
+{
+    std::size_t num_references =
+        spmv_memory_reference_string_size(thread, num_threads);
+    auto w = std::vector<MemoryReference>(num_references);
+    spmv_memory_reference_substring(
+        x, y, thread, num_threads, numa_domains, page_size,
+        0, num_references, w.data());
+    return w;
+}
+
+void Matrix::spmv_memory_reference_substring(
+    value_array_type const & x,
+    value_array_type const & y,
+    int thread,
+    int num_threads,
+    int const * numa_domains,
+    int page_size,
+    std::size_t offset,
+    std::size_t count,
+    MemoryReference * w) const
 {
     index_type rows_per_thread = (rows + num_threads - 1) / num_threads;
     index_type start_row = std::min(rows, thread * rows_per_thread);
     index_type end_row = std::min(rows, (thread + 1) * rows_per_thread);
-    index_type rows = end_row - start_row;
     size_type start_nonzero = row_ptr[start_row];
-    size_type end_nonzero = row_ptr[end_row];
-    size_type nonzeros = end_nonzero - start_nonzero;
+    std::size_t end = offset + count;
+    auto in_range = [offset, end] (std::size_t t) {
+        return offset <= t && t < end; };
 
-    size_type num_references = 3 * nonzeros + 2 * rows + 1;
-    auto w = std::vector<std::pair<uintptr_t, int>>(
-        num_references, std::make_pair(0,0));
-    size_type l = 0;
-    w[l++] = std::make_pair(uintptr_t(&row_ptr[start_row]),
-                            numa_domains[thread]);
-    for (index_type i = start_row; i < end_row; ++i) {
-        w[l++] = std::make_pair(
-            uintptr_t(&row_ptr[i+1]),
+    if (in_range(0)) {
+        w[0] = MemoryReference(
+            uintptr_t(&row_ptr[start_row]),
             numa_domains[thread]);
-        for (size_type k = row_ptr[i]; k < row_ptr[i+1]; ++k) {
-            index_type j = column_index[k];
-            w[l++] = std::make_pair(
-                uintptr_t(&column_index[k]),
-                numa_domains[thread]);
-            w[l++] = std::make_pair(
-                uintptr_t(&value[k]),
+    }
+
+    // Find the last row whose references begin at or before the
+    // offset, since each row is preceded by two references per
+    // row and three references per nonzero.
+    auto row_position = [&] (index_type i) {
+        return 1 + 2 * std::size_t(i - start_row) +
+            3 * std::size_t(row_ptr[i] - start_nonzero); };
+    index_type first_row = start_row;
+    index_type last_row = end_row;
+    while (last_row - first_row > 1) {
+        index_type i = first_row + (last_row - first_row) / 2;
+        if (row_position(i) <= offset)
+            first_row = i;
+        else
+            last_row = i;
+    }
+
+    std::size_t t = row_position(first_row);
+    for (index_type i = first_row; i < end_row && t < end; ++i) {
+        if (in_range(t)) {
+            w[t-offset] = MemoryReference(
+                uintptr_t(&row_ptr[i+1]),
                 numa_domains[thread]);
-            int column_thread = thread_of_index<value_type>(
-                x.data(), columns, j, num_threads, page_size);
-            w[l++] = std::make_pair(
-                uintptr_t(&x[j]),
-                numa_domains[column_thread]);
         }
-        w[l++] = std::make_pair(
-            uintptr_t(&y[i]),
-            numa_domains[thread]);
+        t++;
+
+        size_type k = row_ptr[i];
+        if (t < offset) {
+            size_type skip = std::min<std::size_t>(
+                (offset - t) / 3, row_ptr[i+1] - k);
+            k += skip;
+            t += 3 * std::size_t(skip);
+        }
+        for (; k < row_ptr[i+1] && t < end; ++k, t += 3) {
+            if (in_range(t+0)) {
+                w[t+0-offset] = MemoryReference(
+                    uintptr_t(&column_index[k]),
+                    numa_domains[thread]);
+            }
+            if (in_range(t+1)) {
+                w[t+1-offset] = MemoryReference(
+                    uintptr_t(&value[k]),
+                    numa_domains[thread]);
+            }
+            if (in_range(t+2)) {
+                index_type j = column_index[k];
+                int column_thread = thread_of_index<value_type>(
+                    x.data(), columns, j, num_threads, page_size);
+                w[t+2-offset] = MemoryReference(
+                    uintptr_t(&x[j]),
+                    numa_domains[column_thread]);
+            }
+        }
+        if (k < row_ptr[i+1])
+            break;
+
+        if (in_range(t)) {
+            w[t-offset] = MemoryReference(
+                uintptr_t(&y[i]),
+                numa_domains[thread],
+                AccessType::store);
+        }
+        t++;
+    }
+}
+
+namespace
+{
+
+/*
+ * The number of cache lines occupied by the bytes in `[begin, end)'.
+ */
+uint64_t num_cache_lines(
+    void const * begin,
+    void const * end,
+    std::size_t line_size)
+{
+    if (begin == end)
+        return 0;
+    return (uintptr_t(end) - 1u) / line_size - uintptr_t(begin) / line_size + 1u;
+}
+
+/*
+ * The distinct cache lines of the source vector that were used in the
+ * current and the previous block of rows of a thread, for one cache.
+ */
+struct SourceVectorBlocks
+{
+    SourceVectorBlocks(std::size_t cache_size, std::size_t line_size)
+        : line_size(line_size)
+        , capacity(0.5 * double(cache_size) / double(line_size))
+        , streamed(0.0)
+        , current(UINT64_MAX)
+        , previous(UINT64_MAX)
+    {
+    }
+
+    /*
+     * Start a new block once the current block fills its half of the
+     * cache.
+     */
+    void stream(double lines)
+    {
+        streamed += lines;
+        if (streamed + current.size() >= capacity) {
+            std::swap(current, previous);
+            current.clear();
+            streamed = 0.0;
+        }
+    }
+
+    /*
+     * Use a cache line of the source vector, and return whether it
+     * misses.
+     */
+    bool use(uint64_t line)
+    {
+        if (current.find(line))
+            return false;
+        bool miss = !previous.find(line);
+        current.insert(line, true);
+        return miss;
+    }
+
+    std::size_t line_size;
+    double capacity;
+    double streamed;
+    FlatHashMap<uint64_t, bool> current;
+    FlatHashMap<uint64_t, bool> previous;
+};
+
+}
+
+void Matrix::spmv_estimate_cache_misses(
+    value_array_type const & x,
+    value_array_type const & y,
+    int thread,
+    int num_threads,
+    int const * numa_domains,
+    int page_size,
+    std::vector<std::size_t> const & cache_sizes,
+    std::vector<std::size_t> const & line_sizes,
+    std::vector<std::vector<uint64_t>> & cache_misses,
+    std::vector<std::vector<uint64_t>> & write_backs) const
+{
+    index_type rows_per_thread = (rows + num_threads - 1) / num_threads;
+    index_type start_row = std::min(rows, thread * rows_per_thread);
+    index_type end_row = start_row + spmv_rows_per_thread(thread, num_threads);
+    size_type start_nonzero = row_ptr[start_row];
+    size_type end_nonzero = start_nonzero + spmv_nonzeros_per_thread(thread, num_threads);
+    int numa_domain = numa_domains[thread];
+    std::size_t num_caches = cache_sizes.size();
+
+    // The streamed arrays miss once per cache line, and the cache
+    // lines of the result vector are eventually written back.
+    for (std::size_t c = 0; c < num_caches; c++) {
+        std::size_t line_size = line_sizes[c];
+        uint64_t y_lines = num_cache_lines(
+            y.data() + start_row, y.data() + end_row, line_size);
+        cache_misses[c][numa_domain] +=
+            num_cache_lines(
+                row_ptr.data() + start_row, row_ptr.data() + end_row + 1, line_size) +
+            num_cache_lines(
+                column_index.data() + start_nonzero, column_index.data() + end_nonzero, line_size) +
+            num_cache_lines(
+                value.data() + start_nonzero, value.data() + end_nonzero, line_size) +
+            y_lines;
+        write_backs[c][numa_domain] += y_lines;
+    }
+
+    // Make a single pass over the rows of the thread to find the
+    // cache lines of the source vector that are reused within a
+    // block of rows, for every cache at once.
+    std::vector<SourceVectorBlocks> blocks;
+    for (std::size_t c = 0; c < num_caches; c++)
+        blocks.emplace_back(cache_sizes[c], line_sizes[c]);
+    double row_bytes = sizeof(size_type) + sizeof(value_type);
+    double nonzero_bytes = sizeof(index_type) + sizeof(value_type);
+    for (index_type i = start_row; i < end_row; i++) {
+        for (std::size_t c = 0; c < num_caches; c++)
+            blocks[c].stream(row_bytes / blocks[c].line_size);
+        for (size_type k = row_ptr[i]; k < row_ptr[i+1]; k++) {
+            index_type j = column_index[k];
+            for (std::size_t c = 0; c < num_caches; c++) {
+                SourceVectorBlocks & b = blocks[c];
+                b.stream(nonzero_bytes / b.line_size);
+                if (b.use(uintptr_t(&x[j]) / b.line_size)) {
+                    int column_thread = thread_of_index<value_type>(
+                        x.data(), columns, j, num_threads, page_size);
+                    cache_misses[c][numa_domains[column_thread]]++;
+                }
+            }
+        }
     }
-    return w;
 }
 
 bool operator==(Matrix const & a, Matrix const & b)
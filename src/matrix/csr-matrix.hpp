@@ -2,6 +2,7 @@
 #define CSR_MATRIX_HPP
 
 #include "util/aligned-allocator.hpp"
+#include "util/memory-reference.hpp"
 
 #include <cstdint>
 #include <iosfwd>
@@ -46,7 +47,11 @@ public:
     index_type spmv_rows_per_thread(int thread, int num_threads) const;
     size_type spmv_nonzeros_per_thread(int thread, int num_threads) const;
 
-    std::vector<std::pair<uintptr_t, int>> spmv_memory_reference_string(
+    std::size_t spmv_memory_reference_string_size(
+        int thread,
+        int num_threads) const;
+
+    std::vector<MemoryReference> spmv_memory_reference_string(
         value_array_type const & x,
         value_array_type const & y,
         int thread,
@@ -54,6 +59,49 @@ public:
         int const * numa_domains,
         int page_size) const;
 
+    /*
+     * Generate `count' references of the memory reference string of
+     * the given thread, starting at `offset', without generating the
+     * preceding part of the string.
+     */
+    void spmv_memory_reference_substring(
+        value_array_type const & x,
+        value_array_type const & y,
+        int thread,
+        int num_threads,
+        int const * numa_domains,
+        int page_size,
+        std::size_t offset,
+        std::size_t count,
+        MemoryReference * w) const;
+
+    /*
+     * Estimate the cache misses and write-backs of the given thread
+     * for caches with the given capacities and cache line sizes, in
+     * bytes, without generating its memory references.  The estimates
+     * are added to `cache_misses' and `write_backs', which hold the
+     * counts of each cache for every NUMA domain.
+     *
+     * The row pointers, nonzeros and result vector are streamed, and
+     * miss once per cache line.  For the source vector, the rows of
+     * the thread are divided, in a single pass, into blocks whose
+     * distinct cache lines of `x', together with the streamed cache
+     * lines, fill half of a cache.  A cache line of `x' misses unless
+     * it was already used in the same or in the previous block, which
+     * approximates a cache with LRU replacement.
+     */
+    void spmv_estimate_cache_misses(
+        value_array_type const & x,
+        value_array_type const & y,
+        int thread,
+        int num_threads,
+        int const * numa_domains,
+        int page_size,
+        std::vector<std::size_t> const & cache_sizes,
+        std::vector<std::size_t> const & line_sizes,
+        std::vector<std::vector<uint64_t>> & cache_misses,
+        std::vector<std::vector<uint64_t>> & write_backs) const;
+
 public:
     index_type rows;
     index_type columns;
@@ -99,7 +99,15 @@ size_type Matrix::spmv_nonzeros_per_thread(int thread, int num_threads) const
     return nonzeros;
 }
 
-std::vector<std::pair<uintptr_t, int>>
+std::size_t Matrix::spmv_memory_reference_string_size(
+    int thread,
+    int num_threads) const
+{
+    std::size_t rows = spmv_rows_per_thread(thread, num_threads);
+    return (3 * std::size_t(row_length) + 1) * rows;
+}
+
+std::vector<MemoryReference>
 Matrix::spmv_memory_reference_string(
     value_array_type const & x,
     value_array_type const & y,
@@ -107,39 +115,62 @@ Matrix::spmv_memory_reference_string(
     int num_threads,
     int const * numa_domains,
     int page_size) const
+{
+    std::size_t num_references =
+        spmv_memory_reference_string_size(thread, num_threads);
+    std::vector<MemoryReference> w(num_references);
+    spmv_memory_reference_substring(
+        x, y, thread, num_threads, numa_domains, page_size,
+        0, num_references, w.data());
+    return w;
+}
+
+void Matrix::spmv_memory_reference_substring(
+    value_array_type const & x,
+    value_array_type const & y,
+    int thread,
+    int num_threads,
+    int const * numa_domains,
+    int page_size,
+    std::size_t offset,
+    std::size_t count,
+    MemoryReference * w) const
 {
     index_type rows_per_thread = (rows + num_threads - 1) / num_threads;
     index_type start_row = std::min(rows, thread * rows_per_thread);
-    index_type end_row = std::min(rows, (thread + 1) * rows_per_thread);
-    index_type rows = end_row - start_row;
-    size_type start_nonzero = start_row * row_length;
-    size_type end_nonzero = end_row * row_length;
-    size_type nonzeros = end_nonzero - start_nonzero;
 
-    size_type num_references = 3 * nonzeros + 1 * rows;
-    std::vector<std::pair<uintptr_t, int>> w(
-        num_references, std::make_pair(0,0));
-    size_type l = 0;
-    for (index_type i = start_row; i < end_row; ++i) {
-        for (size_type k = i * row_length; k < (i+1)*row_length; ++k) {
-            index_type j = column_index[k];
-            w[l++] = std::make_pair(
+    // Three references for each entry of a row, followed by one
+    // reference to the result.
+    std::size_t row_references = 3 * std::size_t(row_length) + 1;
+    for (std::size_t t = offset, l = 0; l < count; ++t, ++l) {
+        index_type i = start_row + t / row_references;
+        std::size_t r = t % row_references;
+        if (r == row_references - 1) {
+            w[l] = MemoryReference(
+                uintptr_t(&y[i]),
+                numa_domains[thread],
+                AccessType::store);
+            continue;
+        }
+
+        size_type k = i * row_length + r / 3;
+        if (r % 3 == 0) {
+            w[l] = MemoryReference(
                 uintptr_t(&column_index[k]),
                 numa_domains[thread]);
-            w[l++] = std::make_pair(
+        } else if (r % 3 == 1) {
+            w[l] = MemoryReference(
                 uintptr_t(&value[k]),
                 numa_domains[thread]);
+        } else {
+            index_type j = column_index[k];
             int column_thread = thread_of_index<value_type>(
                 x.data(), columns, j, num_threads, page_size);
-            w[l++] = std::make_pair(
+            w[l] = MemoryReference(
                 uintptr_t(&x[j]),
                 numa_domains[column_thread]);
         }
-        w[l++] = std::make_pair(
-            uintptr_t(&y[i]),
-            numa_domains[thread]);
     }
-    return w;
 }
 
 bool operator==(Matrix const & a, Matrix const & b)
@@ -2,6 +2,7 @@
 #define ELLPACK_MATRIX_HPP
 
 #include "util/aligned-allocator.hpp"
+#include "util/memory-reference.hpp"
 
 #include <cstdint>
 #include <iosfwd>
@@ -46,7 +47,11 @@ public:
     index_type spmv_rows_per_thread(int thread, int num_threads) const;
     size_type spmv_nonzeros_per_thread(int thread, int num_threads) const;
 
-    std::vector<std::pair<uintptr_t, int>> spmv_memory_reference_string(
+    std::size_t spmv_memory_reference_string_size(
+        int thread,
+        int num_threads) const;
+
+    std::vector<MemoryReference> spmv_memory_reference_string(
         value_array_type const & x,
         value_array_type const & y,
         int thread,
@@ -54,6 +59,22 @@ public:
         int const * numa_domains,
         int page_size) const;
 
+    /*
+     * Generate `count' references of the memory reference string of
+     * the given thread, starting at `offset', without generating the
+     * preceding part of the string.
+     */
+    void spmv_memory_reference_substring(
+        value_array_type const & x,
+        value_array_type const & y,
+        int thread,
+        int num_threads,
+        int const * numa_domains,
+        int page_size,
+        std::size_t offset,
+        std::size_t count,
+        MemoryReference * w) const;
+
 public:
     index_type rows;
     index_type columns;
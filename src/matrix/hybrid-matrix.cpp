@@ -120,7 +120,42 @@ size_type Matrix::spmv_nonzeros_per_thread(int thread, int num_threads) const
     return nonzeros;
 }
 
-std::vector<std::pair<uintptr_t, int>>
+std::size_t Matrix::spmv_memory_reference_string_size_ell(
+    int thread,
+    int num_threads) const
+{
+    index_type rows_per_thread = (rows + num_threads - 1) / num_threads;
+    index_type start_row = std::min(rows, thread * rows_per_thread);
+    index_type end_row = std::min(rows, (thread + 1) * rows_per_thread);
+    std::size_t rows = end_row - start_row;
+    return (3 * std::size_t(ell_row_length) + 1) * rows;
+}
+
+std::size_t Matrix::spmv_memory_reference_string_size_coo(
+    int thread,
+    int num_threads) const
+{
+    index_type num_entries_per_thread = (num_coo_entries + num_threads - 1) / num_threads;
+    index_type thread_start_entry = std::min(num_coo_entries, thread * num_entries_per_thread);
+    index_type thread_end_entry = std::min(num_coo_entries, (thread + 1) * num_entries_per_thread);
+    std::size_t thread_num_entries = thread_end_entry - thread_start_entry;
+
+    index_type rows_per_thread = (rows + num_threads - 1) / num_threads;
+    index_type start_row = std::min(rows, thread * rows_per_thread);
+    index_type end_row = std::min(rows, (thread + 1) * rows_per_thread);
+    std::size_t thread_num_rows = end_row - start_row;
+    return 5 * thread_num_entries + 2 * thread_num_rows * num_threads;
+}
+
+std::size_t Matrix::spmv_memory_reference_string_size(
+    int thread,
+    int num_threads) const
+{
+    return spmv_memory_reference_string_size_ell(thread, num_threads) +
+        spmv_memory_reference_string_size_coo(thread, num_threads);
+}
+
+std::vector<MemoryReference>
 Matrix::spmv_memory_reference_string_ell(
     value_array_type const & x,
     value_array_type const & y,
@@ -129,123 +164,203 @@ Matrix::spmv_memory_reference_string_ell(
     int num_threads,
     int const * numa_domains,
     int page_size) const
+{
+    std::size_t num_references =
+        spmv_memory_reference_string_size_ell(thread, num_threads);
+    std::vector<MemoryReference> w(num_references);
+    spmv_memory_reference_substring_ell(
+        x, y, workspace, thread, num_threads, numa_domains, page_size,
+        0, num_references, w.data());
+    return w;
+}
+
+std::vector<MemoryReference>
+Matrix::spmv_memory_reference_string_coo(
+    value_array_type const & x,
+    value_array_type const & y,
+    value_array_type const & workspace,
+    int thread,
+    int num_threads,
+    int const * numa_domains,
+    int page_size) const
+{
+    std::size_t num_references =
+        spmv_memory_reference_string_size_coo(thread, num_threads);
+    std::vector<MemoryReference> w(num_references);
+    spmv_memory_reference_substring_coo(
+        x, y, workspace, thread, num_threads, numa_domains, page_size,
+        0, num_references, w.data());
+    return w;
+}
+
+std::vector<MemoryReference>
+Matrix::spmv_memory_reference_string(
+        value_array_type const & x,
+        value_array_type const & y,
+        value_array_type const & workspace,
+        int thread,
+        int num_threads,
+        int const * numa_domains,
+        int page_size) const
+{
+    std::size_t num_references =
+        spmv_memory_reference_string_size(thread, num_threads);
+    std::vector<MemoryReference> w(num_references);
+    spmv_memory_reference_substring(
+        x, y, workspace, thread, num_threads, numa_domains, page_size,
+        0, num_references, w.data());
+    return w;
+}
+
+void Matrix::spmv_memory_reference_substring_ell(
+    value_array_type const & x,
+    value_array_type const & y,
+    value_array_type const & workspace,
+    int thread,
+    int num_threads,
+    int const * numa_domains,
+    int page_size,
+    std::size_t offset,
+    std::size_t count,
+    MemoryReference * w) const
 {
     index_type rows_per_thread = (rows + num_threads - 1) / num_threads;
     index_type start_row = std::min(rows, thread * rows_per_thread);
-    index_type end_row = std::min(rows, (thread + 1) * rows_per_thread);
-    index_type rows = end_row - start_row;
-    size_type start_nonzero = start_row * ell_row_length;
-    size_type end_nonzero = end_row * ell_row_length;
-    size_type nonzeros = end_nonzero - start_nonzero;
 
-    size_type num_references = 3 * nonzeros + 1 * rows;
-    std::vector<std::pair<uintptr_t, int>> w(
-        num_references, std::make_pair(0,0));
-    size_type l = 0;
-    for (index_type i = start_row; i < end_row; ++i) {
-        for (size_type k = i * ell_row_length;
-             k < (i+1)*ell_row_length; ++k)
-        {
-            index_type j = ell_column_index[k];
-            w[l++] = std::make_pair(
+    std::size_t row_references = 3 * std::size_t(ell_row_length) + 1;
+    for (std::size_t t = offset, l = 0; l < count; ++t, ++l) {
+        index_type i = start_row + t / row_references;
+        std::size_t r = t % row_references;
+        if (r == row_references - 1) {
+            w[l] = MemoryReference(
+                uintptr_t(&y[i]),
+                numa_domains[thread],
+                AccessType::store);
+            continue;
+        }
+
+        size_type k = i * ell_row_length + r / 3;
+        if (r % 3 == 0) {
+            w[l] = MemoryReference(
                 uintptr_t(&ell_column_index[k]),
                 numa_domains[thread]);
-            w[l++] = std::make_pair(
+        } else if (r % 3 == 1) {
+            w[l] = MemoryReference(
                 uintptr_t(&ell_value[k]),
                 numa_domains[thread]);
+        } else {
+            index_type j = ell_column_index[k];
             int column_thread = thread_of_index<value_type>(
                 x.data(), columns, j, num_threads, page_size);
-            w[l++] = std::make_pair(
+            w[l] = MemoryReference(
                 uintptr_t(&x[j]),
                 numa_domains[column_thread]);
         }
-        w[l++] = std::make_pair(
-            uintptr_t(&y[i]),
-            numa_domains[thread]);
     }
-    return w;
 }
 
-std::vector<std::pair<uintptr_t, int>>
-Matrix::spmv_memory_reference_string_coo(
+void Matrix::spmv_memory_reference_substring_coo(
     value_array_type const & x,
     value_array_type const & y,
     value_array_type const & workspace,
     int thread,
     int num_threads,
     int const * numa_domains,
-    int page_size) const
+    int page_size,
+    std::size_t offset,
+    std::size_t count,
+    MemoryReference * w) const
 {
     index_type num_entries_per_thread = (num_coo_entries + num_threads - 1) / num_threads;
     index_type thread_start_entry = std::min(num_coo_entries, thread * num_entries_per_thread);
     index_type thread_end_entry = std::min(num_coo_entries, (thread + 1) * num_entries_per_thread);
-    index_type thread_num_entries = thread_end_entry - thread_start_entry;
+    std::size_t thread_num_entries = thread_end_entry - thread_start_entry;
 
     index_type rows_per_thread = (rows + num_threads - 1) / num_threads;
     index_type start_row = std::min(rows, thread * rows_per_thread);
     index_type end_row = std::min(rows, (thread + 1) * rows_per_thread);
     index_type thread_num_rows = end_row - start_row;
 
-    std::vector<std::pair<uintptr_t, int>> w(
-        5 * thread_num_entries + 2 * thread_num_rows * num_threads,
-        std::make_pair(0,0));
-    size_t l = 0;
-    for (size_type k = thread_start_entry; k < thread_end_entry; ++k, l += 5) {
-        index_type i = coo_row_index[k];
-        index_type j = coo_column_index[k];
-        w[l+0] = std::make_pair(
-            uintptr_t(&coo_row_index[k]),
-            numa_domains[thread]);
-        w[l+1] = std::make_pair(
-            uintptr_t(&coo_column_index[k]),
-            numa_domains[thread]);
-        w[l+2] = std::make_pair(
-            uintptr_t(&coo_value[k]),
-            numa_domains[thread]);
-        int column_thread = thread_of_index<value_type>(
-            x.data(), columns, j, num_threads, page_size);
-        w[l+3] = std::make_pair(
-            uintptr_t(&x[j]),
-            numa_domains[column_thread]);
-        w[l+4] = std::make_pair(
-            uintptr_t(&workspace[thread*rows+i]),
-            numa_domains[thread]);
-    }
-
-    for (index_type i = start_row; i < end_row; i++) {
-        for (size_type j = 0; j < num_threads; j++, l += 2) {
-            int t0 = thread_of_index<value_type>(
-                workspace.data(), num_threads*thread_num_rows, j*rows+i,
-                num_threads, page_size);
-            w[l+0] =  std::make_pair(
-                uintptr_t(&workspace[j*rows+i]),
-                numa_domains[t0]);
-            w[l+1] =  std::make_pair(
-                uintptr_t(&y[i]),
-                numa_domains[thread]);
+    for (std::size_t t = offset, l = 0; l < count; ++t, ++l) {
+        if (t < 5 * thread_num_entries) {
+            size_type k = thread_start_entry + t / 5;
+            index_type i = coo_row_index[k];
+            index_type j = coo_column_index[k];
+            switch (t % 5) {
+            case 0:
+                w[l] = MemoryReference(
+                    uintptr_t(&coo_row_index[k]),
+                    numa_domains[thread]);
+                break;
+            case 1:
+                w[l] = MemoryReference(
+                    uintptr_t(&coo_column_index[k]),
+                    numa_domains[thread]);
+                break;
+            case 2:
+                w[l] = MemoryReference(
+                    uintptr_t(&coo_value[k]),
+                    numa_domains[thread]);
+                break;
+            case 3: {
+                int column_thread = thread_of_index<value_type>(
+                    x.data(), columns, j, num_threads, page_size);
+                w[l] = MemoryReference(
+                    uintptr_t(&x[j]),
+                    numa_domains[column_thread]);
+                break;
+            }
+            case 4:
+                w[l] = MemoryReference(
+                    uintptr_t(&workspace[thread*rows+i]),
+                    numa_domains[thread],
+                    AccessType::store);
+                break;
+            }
+        } else {
+            std::size_t u = t - 5 * thread_num_entries;
+            index_type i = start_row + (u / 2) / num_threads;
+            size_type j = (u / 2) % num_threads;
+            if (u % 2 == 0) {
+                int t0 = thread_of_index<value_type>(
+                    workspace.data(), num_threads*thread_num_rows, j*rows+i,
+                    num_threads, page_size);
+                w[l] = MemoryReference(
+                    uintptr_t(&workspace[j*rows+i]),
+                    numa_domains[t0]);
+            } else {
+                w[l] = MemoryReference(
+                    uintptr_t(&y[i]),
+                    numa_domains[thread],
+                    AccessType::store);
+            }
         }
     }
-    return w;
 }
 
-std::vector<std::pair<uintptr_t, int>>
-Matrix::spmv_memory_reference_string(
-        value_array_type const & x,
-        value_array_type const & y,
-        value_array_type const & workspace,
-        int thread,
-        int num_threads,
-        int const * numa_domains,
-        int page_size) const
+void Matrix::spmv_memory_reference_substring(
+    value_array_type const & x,
+    value_array_type const & y,
+    value_array_type const & workspace,
+    int thread,
+    int num_threads,
+    int const * numa_domains,
+    int page_size,
+    std::size_t offset,
+    std::size_t count,
+    MemoryReference * w) const
 {
-    auto w0 = spmv_memory_reference_string_ell(
-        x, y, workspace, thread, num_threads,
-        numa_domains, page_size);
-    auto w1 = spmv_memory_reference_string_coo(
-        x, y, workspace, thread, num_threads,
-        numa_domains, page_size);
-    w0.insert(std::end(w0), std::begin(w1), std::end(w1));
-    return w0;
+    // The ELL part of the string is followed by the COO part.
+    std::size_t ell_size =
+        spmv_memory_reference_string_size_ell(thread, num_threads);
+    std::size_t ell_count = offset < ell_size
+        ? std::min(count, ell_size - offset) : 0;
+    spmv_memory_reference_substring_ell(
+        x, y, workspace, thread, num_threads, numa_domains, page_size,
+        offset, ell_count, w);
+    spmv_memory_reference_substring_coo(
+        x, y, workspace, thread, num_threads, numa_domains, page_size,
+        offset + ell_count - ell_size, count - ell_count, w + ell_count);
 }
 
 bool operator==(Matrix const & a, Matrix const & b)
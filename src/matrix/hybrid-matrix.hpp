@@ -4,6 +4,7 @@
 #include "matrix/coo-matrix.hpp"
 #include "matrix/ell-matrix.hpp"
 #include "util/aligned-allocator.hpp"
+#include "util/memory-reference.hpp"
 
 #include <cstdint>
 #include <iosfwd>
@@ -53,7 +54,17 @@ public:
     index_type spmv_rows_per_thread(int thread, int num_threads) const;
     size_type spmv_nonzeros_per_thread(int thread, int num_threads) const;
 
-    std::vector<std::pair<uintptr_t, int>> spmv_memory_reference_string_ell(
+    std::size_t spmv_memory_reference_string_size_ell(
+        int thread,
+        int num_threads) const;
+    std::size_t spmv_memory_reference_string_size_coo(
+        int thread,
+        int num_threads) const;
+    std::size_t spmv_memory_reference_string_size(
+        int thread,
+        int num_threads) const;
+
+    std::vector<MemoryReference> spmv_memory_reference_string_ell(
         value_array_type const & x,
         value_array_type const & y,
         value_array_type const & workspace,
@@ -61,7 +72,7 @@ public:
         int num_threads,
         int const * numa_domains,
         int page_size) const;
-    std::vector<std::pair<uintptr_t, int>> spmv_memory_reference_string_coo(
+    std::vector<MemoryReference> spmv_memory_reference_string_coo(
         value_array_type const & x,
         value_array_type const & y,
         value_array_type const & workspace,
@@ -69,7 +80,7 @@ public:
         int num_threads,
         int const * numa_domains,
         int page_size) const;
-    std::vector<std::pair<uintptr_t, int>> spmv_memory_reference_string(
+    std::vector<MemoryReference> spmv_memory_reference_string(
         value_array_type const & x,
         value_array_type const & y,
         value_array_type const & workspace,
@@ -78,6 +89,45 @@ public:
         int const * numa_domains,
         int page_size) const;
 
+    /*
+     * Generate `count' references of the memory reference string of
+     * the given thread, starting at `offset', without generating the
+     * preceding part of the string.
+     */
+    void spmv_memory_reference_substring_ell(
+        value_array_type const & x,
+        value_array_type const & y,
+        value_array_type const & workspace,
+        int thread,
+        int num_threads,
+        int const * numa_domains,
+        int page_size,
+        std::size_t offset,
+        std::size_t count,
+        MemoryReference * w) const;
+    void spmv_memory_reference_substring_coo(
+        value_array_type const & x,
+        value_array_type const & y,
+        value_array_type const & workspace,
+        int thread,
+        int num_threads,
+        int const * numa_domains,
+        int page_size,
+        std::size_t offset,
+        std::size_t count,
+        MemoryReference * w) const;
+    void spmv_memory_reference_substring(
+        value_array_type const & x,
+        value_array_type const & y,
+        value_array_type const & workspace,
+        int thread,
+        int num_threads,
+        int const * numa_domains,
+        int page_size,
+        std::size_t offset,
+        std::size_t count,
+        MemoryReference * w) const;
+
 public:
     index_type rows;
     index_type columns;
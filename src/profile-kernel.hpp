@@ -78,6 +78,34 @@ private:
     std::vector<ProfilingEvent> profiling_events_;
 };
 
+/*
+ * Collect the counts of a hardware performance event of a thread from
+ * every profiling run.
+ */
+ProfilingEvent make_profiling_event(
+    std::string const & event,
+    int thread,
+    std::vector<ProfilingRun> const & profiling_runs);
+
+/*
+ * Profile a kernel, while measuring the given groups of hardware
+ * performance events for each thread.
+ */
+Profiling profile_kernel(
+    TraceConfig const & trace_config,
+    Kernel & kernel,
+    bool warmup,
+    bool flush_caches,
+    int runs,
+    perf::libpfm_context const & libpfm_context,
+    std::vector<std::vector<EventGroup>> const & eventgroups_per_thread,
+    std::ostream & o,
+    bool verbose);
+
+/*
+ * Profile a kernel, while measuring the groups of hardware
+ * performance events of each thread in the trace configuration.
+ */
 Profiling profile_kernel(
     TraceConfig const & trace_config,
     Kernel & kernel,
@@ -1,5 +1,6 @@
 #include "trace-config.hpp"
 #include "util/json.h"
+#include "util/memory-reference.hpp"
 
 #include <algorithm>
 #include <fstream>
@@ -27,7 +28,14 @@ Cache::Cache(
     double bandwidth,
     std::vector<double> const & bandwidth_per_numa_domain,
     std::string const & cache_miss_event,
-    std::string const & parent)
+    std::string const & parent,
+    cache_size_type associativity,
+    std::string const & replacement_policy,
+    std::string const & set_index,
+    std::string const & prefetcher,
+    int prefetch_degree,
+    int prefetch_distance,
+    double latency)
     : name(name)
     , size(size)
     , line_size(line_size)
@@ -35,6 +43,13 @@ Cache::Cache(
     , bandwidth_per_numa_domain(bandwidth_per_numa_domain)
     , cache_miss_event(cache_miss_event)
     , parent(parent)
+    , associativity(associativity)
+    , replacement_policy(replacement_policy)
+    , set_index(set_index)
+    , prefetcher(prefetcher)
+    , prefetch_degree(prefetch_degree)
+    , prefetch_distance(prefetch_distance)
+    , latency(latency)
 {
     if (size % line_size != 0) {
         std::stringstream s;
@@ -43,6 +58,127 @@ Cache::Cache(
           << "to be a multiple of line_size (" << line_size << ")";
         throw trace_config_error(s.str());
     }
+
+    cache_size_type lines = size / line_size;
+    if (associativity < 0 ||
+        (associativity > 0 && lines % associativity != 0))
+    {
+        std::stringstream s;
+        s << name << ": "
+          << "Expected the number of cache lines (" << lines << ") "
+          << "to be a multiple of associativity (" << associativity << ")";
+        throw trace_config_error(s.str());
+    }
+
+    if (replacement_policy != "lru" &&
+        replacement_policy != "fifo" &&
+        replacement_policy != "rand" &&
+        replacement_policy != "plru" &&
+        replacement_policy != "nru" &&
+        replacement_policy != "srrip" &&
+        replacement_policy != "brrip" &&
+        replacement_policy != "drrip")
+    {
+        std::stringstream s;
+        s << name << ": \"replacement_policy\": "
+          << "Expected \"lru\", \"fifo\", \"rand\", \"plru\", \"nru\", "
+          << "\"srrip\", \"brrip\" or \"drrip\", "
+          << "got \"" << replacement_policy << "\"";
+        throw trace_config_error(s.str());
+    }
+
+    // These policies track the lines of each set with trees or bits
+    // that are scanned on every access, which is far too slow for a
+    // fully associative cache of any realistic size.
+    if ((replacement_policy == "plru" ||
+         replacement_policy == "nru" ||
+         replacement_policy == "srrip" ||
+         replacement_policy == "brrip" ||
+         replacement_policy == "drrip") &&
+        associativity == 0)
+    {
+        std::stringstream s;
+        s << name << ": \"replacement_policy\": "
+          << "Expected \"associativity\" to be given "
+          << "for \"" << replacement_policy << "\" replacement";
+        throw trace_config_error(s.str());
+    }
+
+    if (set_index != "modulo" && set_index != "xor") {
+        std::stringstream s;
+        s << name << ": \"set_index\": "
+          << "Expected \"modulo\" or \"xor\", "
+          << "got \"" << set_index << "\"";
+        throw trace_config_error(s.str());
+    }
+
+    if (!prefetcher.empty() &&
+        prefetcher != "next-line" &&
+        prefetcher != "adjacent-line" &&
+        prefetcher != "stride")
+    {
+        std::stringstream s;
+        s << name << ": \"prefetcher\": "
+          << "Expected \"next-line\", \"adjacent-line\", \"stride\" or null, "
+          << "got \"" << prefetcher << "\"";
+        throw trace_config_error(s.str());
+    }
+
+    if (prefetch_degree < 1 || prefetch_distance < 1) {
+        std::stringstream s;
+        s << name << ": "
+          << "Expected prefetch_degree (" << prefetch_degree << ") "
+          << "and prefetch_distance (" << prefetch_distance << ") "
+          << "to be positive";
+        throw trace_config_error(s.str());
+    }
+
+    if (latency < 0.0) {
+        std::stringstream s;
+        s << name << ": "
+          << "Expected latency (" << latency << ") "
+          << "to be non-negative";
+        throw trace_config_error(s.str());
+    }
+}
+
+TLB::TLB(
+    std::string const & name,
+    cache_size_type entries,
+    cache_size_type page_size,
+    std::string const & parent,
+    cache_size_type associativity)
+    : name(name)
+    , entries(entries)
+    , page_size(page_size)
+    , parent(parent)
+    , associativity(associativity)
+{
+    if (entries <= 0) {
+        std::stringstream s;
+        s << name << ": "
+          << "Expected a positive number of entries, "
+          << "got \"" << entries << "\"";
+        throw trace_config_error(s.str());
+    }
+
+    if (page_size <= 0 || (page_size & (page_size - 1)) != 0) {
+        std::stringstream s;
+        s << name << ": "
+          << "Expected page_size (" << page_size << ") "
+          << "to be a power of two";
+        throw trace_config_error(s.str());
+    }
+
+    if (associativity < 0 ||
+        (associativity > 0 && entries % associativity != 0))
+    {
+        std::stringstream s;
+        s << name << ": "
+          << "Expected the number of entries (" << entries << ") "
+          << "to be a multiple of associativity (" << associativity << ")";
+        throw trace_config_error(s.str());
+    }
 }
 
 EventGroup::EventGroup(
@@ -60,12 +196,14 @@ ThreadAffinity::ThreadAffinity(
     int cpu,
     std::string const & cache,
     int numa_domain,
-    std::vector<EventGroup> const & event_groups)
+    std::vector<EventGroup> const & event_groups,
+    std::string const & tlb)
     : thread(thread)
     , cpu(cpu)
     , cache(cache)
     , numa_domain(numa_domain)
     , event_groups(event_groups)
+    , tlb(tlb)
 {
 }
 
@@ -76,6 +214,9 @@ TraceConfig::TraceConfig()
     , bandwidth_per_numa_domain_()
     , caches_()
     , thread_affinities_()
+    , tlbs_()
+    , latency_per_numa_domain_()
+    , max_outstanding_misses_(10)
 {
 }
 
@@ -85,14 +226,37 @@ TraceConfig::TraceConfig(
     int num_numa_domains,
     std::vector<double> const & bandwidth_per_numa_domain,
     std::map<std::string, Cache> const & caches,
-    std::vector<ThreadAffinity> const & thread_affinities)
+    std::vector<ThreadAffinity> const & thread_affinities,
+    std::map<std::string, TLB> const & tlbs,
+    std::vector<double> const & latency_per_numa_domain,
+    int max_outstanding_misses)
     : name_(name)
     , description_(description)
     , num_numa_domains_(num_numa_domains)
     , bandwidth_per_numa_domain_(bandwidth_per_numa_domain)
     , caches_(caches)
     , thread_affinities_(thread_affinities)
+    , tlbs_(tlbs)
+    , latency_per_numa_domain_(latency_per_numa_domain)
+    , max_outstanding_misses_(max_outstanding_misses)
 {
+    // Check that the NUMA domains fit in a memory reference
+    if (num_numa_domains > MemoryReference::max_numa_domains) {
+        std::stringstream s;
+        s << "\"num_numa_domains\": "
+          << "Expected at most " << MemoryReference::max_numa_domains << " NUMA domains, "
+          << "got \"" << num_numa_domains << "\"";
+        throw trace_config_error(s.str());
+    }
+
+    if (max_outstanding_misses < 1) {
+        std::stringstream s;
+        s << "\"max_outstanding_misses\": "
+          << "Expected a positive number, "
+          << "got \"" << max_outstanding_misses << "\"";
+        throw trace_config_error(s.str());
+    }
+
     // Check that the cache hierarchy is sensible
     for (auto it = std::cbegin(caches); it != std::cend(caches); ++it) {
         std::string const & name = (*it).first;
@@ -107,6 +271,19 @@ TraceConfig::TraceConfig(
         }
     }
 
+    // Check that the TLB hierarchy is sensible
+    for (auto it = std::cbegin(tlbs); it != std::cend(tlbs); ++it) {
+        std::string const & name = (*it).first;
+        TLB const & tlb = (*it).second;
+        if (!tlb.parent.empty() && tlbs.find(tlb.parent) == tlbs.end()) {
+            std::stringstream s;
+            s << name << ": \"parent\": "
+              << "Expected a TLB, "
+              << "got \"" << tlb.parent << "\"";
+            throw trace_config_error(s.str());
+        }
+    }
+
     // Check that the thread affinities are sensible
     for (size_t i = 0; i < thread_affinities.size(); i++) {
         if (caches.find(thread_affinities[i].cache) == caches.end()) {
@@ -124,6 +301,16 @@ TraceConfig::TraceConfig(
               << "got \"" << thread_affinities[i].numa_domain << "\"";
             throw trace_config_error(s.str());
         }
+
+        if (!thread_affinities[i].tlb.empty() &&
+            tlbs.find(thread_affinities[i].tlb) == tlbs.end())
+        {
+            std::stringstream s;
+            s << "\"thread_affinities\": " << i << ": "
+              << "Expected a first-level TLB, "
+              << "got \"" << thread_affinities[i].tlb << "\"";
+            throw trace_config_error(s.str());
+        }
     }
 }
 
@@ -161,6 +348,21 @@ std::vector<ThreadAffinity> const & TraceConfig::thread_affinities() const
     return thread_affinities_;
 }
 
+std::map<std::string, TLB> const & TraceConfig::tlbs() const
+{
+    return tlbs_;
+}
+
+std::vector<double> const & TraceConfig::latency_per_numa_domain() const
+{
+    return latency_per_numa_domain_;
+}
+
+int TraceConfig::max_outstanding_misses() const
+{
+    return max_outstanding_misses_;
+}
+
 cache_size_type TraceConfig::max_cache_size() const
 {
     cache_size_type cache_size = 0;
@@ -232,6 +434,34 @@ Cache parse_cache(
     if (!parent || !(json_is_string(parent) || json_is_null(parent)))
         throw trace_config_error("Expected \"parent\": (string) or null");
 
+    struct json * associativity = json_object_get(cache_value, "associativity");
+    if (associativity && !(json_is_number(associativity) || json_is_null(associativity)))
+        throw trace_config_error("Expected \"associativity\": (number) or null");
+
+    struct json * replacement_policy = json_object_get(cache_value, "replacement_policy");
+    if (replacement_policy && !json_is_string(replacement_policy))
+        throw trace_config_error("Expected \"replacement_policy\": (string)");
+
+    struct json * set_index = json_object_get(cache_value, "set_index");
+    if (set_index && !json_is_string(set_index))
+        throw trace_config_error("Expected \"set_index\": (string)");
+
+    struct json * prefetcher = json_object_get(cache_value, "prefetcher");
+    if (prefetcher && !(json_is_string(prefetcher) || json_is_null(prefetcher)))
+        throw trace_config_error("Expected \"prefetcher\": (string) or null");
+
+    struct json * prefetch_degree = json_object_get(cache_value, "prefetch_degree");
+    if (prefetch_degree && !json_is_number(prefetch_degree))
+        throw trace_config_error("Expected \"prefetch_degree\": (number)");
+
+    struct json * prefetch_distance = json_object_get(cache_value, "prefetch_distance");
+    if (prefetch_distance && !json_is_number(prefetch_distance))
+        throw trace_config_error("Expected \"prefetch_distance\": (number)");
+
+    struct json * latency = json_object_get(cache_value, "latency");
+    if (latency && !(json_is_number(latency) || json_is_null(latency)))
+        throw trace_config_error("Expected \"latency\": (number) or null");
+
     return Cache(
         name,
         json_to_int(size),
@@ -239,7 +469,14 @@ Cache parse_cache(
         json_is_number(bandwidth) ? json_to_double(bandwidth) : 0.0,
         bandwidth_per_numa_domain_,
         json_is_string(cache_miss_event) ? json_to_string(cache_miss_event) : "",
-        json_is_string(parent) ? json_to_string(parent) : "");
+        json_is_string(parent) ? json_to_string(parent) : "",
+        (associativity && json_is_number(associativity)) ? json_to_int(associativity) : 0,
+        replacement_policy ? json_to_string(replacement_policy) : "lru",
+        set_index ? json_to_string(set_index) : "modulo",
+        (prefetcher && json_is_string(prefetcher)) ? json_to_string(prefetcher) : "",
+        prefetch_degree ? json_to_int(prefetch_degree) : 1,
+        prefetch_distance ? json_to_int(prefetch_distance) : 1,
+        (latency && json_is_number(latency)) ? json_to_double(latency) : 0.0);
 }
 
 std::map<std::string, Cache> parse_caches(
@@ -260,6 +497,62 @@ std::map<std::string, Cache> parse_caches(
     return caches;
 }
 
+TLB parse_tlb(
+    const struct json * json_tlb)
+{
+    if (!json_is_member(json_tlb)) {
+        throw trace_config_error(
+            "Expected '\"tlb\": "
+            "{\"entries\": ..., \"page_size\": ..., \"parent\": ...}");
+    }
+
+    std::string name(json_to_key(json_tlb));
+    struct json * tlb_value = json_to_value(json_tlb);
+
+    struct json * entries = json_object_get(tlb_value, "entries");
+    if (!entries || !json_is_number(entries))
+        throw trace_config_error("Expected \"entries\": (number)");
+
+    struct json * page_size = json_object_get(tlb_value, "page_size");
+    if (page_size && !json_is_number(page_size))
+        throw trace_config_error("Expected \"page_size\": (number)");
+
+    struct json * parent = json_object_get(tlb_value, "parent");
+    if (parent && !(json_is_string(parent) || json_is_null(parent)))
+        throw trace_config_error("Expected \"parent\": (string) or null");
+
+    struct json * associativity = json_object_get(tlb_value, "associativity");
+    if (associativity && !(json_is_number(associativity) || json_is_null(associativity)))
+        throw trace_config_error("Expected \"associativity\": (number) or null");
+
+    return TLB(
+        name,
+        json_to_int(entries),
+        page_size ? json_to_int(page_size) : 4096,
+        (parent && json_is_string(parent)) ? json_to_string(parent) : "",
+        (associativity && json_is_number(associativity)) ? json_to_int(associativity) : 0);
+}
+
+std::map<std::string, TLB> parse_tlbs(
+    const struct json * root)
+{
+    std::map<std::string, TLB> tlbs;
+    struct json * json_tlbs = json_object_get(root, "tlbs");
+    if (!json_tlbs)
+        return tlbs;
+    if (!json_is_object(json_tlbs))
+        throw trace_config_error("Expected \"tlbs\" object");
+
+    for (struct json * json_tlb = json_object_begin(json_tlbs);
+         json_tlb != json_object_end();
+         json_tlb = json_object_next(json_tlb))
+    {
+        TLB tlb = parse_tlb(json_tlb);
+        tlbs.emplace(tlb.name, tlb);
+    }
+    return tlbs;
+}
+
 std::vector<ThreadAffinity> parse_thread_affinities(
     const struct json * root)
 {
@@ -289,6 +582,9 @@ std::vector<ThreadAffinity> parse_thread_affinities(
         struct json * numa_domain = json_object_get(thread_affinity, "numa_domain");
         if (!numa_domain || !json_is_number(numa_domain))
             throw trace_config_error("Expected \"numa_domain\": (number)");
+        struct json * tlb = json_object_get(thread_affinity, "tlb");
+        if (tlb && !(json_is_string(tlb) || json_is_null(tlb)))
+            throw trace_config_error("Expected \"tlb\": (string) or null");
 
         struct json * json_event_groups = json_object_get(
             thread_affinity, "event_groups");
@@ -335,7 +631,8 @@ std::vector<ThreadAffinity> parse_thread_affinities(
                            json_to_int(cpu),
                            json_to_string(cache),
                            json_to_int(numa_domain),
-                           event_groups));
+                           event_groups,
+                           (tlb && json_is_string(tlb)) ? json_to_string(tlb) : ""));
         thread++;
     }
 
@@ -369,10 +666,32 @@ TraceConfig parse_trace_config(const struct json * root)
         bandwidth_per_numa_domain = parse_bandwidth_per_numa_domain(json_bandwidth_per_numa_domain);
     }
 
+    struct json * json_latency_per_numa_domain = json_object_get(root, "latency_per_numa_domain");
+    std::vector<double> latency_per_numa_domain;
+    if (json_latency_per_numa_domain && json_is_array(json_latency_per_numa_domain)) {
+        for (struct json * latency = json_array_begin(json_latency_per_numa_domain);
+             latency != json_array_end();
+             latency = json_array_next(latency))
+        {
+            if (!json_is_number(latency)) {
+                throw trace_config_error(
+                    "Expected '\"latency_per_numa_domain\": "
+                    "to be an array of numbers");
+            }
+            latency_per_numa_domain.push_back(json_to_double(latency));
+        }
+    }
+
+    struct json * json_max_outstanding_misses = json_object_get(root, "max_outstanding_misses");
+    if (json_max_outstanding_misses && !json_is_number(json_max_outstanding_misses))
+        throw trace_config_error("Expected \"max_outstanding_misses\": (number)");
+
     std::map<std::string, Cache> caches =
         parse_caches(root);
     std::vector<ThreadAffinity> thread_affinities =
         parse_thread_affinities(root);
+    std::map<std::string, TLB> tlbs =
+        parse_tlbs(root);
 
     return TraceConfig(
         name,
@@ -380,7 +699,10 @@ TraceConfig parse_trace_config(const struct json * root)
         num_numa_domains,
         bandwidth_per_numa_domain,
         caches,
-        thread_affinities);
+        thread_affinities,
+        tlbs,
+        latency_per_numa_domain,
+        json_max_outstanding_misses ? json_to_int(json_max_outstanding_misses) : 10);
 }
 
 TraceConfig read_trace_config(std::string const & path)
@@ -461,7 +783,19 @@ std::ostream & operator<<(
              << '"' << "cache_miss_event" << '"' << ": " << (
                  cache.cache_miss_event.empty() ? "null"s : "\""s + cache.cache_miss_event + "\""s) << ',' << ' '
              << '"' << "parent" << '"' << ": " << (
-                 cache.parent.empty() ? "null"s : "\""s + cache.parent + "\""s)
+                 cache.parent.empty() ? "null"s : "\""s + cache.parent + "\""s) << ',' << ' '
+             << '"' << "associativity" << '"' << ": " << (
+                 (cache.associativity == 0) ? "null"s : std::to_string(cache.associativity)) << ',' << ' '
+             << '"' << "replacement_policy" << '"' << ": "
+             << '"' << cache.replacement_policy << '"' << ',' << ' '
+             << '"' << "set_index" << '"' << ": "
+             << '"' << cache.set_index << '"' << ',' << ' '
+             << '"' << "prefetcher" << '"' << ": " << (
+                 cache.prefetcher.empty() ? "null"s : "\""s + cache.prefetcher + "\""s) << ',' << ' '
+             << '"' << "prefetch_degree" << '"' << ": " << cache.prefetch_degree << ',' << ' '
+             << '"' << "prefetch_distance" << '"' << ": " << cache.prefetch_distance << ',' << ' '
+             << '"' << "latency" << '"' << ": " << (
+                 (cache.latency == 0.0) ? "null"s : std::to_string(cache.latency))
              << '}';
 }
 
@@ -486,6 +820,41 @@ std::ostream & operator<<(
     return o << '}';
 }
 
+std::ostream & operator<<(
+    std::ostream & o,
+    TLB const & tlb)
+{
+    return o << '{'
+             << '"' << "entries" << '"' << ": " << tlb.entries << ',' << ' '
+             << '"' << "page_size" << '"' << ": " << tlb.page_size << ',' << ' '
+             << '"' << "parent" << '"' << ": " << (
+                 tlb.parent.empty() ? "null"s : "\""s + tlb.parent + "\""s) << ',' << ' '
+             << '"' << "associativity" << '"' << ": " << (
+                 (tlb.associativity == 0) ? "null"s : std::to_string(tlb.associativity))
+             << '}';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    std::map<std::string, TLB> const & tlbs)
+{
+    if (tlbs.empty())
+        return o << "{}";
+
+    o << '{' << '\n';
+    auto it = std::cbegin(tlbs);
+    auto end = --std::cend(tlbs);
+    for (; it != end; ++it) {
+        auto const & tlb = *it;
+        o << '"' << tlb.first << '"' << ": "
+          << tlb.second << ",\n";
+    }
+    auto const & tlb = *it;
+    o << '"' << tlb.first << '"' << ": "
+      << tlb.second << '\n';
+    return o << '}';
+}
+
 std::ostream & operator<<(
     std::ostream & o,
     EventGroup const & eventgroup)
@@ -526,6 +895,8 @@ std::ostream & operator<<(
              << '"' << thread_affinity.cache << '"' << ',' << ' '
              << '"' << "numa_domain" << '"' << ": "
              << thread_affinity.numa_domain << ',' << ' '
+             << '"' << "tlb" << '"' << ": " << (
+                 thread_affinity.tlb.empty() ? "null"s : "\""s + thread_affinity.tlb + "\""s) << ',' << ' '
              << '"' << "event_groups" << '"' << ": "
              << thread_affinity.event_groups
              << '}';
@@ -589,8 +960,14 @@ std::ostream & operator<<(
              << trace_config.num_numa_domains() << ',' << '\n'
              << '"' << "bandwidth_per_numa_domain" << '"' << ": "
              << trace_config.bandwidth_per_numa_domain() << ',' << '\n'
+             << '"' << "latency_per_numa_domain" << '"' << ": "
+             << trace_config.latency_per_numa_domain() << ',' << '\n'
+             << '"' << "max_outstanding_misses" << '"' << ": "
+             << trace_config.max_outstanding_misses() << ',' << '\n'
              << '"' << "caches" << '"' << ": "
              << trace_config.caches() << ',' << '\n'
+             << '"' << "tlbs" << '"' << ": "
+             << trace_config.tlbs() << ',' << '\n'
              << '"' << "thread_affinities" << '"' << ": "
              << trace_config.thread_affinities()
              << '\n' << '}';
@@ -26,7 +26,14 @@ public:
           double bandwidth,
           std::vector<double> const & bandwidth_per_numa_domain,
           std::string const & cache_miss_event,
-          std::string const & parent);
+          std::string const & parent,
+          cache_size_type associativity = 0,
+          std::string const & replacement_policy = "lru",
+          std::string const & set_index = "modulo",
+          std::string const & prefetcher = "",
+          int prefetch_degree = 1,
+          int prefetch_distance = 1,
+          double latency = 0.0);
 
     std::string name;
     cache_size_type size;
@@ -35,12 +42,74 @@ public:
     std::vector<double> bandwidth_per_numa_domain;
     std::string cache_miss_event;
     std::string parent;
+
+    // The number of ways in each set, or zero for a fully
+    // associative cache
+    cache_size_type associativity;
+
+    // The replacement policy: "lru", "fifo", "rand", "plru", "nru",
+    // "srrip", "brrip" or "drrip"
+    std::string replacement_policy;
+
+    // The function used to map cache lines to sets in a
+    // set-associative cache: "modulo" or "xor"
+    std::string set_index;
+
+    // The hardware prefetcher: "next-line", "adjacent-line" or
+    // "stride", or empty if the cache has no prefetcher
+    std::string prefetcher;
+
+    // The number of cache lines fetched by each prefetch
+    int prefetch_degree;
+
+    // How many strides ahead of an access the stride prefetcher
+    // starts to fetch cache lines
+    int prefetch_distance;
+
+    // The time taken by a memory reference that hits in the cache (in
+    // nanoseconds), or zero if it is unknown
+    double latency;
 };
 
 std::ostream & operator<<(
     std::ostream & o,
     Cache const & trace_config);
 
+/*
+ * A translation lookaside buffer (TLB), which caches the translations
+ * of virtual to physical addresses for a number of pages.  Like a
+ * cache, a TLB may have a parent, such as a second-level (shared)
+ * TLB, which is looked up whenever a translation is missing.  A miss
+ * in a last-level TLB results in a page walk.
+ */
+class TLB
+{
+public:
+    TLB(std::string const & name,
+        cache_size_type entries,
+        cache_size_type page_size,
+        std::string const & parent,
+        cache_size_type associativity = 0);
+
+    std::string name;
+
+    // The number of translations held by the TLB
+    cache_size_type entries;
+
+    // The size of the pages that are translated (in bytes)
+    cache_size_type page_size;
+
+    std::string parent;
+
+    // The number of ways in each set, or zero for a fully
+    // associative TLB
+    cache_size_type associativity;
+};
+
+std::ostream & operator<<(
+    std::ostream & o,
+    TLB const & tlb);
+
 class EventGroup
 {
 public:
@@ -62,13 +131,17 @@ public:
         int cpu,
         std::string const & cache,
         int numa_domain,
-        std::vector<EventGroup> const & event_groups);
+        std::vector<EventGroup> const & event_groups,
+        std::string const & tlb = "");
 
     int thread;
     int cpu;
     std::string cache;
     int numa_domain;
     std::vector<EventGroup> event_groups;
+
+    // The first-level TLB of the thread, if any
+    std::string tlb;
 };
 
 class TraceConfig
@@ -81,7 +154,10 @@ public:
         int num_numa_domains,
         std::vector<double> const & bandwidth_per_numa_domain,
         std::map<std::string, Cache> const & caches,
-        std::vector<ThreadAffinity> const & thread_affinities);
+        std::vector<ThreadAffinity> const & thread_affinities,
+        std::map<std::string, TLB> const & tlbs = std::map<std::string, TLB>(),
+        std::vector<double> const & latency_per_numa_domain = std::vector<double>(),
+        int max_outstanding_misses = 10);
     ~TraceConfig();
 
     std::string const & name() const;
@@ -90,6 +166,9 @@ public:
     std::vector<double> const & bandwidth_per_numa_domain() const;
     std::map<std::string, Cache> const & caches() const;
     std::vector<ThreadAffinity> const & thread_affinities() const;
+    std::map<std::string, TLB> const & tlbs() const;
+    std::vector<double> const & latency_per_numa_domain() const;
+    int max_outstanding_misses() const;
     cache_size_type max_cache_size() const;
 
 private:
@@ -99,6 +178,9 @@ private:
     std::vector<double> bandwidth_per_numa_domain_;
     std::map<std::string, Cache> caches_;
     std::vector<ThreadAffinity> thread_affinities_;
+    std::map<std::string, TLB> tlbs_;
+    std::vector<double> latency_per_numa_domain_;
+    int max_outstanding_misses_;
 };
 
 TraceConfig read_trace_config(std::string const & path);
@@ -0,0 +1,192 @@
+#ifndef FLAT_HASH_MAP_HPP
+#define FLAT_HASH_MAP_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+ * A hash map from integer keys to values, stored in a single,
+ * contiguous array and using open addressing with linear probing.
+ *
+ * One key value, given when the map is constructed, is reserved to
+ * mark empty buckets and may not be inserted.  Erasing uses backward
+ * shift deletion, so that no tombstones are needed and lookups stay
+ * short even after many insertions and deletions.
+ */
+template <typename Key, typename T>
+class FlatHashMap
+{
+public:
+    typedef Key key_type;
+    typedef T mapped_type;
+    typedef std::pair<Key, T> value_type;
+    typedef typename std::vector<value_type>::size_type size_type;
+
+public:
+    FlatHashMap(Key empty_key, size_type capacity = 0u)
+        : empty_key(empty_key)
+        , buckets()
+        , mask(0u)
+        , shift(64u)
+        , num_elements(0u)
+    {
+        reserve(capacity);
+    }
+
+    ~FlatHashMap()
+    {
+    }
+
+    bool empty() const noexcept
+    {
+        return num_elements == 0u;
+    }
+
+    size_type size() const noexcept
+    {
+        return num_elements;
+    }
+
+    size_type bucket_count() const noexcept
+    {
+        return buckets.size();
+    }
+
+    void clear()
+    {
+        for (auto & bucket : buckets)
+            bucket.first = empty_key;
+        num_elements = 0u;
+    }
+
+    /*
+     * Make room for at least `capacity' elements, while keeping the
+     * load factor at or below one half.
+     */
+    void reserve(size_type capacity)
+    {
+        size_type n = 8u;
+        unsigned int log2n = 3u;
+        while (n < 2u * capacity) {
+            n *= 2u;
+            log2n++;
+        }
+        if (n <= buckets.size())
+            return;
+
+        std::vector<value_type> old_buckets(
+            n, std::make_pair(empty_key, T()));
+        old_buckets.swap(buckets);
+        mask = n - 1u;
+        shift = 64u - log2n;
+        num_elements = 0u;
+        for (auto const & bucket : old_buckets) {
+            if (bucket.first != empty_key)
+                insert(bucket.first, bucket.second);
+        }
+    }
+
+    T * find(Key key) noexcept
+    {
+        if (buckets.empty())
+            return nullptr;
+        for (size_type i = bucket(key);; i = (i + 1u) & mask) {
+            if (buckets[i].first == key)
+                return &buckets[i].second;
+            if (buckets[i].first == empty_key)
+                return nullptr;
+        }
+    }
+
+    T const * find(Key key) const noexcept
+    {
+        if (buckets.empty())
+            return nullptr;
+        for (size_type i = bucket(key);; i = (i + 1u) & mask) {
+            if (buckets[i].first == key)
+                return &buckets[i].second;
+            if (buckets[i].first == empty_key)
+                return nullptr;
+        }
+    }
+
+    /*
+     * Insert a key with the given value, or, if the key is already
+     * present, replace its value.
+     */
+    T & insert(Key key, T const & value)
+    {
+        if (2u * (num_elements + 1u) > buckets.size())
+            reserve(num_elements + 1u);
+
+        size_type i = bucket(key);
+        while (buckets[i].first != empty_key && buckets[i].first != key)
+            i = (i + 1u) & mask;
+        if (buckets[i].first == empty_key)
+            num_elements++;
+        buckets[i] = std::make_pair(key, value);
+        return buckets[i].second;
+    }
+
+    /*
+     * Call `f(key, value)' for every element, in no particular order.
+     */
+    template <typename F>
+    void for_each(F f) const
+    {
+        for (auto const & bucket : buckets) {
+            if (bucket.first != empty_key)
+                f(bucket.first, bucket.second);
+        }
+    }
+
+    bool erase(Key key) noexcept
+    {
+        if (buckets.empty())
+            return false;
+
+        size_type i = bucket(key);
+        while (buckets[i].first != key) {
+            if (buckets[i].first == empty_key)
+                return false;
+            i = (i + 1u) & mask;
+        }
+
+        // Shift subsequent elements of the probe sequence backwards
+        // to fill the hole left by the erased element.
+        size_type j = i;
+        for (;;) {
+            j = (j + 1u) & mask;
+            if (buckets[j].first == empty_key)
+                break;
+            size_type k = bucket(buckets[j].first);
+            if ((j > i && (k <= i || k > j)) ||
+                (j < i && (k <= i && k > j)))
+            {
+                buckets[i] = buckets[j];
+                i = j;
+            }
+        }
+        buckets[i].first = empty_key;
+        num_elements--;
+        return true;
+    }
+
+private:
+    size_type bucket(Key key) const noexcept
+    {
+        // Fibonacci hashing
+        return (size_type) (
+            ((uint64_t) key * UINT64_C(0x9e3779b97f4a7c15)) >> shift) & mask;
+    }
+
+private:
+    Key empty_key;
+    std::vector<value_type> buckets;
+    size_type mask;
+    unsigned int shift;
+    size_type num_elements;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef MEMORY_REFERENCE_HPP
+#define MEMORY_REFERENCE_HPP
+
+#include <cstdint>
+#include <utility>
+
+/*
+ * The kind of memory access made by a memory reference.  Loads and
+ * stores both bring the referenced cache line into the cache, and a
+ * store leaves it dirty, so that it must eventually be written back.
+ * A streaming (non-temporal) store bypasses the caches and writes
+ * directly to memory.
+ */
+enum class AccessType
+{
+    load = 0,
+    store = 1,
+    streaming_store = 2,
+};
+
+/*
+ * A memory reference, consisting of an address, the kind of access
+ * and the NUMA domain of the referenced memory, packed into a single
+ * 64-bit word.  The address occupies bits 0-53, which is more than
+ * the 48-bit virtual addresses of current 64-bit processors, the
+ * access type occupies bits 54-55, and the NUMA domain occupies the
+ * upper 8 bits, 56-63.
+ */
+class MemoryReference
+{
+public:
+    static constexpr int address_bits = 54;
+    static constexpr int access_type_bits = 2;
+    static constexpr uint64_t address_mask =
+        (uint64_t(1) << address_bits) - 1u;
+    static constexpr int numa_domain_shift = address_bits + access_type_bits;
+    static constexpr int max_numa_domains = 1 << (64 - numa_domain_shift);
+
+public:
+    MemoryReference()
+        : packed(0u)
+    {
+    }
+
+    MemoryReference(
+        uintptr_t address,
+        int numa_domain,
+        AccessType access_type = AccessType::load)
+        : packed((uint64_t(address) & address_mask) |
+                 (uint64_t(access_type) << address_bits) |
+                 (uint64_t(numa_domain) << numa_domain_shift))
+    {
+    }
+
+    template <typename Address, typename NumaDomain>
+    MemoryReference(std::pair<Address, NumaDomain> const & x)
+        : MemoryReference(x.first, x.second)
+    {
+    }
+
+    uintptr_t address() const
+    {
+        return packed & address_mask;
+    }
+
+    int numa_domain() const
+    {
+        return packed >> numa_domain_shift;
+    }
+
+    AccessType access_type() const
+    {
+        return AccessType(
+            (packed >> address_bits) & ((1u << access_type_bits) - 1u));
+    }
+
+    bool operator==(MemoryReference const & x) const
+    {
+        return packed == x.packed;
+    }
+
+    bool operator!=(MemoryReference const & x) const
+    {
+        return packed != x.packed;
+    }
+
+private:
+    uint64_t packed;
+};
+
+#endif
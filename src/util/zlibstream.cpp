@@ -97,6 +97,110 @@ int zlibstreambuf::underflow()
         : std::char_traits<char>::to_int_type(*this->gptr());
 }
 
+ozlibstreambuf::ozlibstreambuf(
+    std::streambuf * sbuf,
+    int level,
+    std::streamsize buf_size)
+    : sbuf_(sbuf)
+    , in_buf(buf_size)
+    , out_buf(buf_size)
+    , finished(false)
+{
+    memset(&zs, 0, sizeof(zs));
+    zs.zalloc = Z_NULL;
+    zs.zfree = Z_NULL;
+    zs.opaque = Z_NULL;
+    auto err = deflateInit2(&zs, level, Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK) {
+        auto s = std::stringstream{};
+        s << "deflateInit2(" << zs << ", " << level << ", Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY)";
+        throw zlibstream_error(err, s.str());
+    }
+    this->setp((char *)in_buf.data(), (char *)(in_buf.data() + in_buf.size()));
+}
+
+ozlibstreambuf::~ozlibstreambuf()
+{
+    try {
+        finish();
+    } catch (...) {
+    }
+    deflateEnd(&zs);
+}
+
+int ozlibstreambuf::overflow(int c)
+{
+    deflate_buffer(Z_NO_FLUSH);
+    if (!std::char_traits<char>::eq_int_type(c, std::char_traits<char>::eof())) {
+        *this->pptr() = std::char_traits<char>::to_char_type(c);
+        this->pbump(1);
+    }
+    return std::char_traits<char>::not_eof(c);
+}
+
+int ozlibstreambuf::sync()
+{
+    if (finished)
+        return 0;
+    deflate_buffer(Z_SYNC_FLUSH);
+    return sbuf_->pubsync();
+}
+
+void ozlibstreambuf::finish()
+{
+    if (finished)
+        return;
+    deflate_buffer(Z_FINISH);
+    finished = true;
+}
+
+/*
+ * Compress the data in the put area and write it to the underlying
+ * stream buffer.
+ */
+void ozlibstreambuf::deflate_buffer(int flush)
+{
+    if (finished)
+        throw zlibstream_error(Z_STREAM_ERROR, "Expected an unfinished stream");
+
+    zs.next_in = (Bytef *) this->pbase();
+    zs.avail_in = this->pptr() - this->pbase();
+    int err;
+    do {
+        zs.next_out = out_buf.data();
+        zs.avail_out = out_buf.size();
+        err = deflate(&zs, flush);
+        if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR) {
+            auto s = std::stringstream{};
+            s << "deflate(" << zs << ", " << flush << ")";
+            throw zlibstream_error(err, s.str());
+        }
+        std::streamsize size = out_buf.size() - zs.avail_out;
+        if (sbuf_->sputn((char *) out_buf.data(), size) != size)
+            throw zlibstream_error(Z_ERRNO, "Failed to write compressed data");
+    } while (zs.avail_out == 0 || (flush == Z_FINISH && err != Z_STREAM_END));
+    this->setp((char *)in_buf.data(), (char *)(in_buf.data() + in_buf.size()));
+}
+
+ozlibstream::ozlibstream(
+    std::streambuf * sbuf,
+    int level)
+    : std::ostream(nullptr)
+    , sbuf_(sbuf, level)
+{
+    this->init(&sbuf_);
+}
+
+void ozlibstream::finish()
+{
+    try {
+        sbuf_.finish();
+    } catch (zlibstream_error const &) {
+        this->setstate(std::ios::badbit);
+        throw;
+    }
+}
+
 zlibstream_base::zlibstream_base(std::streambuf * sbuf)
     : sbuf_(sbuf)
 {
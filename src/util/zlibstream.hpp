@@ -42,6 +42,43 @@ private:
     bool stream_initialized;
 };
 
+/*
+ * A stream buffer that compresses the data written to it in the gzip
+ * format, and writes it to another stream buffer.  The compressed
+ * stream is completed by `finish', or else when the stream buffer is
+ * destroyed.
+ */
+class ozlibstreambuf
+    : public std::streambuf
+{
+public:
+    ozlibstreambuf(
+        std::streambuf * sbuf,
+        int level = Z_DEFAULT_COMPRESSION,
+        std::streamsize buf_size = 128u*1024u);
+    ~ozlibstreambuf();
+
+    ozlibstreambuf(ozlibstreambuf const &) = delete;
+    ozlibstreambuf(ozlibstreambuf &&) = delete;
+    ozlibstreambuf & operator=(ozlibstreambuf const &) = delete;
+    ozlibstreambuf & operator=(ozlibstreambuf &&) = delete;
+
+    int overflow(int c) override;
+    int sync() override;
+
+    void finish();
+
+private:
+    void deflate_buffer(int flush);
+
+private:
+    std::streambuf * sbuf_;
+    std::vector<Bytef> in_buf;
+    std::vector<Bytef> out_buf;
+    z_stream zs;
+    bool finished;
+};
+
 class zlibstream_base
 {
 public:
@@ -58,6 +95,24 @@ public:
     izlibstream(std::streambuf * sbuf);
 };
 
+class ozlibstream
+    : public std::ostream
+{
+public:
+    ozlibstream(
+        std::streambuf * sbuf,
+        int level = Z_DEFAULT_COMPRESSION);
+
+    /*
+     * Complete the compressed stream, after which nothing more may
+     * be written.
+     */
+    void finish();
+
+private:
+    ozlibstreambuf sbuf_;
+};
+
 struct zlibstream_error
     : public std::system_error
 {
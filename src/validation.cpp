@@ -0,0 +1,196 @@
+#include "validation.hpp"
+#include "cache-trace.hpp"
+#include "profile-kernel.hpp"
+#include "trace-config.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+Profiling profile_cache_misses(
+    TraceConfig const & trace_config,
+    Kernel & kernel,
+    bool warmup,
+    bool flush_caches,
+    int runs,
+    perf::libpfm_context const & libpfm_context,
+    std::ostream & o,
+    bool verbose)
+{
+    auto const & caches = trace_config.caches();
+    auto const & thread_affinities = trace_config.thread_affinities();
+    int num_threads = thread_affinities.size();
+
+    // Each cache miss event is measured in a group of its own, so
+    // that the events of the different caches need not fit in the
+    // hardware performance counters at the same time.
+    std::vector<std::vector<EventGroup>> eventgroups_per_thread;
+    bool has_cache_miss_events = false;
+    for (int thread = 0; thread < num_threads; thread++) {
+        std::vector<EventGroup> event_groups =
+            thread_affinities[thread].event_groups;
+        std::vector<std::string> events;
+        for (auto const & event_group : event_groups)
+            events.insert(events.end(), event_group.events.begin(), event_group.events.end());
+
+        for (auto const & cache : caches) {
+            std::string const & event = cache.second.cache_miss_event;
+            if (event.empty())
+                continue;
+            has_cache_miss_events = true;
+            std::vector<int> threads = active_threads(trace_config, cache.second);
+            if (std::find(threads.begin(), threads.end(), thread) == threads.end() ||
+                std::find(events.begin(), events.end(), event) != events.end())
+            {
+                continue;
+            }
+            event_groups.push_back(
+                EventGroup(0, thread_affinities[thread].cpu, {event}));
+            events.push_back(event);
+        }
+        eventgroups_per_thread.push_back(event_groups);
+    }
+
+    if (!has_cache_miss_events) {
+        throw trace_config_error(
+            "Expected \"cache_miss_event\" to be given for at least one cache");
+    }
+
+    return profile_kernel(
+        trace_config, kernel, warmup, flush_caches,
+        runs, libpfm_context, eventgroups_per_thread,
+        o, verbose);
+}
+
+Validation::Validation(
+    CacheTrace const & cache_trace,
+    Profiling const & profiling)
+    : cache_trace_(cache_trace)
+    , profiling_(profiling)
+    , caches_()
+{
+    TraceConfig const & trace_config = cache_trace.trace_config();
+    auto const & cache_misses = cache_trace.cache_misses();
+    for (auto const & cache : trace_config.caches()) {
+        std::string const & event = cache.second.cache_miss_event;
+        auto it = cache_misses.find(cache.first);
+        if (event.empty() || it == cache_misses.end())
+            continue;
+
+        CacheMissValidation validation;
+        validation.event = event;
+        validation.threads = active_threads(trace_config, cache.second);
+        for (int thread : validation.threads) {
+            double simulated = 0.0;
+            for (auto count : (*it).second[thread])
+                simulated += count;
+
+            // Scale the counts of runs in which the event was
+            // multiplexed with other events.
+            ProfilingEvent profiling_event = make_profiling_event(
+                event, thread, profiling.profiling_runs());
+            double measured = 0.0;
+            for (std::size_t run = 0; run < profiling_event.counts.size(); run++) {
+                double count = profiling_event.counts[run];
+                if (profiling_event.time_running[run] > 0 &&
+                    profiling_event.time_running[run] < profiling_event.time_enabled[run])
+                {
+                    count *= double(profiling_event.time_enabled[run]) /
+                        double(profiling_event.time_running[run]);
+                }
+                measured += count;
+            }
+            if (!profiling_event.counts.empty())
+                measured /= profiling_event.counts.size();
+
+            double absolute_error = std::fabs(simulated - measured);
+            validation.simulated.push_back(simulated);
+            validation.measured.push_back(measured);
+            validation.absolute_error.push_back(absolute_error);
+            validation.relative_error.push_back(
+                measured > 0.0 ? absolute_error / measured : NAN);
+        }
+        caches_[cache.first] = validation;
+    }
+}
+
+Validation::~Validation()
+{
+}
+
+CacheTrace const & Validation::cache_trace() const
+{
+    return cache_trace_;
+}
+
+Profiling const & Validation::profiling() const
+{
+    return profiling_;
+}
+
+std::map<std::string, CacheMissValidation> const & Validation::caches() const
+{
+    return caches_;
+}
+
+namespace
+{
+
+template <typename T>
+std::ostream & print_array(
+    std::ostream & o,
+    std::vector<T> const & v)
+{
+    o << '[';
+    for (std::size_t i = 0; i < v.size(); i++) {
+        o << (i > 0 ? ", " : "");
+        if (std::isnan(double(v[i])))
+            o << "null";
+        else
+            o << v[i];
+    }
+    return o << ']';
+}
+
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    CacheMissValidation const & validation)
+{
+    o << '{' << '\n'
+      << '"' << "event" << '"' << ": "
+      << '"' << validation.event << '"' << ',' << '\n'
+      << '"' << "threads" << '"' << ": ";
+    print_array(o, validation.threads) << ',' << '\n'
+      << '"' << "simulated" << '"' << ": ";
+    print_array(o, validation.simulated) << ',' << '\n'
+      << '"' << "measured" << '"' << ": ";
+    print_array(o, validation.measured) << ',' << '\n'
+      << '"' << "absolute_error" << '"' << ": ";
+    print_array(o, validation.absolute_error) << ',' << '\n'
+      << '"' << "relative_error" << '"' << ": ";
+    print_array(o, validation.relative_error);
+    return o << '\n' << '}';
+}
+
+std::ostream & operator<<(
+    std::ostream & o,
+    Validation const & validation)
+{
+    o << '{' << '\n'
+      << '"' << "cache_trace" << '"' << ": "
+      << validation.cache_trace() << ',' << '\n'
+      << '"' << "profiling" << '"' << ": "
+      << validation.profiling() << ',' << '\n'
+      << '"' << "validation" << '"' << ": " << '{';
+    auto const & caches = validation.caches();
+    for (auto it = caches.cbegin(); it != caches.cend(); ++it) {
+        o << (it == caches.cbegin() ? "" : ",") << '\n'
+          << '"' << (*it).first << '"' << ": " << (*it).second;
+    }
+    return o << '\n' << '}' << '\n' << '}';
+}
@@ -0,0 +1,78 @@
+#ifndef VALIDATION_HPP
+#define VALIDATION_HPP
+
+#include "cache-trace.hpp"
+#include "profile-kernel.hpp"
+#include "trace-config.hpp"
+#include "kernels/kernel.hpp"
+#include "util/perf-events.hpp"
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Profile a kernel, while measuring the `cache_miss_event' of every
+ * cache that each thread uses, in addition to the event groups of the
+ * trace configuration.
+ */
+Profiling profile_cache_misses(
+    TraceConfig const & trace_config,
+    Kernel & kernel,
+    bool warmup,
+    bool flush_caches,
+    int runs,
+    perf::libpfm_context const & libpfm_context,
+    std::ostream & o,
+    bool verbose);
+
+/*
+ * The simulated and measured cache misses of a cache, for each thread
+ * that uses the cache.
+ */
+struct CacheMissValidation
+{
+    std::string event;
+    std::vector<int> threads;
+    std::vector<double> simulated;
+    std::vector<double> measured;
+    std::vector<double> absolute_error;
+    std::vector<double> relative_error;
+};
+
+/*
+ * A comparison of simulated cache misses with those measured by
+ * hardware performance counters, for every cache that has a
+ * `cache_miss_event'.
+ *
+ * The measured cache misses of a thread are the mean count of the
+ * event over the profiling runs, scaled up if the event was only
+ * counted part of the time, and the simulated cache misses are those
+ * of the thread, summed over NUMA domains.  The absolute error is the
+ * magnitude of their difference, and the relative error is the
+ * absolute error divided by the measured cache misses.
+ */
+class Validation
+{
+public:
+    Validation(
+        CacheTrace const & cache_trace,
+        Profiling const & profiling);
+    ~Validation();
+
+    CacheTrace const & cache_trace() const;
+    Profiling const & profiling() const;
+    std::map<std::string, CacheMissValidation> const & caches() const;
+
+private:
+    CacheTrace const & cache_trace_;
+    Profiling const & profiling_;
+    std::map<std::string, CacheMissValidation> caches_;
+};
+
+std::ostream & operator<<(
+    std::ostream & o,
+    Validation const & validation);
+
+#endif
@@ -0,0 +1,182 @@
+#include "cache-simulation/checkpoint.hpp"
+#include "cache-simulation/hierarchy.hpp"
+#include "cache-simulation/prefetch.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace
+{
+
+replacement::MemoryReferenceString memory_reference_string(
+    std::size_t size)
+{
+    replacement::MemoryReferenceString w;
+    uint64_t x = 1;
+    for (std::size_t i = 0; i < size; i++) {
+        x = x * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+        w.push_back({replacement::memory_reference_type((x >> 33) % 4096), 0});
+    }
+    return w;
+}
+
+/*
+ * Simulate a replacement algorithm, but save its state halfway and
+ * continue the simulation with a copy that was restored from the
+ * saved state.  The cache misses and victims should be the same.
+ */
+void expect_same_after_restore(
+    replacement::ReplacementAlgorithm & A,
+    replacement::ReplacementAlgorithm & B)
+{
+    auto w = memory_reference_string(4096);
+    for (std::size_t i = 0; i < w.size() / 2; i++)
+        A.access(w[i].address(), 0, replacement::AccessType::store);
+    std::stringstream s;
+    A.save(s);
+    B.load(s);
+    for (std::size_t i = w.size() / 2; i < w.size(); i++) {
+        ASSERT_EQ(
+            A.access(w[i].address(), 0, replacement::AccessType::store),
+            B.access(w[i].address(), 0, replacement::AccessType::store));
+        ASSERT_EQ(A.victim(), B.victim());
+        ASSERT_EQ(A.write_back(), B.write_back());
+    }
+}
+
+}
+
+TEST(checkpoint, replacement_algorithms)
+{
+    {
+        replacement::LRU A(64, 8), B(64, 8);
+        expect_same_after_restore(A, B);
+    }
+    {
+        replacement::FIFO A(64, 8), B(64, 8);
+        expect_same_after_restore(A, B);
+    }
+    {
+        replacement::RAND A(64, 8, {}, 1), B(64, 8, {}, 1);
+        expect_same_after_restore(A, B);
+    }
+    {
+        replacement::SetAssociativeLRU A(64, 8, 4), B(64, 8, 4);
+        expect_same_after_restore(A, B);
+    }
+    {
+        replacement::SetAssociativeRAND A(64, 8, 4), B(64, 8, 4);
+        expect_same_after_restore(A, B);
+    }
+    {
+        replacement::SetAssociativePLRU A(64, 8, 8), B(64, 8, 8);
+        expect_same_after_restore(A, B);
+    }
+    {
+        replacement::SetAssociativeRRIP A(
+            2048, 8, 8, replacement::RRIPInsertionPolicy::dynamic_rrip);
+        replacement::SetAssociativeRRIP B(
+            2048, 8, 8, replacement::RRIPInsertionPolicy::dynamic_rrip);
+        expect_same_after_restore(A, B);
+    }
+
+    replacement::LRU A(64, 8), B(32, 8);
+    std::stringstream s;
+    A.save(s);
+    ASSERT_THROW(B.load(s), replacement::checkpoint_error);
+}
+
+/*
+ * A finished simulation leaves a checkpoint, from which it is resumed
+ * without simulating any further memory references.
+ */
+TEST(checkpoint, trace_cache_traffic)
+{
+    char dir[] = "/tmp/test_checkpoint.XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    replacement::Checkpoint checkpoint(dir, 600, true);
+    auto c = checkpoint.for_simulation("lru");
+    ASSERT_EQ(-1, c.saved_pass());
+
+    auto w = memory_reference_string(4096);
+    replacement::MemoryReferenceStringGenerator generator(w);
+    std::vector<replacement::MemoryReferenceGenerator const *> ws{&generator};
+    replacement::LRU A(64, 8);
+    replacement::StridePrefetcher prefetcher_A(8);
+    replacement::CacheTrafficOptions options;
+    options.prefetcher = &prefetcher_A;
+    options.checkpoint = &c;
+    auto traffic = replacement::trace_cache_traffic(A, ws, 1, options);
+    ASSERT_EQ(0, c.saved_pass());
+
+    replacement::LRU B(64, 8);
+    replacement::StridePrefetcher prefetcher_B(8);
+    options.prefetcher = &prefetcher_B;
+    auto resumed_traffic = replacement::trace_cache_traffic(B, ws, 1, options);
+    ASSERT_EQ(traffic.cache_misses, resumed_traffic.cache_misses);
+    ASSERT_EQ(traffic.write_backs, resumed_traffic.write_backs);
+    ASSERT_EQ(traffic.prefetch_fills, resumed_traffic.prefetch_fills);
+    ASSERT_TRUE(B.contains(w.back().address()));
+
+    auto v = memory_reference_string(1024);
+    replacement::MemoryReferenceStringGenerator v_generator(v);
+    std::vector<replacement::MemoryReferenceGenerator const *> vs{&v_generator};
+    replacement::LRU C(64, 8);
+    replacement::StridePrefetcher prefetcher_C(8);
+    options.prefetcher = &prefetcher_C;
+    ASSERT_THROW(
+        replacement::trace_cache_traffic(C, vs, 1, options),
+        replacement::checkpoint_error);
+
+    // The same number of memory references to different addresses
+    auto u = memory_reference_string(4096);
+    for (auto & x : u)
+        x = replacement::MemoryReference(x.address() + 64, 0);
+    replacement::MemoryReferenceStringGenerator u_generator(u);
+    std::vector<replacement::MemoryReferenceGenerator const *> us{&u_generator};
+    replacement::LRU D(64, 8);
+    options.prefetcher = nullptr;
+    ASSERT_THROW(
+        replacement::trace_cache_traffic(D, us, 1, options),
+        replacement::checkpoint_error);
+
+    std::remove(c.path().c_str());
+    rmdir(dir);
+}
+
+TEST(checkpoint, hierarchy)
+{
+    auto w = memory_reference_string(4096);
+    auto L1 = replacement::LRU(16, 8);
+    auto L2 = replacement::SetAssociativeLRU(64, 8, 4);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1, replacement::InclusionPolicy::inclusive);
+    int l1 = H.add_cache(L1, l2);
+    H.reset(1, 1);
+    for (std::size_t i = 0; i < w.size() / 2; i++)
+        H.reference(l1, w[i].address(), 0, 0);
+    std::stringstream s;
+    H.save(s);
+
+    auto M1 = replacement::LRU(16, 8);
+    auto M2 = replacement::SetAssociativeLRU(64, 8, 4);
+    replacement::CacheHierarchy G;
+    G.add_cache(M2, -1, replacement::InclusionPolicy::inclusive);
+    G.add_cache(M1, l2);
+    G.reset(1, 1);
+    G.load(s);
+    for (std::size_t i = w.size() / 2; i < w.size(); i++) {
+        H.reference(l1, w[i].address(), 0, 0);
+        G.reference(l1, w[i].address(), 0, 0);
+    }
+    ASSERT_EQ(H.cache_misses(), G.cache_misses());
+}
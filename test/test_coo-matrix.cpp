@@ -8,6 +8,7 @@
 
 #include <omp.h>
 
+#include <algorithm>
 #include <cmath>
 #include <numeric>
 #include <stdexcept>
@@ -142,3 +143,45 @@ TEST(coo_matrix, poisson2D_parallel)
         std::cbegin(poisson2D_result), std::cend(poisson2D_result)};
     ASSERT_NEAR(l2norm(y - z), 0.0, std::numeric_limits<double>::epsilon());
 }
+
+TEST(coo_matrix, spmv_memory_reference_substring)
+{
+    auto A = testMatrix();
+    auto x = coo_matrix::value_array_type(A.columns, 1.0);
+    auto y = coo_matrix::value_array_type(A.rows, 0.0);
+    int numa_domains[] = {0, 1, 2};
+    for (int num_threads = 1; num_threads <= 3; num_threads++) {
+        auto workspace = coo_matrix::value_array_type(num_threads * A.rows, 0.0);
+        for (int thread = 0; thread < num_threads; thread++) {
+            auto w = A.spmv_memory_reference_string(
+                x, y, workspace, thread, num_threads, numa_domains, 4096);
+            auto u = A.spmv_atomic_memory_reference_string(
+                x, y, thread, num_threads, numa_domains, 4096);
+            ASSERT_EQ(w.size(), A.spmv_memory_reference_string_size(
+                          thread, num_threads));
+            ASSERT_EQ(u.size(), A.spmv_atomic_memory_reference_string_size(
+                          thread, num_threads));
+            for (std::size_t offset = 0; offset <= w.size(); offset++) {
+                for (std::size_t count = 0; offset + count <= w.size(); count++) {
+                    auto v = std::vector<MemoryReference>(count);
+                    A.spmv_memory_reference_substring(
+                        x, y, workspace, thread, num_threads, numa_domains, 4096,
+                        offset, count, v.data());
+                    ASSERT_TRUE(std::equal(v.begin(), v.end(), w.begin() + offset))
+                        << "thread " << thread << " of " << num_threads << ", "
+                        << "offset " << offset << ", count " << count;
+                }
+            }
+            for (std::size_t offset = 0; offset <= u.size(); offset++) {
+                std::size_t count = u.size() - offset;
+                auto v = std::vector<MemoryReference>(count);
+                A.spmv_atomic_memory_reference_substring(
+                    x, y, thread, num_threads, numa_domains, 4096,
+                    offset, count, v.data());
+                ASSERT_TRUE(std::equal(v.begin(), v.end(), u.begin() + offset))
+                    << "thread " << thread << " of " << num_threads << ", "
+                    << "offset " << offset;
+            }
+        }
+    }
+}
@@ -8,8 +8,10 @@
 
 #include <omp.h>
 
+#include <algorithm>
 #include <cmath>
 #include <numeric>
+#include <set>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -279,3 +281,99 @@ TEST(csr_matrix, poisson2D_spmv_mkl)
     ASSERT_NEAR(l2norm(y - z), 0.0, std::numeric_limits<double>::epsilon());
 }
 #endif
+
+TEST(csr_matrix, spmv_memory_reference_string)
+{
+    auto A = testMatrix();
+    auto x = csr_matrix::value_array_type(A.columns, 1.0);
+    auto y = csr_matrix::value_array_type(A.rows, 0.0);
+    int numa_domains[] = {0, 1};
+    auto w = A.spmv_memory_reference_string(x, y, 0, 2, numa_domains, 4096);
+    auto expected = std::vector<MemoryReference>{
+        {uintptr_t(&A.row_ptr[0]), 0},
+        {uintptr_t(&A.row_ptr[1]), 0},
+        {uintptr_t(&A.column_index[0]), 0},
+        {uintptr_t(&A.value[0]), 0},
+        {uintptr_t(&x[0]), 0},
+        {uintptr_t(&A.column_index[1]), 0},
+        {uintptr_t(&A.value[1]), 0},
+        {uintptr_t(&x[1]), 0},
+        {uintptr_t(&y[0]), 0, AccessType::store},
+        {uintptr_t(&A.row_ptr[2]), 0},
+        {uintptr_t(&A.column_index[2]), 0},
+        {uintptr_t(&A.value[2]), 0},
+        {uintptr_t(&x[1]), 0},
+        {uintptr_t(&y[1]), 0, AccessType::store}};
+    ASSERT_EQ(expected, w);
+    ASSERT_EQ(expected.size(), A.spmv_memory_reference_string_size(0, 2));
+}
+
+TEST(csr_matrix, spmv_memory_reference_substring)
+{
+    auto A = testMatrix();
+    auto x = csr_matrix::value_array_type(A.columns, 1.0);
+    auto y = csr_matrix::value_array_type(A.rows, 0.0);
+    int numa_domains[] = {0, 1, 2};
+    for (int num_threads = 1; num_threads <= 3; num_threads++) {
+        for (int thread = 0; thread < num_threads; thread++) {
+            auto w = A.spmv_memory_reference_string(
+                x, y, thread, num_threads, numa_domains, 4096);
+            ASSERT_EQ(w.size(), A.spmv_memory_reference_string_size(
+                          thread, num_threads));
+            for (std::size_t offset = 0; offset <= w.size(); offset++) {
+                for (std::size_t count = 0; offset + count <= w.size(); count++) {
+                    auto v = std::vector<MemoryReference>(count);
+                    A.spmv_memory_reference_substring(
+                        x, y, thread, num_threads, numa_domains, 4096,
+                        offset, count, v.data());
+                    ASSERT_TRUE(std::equal(v.begin(), v.end(), w.begin() + offset))
+                        << "thread " << thread << " of " << num_threads << ", "
+                        << "offset " << offset << ", count " << count;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * With caches that are large enough to hold every cache line used by
+ * a thread, each distinct cache line misses exactly once, and each
+ * cache line of the result vector is written back.
+ */
+TEST(csr_matrix, spmv_estimate_cache_misses)
+{
+    std::istringstream stream{poisson2D};
+    auto mm = matrix_market::fromStream(stream);
+    auto A = csr_matrix::from_matrix_market(mm);
+    auto x = csr_matrix::value_array_type(A.columns, 1.0);
+    auto y = csr_matrix::value_array_type(A.rows, 0.0);
+    int numa_domains[] = {0, 0, 0};
+    std::vector<std::size_t> cache_sizes{std::size_t(1) << 30, std::size_t(1) << 30};
+    std::vector<std::size_t> line_sizes{64, 128};
+    for (int num_threads = 1; num_threads <= 3; num_threads++) {
+        for (int thread = 0; thread < num_threads; thread++) {
+            std::vector<std::vector<uint64_t>> cache_misses(
+                cache_sizes.size(), std::vector<uint64_t>(1, 0));
+            std::vector<std::vector<uint64_t>> write_backs(cache_misses);
+            A.spmv_estimate_cache_misses(
+                x, y, thread, num_threads, numa_domains, 4096,
+                cache_sizes, line_sizes, cache_misses, write_backs);
+
+            auto w = A.spmv_memory_reference_string(
+                x, y, thread, num_threads, numa_domains, 4096);
+            for (std::size_t c = 0; c < cache_sizes.size(); c++) {
+                std::set<uintptr_t> lines;
+                std::set<uintptr_t> y_lines;
+                for (auto const & reference : w) {
+                    lines.insert(reference.address() / line_sizes[c]);
+                    if (reference.access_type() == AccessType::store)
+                        y_lines.insert(reference.address() / line_sizes[c]);
+                }
+                ASSERT_EQ(lines.size(), cache_misses[c][0])
+                    << "thread " << thread << " of " << num_threads;
+                ASSERT_EQ(y_lines.size(), write_backs[c][0])
+                    << "thread " << thread << " of " << num_threads;
+            }
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#include "util/flat-hash-map.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+static constexpr uint64_t empty_key = std::numeric_limits<uint64_t>::max();
+
+TEST(flat_hash_map, empty)
+{
+    FlatHashMap<uint64_t, int> m(empty_key);
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(m.size(), 0u);
+    ASSERT_EQ(m.find(0u), nullptr);
+}
+
+TEST(flat_hash_map, insert)
+{
+    FlatHashMap<uint64_t, int> m(empty_key);
+    m.insert(1u, 10);
+    m.insert(2u, 20);
+    ASSERT_FALSE(m.empty());
+    ASSERT_EQ(m.size(), 2u);
+    ASSERT_NE(m.find(1u), nullptr);
+    ASSERT_EQ(*m.find(1u), 10);
+    ASSERT_EQ(*m.find(2u), 20);
+    ASSERT_EQ(m.find(3u), nullptr);
+
+    m.insert(1u, 11);
+    ASSERT_EQ(m.size(), 2u);
+    ASSERT_EQ(*m.find(1u), 11);
+}
+
+TEST(flat_hash_map, erase)
+{
+    FlatHashMap<uint64_t, int> m(empty_key);
+    m.insert(1u, 10);
+    m.insert(2u, 20);
+    ASSERT_TRUE(m.erase(1u));
+    ASSERT_FALSE(m.erase(1u));
+    ASSERT_EQ(m.size(), 1u);
+    ASSERT_EQ(m.find(1u), nullptr);
+    ASSERT_EQ(*m.find(2u), 20);
+}
+
+TEST(flat_hash_map, clear)
+{
+    FlatHashMap<uint64_t, int> m(empty_key, 16u);
+    m.insert(1u, 10);
+    m.insert(2u, 20);
+    m.clear();
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(m.find(1u), nullptr);
+    ASSERT_EQ(m.find(2u), nullptr);
+}
+
+TEST(flat_hash_map, many_insertions_and_deletions)
+{
+    FlatHashMap<uint64_t, uint64_t> m(empty_key, 64u);
+    std::unordered_map<uint64_t, uint64_t> n;
+    uint64_t x = 1u;
+    for (int i = 0; i < 100000; i++) {
+        x = x * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+        uint64_t key = (x >> 33) % 512u;
+        if ((x >> 20) & 1u) {
+            m.insert(key, i);
+            n[key] = i;
+        } else {
+            ASSERT_EQ(m.erase(key), n.erase(key) > 0u);
+        }
+        ASSERT_EQ(m.size(), n.size());
+    }
+
+    for (uint64_t key = 0; key < 512u; key++) {
+        auto it = n.find(key);
+        if (it == n.end()) {
+            ASSERT_EQ(m.find(key), nullptr);
+        } else {
+            ASSERT_NE(m.find(key), nullptr);
+            ASSERT_EQ(*m.find(key), (*it).second);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#include "cache-simulation/heatmap.hpp"
+#include "cache-simulation/hierarchy.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+TEST(heatmap, bins)
+{
+    auto heatmap = replacement::Heatmap(10, 4, 3, 8);
+    ASSERT_EQ(3u, heatmap.row_bins());
+    ASSERT_EQ(4u, heatmap.column_bins());
+    ASSERT_EQ(0u, heatmap.row_begin(0));
+    ASSERT_EQ(4u, heatmap.row_begin(1));
+    ASSERT_EQ(7u, heatmap.row_begin(2));
+    ASSERT_EQ(10u, heatmap.row_begin(3));
+    heatmap.add({3, 0});
+    heatmap.add({4, 3});
+    heatmap.add({9, 2}, 2);
+    heatmap.add({-1, 17});
+    ASSERT_EQ(1u, heatmap(0, 0));
+    ASSERT_EQ(1u, heatmap(1, 3));
+    ASSERT_EQ(2u, heatmap(2, 2));
+    ASSERT_EQ(1u, heatmap(0, 3));
+    heatmap.scale(2.5);
+    ASSERT_EQ(5u, heatmap(2, 2));
+}
+
+TEST(heatmap, save_and_load)
+{
+    auto a = replacement::Heatmap(4, 4, 2, 2);
+    a.add({3, 1}, 7);
+    std::stringstream s;
+    a.save(s);
+    auto b = replacement::Heatmap(4, 4, 2, 2);
+    b.load(s);
+    ASSERT_EQ(7u, b(1, 0));
+}
+
+/*
+ * References to the arrays of a locator update the row or the column
+ * of the location, and other references leave it unchanged.
+ */
+TEST(heatmap, matrix_locator)
+{
+    std::vector<int32_t> row_ptr{0, 2, 3, 5};
+    std::vector<int32_t> column_index{0, 2, 1, 0, 2};
+    std::vector<double> x(3);
+    auto locator = replacement::MatrixLocator(
+        3, 3,
+        std::vector<replacement::MatrixLocatorArray>{
+            replacement::make_matrix_locator_array(
+                replacement::MatrixLocatorArray::row, row_ptr, 1, -1),
+            replacement::make_matrix_locator_array(
+                replacement::MatrixLocatorArray::column, column_index, column_index),
+            replacement::make_matrix_locator_array(
+                replacement::MatrixLocatorArray::column, x)});
+    ASSERT_FALSE(locator.empty());
+    ASSERT_TRUE(replacement::MatrixLocator().empty());
+
+    replacement::MatrixLocation location{0, 0};
+    locator.locate(uintptr_t(&row_ptr[2]), location);
+    ASSERT_EQ(1, location.row);
+    locator.locate(uintptr_t(&column_index[4]), location);
+    ASSERT_EQ(2, location.column);
+    locator.locate(uintptr_t(&x[1]), location);
+    ASSERT_EQ(1, location.column);
+    locator.locate(uintptr_t(x.data() + 3), location);
+    ASSERT_EQ(1, location.row);
+    ASSERT_EQ(1, location.column);
+}
+
+/*
+ * Each cache miss is counted at the location of the processor that
+ * made it, both for a single cache and in a cache hierarchy.
+ */
+TEST(heatmap, trace_cache_traffic)
+{
+    std::vector<double> y(16);
+    std::vector<double> x(16);
+    auto locator = replacement::MatrixLocator(
+        16, 16,
+        std::vector<replacement::MatrixLocatorArray>{
+            replacement::make_matrix_locator_array(
+                replacement::MatrixLocatorArray::row, y),
+            replacement::make_matrix_locator_array(
+                replacement::MatrixLocatorArray::column, x)});
+    auto ref = [](double const & a) {
+        return replacement::MemoryReference{uintptr_t(&a), 0}; };
+    replacement::MemoryReferenceString w{
+        ref(y[0]), ref(x[0]), ref(x[0]), ref(y[12]), ref(x[15])};
+    replacement::MemoryReferenceStringGenerator generator(w);
+    std::vector<replacement::MemoryReferenceGenerator const *> ws{&generator};
+
+    auto heatmap = replacement::Heatmap(16, 16, 2, 2);
+    auto A = replacement::LRU(64, 64);
+    replacement::CacheTrafficOptions options;
+    options.locator = &locator;
+    options.heatmap = &heatmap;
+    auto traffic = replacement::trace_cache_traffic(A, ws, 1, options);
+    replacement::cache_miss_type misses = 0;
+    for (std::size_t i = 0; i < 2; i++) {
+        for (std::size_t j = 0; j < 2; j++)
+            misses += heatmap(i, j);
+    }
+    ASSERT_EQ(traffic.cache_misses[0][0], misses);
+    ASSERT_LE(1u, heatmap(1, 1));
+
+    auto L1 = replacement::LRU(64, 64);
+    replacement::CacheHierarchy H;
+    int l1 = H.add_cache(L1, -1);
+    H.enable_heatmaps(locator, replacement::Heatmap(16, 16, 2, 2));
+    replacement::trace_cache_misses(H, {l1}, {w}, 1);
+    replacement::Heatmap const & h = H.heatmaps()[l1];
+    ASSERT_EQ(heatmap(0, 0), h(0, 0));
+    ASSERT_EQ(heatmap(1, 1), h(1, 1));
+}
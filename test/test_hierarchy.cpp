@@ -0,0 +1,236 @@
+#include "cache-simulation/hierarchy.hpp"
+
+#include <gtest/gtest.h>
+
+/*
+ * Only the cache misses of the first-level cache reach the
+ * second-level cache.
+ */
+TEST(hierarchy, non_inclusive)
+{
+    auto L1 = replacement::LRU(2, 1);
+    auto L2 = replacement::LRU(2, 1);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1);
+    int l1 = H.add_cache(L1, l2);
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {std::make_pair(0,0),
+         std::make_pair(1,0),
+         std::make_pair(0,0),
+         std::make_pair(2,0),
+         std::make_pair(0,0)}};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<std::vector<std::vector<replacement::cache_miss_type>>> cache_misses =
+        replacement::trace_cache_misses(H, {l1}, ws, num_numa_domains);
+    ASSERT_EQ(3u, cache_misses[l1][0][0]);
+    ASSERT_EQ(3u, cache_misses[l2][0][0]);
+}
+
+/*
+ * An inclusive cache invalidates its victims in the caches above it,
+ * which causes an additional cache miss in the first-level cache.
+ */
+TEST(hierarchy, inclusive)
+{
+    auto L1 = replacement::LRU(2, 1);
+    auto L2 = replacement::LRU(2, 1);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1, replacement::InclusionPolicy::inclusive);
+    int l1 = H.add_cache(L1, l2);
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {std::make_pair(0,0),
+         std::make_pair(1,0),
+         std::make_pair(0,0),
+         std::make_pair(2,0),
+         std::make_pair(0,0)}};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<std::vector<std::vector<replacement::cache_miss_type>>> cache_misses =
+        replacement::trace_cache_misses(H, {l1}, ws, num_numa_domains);
+    ASSERT_EQ(4u, cache_misses[l1][0][0]);
+    ASSERT_EQ(4u, cache_misses[l2][0][0]);
+}
+
+/*
+ * An exclusive cache holds the victims of the caches above it, so
+ * that the capacity of the two caches adds up.
+ */
+TEST(hierarchy, exclusive)
+{
+    auto L1 = replacement::LRU(1, 1);
+    auto L2 = replacement::LRU(1, 1);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1, replacement::InclusionPolicy::exclusive);
+    int l1 = H.add_cache(L1, l2);
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {std::make_pair(0,0),
+         std::make_pair(1,0),
+         std::make_pair(0,0),
+         std::make_pair(1,0),
+         std::make_pair(0,0)}};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<std::vector<std::vector<replacement::cache_miss_type>>> cache_misses =
+        replacement::trace_cache_misses(H, {l1}, ws, num_numa_domains);
+    ASSERT_EQ(5u, cache_misses[l1][0][0]);
+    ASSERT_EQ(2u, cache_misses[l2][0][0]);
+}
+
+/*
+ * Test two threads with private first-level caches and a shared
+ * second-level cache.
+ */
+TEST(hierarchy, shared_cache)
+{
+    auto L1_0 = replacement::LRU(1, 1);
+    auto L1_1 = replacement::LRU(1, 1);
+    auto L2 = replacement::LRU(4, 1);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1);
+    int l1_0 = H.add_cache(L1_0, l2);
+    int l1_1 = H.add_cache(L1_1, l2);
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {std::make_pair(0,0),
+         std::make_pair(1,0),
+         std::make_pair(0,0)},
+        {std::make_pair(0,0),
+         std::make_pair(2,1)}};
+    replacement::numa_domain_type num_numa_domains = 2;
+    std::vector<std::vector<std::vector<replacement::cache_miss_type>>> cache_misses =
+        replacement::trace_cache_misses(H, {l1_0, l1_1}, ws, num_numa_domains);
+    ASSERT_EQ(3u, cache_misses[l1_0][0][0]);
+    ASSERT_EQ(0u, cache_misses[l1_0][1][0]);
+    ASSERT_EQ(1u, cache_misses[l1_1][1][0]);
+    ASSERT_EQ(1u, cache_misses[l1_1][1][1]);
+    ASSERT_EQ(2u, cache_misses[l2][0][0]);
+    ASSERT_EQ(0u, cache_misses[l2][1][0]);
+    ASSERT_EQ(1u, cache_misses[l2][1][1]);
+}
+
+/*
+ * Dirty cache lines are written back to the parent cache, if it holds
+ * the cache line, and otherwise to memory.
+ */
+TEST(hierarchy, write_back)
+{
+    auto L1 = replacement::LRU(1, 1);
+    auto L2 = replacement::LRU(2, 1);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1);
+    int l1 = H.add_cache(L1, l2);
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {replacement::MemoryReference(0, 0, replacement::AccessType::store),
+         replacement::MemoryReference(1, 0, replacement::AccessType::load),
+         replacement::MemoryReference(2, 0, replacement::AccessType::load)}};
+    replacement::numa_domain_type num_numa_domains = 1;
+    replacement::trace_cache_misses(H, {l1}, ws, num_numa_domains);
+    ASSERT_EQ(1u, H.write_backs()[l1][0][0]);
+    ASSERT_EQ(1u, H.write_backs()[l2][0][0]);
+}
+
+/*
+ * A dirty cache line that is back-invalidated by an inclusive cache
+ * is written back from the inclusive cache.
+ */
+TEST(hierarchy, inclusive_write_back)
+{
+    auto L1 = replacement::LRU(2, 1);
+    auto L2 = replacement::LRU(2, 1);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1, replacement::InclusionPolicy::inclusive);
+    int l1 = H.add_cache(L1, l2);
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {replacement::MemoryReference(0, 0, replacement::AccessType::store),
+         replacement::MemoryReference(1, 0, replacement::AccessType::load),
+         replacement::MemoryReference(0, 0, replacement::AccessType::load),
+         replacement::MemoryReference(2, 0, replacement::AccessType::load)}};
+    replacement::numa_domain_type num_numa_domains = 1;
+    replacement::trace_cache_misses(H, {l1}, ws, num_numa_domains);
+    ASSERT_EQ(0u, H.write_backs()[l1][0][0]);
+    ASSERT_EQ(1u, H.write_backs()[l2][0][0]);
+}
+
+/*
+ * An exclusive cache holds dirty victims of the caches above it and
+ * hands them back, still dirty, when they are referenced again.
+ */
+TEST(hierarchy, exclusive_write_back)
+{
+    auto L1 = replacement::LRU(1, 1);
+    auto L2 = replacement::LRU(1, 1);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1, replacement::InclusionPolicy::exclusive);
+    int l1 = H.add_cache(L1, l2);
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {replacement::MemoryReference(0, 0, replacement::AccessType::store),
+         replacement::MemoryReference(1, 0, replacement::AccessType::load),
+         replacement::MemoryReference(0, 0, replacement::AccessType::load),
+         replacement::MemoryReference(2, 0, replacement::AccessType::load),
+         replacement::MemoryReference(3, 0, replacement::AccessType::load)}};
+    replacement::numa_domain_type num_numa_domains = 1;
+    replacement::trace_cache_misses(H, {l1}, ws, num_numa_domains);
+    ASSERT_EQ(2u, H.write_backs()[l1][0][0]);
+    ASSERT_EQ(1u, H.write_backs()[l2][0][0]);
+}
+
+/*
+ * Streaming stores bypass every cache in the hierarchy.
+ */
+TEST(hierarchy, streaming_store)
+{
+    auto L1 = replacement::LRU(2, 1);
+    auto L2 = replacement::LRU(2, 1);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1);
+    int l1 = H.add_cache(L1, l2);
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {replacement::MemoryReference(0, 0, replacement::AccessType::load),
+         replacement::MemoryReference(0, 0, replacement::AccessType::streaming_store),
+         replacement::MemoryReference(0, 0, replacement::AccessType::load)}};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<std::vector<std::vector<replacement::cache_miss_type>>> cache_misses =
+        replacement::trace_cache_misses(H, {l1}, ws, num_numa_domains);
+    ASSERT_EQ(2u, cache_misses[l1][0][0]);
+    ASSERT_EQ(2u, cache_misses[l2][0][0]);
+    ASSERT_EQ(1u, H.write_backs()[l1][0][0]);
+    ASSERT_EQ(1u, H.write_backs()[l2][0][0]);
+}
+
+/*
+ * A store through one first-level cache invalidates the cache line in
+ * the other, whose next access to it is a coherence miss.  The miss
+ * is due to false sharing if the store was to a different address.
+ */
+TEST(hierarchy, coherence)
+{
+    auto L1_0 = replacement::LRU(2, 64);
+    auto L1_1 = replacement::LRU(2, 64);
+    auto L2 = replacement::LRU(8, 64);
+    auto regions = replacement::MemoryRegions(
+        {{"y", 0, 64}, {"z", 128, 192}});
+    replacement::CacheHierarchy H;
+    H.enable_coherence(regions);
+    int l2 = H.add_cache(L2, -1);
+    int l1_0 = H.add_cache(L1_0, l2);
+    int l1_1 = H.add_cache(L1_1, l2);
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {replacement::MemoryReference(0, 0, replacement::AccessType::load),
+         replacement::MemoryReference(0, 0, replacement::AccessType::load),
+         replacement::MemoryReference(8, 0, replacement::AccessType::load)},
+        {replacement::MemoryReference(8, 0, replacement::AccessType::store),
+         replacement::MemoryReference(8, 0, replacement::AccessType::store),
+         replacement::MemoryReference(128, 0, replacement::AccessType::load)}};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<std::vector<std::vector<replacement::cache_miss_type>>> cache_misses =
+        replacement::trace_cache_misses(H, {l1_0, l1_1}, ws, num_numa_domains);
+    ASSERT_EQ(3u, cache_misses[l1_0][0][0]);
+    ASSERT_EQ(2u, cache_misses[l1_1][1][0]);
+    ASSERT_EQ((std::vector<replacement::cache_miss_type>{2, 0, 0}),
+              H.invalidations()[l1_0]);
+    ASSERT_EQ((std::vector<replacement::cache_miss_type>{2, 0, 0}),
+              H.coherence_misses()[l1_0]);
+    ASSERT_EQ((std::vector<replacement::cache_miss_type>{1, 0, 0}),
+              H.false_sharing()[l1_0]);
+    ASSERT_EQ((std::vector<replacement::cache_miss_type>{0, 0, 0}),
+              H.invalidations()[l1_1]);
+    ASSERT_EQ(2u, H.write_backs()[l1_1][0][0]);
+    ASSERT_EQ(0u, H.write_backs()[l2][0][0]);
+}
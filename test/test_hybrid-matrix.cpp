@@ -6,6 +6,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cmath>
 #include <numeric>
 #include <stdexcept>
@@ -126,3 +127,31 @@ TEST(hybrid_matrix, aligned_arrays)
     ASSERT_EQ(0u, intptr_t(A.ell_column_index.data()) % 64);
     ASSERT_EQ(0u, intptr_t(A.ell_value.data()) % 64);
 }
+
+TEST(hybrid_matrix, spmv_memory_reference_substring)
+{
+    auto A = testMatrix();
+    auto x = hybrid_matrix::value_array_type(A.columns, 1.0);
+    auto y = hybrid_matrix::value_array_type(A.rows, 0.0);
+    int numa_domains[] = {0, 1, 2};
+    for (int num_threads = 1; num_threads <= 3; num_threads++) {
+        auto workspace = hybrid_matrix::value_array_type(num_threads * A.rows, 0.0);
+        for (int thread = 0; thread < num_threads; thread++) {
+            auto w = A.spmv_memory_reference_string(
+                x, y, workspace, thread, num_threads, numa_domains, 4096);
+            ASSERT_EQ(w.size(), A.spmv_memory_reference_string_size(
+                          thread, num_threads));
+            for (std::size_t offset = 0; offset <= w.size(); offset++) {
+                for (std::size_t count = 0; offset + count <= w.size(); count++) {
+                    auto v = std::vector<MemoryReference>(count);
+                    A.spmv_memory_reference_substring(
+                        x, y, workspace, thread, num_threads, numa_domains, 4096,
+                        offset, count, v.data());
+                    ASSERT_TRUE(std::equal(v.begin(), v.end(), w.begin() + offset))
+                        << "thread " << thread << " of " << num_threads << ", "
+                        << "offset " << offset << ", count " << count;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#include "cache-simulation/replacement.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+/*
+ * Read an interleaved stream to the end, and return the processor
+ * that made each memory reference.
+ */
+std::vector<std::size_t> interleaved_processors(
+    std::vector<replacement::MemoryReferenceString> const & ws,
+    replacement::Interleaving const & interleaving)
+{
+    std::vector<replacement::MemoryReferenceStringGenerator> generators;
+    for (auto const & w : ws)
+        generators.emplace_back(w);
+    std::vector<replacement::MemoryReferenceGenerator const *> gs;
+    for (auto const & generator : generators)
+        gs.push_back(&generator);
+
+    replacement::InterleavedMemoryReferenceStream stream(gs, interleaving);
+    std::vector<std::size_t> processors;
+    std::size_t p;
+    for (auto const * x = stream.next(p); x; x = stream.next(p))
+        processors.push_back(p);
+    EXPECT_EQ(stream.size(), stream.position());
+    return processors;
+}
+
+}
+
+TEST(interleaving, round_robin)
+{
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {{0, 0}, {1, 0}, {2, 0}},
+        {},
+        {{3, 0}}};
+    ASSERT_EQ(
+        (std::vector<std::size_t>{0, 2, 0, 0}),
+        interleaved_processors(ws, replacement::Interleaving()));
+}
+
+/*
+ * A processor that accesses a NUMA domain with a quarter of the
+ * bandwidth makes a memory reference for every four made by a
+ * processor that accesses the faster NUMA domain.
+ */
+TEST(interleaving, bandwidth)
+{
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {{0, 1}, {1, 1}},
+        {{2, 0}, {3, 0}, {4, 0}, {5, 0}, {6, 0}, {7, 0}}};
+    auto interleaving = replacement::Interleaving(
+        replacement::InterleavingPolicy::bandwidth, {4.0, 1.0});
+    ASSERT_EQ(
+        (std::vector<std::size_t>{0, 1, 1, 1, 1, 0, 1, 1}),
+        interleaved_processors(ws, interleaving));
+    ASSERT_THROW(
+        replacement::Interleaving(
+            replacement::InterleavingPolicy::bandwidth, {1.0, 0.0}),
+        std::invalid_argument);
+}
+
+TEST(interleaving, random)
+{
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {{0, 0}, {1, 0}, {2, 0}, {3, 0}, {4, 0}, {5, 0}, {6, 0}, {7, 0}},
+        {{8, 0}, {9, 0}, {10, 0}, {11, 0}, {12, 0}, {13, 0}, {14, 0}, {15, 0}}};
+    auto a = interleaved_processors(
+        ws, replacement::Interleaving(
+            replacement::InterleavingPolicy::random, {}, 1));
+    auto b = interleaved_processors(
+        ws, replacement::Interleaving(
+            replacement::InterleavingPolicy::random, {}, 1));
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(16u, a.size());
+    ASSERT_EQ(8, std::count(a.cbegin(), a.cend(), 0u));
+}
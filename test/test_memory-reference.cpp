@@ -0,0 +1,42 @@
+#include "util/memory-reference.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+TEST(memory_reference, size)
+{
+    ASSERT_EQ(8u, sizeof(MemoryReference));
+}
+
+TEST(memory_reference, pack)
+{
+    MemoryReference x(0x7fffdeadbeefu, 3);
+    ASSERT_EQ(0x7fffdeadbeefu, x.address());
+    ASSERT_EQ(3, x.numa_domain());
+
+    MemoryReference y(MemoryReference::address_mask,
+                      MemoryReference::max_numa_domains - 1);
+    ASSERT_EQ(MemoryReference::address_mask, y.address());
+    ASSERT_EQ(MemoryReference::max_numa_domains - 1, y.numa_domain());
+    ASSERT_NE(x, y);
+    ASSERT_EQ(x, MemoryReference(std::make_pair(0x7fffdeadbeefu, 3)));
+    ASSERT_EQ(AccessType::load, x.access_type());
+}
+
+TEST(memory_reference, access_type)
+{
+    for (AccessType access_type :
+             {AccessType::load, AccessType::store, AccessType::streaming_store})
+    {
+        MemoryReference x(
+            MemoryReference::address_mask,
+            MemoryReference::max_numa_domains - 1,
+            access_type);
+        ASSERT_EQ(MemoryReference::address_mask, x.address());
+        ASSERT_EQ(MemoryReference::max_numa_domains - 1, x.numa_domain());
+        ASSERT_EQ(access_type, x.access_type());
+    }
+    ASSERT_NE(MemoryReference(64u, 0, AccessType::load),
+              MemoryReference(64u, 0, AccessType::store));
+}
@@ -0,0 +1,127 @@
+#include "cache-simulation/hierarchy.hpp"
+#include "cache-simulation/memory-region.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+TEST(memory_region, find)
+{
+    auto regions = replacement::MemoryRegions(
+        {{"b", 256, 512}, {"a", 0, 128}, {"empty", 128, 128}});
+    ASSERT_EQ(4u, regions.size());
+    ASSERT_EQ("a", regions.name(1));
+    ASSERT_EQ("other", regions.name(3));
+    ASSERT_EQ(1u, regions.find(0));
+    ASSERT_EQ(1u, regions.find(127));
+    ASSERT_EQ(3u, regions.find(128));
+    ASSERT_EQ(0u, regions.find(256));
+    ASSERT_EQ(0u, regions.find(511));
+    ASSERT_EQ(3u, regions.find(512));
+}
+
+TEST(memory_region, make_memory_region)
+{
+    std::vector<double> x(4);
+    replacement::MemoryRegion region = replacement::make_memory_region("x", x);
+    ASSERT_EQ("x", region.name);
+    ASSERT_EQ(uintptr_t(x.data()), region.begin);
+    ASSERT_EQ(uintptr_t(x.data() + 4), region.end);
+}
+
+/*
+ * Every cache miss is attributed to the memory region of the missing
+ * memory reference, or else to `other'.
+ */
+TEST(memory_region, trace_cache_traffic)
+{
+    auto regions = replacement::MemoryRegions(
+        {{"a", 0, 256}, {"b", 256, 512}});
+    replacement::MemoryReferenceString w{
+        {0, 0}, {64, 0}, {256, 0}, {0, 0}, {1024, 0}, {320, 0}, {256, 0}};
+    replacement::MemoryReferenceStringGenerator generator(w);
+    std::vector<replacement::MemoryReferenceGenerator const *> ws{&generator};
+    auto A = replacement::LRU(4, 64);
+    replacement::CacheTrafficOptions options;
+    options.regions = &regions;
+    auto traffic = replacement::trace_cache_traffic(A, ws, 1, options);
+    ASSERT_EQ(5u, traffic.cache_misses[0][0]);
+    ASSERT_EQ(
+        (std::vector<replacement::cache_miss_type>{2, 2, 1}),
+        traffic.cache_misses_per_region);
+
+    auto B = replacement::LRU(4, 64);
+    ASSERT_TRUE(
+        replacement::trace_cache_traffic(B, ws, 1)
+        .cache_misses_per_region.empty());
+}
+
+/*
+ * In a cache hierarchy, only the cache misses of a cache reach its
+ * parent, and they are attributed to memory regions for each cache.
+ */
+TEST(memory_region, hierarchy)
+{
+    auto regions = replacement::MemoryRegions(
+        {{"a", 0, 256}, {"b", 256, 512}});
+    auto L1 = replacement::LRU(1, 64);
+    auto L2 = replacement::LRU(4, 64);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1);
+    int l1 = H.add_cache(L1, l2);
+    H.attribute_cache_misses(regions);
+    std::vector<replacement::MemoryReferenceString> ws{
+        {{0, 0}, {256, 0}, {0, 0}, {256, 0}, {1024, 0}}};
+    replacement::trace_cache_misses(H, {l1}, ws, 1);
+    ASSERT_EQ(
+        (std::vector<replacement::cache_miss_type>{2, 2, 1}),
+        H.cache_misses_per_region()[l1]);
+    ASSERT_EQ(
+        (std::vector<replacement::cache_miss_type>{1, 1, 1}),
+        H.cache_misses_per_region()[l2]);
+}
+
+/*
+ * Relocated regions are placed in order at fixed addresses, and keep
+ * their offsets from a multiple of the alignment, whereas memory
+ * references outside every region stay where they are.
+ */
+TEST(memory_region, relocation)
+{
+    using replacement::MemoryRelocation;
+    replacement::memory_reference_type a = 0x7f0000123440u;
+    replacement::memory_reference_type b = 0x550000000080u;
+    auto relocation = MemoryRelocation(
+        {{"a", a, a + 3 * MemoryRelocation::alignment},
+         {"b", b, b + 256},
+         {"empty", b + 512, b + 512}});
+    auto const & regions = relocation.regions();
+    ASSERT_EQ(3u, regions.size());
+    ASSERT_EQ("a", regions[0].name);
+    ASSERT_EQ(MemoryRelocation::base + 0x80u, regions[1].begin);
+    ASSERT_EQ(MemoryRelocation::base + 0x180u, regions[1].end);
+    ASSERT_EQ(a % MemoryRelocation::alignment,
+              regions[0].begin % MemoryRelocation::alignment);
+    ASSERT_LE(regions[2].end, regions[0].begin);
+    ASSERT_EQ(3 * MemoryRelocation::alignment,
+              regions[0].end - regions[0].begin);
+
+    ASSERT_EQ(regions[0].begin + 8, relocation.relocate(a + 8));
+    ASSERT_EQ(regions[1].begin + 255, relocation.relocate(b + 255));
+    ASSERT_EQ(b + 256, relocation.relocate(b + 256));
+
+    replacement::MemoryReferenceString w{
+        {a, 1, replacement::AccessType::store}, {b + 64, 0}, {0x1000, 0}};
+    replacement::RelocatedMemoryReferenceGenerator relocated(
+        std::make_unique<replacement::MemoryReferenceStringGenerator>(w),
+        relocation);
+    ASSERT_EQ(3u, relocated.size());
+    replacement::MemoryReferenceString v(3);
+    relocated.generate(0, 3, v.data());
+    ASSERT_EQ(replacement::MemoryReference(
+                  regions[0].begin, 1, replacement::AccessType::store), v[0]);
+    ASSERT_EQ(replacement::MemoryReference(regions[1].begin + 64, 0), v[1]);
+    ASSERT_EQ(w[2], v[2]);
+}
@@ -0,0 +1,112 @@
+#include "cache-simulation/hierarchy.hpp"
+#include "cache-simulation/prefetch.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using prefetches_type = std::vector<replacement::memory_reference_type>;
+
+TEST(prefetch, next_line)
+{
+    auto P = replacement::NextLinePrefetcher(64, 2);
+    prefetches_type prefetches;
+    P.access(8, true, prefetches);
+    ASSERT_EQ((prefetches_type{64, 128}), prefetches);
+    prefetches.clear();
+    P.access(8, false, prefetches);
+    ASSERT_TRUE(prefetches.empty());
+    P.access(4096 - 128, true, prefetches);
+    ASSERT_EQ((prefetches_type{4096 - 64}), prefetches);
+}
+
+TEST(prefetch, adjacent_line)
+{
+    auto P = replacement::AdjacentLinePrefetcher(64);
+    prefetches_type prefetches;
+    P.access(8, true, prefetches);
+    ASSERT_EQ((prefetches_type{64}), prefetches);
+    prefetches.clear();
+    P.access(72, true, prefetches);
+    ASSERT_EQ((prefetches_type{0}), prefetches);
+}
+
+/*
+ * The stride prefetcher fetches ahead once the same stride is seen
+ * twice in a row, and it keeps track of each page separately.
+ */
+TEST(prefetch, stride)
+{
+    auto P = replacement::StridePrefetcher(64, 2, 4);
+    prefetches_type prefetches;
+    P.access(0, false, prefetches);
+    P.access(64, false, prefetches);
+    ASSERT_TRUE(prefetches.empty());
+    P.access(128, false, prefetches);
+    ASSERT_EQ((prefetches_type{384, 448}), prefetches);
+    prefetches.clear();
+    P.access(136, false, prefetches);
+    P.access(8192, false, prefetches);
+    ASSERT_TRUE(prefetches.empty());
+    P.access(192, false, prefetches);
+    ASSERT_EQ((prefetches_type{448, 512}), prefetches);
+
+    prefetches.clear();
+    P.access(16384 + 4032, false, prefetches);
+    P.access(16384 + 3968, false, prefetches);
+    P.access(16384 + 3904, false, prefetches);
+    ASSERT_EQ((prefetches_type{16384 + 3648, 16384 + 3584}), prefetches);
+
+    prefetches.clear();
+    P.access(16384 + 320, false, prefetches);
+    P.access(16384 + 192, false, prefetches);
+    P.access(16384 + 64, false, prefetches);
+    ASSERT_TRUE(prefetches.empty());
+}
+
+/*
+ * A next-line prefetcher hides every cache miss of a sequential
+ * scan except the first.
+ */
+TEST(prefetch, trace_cache_traffic)
+{
+    auto A = replacement::LRU(4, 64);
+    auto P = replacement::NextLinePrefetcher(64);
+    auto w = replacement::MemoryReferenceString{
+        {0, 0}, {64, 0}, {128, 0}, {192, 0}};
+    auto g = replacement::MemoryReferenceStringGenerator(w);
+    replacement::numa_domain_type num_numa_domains = 1;
+    replacement::CacheTrafficOptions options;
+    options.prefetcher = &P;
+    replacement::CacheTraffic traffic = replacement::trace_cache_traffic(
+        A, {&g}, num_numa_domains, options);
+    ASSERT_EQ(1u, traffic.cache_misses[0][0]);
+    ASSERT_EQ(4u, traffic.prefetch_fills[0][0]);
+    ASSERT_EQ(3u, traffic.useful_prefetches[0][0]);
+}
+
+/*
+ * Prefetches of a first-level cache are requested from the
+ * second-level cache, where they count as prefetch fills.
+ */
+TEST(prefetch, hierarchy)
+{
+    auto L1 = replacement::LRU(2, 64);
+    auto L2 = replacement::LRU(8, 64);
+    auto P = replacement::NextLinePrefetcher(64);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1);
+    int l1 = H.add_cache(
+        L1, l2, replacement::InclusionPolicy::non_inclusive, &P);
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {{0, 0}, {64, 0}, {128, 0}}};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<std::vector<std::vector<replacement::cache_miss_type>>> cache_misses =
+        replacement::trace_cache_misses(H, {l1}, ws, num_numa_domains);
+    ASSERT_EQ(1u, cache_misses[l1][0][0]);
+    ASSERT_EQ(1u, cache_misses[l2][0][0]);
+    ASSERT_EQ(3u, H.prefetch_fills()[l1][0][0]);
+    ASSERT_EQ(3u, H.prefetch_fills()[l2][0][0]);
+    ASSERT_EQ(2u, H.useful_prefetches()[l1][0][0]);
+    ASSERT_EQ(0u, H.useful_prefetches()[l2][0][0]);
+}
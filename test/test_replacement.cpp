@@ -2,6 +2,10 @@
 
 #include <gtest/gtest.h>
 
+#include <functional>
+#include <memory>
+#include <random>
+
 /*
  * Test a replacement algorithm that replaces a random cache block.
  */
@@ -64,6 +68,38 @@ TEST(replacement, rand_replacement)
     ASSERT_LE(cache_misses[0], 9u);
 }
 
+/*
+ * Check that the victims are chosen uniformly at random, and that the
+ * same seed gives the same cache misses.
+ */
+TEST(replacement, rand_uniform)
+{
+    auto m = 4u;
+    std::vector<int> victims(m, 0);
+    for (uint64_t seed = 0; seed < 4000u; seed++) {
+        auto A = replacement::RAND(m, 1, replacement::MemoryReferenceSet(), seed);
+        for (uintptr_t x = 0; x < m; x++)
+            ASSERT_EQ(1u, A.allocate(x, 0));
+        ASSERT_EQ(1u, A.allocate(m, 0));
+        ASSERT_LT(A.victim(), m);
+        victims[A.victim()]++;
+    }
+    for (auto n : victims)
+        ASSERT_GT(n, 800);
+
+    // A cyclic reference string that is one cache line larger than
+    // the cache always misses with LRU and FIFO, but not with RAND.
+    auto w = replacement::MemoryReferenceString{};
+    for (int i = 0; i < 1000; i++)
+        w.emplace_back(i % (m + 1u), 0);
+    auto B = replacement::RAND(m, 1, replacement::MemoryReferenceSet(), 7);
+    auto C = replacement::RAND(m, 1, replacement::MemoryReferenceSet(), 7);
+    std::vector<replacement::cache_miss_type> cache_misses =
+        replacement::trace_cache_misses(B, w, 1);
+    ASSERT_LT(cache_misses[0], 1000u);
+    ASSERT_EQ(cache_misses, replacement::trace_cache_misses(C, w, 1));
+}
+
 /*
  * Test a replacement algorithm that replaces a cache block according to
  * the first-in-first-out policy.
@@ -382,3 +418,647 @@ TEST(replacement, lru_replacement_numa_domains)
     ASSERT_EQ(2u, cache_misses[1][0]);
     ASSERT_EQ(4u, cache_misses[1][1]);
 }
+
+/*
+ * Test set-associative caches.
+ */
+/*
+ * Test optimal replacement with the reference string from Belady's
+ * anomaly, for which LRU has 10 cache misses with 3 cache lines.
+ */
+TEST(replacement, opt_replacement)
+{
+    auto w = replacement::MemoryReferenceString();
+    for (int x : {1, 2, 3, 4, 1, 2, 5, 1, 2, 3, 4, 5})
+        w.emplace_back(x, 0);
+    replacement::numa_domain_type num_numa_domains = 1;
+
+    auto A = replacement::OPT(3, 1, w);
+    ASSERT_EQ(7u, replacement::trace_cache_misses(A, w, num_numa_domains)[0]);
+    auto B = replacement::LRU(3, 1);
+    ASSERT_EQ(10u, replacement::trace_cache_misses(B, w, num_numa_domains)[0]);
+    auto C = replacement::OPT(0, 1, w);
+    ASSERT_EQ(12u, replacement::trace_cache_misses(C, w, num_numa_domains)[0]);
+}
+
+/*
+ * Check that optimal replacement never has more cache misses than
+ * other policies for the interleaved reference strings of two
+ * processors.
+ */
+TEST(replacement, opt_lower_bound)
+{
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> line(0, 99);
+    auto ws = std::vector<replacement::MemoryReferenceString>(2);
+    for (auto & w : ws) {
+        for (int t = 0; t < 5000; t++)
+            w.emplace_back(64 * line(rng) + 8 * (t % 8), 0);
+    }
+    ws[1].resize(3000);
+    std::vector<replacement::MemoryReferenceStringGenerator> generators(
+        ws.cbegin(), ws.cend());
+    std::vector<replacement::MemoryReferenceGenerator const *> generator_ptrs{
+        &generators[0], &generators[1]};
+    replacement::numa_domain_type num_numa_domains = 1;
+
+    for (replacement::cache_size_type m : {1u, 8u, 32u, 64u, 100u}) {
+        auto A = replacement::OPT(m, 64, generator_ptrs);
+        auto opt = replacement::trace_cache_misses(A, ws, num_numa_domains);
+        auto B = replacement::LRU(m, 64);
+        auto lru = replacement::trace_cache_misses(B, ws, num_numa_domains);
+        auto C = replacement::FIFO(m, 64);
+        auto fifo = replacement::trace_cache_misses(C, ws, num_numa_domains);
+        auto D = replacement::SetAssociativeRRIP(
+            m, 64, m, replacement::RRIPInsertionPolicy::static_rrip);
+        auto srrip = replacement::trace_cache_misses(D, ws, num_numa_domains);
+        auto misses = [](std::vector<std::vector<replacement::cache_miss_type>> const & x) {
+            return x[0][0] + x[1][0];
+        };
+        ASSERT_LE(misses(opt), misses(lru)) << "cache lines: " << m;
+        ASSERT_LE(misses(opt), misses(fifo)) << "cache lines: " << m;
+        ASSERT_LE(misses(opt), misses(srrip)) << "cache lines: " << m;
+        if (m == 100u) {
+            ASSERT_EQ(100u, misses(opt));
+        }
+    }
+}
+
+/*
+ * With a warmup pass, the cache lines that are kept at the end of the
+ * first pass are chosen by their uses in the second pass.
+ */
+TEST(replacement, opt_warmup)
+{
+    auto w = replacement::MemoryReferenceString{
+        std::make_pair(0,0),
+        std::make_pair(1,0),
+        std::make_pair(2,0)};
+    replacement::numa_domain_type num_numa_domains = 1;
+    auto A = replacement::OPT(2, 1, w, 2);
+    ASSERT_EQ(1u, A.allocate(0, 0));
+    ASSERT_EQ(1u, A.allocate(1, 0));
+    ASSERT_EQ(1u, A.allocate(2, 0));
+    ASSERT_EQ(1u, A.victim());
+    ASSERT_EQ(1u, replacement::trace_cache_misses(A, w, num_numa_domains)[0]);
+    ASSERT_TRUE(A.invalidate(2));
+    ASSERT_FALSE(A.invalidate(0));
+}
+
+TEST(replacement, set_associative_lru_fully_associative)
+{
+    auto m = 4u;
+    auto A = replacement::SetAssociativeLRU(m, 1, m);
+    auto w = replacement::MemoryReferenceString{
+        std::make_pair(0,0),
+        std::make_pair(1,0),
+        std::make_pair(0,0),
+        std::make_pair(2,0),
+        std::make_pair(0,0),
+        std::make_pair(3,0),
+        std::make_pair(0,0),
+        std::make_pair(4,0),
+        std::make_pair(0,0)};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<replacement::cache_miss_type> cache_misses =
+        replacement::trace_cache_misses(A, w, num_numa_domains);
+    ASSERT_EQ(5u, cache_misses[0]);
+}
+
+TEST(replacement, set_associative_lru_conflict_misses)
+{
+    auto m = 4u;
+    auto A = replacement::SetAssociativeLRU(m, 1, 2);
+    auto w = replacement::MemoryReferenceString{
+        std::make_pair(0,0),
+        std::make_pair(2,0),
+        std::make_pair(0,0),
+        std::make_pair(4,0),
+        std::make_pair(2,0),
+        std::make_pair(1,0),
+        std::make_pair(0,0)};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<replacement::cache_miss_type> cache_misses =
+        replacement::trace_cache_misses(A, w, num_numa_domains);
+    ASSERT_EQ(6u, cache_misses[0]);
+}
+
+TEST(replacement, set_associative_direct_mapped)
+{
+    auto m = 4u;
+    auto A = replacement::SetAssociativeLRU(m, 64, 1);
+    auto w = replacement::MemoryReferenceString{
+        std::make_pair(  0,0),
+        std::make_pair(256,0),
+        std::make_pair( 64,0),
+        std::make_pair(  0,0),
+        std::make_pair(256,0),
+        std::make_pair( 64,0)};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<replacement::cache_miss_type> cache_misses =
+        replacement::trace_cache_misses(A, w, num_numa_domains);
+    ASSERT_EQ(5u, cache_misses[0]);
+}
+
+TEST(replacement, set_associative_xor_set_index)
+{
+    auto m = 4u;
+    auto A = replacement::SetAssociativeLRU(
+        m, 1, 1, replacement::SetIndexFunction::xor_fold);
+    auto w = replacement::MemoryReferenceString{
+        std::make_pair(0,0),
+        std::make_pair(4,0),
+        std::make_pair(0,0),
+        std::make_pair(4,0)};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<replacement::cache_miss_type> cache_misses =
+        replacement::trace_cache_misses(A, w, num_numa_domains);
+    ASSERT_EQ(2u, cache_misses[0]);
+}
+
+TEST(replacement, set_associative_fifo)
+{
+    auto m = 4u;
+    auto A = replacement::SetAssociativeFIFO(m, 1, 2);
+    auto w = replacement::MemoryReferenceString{
+        std::make_pair(0,0),
+        std::make_pair(2,0),
+        std::make_pair(0,0),
+        std::make_pair(4,0),
+        std::make_pair(0,0),
+        std::make_pair(1,0)};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<replacement::cache_miss_type> cache_misses =
+        replacement::trace_cache_misses(A, w, num_numa_domains);
+    ASSERT_EQ(5u, cache_misses[0]);
+}
+
+TEST(replacement, set_associative_rand)
+{
+    auto m = 4u;
+    auto A = replacement::SetAssociativeRAND(m, 1, 2);
+    auto w = replacement::MemoryReferenceString{
+        std::make_pair(0,0),
+        std::make_pair(2,0),
+        std::make_pair(1,0),
+        std::make_pair(3,0),
+        std::make_pair(4,0),
+        std::make_pair(0,0),
+        std::make_pair(2,0),
+        std::make_pair(1,0),
+        std::make_pair(3,0)};
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<replacement::cache_miss_type> cache_misses =
+        replacement::trace_cache_misses(A, w, num_numa_domains);
+    ASSERT_GE(cache_misses[0], 6u);
+    ASSERT_LE(cache_misses[0], 9u);
+}
+
+/*
+ * Check the victims chosen by tree-based pseudo-LRU, which differ
+ * from those of LRU once a cache line is reused.
+ */
+TEST(replacement, set_associative_plru)
+{
+    auto A = replacement::SetAssociativePLRU(4, 1, 4);
+    for (replacement::memory_reference_type x : {0u, 1u, 2u, 3u})
+        ASSERT_EQ(1u, A.allocate(x, 0));
+    ASSERT_EQ(0u, A.allocate(0, 0));
+    ASSERT_EQ(1u, A.allocate(4, 0));
+    ASSERT_EQ(2u, A.victim());
+    ASSERT_EQ(1u, A.allocate(5, 0));
+    ASSERT_EQ(1u, A.victim());
+}
+
+TEST(replacement, set_associative_plru_non_power_of_two)
+{
+    auto A = replacement::SetAssociativePLRU(6, 1, 3);
+    for (replacement::memory_reference_type x : {0u, 2u, 4u})
+        ASSERT_EQ(1u, A.allocate(x, 0));
+    ASSERT_EQ(1u, A.allocate(6, 0));
+    ASSERT_EQ(0u, A.victim());
+    ASSERT_EQ(1u, A.allocate(8, 0));
+    ASSERT_EQ(4u, A.victim());
+    ASSERT_EQ(1u, A.allocate(10, 0));
+    ASSERT_EQ(2u, A.victim());
+}
+
+TEST(replacement, set_associative_nru)
+{
+    auto A = replacement::SetAssociativeNRU(4, 1, 4);
+    for (replacement::memory_reference_type x : {0u, 1u, 2u, 3u})
+        ASSERT_EQ(1u, A.allocate(x, 0));
+    ASSERT_EQ(1u, A.allocate(4, 0));
+    ASSERT_EQ(0u, A.victim());
+    ASSERT_EQ(0u, A.allocate(1, 0));
+    ASSERT_EQ(1u, A.allocate(5, 0));
+    ASSERT_EQ(2u, A.victim());
+
+    auto B = replacement::SetAssociativeNRU(2, 1, 1);
+    ASSERT_EQ(1u, B.allocate(0, 0));
+    ASSERT_EQ(1u, B.allocate(2, 0));
+    ASSERT_EQ(0u, B.victim());
+}
+
+/*
+ * SRRIP keeps a cache line that was reused, whereas LRU would evict
+ * it after three new cache lines.
+ */
+TEST(replacement, set_associative_srrip)
+{
+    auto A = replacement::SetAssociativeRRIP(
+        4, 1, 4, replacement::RRIPInsertionPolicy::static_rrip);
+    for (replacement::memory_reference_type x : {0u, 1u, 2u, 3u})
+        ASSERT_EQ(1u, A.allocate(x, 0));
+    ASSERT_EQ(0u, A.allocate(0, 0));
+    ASSERT_EQ(1u, A.allocate(4, 0));
+    ASSERT_EQ(1u, A.victim());
+    ASSERT_EQ(1u, A.allocate(5, 0));
+    ASSERT_EQ(2u, A.victim());
+    ASSERT_EQ(1u, A.allocate(6, 0));
+    ASSERT_EQ(3u, A.victim());
+    ASSERT_EQ(1u, A.allocate(7, 0));
+    ASSERT_EQ(4u, A.victim());
+    ASSERT_EQ(0u, A.allocate(0, 0));
+}
+
+/*
+ * BRRIP inserts most cache lines with a distant re-reference
+ * interval, so that they are the first to be replaced.
+ */
+TEST(replacement, set_associative_brrip)
+{
+    auto A = replacement::SetAssociativeRRIP(
+        4, 1, 4, replacement::RRIPInsertionPolicy::bimodal_rrip);
+    for (replacement::memory_reference_type x : {0u, 1u, 2u, 3u})
+        ASSERT_EQ(1u, A.allocate(x, 0));
+    ASSERT_EQ(0u, A.allocate(0, 0));
+    ASSERT_EQ(1u, A.allocate(4, 0));
+    ASSERT_EQ(1u, A.victim());
+    ASSERT_EQ(1u, A.allocate(5, 0));
+    ASSERT_EQ(4u, A.victim());
+}
+
+/*
+ * With 8 sets, sets 0 and 4 are SRRIP leaders, sets 1 and 5 are
+ * BRRIP leaders, and the remaining sets follow the leaders with
+ * fewer misses.
+ */
+TEST(replacement, set_associative_drrip)
+{
+    auto A = replacement::SetAssociativeRRIP(
+        32, 1, 4, replacement::RRIPInsertionPolicy::dynamic_rrip);
+
+    // Set 1 behaves like BRRIP
+    for (replacement::memory_reference_type x : {1u, 9u, 17u, 25u})
+        ASSERT_EQ(1u, A.allocate(x, 0));
+    ASSERT_EQ(0u, A.allocate(1, 0));
+    ASSERT_EQ(1u, A.allocate(33, 0));
+    ASSERT_EQ(9u, A.victim());
+    ASSERT_EQ(1u, A.allocate(41, 0));
+    ASSERT_EQ(33u, A.victim());
+
+    // Set 0 behaves like SRRIP
+    for (replacement::memory_reference_type x : {0u, 8u, 16u, 24u})
+        ASSERT_EQ(1u, A.allocate(x, 0));
+    ASSERT_EQ(0u, A.allocate(0, 0));
+    for (replacement::memory_reference_type x : {32u, 40u, 48u, 56u})
+        ASSERT_EQ(1u, A.allocate(x, 0));
+    ASSERT_EQ(32u, A.victim());
+
+    // The SRRIP leader set has missed more often, so that set 2
+    // follows BRRIP
+    for (replacement::memory_reference_type x : {2u, 10u, 18u, 26u})
+        ASSERT_EQ(1u, A.allocate(x, 0));
+    ASSERT_EQ(0u, A.allocate(2, 0));
+    ASSERT_EQ(1u, A.allocate(34, 0));
+    ASSERT_EQ(10u, A.victim());
+    ASSERT_EQ(1u, A.allocate(42, 0));
+    ASSERT_EQ(34u, A.victim());
+}
+
+/*
+ * A working set that is reused between scans of data that is used
+ * only once survives under SRRIP, but not under LRU.
+ */
+TEST(replacement, set_associative_srrip_scan_resistance)
+{
+    auto w = replacement::MemoryReferenceString();
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 2; i++) {
+            for (int x = 0; x < 8; x++)
+                w.emplace_back(x, 0);
+        }
+        for (int x = 0; x < 16; x++)
+            w.emplace_back(1000 + 16 * round + x, 0);
+    }
+
+    replacement::numa_domain_type num_numa_domains = 1;
+    auto A = replacement::SetAssociativeLRU(16, 1, 16);
+    ASSERT_EQ(240u, replacement::trace_cache_misses(
+                  A, w, num_numa_domains)[0]);
+    auto B = replacement::SetAssociativeRRIP(
+        16, 1, 16, replacement::RRIPInsertionPolicy::static_rrip);
+    ASSERT_EQ(168u, replacement::trace_cache_misses(
+                  B, w, num_numa_domains)[0]);
+}
+
+/*
+ * Test invalidating cache lines and reporting evicted cache lines.
+ */
+TEST(replacement, lru_invalidate)
+{
+    auto A = replacement::LRU(2, 64);
+    ASSERT_EQ(1u, A.allocate(0, 0));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_victim, A.victim());
+    ASSERT_EQ(1u, A.allocate(64, 0));
+    ASSERT_TRUE(A.invalidate(8));
+    ASSERT_FALSE(A.invalidate(0));
+    ASSERT_EQ(1u, A.allocate(128, 0));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_victim, A.victim());
+    ASSERT_EQ(1u, A.allocate(192, 0));
+    ASSERT_EQ(64u, A.victim());
+    ASSERT_EQ(0u, A.allocate(128, 0));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_victim, A.victim());
+}
+
+TEST(replacement, rand_invalidate)
+{
+    auto A = replacement::RAND(2, 1);
+    ASSERT_EQ(1u, A.allocate(0, 0));
+    ASSERT_EQ(1u, A.allocate(1, 0));
+    ASSERT_TRUE(A.invalidate(0));
+    ASSERT_FALSE(A.invalidate(0));
+    ASSERT_EQ(0u, A.allocate(1, 0));
+    ASSERT_EQ(1u, A.allocate(2, 0));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_victim, A.victim());
+    ASSERT_EQ(0u, A.allocate(1, 0));
+    ASSERT_EQ(0u, A.allocate(2, 0));
+}
+
+TEST(replacement, fifo_invalidate)
+{
+    auto A = replacement::FIFO(2, 1);
+    ASSERT_EQ(1u, A.allocate(0, 0));
+    ASSERT_EQ(1u, A.allocate(1, 0));
+    ASSERT_TRUE(A.invalidate(0));
+    ASSERT_EQ(1u, A.allocate(2, 0));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_victim, A.victim());
+    ASSERT_EQ(1u, A.allocate(3, 0));
+    ASSERT_EQ(1u, A.victim());
+}
+
+TEST(replacement, set_associative_invalidate)
+{
+    auto A = replacement::SetAssociativeLRU(4, 1, 2);
+    ASSERT_EQ(1u, A.allocate(0, 0));
+    ASSERT_EQ(1u, A.allocate(2, 0));
+    ASSERT_EQ(0u, A.allocate(0, 0));
+    ASSERT_TRUE(A.invalidate(0));
+    ASSERT_FALSE(A.invalidate(4));
+    ASSERT_EQ(1u, A.allocate(4, 0));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_victim, A.victim());
+    ASSERT_EQ(1u, A.allocate(6, 0));
+    ASSERT_EQ(2u, A.victim());
+
+    auto B = replacement::SetAssociativeFIFO(4, 1, 2);
+    ASSERT_EQ(1u, B.allocate(0, 0));
+    ASSERT_EQ(1u, B.allocate(2, 0));
+    ASSERT_TRUE(B.invalidate(2));
+    ASSERT_EQ(1u, B.allocate(4, 0));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_victim, B.victim());
+    ASSERT_EQ(1u, B.allocate(6, 0));
+    ASSERT_EQ(0u, B.victim());
+
+    auto C = replacement::SetAssociativeRRIP(
+        2, 1, 2, replacement::RRIPInsertionPolicy::static_rrip);
+    ASSERT_EQ(1u, C.allocate(0, 0));
+    ASSERT_EQ(1u, C.allocate(1, 0));
+    ASSERT_EQ(0u, C.allocate(0, 0));
+    ASSERT_TRUE(C.invalidate(0));
+    ASSERT_EQ(1u, C.allocate(2, 0));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_victim, C.victim());
+    ASSERT_EQ(1u, C.allocate(3, 0));
+    ASSERT_EQ(2u, C.victim());
+
+    auto D = replacement::SetAssociativeNRU(2, 1, 2);
+    ASSERT_EQ(1u, D.allocate(0, 0));
+    ASSERT_EQ(1u, D.allocate(1, 0));
+    ASSERT_TRUE(D.invalidate(1));
+    ASSERT_EQ(1u, D.allocate(2, 0));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_victim, D.victim());
+}
+
+/*
+ * Test writing back dirty cache lines when they are evicted.
+ */
+TEST(replacement, write_back)
+{
+    auto A = replacement::LRU(1, 1);
+    ASSERT_EQ(1u, A.access(0, 0, replacement::AccessType::store));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_write_back, A.write_back());
+    ASSERT_EQ(0u, A.access(0, 0, replacement::AccessType::load));
+    ASSERT_EQ(1u, A.access(1, 1, replacement::AccessType::store));
+    ASSERT_EQ(0, A.write_back());
+    ASSERT_EQ(1u, A.access(2, 0, replacement::AccessType::load));
+    ASSERT_EQ(1, A.write_back());
+    ASSERT_EQ(1u, A.access(3, 0, replacement::AccessType::load));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_write_back, A.write_back());
+
+    ASSERT_FALSE(A.mark_dirty(0, 0));
+    ASSERT_TRUE(A.mark_dirty(3, 1));
+    ASSERT_EQ(1, A.clean(3));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_write_back, A.clean(3));
+
+    auto B = replacement::LRU(0, 1);
+    ASSERT_EQ(1u, B.access(0, 0, replacement::AccessType::store));
+    ASSERT_EQ(0, B.write_back());
+}
+
+/*
+ * Test that every replacement algorithm keeps the dirty state of its
+ * cache lines, and writes them back when they are evicted.
+ */
+TEST(replacement, write_back_every_policy)
+{
+    using replacement::ReplacementAlgorithm;
+    using replacement::AccessType;
+    auto w = replacement::MemoryReferenceString{
+        replacement::MemoryReference(0, 1, AccessType::store),
+        replacement::MemoryReference(0, 0, AccessType::load),
+        replacement::MemoryReference(1, 0, AccessType::load),
+        replacement::MemoryReference(2, 0, AccessType::load)};
+    std::vector<std::unique_ptr<ReplacementAlgorithm>> caches;
+    caches.push_back(std::make_unique<replacement::LRU>(1, 1));
+    caches.push_back(std::make_unique<replacement::FIFO>(1, 1));
+    caches.push_back(std::make_unique<replacement::RAND>(1, 1));
+    caches.push_back(std::make_unique<replacement::OPT>(1, 1, w));
+    caches.push_back(std::make_unique<replacement::SetAssociativeLRU>(1, 1, 1));
+    caches.push_back(std::make_unique<replacement::SetAssociativeFIFO>(1, 1, 1));
+    caches.push_back(std::make_unique<replacement::SetAssociativeRAND>(1, 1, 1));
+    caches.push_back(std::make_unique<replacement::SetAssociativePLRU>(1, 1, 1));
+    caches.push_back(std::make_unique<replacement::SetAssociativeNRU>(1, 1, 1));
+    caches.push_back(std::make_unique<replacement::SetAssociativeRRIP>(
+        1, 1, 1, replacement::RRIPInsertionPolicy::static_rrip));
+    for (std::size_t i = 0; i < caches.size(); i++) {
+        ReplacementAlgorithm & A = *caches[i];
+        std::vector<replacement::numa_domain_type> write_backs;
+        for (auto const & x : w) {
+            A.access(x.address(), x.numa_domain(), x.access_type());
+            write_backs.push_back(A.write_back());
+        }
+        ASSERT_EQ(std::vector<replacement::numa_domain_type>(
+                      {ReplacementAlgorithm::no_write_back,
+                       ReplacementAlgorithm::no_write_back,
+                       1,
+                       ReplacementAlgorithm::no_write_back}), write_backs)
+            << "cache: " << i;
+    }
+
+    // A dirty cache line stays dirty when random replacement moves it
+    // into the slot of an invalidated cache line.
+    auto B = replacement::RAND(2, 1);
+    B.access(0, 0, AccessType::load);
+    B.access(1, 1, AccessType::store);
+    ASSERT_TRUE(B.invalidate(0));
+    ASSERT_EQ(1, B.clean(1));
+}
+
+/*
+ * Streaming stores bypass the cache, and consecutive streaming
+ * stores to the same cache line are written to memory only once.
+ */
+TEST(replacement, streaming_store)
+{
+    auto A = replacement::LRU(2, 64);
+    ASSERT_EQ(1u, A.access(0, 0, replacement::AccessType::store));
+    ASSERT_EQ(0u, A.access(8, 1, replacement::AccessType::streaming_store));
+    ASSERT_EQ(1, A.write_back());
+    ASSERT_FALSE(A.contains(0));
+    ASSERT_EQ(0u, A.access(16, 1, replacement::AccessType::streaming_store));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_write_back, A.write_back());
+    ASSERT_EQ(0u, A.access(64, 1, replacement::AccessType::streaming_store));
+    ASSERT_EQ(1, A.write_back());
+    ASSERT_EQ(1u, A.access(0, 0, replacement::AccessType::load));
+    ASSERT_EQ(1u, A.access(128, 0, replacement::AccessType::load));
+    ASSERT_EQ(1u, A.access(192, 0, replacement::AccessType::load));
+    ASSERT_EQ(replacement::ReplacementAlgorithm::no_write_back, A.write_back());
+}
+
+/*
+ * Test counting cache misses and write-backs for each processor and
+ * NUMA domain.
+ */
+TEST(replacement, trace_cache_traffic)
+{
+    auto A = replacement::LRU(2, 1);
+    auto w0 = replacement::MemoryReferenceString{
+        replacement::MemoryReference(0, 0, replacement::AccessType::store),
+        replacement::MemoryReference(1, 0, replacement::AccessType::load),
+        replacement::MemoryReference(2, 0, replacement::AccessType::load)};
+    auto w1 = replacement::MemoryReferenceString{
+        replacement::MemoryReference(3, 1, replacement::AccessType::store),
+        replacement::MemoryReference(4, 1, replacement::AccessType::load)};
+    auto g0 = replacement::MemoryReferenceStringGenerator(w0);
+    auto g1 = replacement::MemoryReferenceStringGenerator(w1);
+    replacement::numa_domain_type num_numa_domains = 2;
+    replacement::CacheTraffic traffic = replacement::trace_cache_traffic(
+        A, {&g0, &g1}, num_numa_domains);
+    ASSERT_EQ(3u, traffic.cache_misses[0][0]);
+    ASSERT_EQ(2u, traffic.cache_misses[1][1]);
+    ASSERT_EQ(1u, traffic.write_backs[0][0]);
+    ASSERT_EQ(0u, traffic.write_backs[0][1]);
+    ASSERT_EQ(0u, traffic.write_backs[1][0]);
+    ASSERT_EQ(1u, traffic.write_backs[1][1]);
+}
+
+/*
+ * Test that caches simulated in batches, without virtual calls, have
+ * the same traffic as when they are simulated one memory reference at
+ * a time, and that every cache except those with an unsupported
+ * cache line size is simulated in batches.
+ */
+TEST(replacement, trace_cache_traffic_batched)
+{
+    using replacement::ReplacementAlgorithm;
+    using replacement::SetIndexFunction;
+    std::vector<std::function<std::unique_ptr<ReplacementAlgorithm>(
+        replacement::cache_size_type)>> make_caches{
+        [](auto l) { return std::make_unique<replacement::LRU>(16, l); },
+        [](auto l) { return std::make_unique<replacement::FIFO>(16, l); },
+        [](auto l) { return std::make_unique<replacement::RAND>(16, l); },
+        [](auto l) { return std::make_unique<replacement::SetAssociativeLRU>(16, l, 4); },
+        [](auto l) { return std::make_unique<replacement::SetAssociativeFIFO>(16, l, 4); },
+        [](auto l) { return std::make_unique<replacement::SetAssociativeRAND>(
+                16, l, 4, SetIndexFunction::xor_fold, 1); },
+        [](auto l) { return std::make_unique<replacement::SetAssociativePLRU>(16, l, 4); },
+        [](auto l) { return std::make_unique<replacement::SetAssociativeNRU>(16, l, 4); },
+        [](auto l) { return std::make_unique<replacement::SetAssociativeRRIP>(
+                16, l, 4, replacement::RRIPInsertionPolicy::dynamic_rrip); }};
+
+    std::mt19937_64 rng(0);
+    std::vector<replacement::MemoryReferenceString> ws(2);
+    for (auto & w : ws) {
+        for (int t = 0; t < 10000; t++) {
+            w.emplace_back(
+                std::uniform_int_distribution<uintptr_t>(0, 4096)(rng),
+                t % 2,
+                replacement::AccessType(
+                    std::uniform_int_distribution<int>(0, 2)(rng)));
+        }
+    }
+    auto g0 = replacement::MemoryReferenceStringGenerator(ws[0]);
+    auto g1 = replacement::MemoryReferenceStringGenerator(ws[1]);
+    replacement::CacheTrafficOptions options;
+    options.interleaving = replacement::Interleaving(
+        replacement::InterleavingPolicy::random, {}, 1);
+    replacement::CacheTrafficOptions unbatched_options(options);
+    unbatched_options.batched = false;
+    for (replacement::cache_size_type line_size : {32u, 64u, 128u, 48u}) {
+        for (std::size_t i = 0; i < make_caches.size(); i++) {
+            auto A = make_caches[i](line_size);
+            auto B = make_caches[i](line_size);
+            ASSERT_EQ(line_size != 48u,
+                      replacement::supports_batched_simulation(*A))
+                << "cache: " << i << ", line size: " << line_size;
+            replacement::CacheTraffic a = replacement::trace_cache_traffic(
+                *A, {&g0, &g1}, 2, options);
+            replacement::CacheTraffic b = replacement::trace_cache_traffic(
+                *B, {&g0, &g1}, 2, unbatched_options);
+            ASSERT_EQ(b.cache_misses, a.cache_misses)
+                << "cache: " << i << ", line size: " << line_size;
+            ASSERT_EQ(b.write_backs, a.write_backs)
+                << "cache: " << i << ", line size: " << line_size;
+            ASSERT_EQ(b.prefetch_fills, a.prefetch_fills)
+                << "cache: " << i << ", line size: " << line_size;
+            ASSERT_EQ(b.useful_prefetches, a.useful_prefetches)
+                << "cache: " << i << ", line size: " << line_size;
+            ASSERT_EQ(b.cache_misses_per_region, a.cache_misses_per_region)
+                << "cache: " << i << ", line size: " << line_size;
+        }
+    }
+
+    auto C = replacement::OPT(16, 64, ws[0]);
+    ASSERT_FALSE(replacement::supports_batched_simulation(C));
+}
+
+/*
+ * Test reading a generated memory reference string in chunks that
+ * do not evenly divide the string.
+ */
+TEST(replacement, memory_reference_stream)
+{
+    auto w = replacement::MemoryReferenceString{};
+    for (int t = 0; t < 10; t++)
+        w.emplace_back(t, t % 2);
+    auto generator = replacement::MemoryReferenceStringGenerator(w);
+    for (std::size_t chunk_size : {1u, 3u, 10u, 64u}) {
+        auto stream = replacement::MemoryReferenceStream(generator, chunk_size);
+        ASSERT_EQ(10u, stream.size());
+        for (int t = 0; t < 10; t++) {
+            ASSERT_FALSE(stream.empty());
+            ASSERT_EQ(w[t], stream.next()) << "chunk size: " << chunk_size;
+        }
+        ASSERT_TRUE(stream.empty());
+    }
+}
@@ -0,0 +1,146 @@
+#include "cache-simulation/reuse-distance.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+TEST(reuse_distance, reuse_distances)
+{
+    auto R = replacement::ReuseDistance(1);
+    ASSERT_EQ(replacement::ReuseDistance::infinite, R.reference(0));
+    ASSERT_EQ(0u, R.reference(0));
+    ASSERT_EQ(replacement::ReuseDistance::infinite, R.reference(1));
+    ASSERT_EQ(replacement::ReuseDistance::infinite, R.reference(2));
+    ASSERT_EQ(2u, R.reference(0));
+    ASSERT_EQ(1u, R.reference(2));
+    ASSERT_EQ(2u, R.reference(1));
+    ASSERT_EQ(0u, R.reference(1));
+}
+
+TEST(reuse_distance, cache_line_size)
+{
+    auto R = replacement::ReuseDistance(64);
+    ASSERT_EQ(replacement::ReuseDistance::infinite, R.reference(0));
+    ASSERT_EQ(0u, R.reference(63));
+    ASSERT_EQ(replacement::ReuseDistance::infinite, R.reference(64));
+    ASSERT_EQ(1u, R.reference(8));
+}
+
+TEST(reuse_distance, bins)
+{
+    for (replacement::reuse_distance_type d = 0; d < 4; d++) {
+        ASSERT_EQ(d, replacement::reuse_distance_bin(d));
+        ASSERT_EQ(d, replacement::reuse_distance_bin_lower_bound(d));
+    }
+    ASSERT_EQ(8u, replacement::reuse_distance_bin(8));
+    ASSERT_EQ(8u, replacement::reuse_distance_bin(9));
+    ASSERT_EQ(9u, replacement::reuse_distance_bin(10));
+    ASSERT_EQ(11u, replacement::reuse_distance_bin(15));
+    ASSERT_EQ(12u, replacement::reuse_distance_bin(16));
+    ASSERT_EQ(10u, replacement::reuse_distance_bin_lower_bound(9));
+    ASSERT_EQ(14u, replacement::reuse_distance_bin_lower_bound(11));
+    ASSERT_EQ(16u, replacement::reuse_distance_bin_lower_bound(12));
+    for (std::size_t bin = 0; bin < 200; bin++) {
+        replacement::reuse_distance_type d =
+            replacement::reuse_distance_bin_lower_bound(bin);
+        ASSERT_EQ(bin, replacement::reuse_distance_bin(d));
+        ASSERT_EQ(bin, replacement::reuse_distance_bin(
+                      replacement::reuse_distance_bin_lower_bound(bin+1)-1));
+    }
+}
+
+/*
+ * Check that the cache misses obtained from reuse distances agree
+ * with a simulation of LRU replacement, for two threads with a shared
+ * cache and a reference string that is long enough to require the
+ * clock to be compacted several times.
+ */
+TEST(reuse_distance, lru_cache_misses)
+{
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> line(0, 999);
+    std::uniform_int_distribution<int> numa_domain(0, 1);
+    auto ws = std::vector<replacement::MemoryReferenceString>(2);
+    for (auto & w : ws) {
+        for (int t = 0; t < 20000; t++)
+            w.emplace_back(line(rng), numa_domain(rng));
+    }
+    ws[1].resize(15000);
+
+    replacement::numa_domain_type num_numa_domains = 2;
+    replacement::ReuseDistanceHistogram histogram =
+        replacement::trace_reuse_distances(1, ws, num_numa_domains);
+    ASSERT_EQ(2u, histogram.num_processors());
+
+    for (replacement::cache_size_type m : {0u, 1u, 4u, 10u, 64u, 512u, 1024u}) {
+        auto A = replacement::LRU(m, 1);
+        std::vector<std::vector<replacement::cache_miss_type>> expected =
+            replacement::trace_cache_misses(A, ws, num_numa_domains);
+        ASSERT_EQ(expected, histogram.cache_misses(m)) << "cache lines: " << m;
+    }
+
+    replacement::cache_miss_type cold_misses =
+        histogram.cold_misses(0, 0) + histogram.cold_misses(0, 1) +
+        histogram.cold_misses(1, 0) + histogram.cold_misses(1, 1);
+    ASSERT_EQ(1000u, cold_misses);
+}
+
+/*
+ * Cache misses are exact for the given cache sizes, even if they do
+ * not lie at the boundaries of bins, and a lower bound otherwise.
+ */
+TEST(reuse_distance, exact_cache_misses)
+{
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> line(0, 999);
+    auto ws = std::vector<replacement::MemoryReferenceString>(2);
+    for (auto & w : ws) {
+        for (int t = 0; t < 10000; t++)
+            w.emplace_back(line(rng), 0);
+    }
+
+    replacement::numa_domain_type num_numa_domains = 1;
+    std::vector<replacement::cache_size_type> exact_cache_lines{999u, 9u, 100u};
+    replacement::ReuseDistanceHistogram histogram =
+        replacement::trace_reuse_distances(
+            1, ws, num_numa_domains, false, false, 0, exact_cache_lines);
+    ASSERT_EQ(std::vector<replacement::cache_size_type>({9u, 100u, 999u}),
+              histogram.exact_cache_lines());
+
+    for (replacement::cache_size_type m : exact_cache_lines) {
+        ASSERT_NE(m, replacement::reuse_distance_bin_lower_bound(
+                      replacement::reuse_distance_bin(m)));
+        ASSERT_TRUE(histogram.exact(m));
+        auto A = replacement::LRU(m, 1);
+        std::vector<std::vector<replacement::cache_miss_type>> expected =
+            replacement::trace_cache_misses(A, ws, num_numa_domains);
+        ASSERT_EQ(expected, histogram.cache_misses(m)) << "cache lines: " << m;
+    }
+
+    replacement::cache_size_type m = 11u;
+    ASSERT_FALSE(histogram.exact(m));
+    ASSERT_TRUE(histogram.exact(12u));
+    auto A = replacement::LRU(m, 1);
+    std::vector<std::vector<replacement::cache_miss_type>> expected =
+        replacement::trace_cache_misses(A, ws, num_numa_domains);
+    std::vector<std::vector<replacement::cache_miss_type>> lower_bound =
+        histogram.cache_misses(m);
+    for (std::size_t p = 0; p < ws.size(); p++)
+        ASSERT_LE(lower_bound[p][0], expected[p][0]);
+}
+
+TEST(reuse_distance, warmup)
+{
+    auto ws = std::vector<replacement::MemoryReferenceString>{
+        {std::make_pair(0,0),
+         std::make_pair(1,0),
+         std::make_pair(2,0),
+         std::make_pair(0,0)}};
+    replacement::numa_domain_type num_numa_domains = 1;
+    replacement::ReuseDistanceHistogram histogram =
+        replacement::trace_reuse_distances(1, ws, num_numa_domains, true);
+    ASSERT_EQ(0u, histogram.cold_misses(0, 0));
+    ASSERT_EQ(1u, histogram.count(0, 0, 0));
+    ASSERT_EQ(0u, histogram.count(0, 0, 1));
+    ASSERT_EQ(3u, histogram.count(0, 0, 2));
+}
@@ -0,0 +1,134 @@
+#include "cache-simulation/hierarchy.hpp"
+#include "cache-simulation/replacement.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+/*
+ * Each sampling period ends with a detailed window, which is preceded
+ * by a warm-up window, and the rest of the period is skipped.
+ */
+TEST(sampling, window)
+{
+    auto sampling = replacement::Sampling(10, 3, 2);
+    std::vector<replacement::SamplingWindow> windows;
+    for (uint64_t t = 0; t < 10; t++)
+        windows.push_back(sampling.window(t));
+    auto skip = replacement::SamplingWindow::skip;
+    auto warmup = replacement::SamplingWindow::warmup;
+    auto detailed = replacement::SamplingWindow::detailed;
+    ASSERT_EQ(
+        (std::vector<replacement::SamplingWindow>{
+            skip, skip, skip, skip, skip, warmup, warmup, warmup, detailed, detailed}),
+        windows);
+    ASSERT_EQ(skip, sampling.window(10));
+    ASSERT_EQ(detailed, sampling.window(19));
+    ASSERT_FALSE(replacement::Sampling().enabled());
+    ASSERT_EQ(detailed, replacement::Sampling().window(5));
+    ASSERT_THROW(replacement::Sampling(10, 9, 2), std::invalid_argument);
+    ASSERT_THROW(replacement::Sampling(10, 0, 0), std::invalid_argument);
+    ASSERT_THROW(replacement::Sampling(10, 3, 2, -0.1), std::invalid_argument);
+}
+
+/*
+ * The counts of the detailed windows are scaled by the fraction of
+ * memory references that were counted, and the confidence interval
+ * follows from the variance of the cache misses between windows.
+ */
+TEST(sampling, statistics)
+{
+    replacement::SamplingStatistics statistics;
+    statistics.reset(1, 1);
+    for (int i = 0; i < 4; i++)
+        statistics.reference(0, replacement::SamplingWindow::skip);
+    statistics.reference(0, replacement::SamplingWindow::detailed);
+    statistics.end_window({2});
+    for (int i = 0; i < 4; i++)
+        statistics.reference(0, replacement::SamplingWindow::skip);
+    statistics.reference(0, replacement::SamplingWindow::detailed);
+    statistics.end_window({6});
+    ASSERT_EQ(5.0, statistics.scale(0));
+    ASSERT_EQ(5.0, statistics.scale());
+
+    std::vector<std::vector<replacement::cache_miss_type>> counts{{6}};
+    statistics.extrapolate(counts);
+    ASSERT_EQ(30u, counts[0][0]);
+
+    replacement::SamplingEstimate estimate = statistics.estimate(0);
+    ASSERT_EQ(2u, estimate.windows);
+    ASSERT_EQ(30.0, estimate.cache_misses);
+    ASSERT_NEAR(1.96 * 5.0 * 2.0, estimate.confidence_interval, 1e-9);
+    ASSERT_NEAR(1.96 * 10.0 / 30.0, estimate.relative_error(), 1e-9);
+    ASSERT_TRUE(estimate.meets_target(replacement::Sampling(10, 3, 2)));
+    ASSERT_TRUE(estimate.meets_target(replacement::Sampling(10, 3, 2, 0.7)));
+    ASSERT_FALSE(estimate.meets_target(replacement::Sampling(10, 3, 2, 0.6)));
+    ASSERT_EQ(0.0, replacement::SamplingEstimate().relative_error());
+}
+
+/*
+ * A cyclic memory reference string that does not fit in the cache
+ * misses on every memory reference, so the extrapolated cache misses
+ * are exact.  If the detailed window spans the whole period, sampling
+ * counts every memory reference.
+ */
+TEST(sampling, trace_cache_traffic)
+{
+    replacement::MemoryReferenceString w;
+    for (int i = 0; i < 64; i++)
+        w.push_back({replacement::memory_reference_type(i % 4), 0});
+    replacement::MemoryReferenceStringGenerator generator(w);
+    std::vector<replacement::MemoryReferenceGenerator const *> ws{&generator};
+
+    auto A = replacement::LRU(2, 1);
+    replacement::CacheTrafficOptions options;
+    options.sampling = replacement::Sampling(16, 4, 4);
+    auto traffic = replacement::trace_cache_traffic(A, ws, 1, options);
+    ASSERT_EQ(64u, traffic.cache_misses[0][0]);
+    ASSERT_EQ(4u, traffic.sampling.windows);
+    ASSERT_EQ(64.0, traffic.sampling.cache_misses);
+    ASSERT_EQ(0.0, traffic.sampling.confidence_interval);
+
+    auto B = replacement::LRU(3, 1);
+    auto C = replacement::LRU(3, 1);
+    options.sampling = replacement::Sampling(8, 0, 8);
+    replacement::MemoryReferenceString v;
+    for (int i = 0; i < 64; i++)
+        v.push_back({replacement::memory_reference_type((i * 7) % 5), 0});
+    replacement::MemoryReferenceStringGenerator v_generator(v);
+    std::vector<replacement::MemoryReferenceGenerator const *> vs{&v_generator};
+    ASSERT_EQ(
+        replacement::trace_cache_traffic(B, vs, 1).cache_misses,
+        replacement::trace_cache_traffic(C, vs, 1, options).cache_misses);
+}
+
+/*
+ * The memory references in the warm-up windows fill the caches of a
+ * hierarchy without being counted.
+ */
+TEST(sampling, hierarchy)
+{
+    auto L1 = replacement::LRU(4, 1);
+    replacement::CacheHierarchy H;
+    int l1 = H.add_cache(L1, -1);
+    std::vector<replacement::MemoryReferenceString> ws{
+        {{0, 0}, {1, 0}, {0, 0}, {1, 0}, {2, 0}, {3, 0}, {2, 0}, {3, 0}}};
+    std::vector<replacement::MemoryReferenceStringGenerator> generators(
+        ws.cbegin(), ws.cend());
+    std::vector<replacement::MemoryReferenceGenerator const *> gs{&generators[0]};
+
+    replacement::SamplingStatistics statistics;
+    replacement::CacheHierarchyTraceOptions options;
+    options.sampling = replacement::Sampling(4, 2, 2);
+    options.statistics = &statistics;
+    auto cache_misses = replacement::trace_cache_misses(H, {l1}, gs, 1, options);
+    ASSERT_EQ(0u, cache_misses[l1][0][0]);
+    ASSERT_EQ(2u, statistics.estimate(l1).windows);
+
+    H.count(false);
+    H.reference(l1, 4, 0, 0);
+    H.count(true);
+    H.reference(l1, 5, 0, 0);
+    ASSERT_EQ(1u, H.cache_misses()[l1][0][0]);
+}
@@ -0,0 +1,65 @@
+#include "cache-simulation/hierarchy.hpp"
+#include "cache-simulation/timing.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+/*
+ * The hierarchy reports the cache that held each referenced cache
+ * line, or -1 if it came from memory.
+ */
+TEST(timing, served_by)
+{
+    auto L1 = replacement::LRU(1, 1);
+    auto L2 = replacement::LRU(2, 1);
+    replacement::CacheHierarchy H;
+    int l2 = H.add_cache(L2, -1);
+    int l1 = H.add_cache(L1, l2);
+    H.reset(1, 1);
+    ASSERT_EQ(-1, H.reference(l1, 0, 0, 0));
+    ASSERT_EQ(l1, H.reference(l1, 0, 0, 0));
+    ASSERT_EQ(-1, H.reference(l1, 1, 0, 0));
+    ASSERT_EQ(l2, H.reference(l1, 0, 0, 0));
+}
+
+/*
+ * Cache hits take the latency of the first-level cache, whereas
+ * cache misses overlap, up to the number of outstanding misses.
+ */
+TEST(timing, outstanding_misses)
+{
+    int l2 = 0;
+    int l1 = 1;
+    replacement::TimingModel serial({10.0, 1.0}, {}, {100.0}, {}, 64, 1);
+    serial.reset(1);
+    serial.reference(0, l1, l1, 0);
+    serial.reference(0, l1, -1, 0);
+    serial.reference(0, l1, -1, 0);
+    serial.reference(0, l1, l2, 0);
+    ASSERT_EQ(std::vector<double>{211.0}, serial.time());
+
+    replacement::TimingModel overlapped({10.0, 1.0}, {}, {100.0}, {}, 64, 4);
+    overlapped.reset(1);
+    overlapped.reference(0, l1, l1, 0);
+    overlapped.reference(0, l1, -1, 0);
+    overlapped.reference(0, l1, -1, 0);
+    overlapped.reference(0, l1, l2, 0);
+    ASSERT_EQ(std::vector<double>{102.0}, overlapped.time());
+}
+
+/*
+ * Processors that share a NUMA domain finish no earlier than it takes
+ * to transfer every cache line that it served at its bandwidth.
+ */
+TEST(timing, bandwidth)
+{
+    int l1 = 0;
+    replacement::TimingModel timing({1.0}, {}, {10.0, 10.0}, {64.0, 64.0}, 64, 10);
+    timing.reset(2);
+    for (int i = 0; i < 49; i++)
+        timing.reference(0, l1, -1, 0);
+    timing.reference(1, l1, -1, 0);
+    timing.transfer(1, 0, 50);
+    ASSERT_EQ((std::vector<double>{100.0, 100.0}), timing.time());
+}
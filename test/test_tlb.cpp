@@ -0,0 +1,73 @@
+#include "cache-simulation/hierarchy.hpp"
+#include "cache-simulation/tlb.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using tlb_misses_type =
+    std::vector<std::vector<std::vector<replacement::cache_miss_type>>>;
+
+/*
+ * A page that was evicted from the first-level TLB is still found in
+ * the second-level TLB, so that it does not cause a page walk.
+ */
+TEST(tlb, hierarchy)
+{
+    auto DTLB = replacement::TLB(2, 4096);
+    auto STLB = replacement::TLB(4, 4096);
+    replacement::CacheHierarchy H;
+    int stlb = H.add_cache(STLB, -1);
+    int dtlb = H.add_cache(DTLB, stlb);
+    auto w = replacement::MemoryReferenceString{
+        {0, 0}, {4096, 0}, {8192, 0}, {8, 0}};
+    auto g = replacement::MemoryReferenceStringGenerator(w);
+    replacement::numa_domain_type num_numa_domains = 1;
+    tlb_misses_type tlb_misses = replacement::trace_tlb_misses(
+        H, {dtlb}, {&g}, num_numa_domains);
+    ASSERT_EQ(4u, tlb_misses[dtlb][0][0]);
+    ASSERT_EQ(3u, tlb_misses[stlb][0][0]);
+}
+
+/*
+ * With 2 MiB pages, the same memory references fall within one page.
+ */
+TEST(tlb, large_pages)
+{
+    auto DTLB = replacement::TLB(2, 2 << 20);
+    replacement::CacheHierarchy H;
+    int dtlb = H.add_cache(DTLB, -1);
+    auto w = replacement::MemoryReferenceString{
+        {0, 0}, {4096, 0}, {8192, 0}, {8, 0}};
+    auto g = replacement::MemoryReferenceStringGenerator(w);
+    replacement::numa_domain_type num_numa_domains = 1;
+    tlb_misses_type tlb_misses = replacement::trace_tlb_misses(
+        H, {dtlb}, {&g}, num_numa_domains);
+    ASSERT_EQ(1u, tlb_misses[dtlb][0][0]);
+}
+
+/*
+ * Pages that map to the same set of a set-associative TLB evict each
+ * other, even though a fully associative TLB could hold them all.
+ */
+TEST(tlb, set_associative)
+{
+    auto w = replacement::MemoryReferenceString{
+        {0, 0}, {2 * 4096, 0}, {4 * 4096, 0}, {0, 0}};
+    auto g = replacement::MemoryReferenceStringGenerator(w);
+    replacement::numa_domain_type num_numa_domains = 1;
+
+    auto A = replacement::TLB(4, 4096, 2);
+    replacement::CacheHierarchy H;
+    int a = H.add_cache(A, -1);
+    tlb_misses_type tlb_misses = replacement::trace_tlb_misses(
+        H, {a}, {&g}, num_numa_domains);
+    ASSERT_EQ(4u, tlb_misses[a][0][0]);
+
+    auto B = replacement::TLB(4, 4096);
+    replacement::CacheHierarchy G;
+    int b = G.add_cache(B, -1);
+    tlb_misses = replacement::trace_tlb_misses(
+        G, {b}, {&g}, num_numa_domains);
+    ASSERT_EQ(3u, tlb_misses[b][0][0]);
+}
@@ -0,0 +1,124 @@
+#include "cache-simulation/memory-region.hpp"
+#include "cache-simulation/replacement.hpp"
+#include "cache-simulation/trace-file.hpp"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace
+{
+
+/*
+ * A memory reference string that spans several blocks, with both
+ * small and large jumps between addresses, and occasional changes of
+ * NUMA domain and access type.
+ */
+replacement::MemoryReferenceString memory_reference_string(
+    std::size_t size)
+{
+    replacement::MemoryReferenceString w;
+    uint64_t x = 1;
+    for (std::size_t i = 0; i < size; i++) {
+        x = x * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+        replacement::memory_reference_type address = (i % 7 == 0)
+            ? (x >> 16) & replacement::MemoryReference::address_mask
+            : 0x10000 + 8 * i;
+        w.push_back(replacement::MemoryReference(
+            address,
+            (i / 1000) % 3,
+            (i % 5 == 0) ? replacement::AccessType::store : replacement::AccessType::load));
+    }
+    return w;
+}
+
+void expect_same_after_replay(bool compress)
+{
+    char path[] = "/tmp/test_trace-file.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    close(fd);
+
+    std::vector<replacement::MemoryReferenceString> ws{
+        memory_reference_string(3 * replacement::trace_file_block_size + 17),
+        memory_reference_string(0),
+        memory_reference_string(100)};
+    std::vector<replacement::MemoryReferenceStringGenerator> generators;
+    for (auto const & w : ws)
+        generators.emplace_back(w);
+    std::vector<replacement::MemoryReferenceGenerator const *> gs;
+    for (auto const & g : generators)
+        gs.push_back(&g);
+    std::vector<replacement::MemoryRegion> regions{
+        {"a", 0x10000, 0x20000}, {"b", 0x20000, 0x30000}};
+
+    {
+        std::ofstream f(path, std::ios::binary);
+        replacement::write_trace_file(
+            f, "kernel", "{\"name\": \"kernel\"}", regions, 3, gs, compress);
+        ASSERT_TRUE(bool(f));
+    }
+
+    replacement::TraceFile trace_file(path);
+    ASSERT_EQ("kernel", trace_file.kernel_name());
+    ASSERT_EQ("{\"name\": \"kernel\"}", trace_file.kernel_description());
+    ASSERT_EQ(compress, trace_file.compressed());
+    ASSERT_EQ(3, trace_file.num_numa_domains());
+    ASSERT_EQ(3, trace_file.num_threads());
+    ASSERT_EQ(2u, trace_file.memory_regions().size());
+    ASSERT_EQ("b", trace_file.memory_regions()[1].name);
+    ASSERT_EQ(0x20000u, trace_file.memory_regions()[1].begin);
+    ASSERT_EQ(0x30000u, trace_file.memory_regions()[1].end);
+
+    for (int thread = 0; thread < 3; thread++) {
+        auto const & w = ws[thread];
+        auto g = trace_file.generator(thread);
+        ASSERT_EQ(w.size(), g->size());
+
+        // Generate the entire string at once, and then in pieces that
+        // cross the boundaries of blocks out of order.
+        replacement::MemoryReferenceString v(w.size());
+        g->generate(0, v.size(), v.data());
+        ASSERT_EQ(w, v);
+        if (w.size() > replacement::trace_file_block_size) {
+            uint64_t offset = replacement::trace_file_block_size - 5;
+            replacement::MemoryReferenceString u(10);
+            g->generate(offset, u.size(), u.data());
+            ASSERT_TRUE(std::equal(u.begin(), u.end(), w.begin() + offset));
+            g->generate(3, u.size(), u.data());
+            ASSERT_TRUE(std::equal(u.begin(), u.end(), w.begin() + 3));
+        }
+    }
+
+    unlink(path);
+}
+
+}
+
+TEST(trace_file, replay)
+{
+    expect_same_after_replay(false);
+}
+
+TEST(trace_file, replay_compressed)
+{
+    expect_same_after_replay(true);
+}
+
+TEST(trace_file, invalid)
+{
+    char path[] = "/tmp/test_trace-file.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    ASSERT_EQ(8, write(fd, "SPMVCKPT", 8));
+    close(fd);
+    ASSERT_THROW(replacement::TraceFile trace_file(path), replacement::trace_file_error);
+    unlink(path);
+    ASSERT_THROW(replacement::TraceFile trace_file(path), replacement::trace_file_error);
+}
@@ -0,0 +1,115 @@
+#include "validation.hpp"
+#include "cache-trace.hpp"
+#include "profile-kernel.hpp"
+#include "trace-config.hpp"
+#include "kernels/triad.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using cache_misses_type =
+    std::map<std::string, std::vector<std::vector<cache_miss_type>>>;
+
+/*
+ * Two threads with private first-level caches, a shared second-level
+ * cache and a last-level cache without a cache miss event.
+ */
+TraceConfig trace_config()
+{
+    std::map<std::string, Cache> caches{
+        {"L1-0", Cache("L1-0", 4096, 64, 0.0, {}, "l1-misses", "L2")},
+        {"L1-1", Cache("L1-1", 4096, 64, 0.0, {}, "l1-misses", "L2")},
+        {"L2", Cache("L2", 16384, 64, 0.0, {}, "l2-misses", "L3")},
+        {"L3", Cache("L3", 65536, 64, 0.0, {}, "", "")}};
+    std::vector<ThreadAffinity> thread_affinities{
+        ThreadAffinity(0, 0, "L1-0", 0, {}),
+        ThreadAffinity(1, 1, "L1-1", 1, {})};
+    return TraceConfig("", "", 2, {}, caches, thread_affinities);
+}
+
+CacheTrace cache_trace(
+    TraceConfig const & trace_config,
+    Kernel const & kernel,
+    cache_misses_type const & cache_misses)
+{
+    CacheTraceResults results;
+    results.cache_misses = cache_misses;
+    return CacheTrace(trace_config, kernel, CacheTraceOptions(), results);
+}
+
+}
+
+/*
+ * Simulated cache misses are summed over NUMA domains, and measured
+ * cache misses are averaged over runs, and scaled up in runs where
+ * the event was multiplexed.
+ */
+TEST(validation, errors)
+{
+    TraceConfig config = trace_config();
+    triad_kernel kernel(16);
+    cache_misses_type cache_misses{
+        {"L1-0", {{100, 20}, {0, 0}}},
+        {"L1-1", {{0, 0}, {30, 10}}},
+        {"L2", {{50, 10}, {0, 40}}},
+        {"L3", {{10, 0}, {0, 10}}}};
+    CacheTrace trace = cache_trace(config, kernel, cache_misses);
+
+    // Each thread counts its events in separate groups, with the
+    // times that the groups were enabled and running.
+    std::vector<ProfilingRun> runs{
+        ProfilingRun(1000, {
+            {EventGroupValues(10, 10, {{"l1-misses", 100}}),
+             EventGroupValues(10, 5, {{"l2-misses", 30}})},
+            {EventGroupValues(10, 10, {{"l1-misses", 0}}),
+             EventGroupValues(10, 10, {{"l2-misses", 50}})}}),
+        ProfilingRun(1000, {
+            {EventGroupValues(10, 10, {{"l1-misses", 160}}),
+             EventGroupValues(10, 10, {{"l2-misses", 60}})},
+            {EventGroupValues(10, 10, {{"l1-misses", 0}}),
+             EventGroupValues(10, 10, {{"l2-misses", 50}})}})};
+    Profiling profiling(config, kernel, runs);
+
+    Validation validation(trace, profiling);
+    auto const & caches = validation.caches();
+    ASSERT_EQ(3u, caches.size());
+    ASSERT_EQ(caches.end(), caches.find("L3"));
+
+    CacheMissValidation const & l1 = caches.at("L1-0");
+    ASSERT_EQ("l1-misses", l1.event);
+    ASSERT_EQ(std::vector<int>({0}), l1.threads);
+    ASSERT_DOUBLE_EQ(120.0, l1.simulated[0]);
+    ASSERT_DOUBLE_EQ(130.0, l1.measured[0]);
+    ASSERT_DOUBLE_EQ(10.0, l1.absolute_error[0]);
+    ASSERT_DOUBLE_EQ(10.0 / 130.0, l1.relative_error[0]);
+
+    // No cache misses were measured, so the relative error is
+    // undefined.
+    CacheMissValidation const & l1_1 = caches.at("L1-1");
+    ASSERT_EQ(std::vector<int>({1}), l1_1.threads);
+    ASSERT_DOUBLE_EQ(40.0, l1_1.simulated[0]);
+    ASSERT_DOUBLE_EQ(0.0, l1_1.measured[0]);
+    ASSERT_DOUBLE_EQ(40.0, l1_1.absolute_error[0]);
+    ASSERT_TRUE(std::isnan(l1_1.relative_error[0]));
+
+    // The first run of thread 0 only counted the event half of the
+    // time, and is scaled from 30 to 60.
+    CacheMissValidation const & l2 = caches.at("L2");
+    ASSERT_EQ("l2-misses", l2.event);
+    ASSERT_EQ(std::vector<int>({0, 1}), l2.threads);
+    ASSERT_DOUBLE_EQ(60.0, l2.simulated[0]);
+    ASSERT_DOUBLE_EQ(60.0, l2.measured[0]);
+    ASSERT_DOUBLE_EQ(0.0, l2.absolute_error[0]);
+    ASSERT_DOUBLE_EQ(0.0, l2.relative_error[0]);
+    ASSERT_DOUBLE_EQ(40.0, l2.simulated[1]);
+    ASSERT_DOUBLE_EQ(50.0, l2.measured[1]);
+    ASSERT_DOUBLE_EQ(10.0, l2.absolute_error[1]);
+    ASSERT_DOUBLE_EQ(0.2, l2.relative_error[1]);
+}